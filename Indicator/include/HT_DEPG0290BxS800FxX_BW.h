@@ -0,0 +1,239 @@
+#ifndef __HT_DEPG0290BXS800FXX_BW_H__
+#define __HT_DEPG0290BXS800FXX_BW_H__
+
+#include <HT_Display.h>
+#include <SPI.h>
+#include "HT_st7735_fonts.h"
+SPIClass EPDSPI(HSPI);
+
+
+/**
+ * Vision Master E290 panel (SSD1680, 296 x 128), project copy of the
+ * Heltec driver with non-blocking and partial refreshes
+ *
+ * A RAM row (Y address) is one display column over the full panel height,
+ * so partial writes cover bands of columns. The partial waveform drives
+ * each pixel from the old image (RAM 0x26) to the new one (RAM 0x24):
+ * after a partial refresh has finished, write the same bands to 0x26
+ * (updateColumns(x0, x1, PREVIOUS_RAM)) so the next one starts from what
+ * the panel shows.
+ */
+class DEPG0290BxS800FxX_BW : public ScreenDisplay
+{
+private:
+	uint8_t _rst;
+	uint8_t _dc;
+	int8_t _cs;
+	int8_t _clk;
+	int8_t _mosi;
+	int8_t _miso;
+	uint32_t _freq;
+	int8_t _busy;
+	uint8_t _buf[4736];
+	SPISettings _spiSettings;
+
+public:
+	static const uint8_t CURRENT_RAM = 0x24;   // Image to show
+	static const uint8_t PREVIOUS_RAM = 0x26;  // Image shown (partial waveform)
+
+	DEPG0290BxS800FxX_BW(uint8_t _rst, uint8_t _dc, int8_t _cs, int8_t _busy, int8_t _sck, int8_t _mosi, int8_t _miso, uint32_t _freq = 6000000, DISPLAY_GEOMETRY g = GEOMETRY_296_128)
+	{
+		setGeometry(g);
+		this->_rst = _rst;
+		this->_dc = _dc;
+		this->_cs = _cs;
+		this->_freq = _freq;
+		this->_clk = _sck;
+		this->_mosi = _mosi;
+		this->_miso = _miso;
+		this->_busy = _busy;
+		this->displayType = E_INK;
+	}
+
+	bool connect()
+	{
+		pinMode(_dc, OUTPUT);
+		pinMode(_rst, OUTPUT);
+		pinMode(_cs, OUTPUT);
+		digitalWrite(_cs, HIGH);
+		pinMode(_busy, INPUT);
+		this->buffer = _buf;
+		EPDSPI.begin(this->_clk, this->_miso, this->_mosi);
+		_spiSettings._clock = this->_freq;
+		// Pulse Reset low for 10ms
+		digitalWrite(_rst, HIGH);
+		delay(20);
+		digitalWrite(_rst, LOW);
+		delay(10);
+		digitalWrite(_rst, HIGH);
+		return true;
+	}
+
+	/**
+	 * Write the whole buffer to both RAMs (a full refresh ignores the old
+	 * image, and the next partial refresh starts from this one)
+	 */
+	void update(DISPLAY_BUFFER buffer)
+	{
+		updateData(CURRENT_RAM);
+		updateData(PREVIOUS_RAM);
+	}
+
+	void display()
+	{
+		startRefresh(false);
+		WaitUntilIdle();
+	}
+
+	void displayPartial()
+	{
+		startRefresh(true);
+		WaitUntilIdle();
+	}
+
+	/**
+	 * Start a refresh and return - poll isBusy() before the next command
+	 */
+	void startRefresh(bool partial)
+	{
+		sendCommand(0x22);
+		sendData(partial ? 0xFF : 0xF7);  // Display mode 2 (partial) / mode 1 (full)
+		sendCommand(0x20);  // Master activation
+	}
+
+	bool isBusy()
+	{
+		return digitalRead(_busy);  // LOW: idle, HIGH: busy
+	}
+
+	int busyPin() const
+	{
+		return _busy;
+	}
+
+	/**
+	 * Write display columns x0..x1 of the buffer to one panel RAM
+	 * (the bytes updateData() writes for them, without the rest)
+	 */
+	void updateColumns(uint16_t x0, uint16_t x1, uint8_t ram = CURRENT_RAM)
+	{
+		if (x1 > 295) x1 = 295;
+		if (x0 > x1) return;
+
+		setRamArea(x0, x1);
+		sendCommand(ram);
+		for (int x = x0; x <= x1; x++)
+		{
+			for (int y = 15; y >= 0; y--)
+			{
+				sendData(~buffer[x + y * 296]);
+			}
+		}
+	}
+
+	void updateData(uint8_t addr)
+	{
+		sendCommand(0x3C);  // Border waveform
+		sendData(0x05);     // Follow LUT, white
+
+		setRamArea(0, 295);
+		sendCommand(addr);
+		for (int x = 0; x < 296; x++)
+		{
+			for (int y = 15; y >= 0; y--)
+			{
+				sendData(~buffer[x + y * 296]);
+			}
+		}
+	}
+
+	void stop()
+	{
+		end();
+	}
+
+private:
+	int getBufferOffset(void)
+	{
+		return 0;
+	}
+
+	void WaitUntilIdle()
+	{
+		while (digitalRead(_busy))
+		{ // LOW: idle, HIGH: busy
+			delay(10);
+		}
+		delay(10);
+	}
+
+	void setRamArea(uint16_t x0, uint16_t x1)
+	{
+		// X counts the 16 source bytes of a row (all 128 pixels), Y the
+		// display columns
+		sendCommand(0x11); // set ram entry mode
+		sendData(0x03);    // x increase, y increase
+		sendCommand(0x44);
+		sendData(0x00);    // X start
+		sendData(0x0F);    // X end
+		sendCommand(0x45);
+		sendData(x0 & 0xFF);  // Y start
+		sendData(x0 >> 8);
+		sendData(x1 & 0xFF);  // Y end
+		sendData(x1 >> 8);
+		sendCommand(0x4E);
+		sendData(0x00);    // X counter
+		sendCommand(0x4F);
+		sendData(x0 & 0xFF);  // Y counter
+		sendData(x0 >> 8);
+	}
+
+	void sendInitCommands(void)
+	{
+		WaitUntilIdle();
+		sendCommand(0x12); // soft reset
+		WaitUntilIdle();
+
+		sendCommand(0x01); // Driver output control: 296 gates
+		sendData(0x27);
+		sendData(0x01);
+		sendData(0x00);
+
+		sendCommand(0x21); // Display update control: normal RAM
+		sendData(0x00);
+		sendData(0x80);
+
+		sendCommand(0x3C); // Border Waveform
+		sendData(0x05);
+
+		sendCommand(0x18); // Internal temperature sensor
+		sendData(0x80);
+
+		setRamArea(0, 295);
+		WaitUntilIdle();
+	}
+
+	void sendScreenRotateCommand()
+	{
+
+	}
+
+	inline void sendCommand(uint8_t com) __attribute__((always_inline))
+	{
+		digitalWrite(_dc, LOW);
+		digitalWrite(_cs, LOW);
+		EPDSPI.beginTransaction(_spiSettings);
+		EPDSPI.transfer(com);
+		EPDSPI.endTransaction();
+		digitalWrite(_cs, HIGH);
+		digitalWrite(_dc, HIGH);
+	}
+	void sendData(unsigned char data)
+	{
+		digitalWrite(this->_cs, LOW);
+		EPDSPI.transfer(data);
+		digitalWrite(this->_cs, HIGH);
+	}
+};
+
+#endif
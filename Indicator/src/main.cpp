@@ -12,15 +12,19 @@
  * Features:
  * - E-ink display showing staff name and real-time vitals
  * - Receives monitoring data from Wireless Stick V3 via UART
- * - Flashes emergency warnings for fall detection and unconscious states
- * - Low power consumption (E-ink only updates when needed)
+ * - Shows emergency warnings for fall detection and unconscious states
+ *   as soon as the packet arrives
+ * - Low power consumption: only changed fields are redrawn (partial
+ *   refresh), and the MCU light-sleeps until the next UART frame, button
+ *   press or refresh completion
  * 
  * Hardware:
  * - Heltec Vision Master E290 (ESP32-S3 with 2.9" E-ink display)
  * - UART connection to Wireless Stick V3 (TX/RX)
  * 
  * Communication Protocol (from Wireless Stick V3):
- * Realtime Packet (10 bytes):
+ * UartFrame::REALTIME frames (COBS + CRC16, see shared/include/UartLink.h)
+ * carrying the Realtime Packet (10 bytes):
  *   [0] Packet type: 0x01
  *   [1] Heart rate (BPM)
  *   [2] Body temperature
@@ -30,11 +34,20 @@
  *   [6] Alert flags
  *   [7-9] RSSI/SNR
  * 
+ * The frames arrive through the UART driver's event queue: the badge
+ * sleeps and the wearable sends a preamble of delimiters ahead of each
+ * frame that wakes it (UartLink::setWakePreamble()).
+ * 
  * ============================================================================
  */
 
 #include <Arduino.h>
+#include "esp_sleep.h"
+#include "driver/gpio.h"
 #include "HT_DEPG0290BxS800FxX_BW.h"
+#include "UartLink.h"
+#include "LinkConfig.h"
+#include "PacketCodec.h"
 
 // ============================================================================
 // PIN DEFINITIONS - Heltec Vision Master E290
@@ -45,7 +58,7 @@ DEPG0290BxS800FxX_BW display(5, 4, 3, 6, 2, 1, -1, 6000000);
 // UART pins for communication with Wireless Stick V3
 #define UART_RX     44  // Connect to Wireless Stick V3 TX
 #define UART_TX     43  // Connect to Wireless Stick V3 RX
-#define UART_BAUD   115200
+const int UART_BAUD = UartConfig::BADGE_BAUD;  // Shared with the wearable (shared/include/LinkConfig.h)
 
 // Button pins
 #define BUTTON_PIN  0   // Built-in button for manual refresh
@@ -58,9 +71,19 @@ DEPG0290BxS800FxX_BW display(5, 4, 3, 6, 2, 1, -1, 6000000);
 #define STAFF_TITLE       "Technician"
 #define DEVICE_ID         "BADGE-001"
 
-#define NORMAL_REFRESH_MS     30000        // Update every 30 seconds in normal mode
-#define EMERGENCY_BLINK_MS    1000         // Blink every second in emergency
 #define UART_TIMEOUT_MS       5000         // UART data timeout
+#define UART_WAKE_WINDOW_MS   20           // Awake after a wake-up, for the frame behind the preamble
+#define BUTTON_POLL_MS        50           // Button check while awake (asleep it wakes the chip)
+
+static_assert(UART_WAKE_WINDOW_MS * 1000 >=
+              UartConfig::bytesUs(UartConfig::BADGE_WAKE_PREAMBLE + UartFrame::MAX_ENCODED, UartConfig::BADGE_BAUD),
+              "Wake window ends before the longest frame behind the preamble has arrived");
+
+// Light sleep between events (0 keeps the USB console connected for debugging -
+// USB CDC drops while the chip sleeps)
+#ifndef INDICATOR_LIGHT_SLEEP
+#define INDICATOR_LIGHT_SLEEP 1
+#endif
 
 /* Screen rotation options:
  * ANGLE_0_DEGREE
@@ -87,10 +110,10 @@ struct MonitoringData {
 };
 
 MonitoringData currentData = {0};
-unsigned long lastDisplayUpdate = 0;
+UartLink wearableLink;  // UART1 through the ESP-IDF driver (not Serial1)
 unsigned long lastUARTReceive = 0;
-bool emergencyMode = false;
-bool displayState = false;  // For blinking in emergency mode
+bool dataLive = false;             // Fresh data shown (not "waiting")
+unsigned long awakeUntilMs = 0;    // No light sleep before this (frame behind a wake-up)
 
 // ============================================================================
 // POWER CONTROL
@@ -110,36 +133,35 @@ void VextOFF(void) {
 // ============================================================================
 
 /**
- * Decode temperature from uint8 to float
- * Formula matches ESP32 encoding: (temp + 20) / 100 * 255
- * So decoding is: (encoded / 255) * 100 - 20
+ * Decode temperature from uint8 to float (shared TempCode, -20 to 80°C)
  */
 float decodeTemperature(uint8_t encoded) {
-  return ((float)encoded / 255.0f) * 100.0f - 20.0f;
+  return TempCode::decode(encoded);
 }
 
 /**
- * Read packet from UART
+ * Read packets from UART
+ * Takes every frame waiting; corrupt frames are dropped by the link
+ * @param wait Ticks to wait for the first UART event
  * Returns true if valid packet received
  */
-bool readUARTPacket() {
-  if (Serial1.available() >= 10) {
-    uint8_t buffer[10];
-    
-    // Read 10 bytes
-    for (int i = 0; i < 10; i++) {
-      buffer[i] = Serial1.read();
-    }
+bool readUARTPacket(TickType_t wait) {
+  bool received = false;
+  
+  while (wearableLink.receive(wait)) {
+    wait = 0;
+    if (wearableLink.frameType() != UartFrame::REALTIME) continue;
     
-    // Check packet type
-    if (buffer[0] == 0x01) {  // Realtime data packet
-      currentData.packet_type = buffer[0];
-      currentData.heart_rate = buffer[1];
-      currentData.body_temp = buffer[2];
-      currentData.ambient_temp = buffer[3];
-      currentData.noise_level = buffer[4];
-      currentData.fall_state = buffer[5];
-      currentData.alert_flags = buffer[6];
+    // Realtime data packet, read in place from the link's buffer
+    RealtimePacket::View packet(wearableLink.payload(), wearableLink.payloadLength());
+    if (packet.valid()) {
+      currentData.packet_type = RealtimePacket::TYPE;
+      currentData.heart_rate = packet.heartRate();
+      currentData.body_temp = packet.bodyTempCode();
+      currentData.ambient_temp = packet.ambientTempCode();
+      currentData.noise_level = packet.noise();
+      currentData.fall_state = packet.fallState();
+      currentData.alert_flags = packet.alertFlags();
       currentData.last_update = millis();
       currentData.valid = true;
       lastUARTReceive = millis();
@@ -151,11 +173,11 @@ bool readUARTPacket() {
                     decodeTemperature(currentData.body_temp),
                     currentData.fall_state);
       
-      return true;
+      received = true;
     }
   }
   
-  return false;
+  return received;
 }
 
 /**
@@ -169,12 +191,184 @@ bool isDataStale() {
 // E-INK DISPLAY FUNCTIONS
 // ============================================================================
 
+const unsigned long DISPLAY_MIN_INTERVAL_MS = 1000;  // Between refreshes (new alerts excepted)
+const uint8_t DISPLAY_FULL_EVERY = 20;               // Partial refreshes before a full one (ghosting)
+const unsigned long DISPLAY_SETTLE_MS = 20;          // BUSY rises shortly after activation
+const int DISPLAY_TEXT_MAX = 24;
+const int DISPLAY_COLUMNS = 296;
+
+enum DisplayLayout {
+  LAYOUT_NONE = 0,        // Panel content unknown (boot)
+  LAYOUT_WAITING = 1,     // No data / stale data
+  LAYOUT_NORMAL = 2,      // Name tag with vitals
+  LAYOUT_FALL = 3,        // Inverted fall alert
+  LAYOUT_UNCONSCIOUS = 4  // Inverted DANGEROUS alert
+};
+
+enum DisplayFieldId {
+  FIELD_HR, FIELD_TEMP, FIELD_STATUS,
+  FIELD_COUNT
+};
+
+// Text anchor, alignment, and the area cleared before drawing
+struct DisplayField {
+  int16_t x, y;
+  DISPLAY_TEXT_ALIGNMENT align;
+  int16_t clearX, clearY, clearW, clearH;
+};
+
+const DisplayField NORMAL_FIELDS[FIELD_COUNT] = {
+  {10, 75, TEXT_ALIGN_LEFT, 8, 75, 140, 12},   // HR
+  {10, 90, TEXT_ALIGN_LEFT, 8, 90, 140, 12},   // Temp
+  {10, 105, TEXT_ALIGN_LEFT, 8, 105, 140, 12}  // Status
+};
+
+// Alert layouts: white on black, no status line (the banner is the status)
+const DisplayField ALERT_FIELDS[FIELD_COUNT] = {
+  {20, 70, TEXT_ALIGN_LEFT, 18, 70, 120, 12},  // HR
+  {20, 85, TEXT_ALIGN_LEFT, 18, 85, 120, 12},  // Temp
+  {20, 0, TEXT_ALIGN_LEFT, 0, 0, 0, 0}         // Status (unused)
+};
+
+struct DisplayModel {
+  DisplayLayout layout;
+  char text[FIELD_COUNT][DISPLAY_TEXT_MAX];
+};
+
+// Columns to write to the panel, merged into a few bands
+struct DirtyColumns {
+  static const int MAX_BANDS = 4;
+  int16_t first[MAX_BANDS];
+  int16_t last[MAX_BANDS];
+  int count;
+  
+  void add(int16_t x0, int16_t x1) {
+    if (x0 < 0) x0 = 0;
+    if (x1 > DISPLAY_COLUMNS - 1) x1 = DISPLAY_COLUMNS - 1;
+    for (int i = 0; i < count; i++) {
+      if (x0 <= last[i] + 1 && x1 >= first[i] - 1) {
+        first[i] = min(first[i], x0);
+        last[i] = max(last[i], x1);
+        return;
+      }
+    }
+    if (count == MAX_BANDS) {
+      // Widen the last band rather than track more
+      first[count - 1] = min(first[count - 1], x0);
+      last[count - 1] = max(last[count - 1], x1);
+      return;
+    }
+    first[count] = x0;
+    last[count] = x1;
+    count++;
+  }
+};
+
+DisplayModel panelModel = {};     // What the panel shows (or is refreshing to)
+DirtyColumns refreshedColumns = {};  // Bands of the partial refresh in progress
+bool displayStale = true;         // Model inputs changed since the last render
+bool displayRefreshing = false;   // Refresh started, BUSY not yet low
+bool needsFullRefresh = true;
+uint8_t partialRefreshes = 0;
+unsigned long refreshStartMs = 0;
+
 /**
- * Display normal staff name tag
+ * Mark the display out of date (rendered by serviceDisplay())
  */
-void displayNormalMode() {
+void requestDisplayUpdate() {
+  displayStale = true;
+}
+
+bool isAlertLayout(DisplayLayout layout) {
+  return layout >= LAYOUT_FALL;
+}
+
+/**
+ * Build the display model from the received data
+ */
+void buildDisplayModel(DisplayModel& m) {
+  memset(&m, 0, sizeof(m));
+  
+  if (!currentData.valid || isDataStale()) {
+    m.layout = LAYOUT_WAITING;
+    return;
+  }
+  
+  if (currentData.fall_state == 3) m.layout = LAYOUT_UNCONSCIOUS;
+  else if (currentData.fall_state == 2) m.layout = LAYOUT_FALL;
+  else m.layout = LAYOUT_NORMAL;
+  
+  if (isAlertLayout(m.layout)) {
+    sprintf(m.text[FIELD_HR], "HR: %d BPM", currentData.heart_rate);
+    sprintf(m.text[FIELD_TEMP], "%.1fC", decodeTemperature(currentData.body_temp));
+    return;
+  }
+  
+  sprintf(m.text[FIELD_HR], "HR: %d BPM", currentData.heart_rate);
+  sprintf(m.text[FIELD_TEMP], "Temp: %.1fC", decodeTemperature(currentData.body_temp));
+  
+  // Status text
+  const char* status;
+  switch(currentData.fall_state) {
+    case 0: status = "Status: OK"; break;
+    case 1: status = "Status: WARNING"; break;
+    case 4: status = "Status: RECOVERY"; break;
+    default: status = "Status: UNKNOWN"; break;
+  }
+  strcpy(m.text[FIELD_STATUS], status);
+}
+
+/**
+ * Draw one field into the frame buffer
+ * @param clear Erase the field's area first (partial updates)
+ */
+void drawField(const DisplayModel& m, int id, bool clear) {
+  bool alert = isAlertLayout(m.layout);
+  const DisplayField& f = alert ? ALERT_FIELDS[id] : NORMAL_FIELDS[id];
+  if (clear) {
+    display.setColor(alert ? WHITE : BLACK);  // Clear area (black on the alert screens)
+    display.fillRect(f.clearX, f.clearY, f.clearW, f.clearH);
+  }
+  display.setColor(alert ? BLACK : WHITE);
+  if (m.text[id][0] != '\0') {
+    display.setTextAlignment(f.align);
+    display.setFont(ArialMT_Plain_10);
+    display.drawString(f.x, f.y, m.text[id]);
+  }
+  display.setColor(WHITE);  // Reset color
+}
+
+/**
+ * Draw the whole screen: static layout and every field
+ */
+void drawFullScreen(const DisplayModel& m) {
   display.clear();
   
+  if (isAlertLayout(m.layout)) {
+    // Fill screen (inverted for maximum visibility)
+    display.fillRect(0, 0, display.width(), display.height());
+    display.setColor(BLACK);
+    
+    // Warning text
+    display.setFont(ArialMT_Plain_24);
+    display.setTextAlignment(TEXT_ALIGN_CENTER);
+    display.drawString(display.width() / 2, 10, m.layout == LAYOUT_UNCONSCIOUS ? "UNCONSCIOUS" : "FALL ALERT");
+    
+    // Staff name
+    display.setFont(ArialMT_Plain_16);
+    display.drawString(display.width() / 2, 45, STAFF_NAME);
+    
+    // Alert message
+    display.setFont(ArialMT_Plain_10);
+    display.drawString(display.width() / 2, 105, "IMMEDIATE ASSISTANCE");
+    display.drawString(display.width() / 2, 115, "REQUIRED");
+    
+    display.setColor(WHITE);  // Reset color
+    drawField(m, FIELD_HR, false);
+    drawField(m, FIELD_TEMP, false);
+    return;
+  }
+  
   // Draw border
   display.drawRect(2, 2, display.width() - 4, display.height() - 4);
   display.drawRect(3, 3, display.width() - 6, display.height() - 6);
@@ -188,30 +382,10 @@ void displayNormalMode() {
   display.setFont(ArialMT_Plain_16);
   display.drawString(display.width() / 2, 50, STAFF_TITLE);
   
-  // Status indicator
-  if (currentData.valid && !isDataStale()) {
-    // Display vitals
-    display.setFont(ArialMT_Plain_10);
-    display.setTextAlignment(TEXT_ALIGN_LEFT);
-    
-    char buffer[32];
-    sprintf(buffer, "HR: %d BPM", currentData.heart_rate);
-    display.drawString(10, 75, buffer);
-    
-    sprintf(buffer, "Temp: %.1fC", decodeTemperature(currentData.body_temp));
-    display.drawString(10, 90, buffer);
-    
-    // Status text
-    const char* status;
-    switch(currentData.fall_state) {
-      case 0: status = "Status: OK"; break;
-      case 1: status = "Status: WARNING"; break;
-      case 2: status = "Status: FALL!"; break;
-      case 3: status = "Status: EMERGENCY!"; break;
-      case 4: status = "Status: RECOVERY"; break;
-      default: status = "Status: UNKNOWN"; break;
+  if (m.layout == LAYOUT_NORMAL) {
+    for (int id = 0; id < FIELD_COUNT; id++) {
+      drawField(m, id, false);
     }
-    display.drawString(10, 105, status);
   } else {
     // No data / stale data
     display.setFont(ArialMT_Plain_10);
@@ -223,96 +397,148 @@ void displayNormalMode() {
   display.setFont(ArialMT_Plain_10);
   display.setTextAlignment(TEXT_ALIGN_RIGHT);
   display.drawString(display.width() - 10, display.height() - 15, DEVICE_ID);
-  
-  display.display();
 }
 
 /**
- * Display emergency alert (Fall or Unconscious)
+ * Render scheduler step (loop()) - never waits for the panel
+ *
+ * A new alert goes out at once as a partial refresh of the whole screen
+ * (no full-refresh flashing, so it lands within a few hundred ms of the
+ * packet). Other layout changes get a full refresh; within a layout only
+ * the fields whose text changed are redrawn and written to the panel.
  */
-void displayEmergencyMode(bool show) {
-  display.clear();
+void serviceDisplay() {
+  unsigned long now = millis();
   
-  if (show) {
-    // Fill screen (inverted for maximum visibility)
-    display.fillRect(0, 0, display.width(), display.height());
-    display.setColor(BLACK);
-    
-    // Warning text
-    display.setFont(ArialMT_Plain_24);
-    display.setTextAlignment(TEXT_ALIGN_CENTER);
-    
-    const char* alertText;
-    if (currentData.fall_state == 3) {
-      alertText = "UNCONSCIOUS";
-    } else {
-      alertText = "FALL ALERT";
+  if (displayRefreshing) {
+    if (now - refreshStartMs < DISPLAY_SETTLE_MS || display.isBusy()) return;
+    displayRefreshing = false;
+    // The next partial refresh starts from what the panel now shows
+    for (int i = 0; i < refreshedColumns.count; i++) {
+      display.updateColumns(refreshedColumns.first[i], refreshedColumns.last[i],
+                            DEPG0290BxS800FxX_BW::PREVIOUS_RAM);
     }
-    
-    display.drawString(display.width() / 2, 10, alertText);
-    
-    // Staff name
-    display.setFont(ArialMT_Plain_16);
-    display.drawString(display.width() / 2, 45, STAFF_NAME);
-    
-    // Vitals
-    display.setFont(ArialMT_Plain_10);
-    display.setTextAlignment(TEXT_ALIGN_LEFT);
-    
-    char buffer[32];
-    sprintf(buffer, "HR: %d BPM", currentData.heart_rate);
-    display.drawString(20, 70, buffer);
-    
-    sprintf(buffer, "%.1fC", decodeTemperature(currentData.body_temp));
-    display.drawString(20, 85, buffer);
-    
-    // Alert message
-    display.setTextAlignment(TEXT_ALIGN_CENTER);
-    display.drawString(display.width() / 2, 105, "IMMEDIATE ASSISTANCE");
-    display.drawString(display.width() / 2, 115, "REQUIRED");
-    
-    display.setColor(WHITE);  // Reset color
+    refreshedColumns.count = 0;
   }
   
-  display.display();
+  if (!displayStale) return;
+  
+  DisplayModel next;
+  buildDisplayModel(next);
+  
+  bool layoutChanged = next.layout != panelModel.layout;
+  bool urgent = layoutChanged && isAlertLayout(next.layout) && !needsFullRefresh;
+  if (!urgent && now - refreshStartMs < DISPLAY_MIN_INTERVAL_MS) return;  // Stays stale
+  
+  displayStale = false;
+  
+  DirtyColumns dirty = {};
+  if (urgent) {
+    drawFullScreen(next);
+    dirty.add(0, DISPLAY_COLUMNS - 1);
+    Serial.println("🚨 ENTERING EMERGENCY MODE!");
+  } else if (needsFullRefresh || layoutChanged || partialRefreshes >= DISPLAY_FULL_EVERY) {
+    if (isAlertLayout(panelModel.layout) && !isAlertLayout(next.layout)) {
+      Serial.println("✅ Returning to normal mode");
+    }
+    drawFullScreen(next);
+    display.update(BLACK_BUFFER);
+    display.startRefresh(false);
+    partialRefreshes = 0;
+    needsFullRefresh = false;
+  } else {
+    for (int id = 0; id < FIELD_COUNT; id++) {
+      if (strcmp(next.text[id], panelModel.text[id]) == 0) continue;
+      drawField(next, id, true);
+      const DisplayField& f = isAlertLayout(next.layout) ? ALERT_FIELDS[id] : NORMAL_FIELDS[id];
+      dirty.add(f.clearX, f.clearX + f.clearW - 1);
+    }
+    if (dirty.count == 0) return;  // Nothing visible changed
+  }
+  
+  if (dirty.count > 0) {
+    for (int i = 0; i < dirty.count; i++) {
+      display.updateColumns(dirty.first[i], dirty.last[i]);
+    }
+    display.startRefresh(true);
+    partialRefreshes++;
+    refreshedColumns = dirty;
+  }
+  
+  panelModel = next;
+  refreshStartMs = now;
+  displayRefreshing = true;
 }
 
+// ============================================================================
+// SLEEP BETWEEN EVENTS
+// ============================================================================
+
 /**
- * Update display based on current state
+ * Milliseconds until loop() has timed work: the refresh settling, a
+ * rate-limited render, or the data going stale
  */
-void updateDisplay() {
-  // Check for emergency conditions
-  if (currentData.valid && !isDataStale()) {
-    if (currentData.fall_state == 2 || currentData.fall_state == 3) {
-      // Emergency mode - blink display
-      if (!emergencyMode) {
-        emergencyMode = true;
-        displayState = false;
-        Serial.println("🚨 ENTERING EMERGENCY MODE!");
-      }
-      
-      // Toggle display state for blinking
-      displayState = !displayState;
-      displayEmergencyMode(displayState);
-      
-    } else {
-      // Normal mode
-      if (emergencyMode) {
-        emergencyMode = false;
-        Serial.println("✅ Returning to normal mode");
-      }
-      displayNormalMode();
-    }
+unsigned long msUntilNextWork(unsigned long limit) {
+  unsigned long now = millis();
+  unsigned long wait = limit;
+  
+  if (displayRefreshing && now - refreshStartMs < DISPLAY_SETTLE_MS) {
+    wait = min(wait, DISPLAY_SETTLE_MS - (now - refreshStartMs));
+  }
+  if (displayStale && !displayRefreshing) {
+    unsigned long elapsed = now - refreshStartMs;
+    wait = min(wait, elapsed < DISPLAY_MIN_INTERVAL_MS ? DISPLAY_MIN_INTERVAL_MS - elapsed : 0UL);
+  }
+  if (dataLive) {
+    unsigned long age = now - lastUARTReceive;
+    wait = min(wait, age <= UART_TIMEOUT_MS ? UART_TIMEOUT_MS - age + 1 : 0UL);
+  }
+  return wait;
+}
+
+/**
+ * Idle until the next event or for at most ms
+ *
+ * Light sleep wakes on the UART RX line (the start bit of the wearable's
+ * wake preamble), the button, the panel's BUSY line going low, or the
+ * timer. After a wake-up the UART driver is given UART_WAKE_WINDOW_MS to
+ * receive the frame behind the preamble before the next sleep.
+ */
+void waitForEvent(unsigned long ms) {
+  if (ms == 0) return;
+  
+#if INDICATOR_LIGHT_SLEEP
+  unsigned long now = millis();
+  if ((long)(now - awakeUntilMs) < 0) {
+    ms = min(ms, awakeUntilMs - now);
+  } else if (!wearableLink.rxPending() && digitalRead(BUTTON_PIN) == HIGH) {
+    // BUSY is low until the refresh has really started
+    bool watchBusy = displayRefreshing && now - refreshStartMs >= DISPLAY_SETTLE_MS;
     
-  } else {
-    // No data or stale data - show normal mode
-    if (emergencyMode) {
-      emergencyMode = false;
+    wearableLink.flush(pdMS_TO_TICKS(10));  // The UART clock stops while asleep
+    gpio_wakeup_enable((gpio_num_t)UART_RX, GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+    if (watchBusy) gpio_wakeup_enable((gpio_num_t)display.busyPin(), GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+    
+    esp_light_sleep_start();
+    
+    gpio_wakeup_disable((gpio_num_t)UART_RX);
+    gpio_wakeup_disable((gpio_num_t)BUTTON_PIN);
+    if (watchBusy) gpio_wakeup_disable((gpio_num_t)display.busyPin());
+    
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+      awakeUntilMs = millis() + UART_WAKE_WINDOW_MS;
     }
-    displayNormalMode();
+    return;
   }
+#endif
   
-  lastDisplayUpdate = millis();
+  // Block on the UART event queue
+  if (readUARTPacket(pdMS_TO_TICKS(min(ms, (unsigned long)BUTTON_POLL_MS)))) {
+    requestDisplayUpdate();
+  }
 }
 
 // ============================================================================
@@ -340,8 +566,11 @@ void setup() {
   delay(100);
   
   // Initialize UART communication with Wireless Stick V3
-  Serial1.begin(UART_BAUD, SERIAL_8N1, UART_RX, UART_TX);
-  Serial.printf("UART initialized: RX=%d, TX=%d, Baud=%d\n", UART_RX, UART_TX, UART_BAUD);
+  if (wearableLink.begin(UART_NUM_1, UART_TX, UART_RX, UART_BAUD)) {
+    Serial.printf("UART initialized: RX=%d, TX=%d, Baud=%d\n", UART_RX, UART_TX, UART_BAUD);
+  } else {
+    Serial.println("❌ UART init failed");
+  }
   
   // Initialize E-ink display
   Serial.println("Initializing E-ink display...");
@@ -351,14 +580,17 @@ void setup() {
   
   Serial.println("✅ E-ink display initialized!");
   
-  // Display initial screen
+  // Display initial screen (refreshes in the background)
   Serial.println("Displaying initial staff badge...");
-  displayNormalMode();
+  serviceDisplay();
   
   Serial.println("\n========================================");
   Serial.println("  SYSTEM READY");
   Serial.println("========================================");
   Serial.println("Waiting for data from Wireless Stick V3...\n");
+#if INDICATOR_LIGHT_SLEEP
+  Serial.println("💤 Light sleep between events (USB console drops while asleep)");
+#endif
   
   // Send dummy test packet after 5 seconds
   Serial.println("⏱️  Sending dummy test packet in 5 seconds...");
@@ -369,27 +601,24 @@ void setup() {
 // ============================================================================
 void sendDummyPacket() {
   // Create dummy realtime packet (10 bytes)
-  uint8_t dummyPacket[10];
-  
-  dummyPacket[0] = 0x01;  // Packet type: Realtime
-  dummyPacket[1] = 75;    // Heart rate: 75 BPM
-  dummyPacket[2] = 144;   // Body temp: 36.5°C encoded: (36.5+20)/100*255 = 144
-  dummyPacket[3] = 102;   // Ambient temp: 20°C encoded: (20+20)/100*255 = 102
-  dummyPacket[4] = 50;    // Noise level: Low
-  dummyPacket[5] = 0;     // Fall state: Normal
-  dummyPacket[6] = 0;     // Alert flags: None
-  dummyPacket[7] = 200;   // RSSI (dummy)
-  dummyPacket[8] = 100;   // SNR (dummy)
-  dummyPacket[9] = 0;     // Reserved
+  uint8_t dummyPacket[RealtimePacket::SIZE];
+  size_t len = RealtimePacket::write(dummyPacket,
+                                     75,                         // Heart rate: 75 BPM
+                                     TempCode::encode(36.5f),    // Body temp
+                                     TempCode::encode(20.0f),    // Ambient temp
+                                     50,                         // Noise level: Low
+                                     0,                          // Fall state: Normal
+                                     0);                         // Alert flags: None
   
   // Send via UART
-  Serial1.write(dummyPacket, 10);
+  wearableLink.send(UartFrame::REALTIME, dummyPacket, len);
   
+  RealtimePacket::View packet(dummyPacket, len);
   Serial.println("📤 Dummy packet sent via UART:");
   Serial.printf("   HR=%d, Temp=%.1f°C, Fall State=%d\n", 
-                dummyPacket[1], 
-                decodeTemperature(dummyPacket[2]), 
-                dummyPacket[5]);
+                packet.heartRate(), 
+                packet.bodyTemp(), 
+                packet.fallState());
 }
 
 // ============================================================================
@@ -405,19 +634,17 @@ void loop() {
     dummyPacketSent = true;
   }
   
-  // Read UART data
-  if (readUARTPacket()) {
+  // Take every frame the driver holds; a new packet is rendered at once
+  if (readUARTPacket(0)) {
     Serial.println("✅ Packet received and processed");
-    // Immediately update display when new data arrives
-    updateDisplay();
+    requestDisplayUpdate();
   }
   
-  // Update display based on mode and timing
-  unsigned long currentTime = millis();
-  unsigned long updateInterval = emergencyMode ? EMERGENCY_BLINK_MS : NORMAL_REFRESH_MS;
-  
-  if (currentTime - lastDisplayUpdate >= updateInterval) {
-    updateDisplay();
+  // Data going stale swaps the vitals for "waiting"
+  bool live = currentData.valid && !isDataStale();
+  if (live != dataLive) {
+    dataLive = live;
+    requestDisplayUpdate();
   }
   
   // Check for manual refresh button (send new dummy packet on press)
@@ -425,10 +652,17 @@ void loop() {
     Serial.println("🔄 Button pressed - sending new dummy packet");
     delay(200);  // Debounce
     sendDummyPacket();
-    updateDisplay();
+    requestDisplayUpdate();
     while(digitalRead(BUTTON_PIN) == LOW) delay(10);  // Wait for release
   }
   
-  // Small delay to prevent CPU hogging
-  delay(10);
-}
\ No newline at end of file
+  serviceDisplay();
+  
+  // Sleep until the next frame, button press, refresh completion or timer
+  unsigned long limit = 60000;
+  if (!dummyPacketSent) {
+    unsigned long elapsed = millis() - startTime;
+    limit = elapsed < 5000 ? 5000 - elapsed : 0;
+  }
+  waitForEvent(msUntilNextWork(limit));
+}
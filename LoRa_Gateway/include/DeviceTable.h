@@ -0,0 +1,266 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <Arduino.h>
+
+/**
+ * DeviceState - Everything the gateway keeps about one wearable
+ *
+ * Frame counters are checked against a sliding window of the last
+ * FRAME_WINDOW values. Each window slot also remembers a hash of the
+ * packet that used it: wearables retransmit byte-identical copies, so a
+ * counter already seen with the same hash is a duplicate, and with a
+ * different hash the wearable has restarted. A counter older than the
+ * window is a replay - unless it is small, which is also a restart
+ * (counters start from zero at boot).
+ */
+struct DeviceState {
+  static const int FRAME_WINDOW = 32;      // Counters tracked behind the highest
+  static const uint16_t RESTART_COUNTER_MAX = 64;
+  static const int SNR_HISTORY = 10;       // ADR samples
+
+  enum FrameStatus {
+    FRAME_NEW = 0,
+    FRAME_DUPLICATE = 1,
+    FRAME_REPLAY = 2,
+    FRAME_RESTART = 3
+  };
+
+  uint16_t shortId;
+  char deviceId[11];   // Learned from classic frames, "ID-XXXX" until then
+  bool idKnown;
+
+  // Frame counter window
+  bool synced;
+  uint16_t highestCounter;
+  uint32_t seenMask;                   // Bit i: highestCounter - i received
+  uint32_t seenHash[FRAME_WINDOW];     // Packet hash per counter % FRAME_WINDOW
+
+  // Counters
+  uint32_t received;
+  uint32_t duplicates;
+  uint32_t replays;
+  uint32_t lost;                       // Counter values never seen
+  uint32_t restarts;
+
+  // Newest packet (what the display shows for this device)
+  uint8_t type;        // 1=Realtime (also batches), 2=ECG, 3=Fall
+  uint8_t readings;    // Readings carried (1, or the batch size)
+  uint16_t frameCounter;
+
+  // Latest vitals (realtime readings and fall events)
+  int8_t heartRate;
+  float temperature;
+  uint8_t noiseLevel;
+  uint8_t fallState;   // 0=Normal, 1=Warning, 2=Fall, 3=DANGEROUS/Unconscious, 4=Recovery
+  bool fallDetected;
+  bool noiseAlert;
+  bool hrAlert;
+  bool tempAlert;
+
+  // Link
+  int16_t rssi;
+  float snr;
+  float rssiAverage;   // Exponential average, 1/8 weight per packet
+  unsigned long lastSeenMs;
+  unsigned long lastAckMs;
+
+  // ADR (see updateAdr() in main.cpp)
+  int8_t adrSnr[SNR_HISTORY];
+  uint8_t adrSnrCount;
+  uint8_t adrSnrNext;
+  uint8_t adrSf;       // Last setting sent
+  int8_t adrPower;
+  unsigned long adrCommandMs;
+
+  /**
+   * Classify a frame counter
+   * @param counter First frame counter of the packet
+   * @param hash packetHash() of the whole packet
+   */
+  FrameStatus checkFrame(uint16_t counter, uint32_t hash) const {
+    if (!synced) return FRAME_NEW;
+
+    int16_t delta = (int16_t)(counter - highestCounter);
+    if (delta > 0) return FRAME_NEW;
+    if (-delta < FRAME_WINDOW) {
+      if (!(seenMask & (1UL << -delta))) return FRAME_NEW;  // Late, not seen yet
+      return seenHash[counter % FRAME_WINDOW] == hash ? FRAME_DUPLICATE : FRAME_RESTART;
+    }
+    return counter < RESTART_COUNTER_MAX ? FRAME_RESTART : FRAME_REPLAY;
+  }
+
+  /**
+   * Record an accepted packet
+   * @param counter First frame counter of the packet
+   * @param span Counter values it uses (readings in a batch)
+   * @param hash packetHash() of the whole packet
+   * @param status Result of checkFrame()
+   */
+  void acceptFrame(uint16_t counter, uint8_t span, uint32_t hash, FrameStatus status) {
+    if (!synced || status == FRAME_RESTART) {
+      if (status == FRAME_RESTART) restarts++;
+      synced = true;
+      highestCounter = counter;
+      seenMask = 0;
+    }
+
+    for (uint8_t i = 0; i < span; i++) {
+      uint16_t c = counter + i;
+      int16_t delta = (int16_t)(c - highestCounter);
+      if (delta > 0) {
+        lost += delta - 1;
+        seenMask = delta >= FRAME_WINDOW ? 0 : seenMask << delta;
+        highestCounter = c;
+        delta = 0;
+      } else if (-delta >= FRAME_WINDOW) {
+        continue;
+      } else if (delta < 0 && !(seenMask & (1UL << -delta)) && lost > 0) {
+        lost--;  // Counted as lost when the gap appeared
+      }
+      seenMask |= 1UL << -delta;
+      seenHash[c % FRAME_WINDOW] = hash;
+    }
+    received++;
+  }
+
+  /**
+   * Update the link statistics from a received packet
+   */
+  void updateLink(int16_t packetRssi, float packetSnr, unsigned long now) {
+    rssiAverage = received == 0 ? packetRssi : rssiAverage + (packetRssi - rssiAverage) / 8.0f;
+    rssi = packetRssi;
+    snr = packetSnr;
+    lastSeenMs = now;
+  }
+
+  void setName(const char* id) {
+    strncpy(deviceId, id, 10);
+    deviceId[10] = '\0';
+    idKnown = true;
+  }
+};
+
+/**
+ * DeviceTable - Fixed-capacity device table indexed by short ID
+ *
+ * Entries live in a pool that never moves (callers may keep pointers);
+ * an open-addressing hash index with linear probing maps short IDs to
+ * pool slots, so a lookup per packet costs one or two probes. The index
+ * has twice as many slots as the pool. When the pool is full the device
+ * heard least recently is evicted and its index slot removed by
+ * backward-shift deletion, so no tombstones build up.
+ */
+class DeviceTable {
+public:
+  static const int CAPACITY = 32;
+  static const int INDEX_SLOTS = 64;   // Power of two, load <= 0.5
+
+private:
+  DeviceState devices[CAPACITY];
+  int8_t index[INDEX_SLOTS];           // Pool index, -1 = empty
+  int count;
+
+  static int home(uint16_t shortId) {
+    return (uint16_t)(shortId * 40503u) >> 10;  // Fibonacci hash to 6 bits
+  }
+
+  static int next(int slot) {
+    return (slot + 1) & (INDEX_SLOTS - 1);
+  }
+
+  /**
+   * Index slot holding a short ID, -1 if absent
+   */
+  int findSlot(uint16_t shortId) const {
+    for (int slot = home(shortId); index[slot] >= 0; slot = next(slot)) {
+      if (devices[index[slot]].shortId == shortId) return slot;
+    }
+    return -1;
+  }
+
+  /**
+   * Empty an index slot and pull later entries of the probe run back
+   */
+  void removeSlot(int hole) {
+    index[hole] = -1;
+    for (int slot = next(hole); index[slot] >= 0; slot = next(slot)) {
+      int want = home(devices[index[slot]].shortId);
+      // Entry may move into the hole unless its home lies in (hole, slot]
+      bool stays = hole <= slot ? (hole < want && want <= slot) : (hole < want || want <= slot);
+      if (stays) continue;
+      index[hole] = index[slot];
+      index[slot] = -1;
+      hole = slot;
+    }
+  }
+
+public:
+  DeviceTable() {
+    clear();
+  }
+
+  void clear() {
+    for (int i = 0; i < INDEX_SLOTS; i++) index[i] = -1;
+    count = 0;
+  }
+
+  DeviceState* find(uint16_t shortId) {
+    int slot = findSlot(shortId);
+    return slot < 0 ? nullptr : &devices[index[slot]];
+  }
+
+  /**
+   * Entry for a short ID, created (evicting the stalest device if full)
+   * @param now millis(), the new entry's last-seen time
+   */
+  DeviceState* findOrAdd(uint16_t shortId, unsigned long now) {
+    DeviceState* existing = find(shortId);
+    if (existing) return existing;
+
+    int entry;
+    if (count < CAPACITY) {
+      entry = count++;
+    } else {
+      entry = 0;
+      for (int i = 1; i < CAPACITY; i++) {
+        if (now - devices[i].lastSeenMs > now - devices[entry].lastSeenMs) entry = i;
+      }
+      removeSlot(findSlot(devices[entry].shortId));
+    }
+
+    DeviceState& dev = devices[entry];
+    memset(&dev, 0, sizeof(DeviceState));
+    dev.shortId = shortId;
+    snprintf(dev.deviceId, sizeof(dev.deviceId), "ID-%04X", shortId);
+    dev.heartRate = -1;
+    dev.lastSeenMs = now;
+
+    int slot = home(shortId);
+    while (index[slot] >= 0) slot = next(slot);
+    index[slot] = entry;
+    return &dev;
+  }
+
+  int size() const {
+    return count;
+  }
+
+  DeviceState& at(int i) {
+    return devices[i];
+  }
+
+  /**
+   * 32-bit FNV-1a of a whole packet (duplicate check)
+   */
+  static uint32_t packetHash(const uint8_t* data, int length) {
+    uint32_t hash = 2166136261UL;
+    for (int i = 0; i < length; i++) {
+      hash ^= data[i];
+      hash *= 16777619UL;
+    }
+    return hash;
+  }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef DOWNLINK_BUDGET_H
+#define DOWNLINK_BUDGET_H
+
+#include <Arduino.h>
+#include "LinkConfig.h"
+
+/**
+ * DownlinkBudget - The gateway's own duty-cycle limit for ACKs and ADR
+ *
+ * The gateway is a transmitter like any wearable and falls under the same
+ * limit (RadioConfig::DUTY_CYCLE of every rolling hour). Every downlink is
+ * charged its time-on-air in one-minute buckets, as the wearable's LoRaComm
+ * does for its uplinks. allows() refuses a downlink that would take the
+ * hour over its share of the budget: ACKs may use all of it, ADR only
+ * part, so alert ACKs still go out when ADR traffic is heavy.
+ *
+ * allows() and charge() belong to the radio task; the totals may be read
+ * from any task.
+ */
+class DownlinkBudget {
+public:
+  static const int BUCKETS = 60;
+  static const uint32_t BUCKET_MS = 60000;
+
+private:
+  uint32_t bucketAirtime[BUCKETS];
+  uint32_t bucketMinute[BUCKETS];
+  uint32_t sent;
+  uint32_t refused;
+  mutable portMUX_TYPE mux;
+
+  /**
+   * Airtime charged in the hour ending at now (mux held)
+   */
+  uint32_t sumBuckets(uint32_t now) const {
+    uint32_t minute = now / BUCKET_MS;
+    uint32_t used = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      if (bucketMinute[i] != 0xFFFFFFFF && minute - bucketMinute[i] < BUCKETS) {
+        used += bucketAirtime[i];
+      }
+    }
+    return used;
+  }
+
+public:
+  DownlinkBudget() {
+    for (int i = 0; i < BUCKETS; i++) {
+      bucketAirtime[i] = 0;
+      bucketMinute[i] = 0xFFFFFFFF;
+    }
+    sent = 0;
+    refused = 0;
+    mux = portMUX_INITIALIZER_UNLOCKED;
+  }
+
+  /**
+   * Airtime allowed per rolling hour (ms)
+   */
+  static uint32_t budgetMs() {
+    return (uint32_t)(3600000.0f * RadioConfig::DUTY_CYCLE);
+  }
+
+  /**
+   * Check a downlink against the budget (counts a refusal)
+   * @param airtimeMs Its time-on-air
+   * @param now millis()
+   * @param share Part of the budget this kind of downlink may fill
+   */
+  bool allows(uint32_t airtimeMs, uint32_t now, float share = 1.0f) {
+    portENTER_CRITICAL(&mux);
+    bool ok = sumBuckets(now) + airtimeMs <= (uint32_t)(budgetMs() * share);
+    if (!ok) refused++;
+    portEXIT_CRITICAL(&mux);
+    return ok;
+  }
+
+  /**
+   * Charge a downlink that went on air
+   */
+  void charge(uint32_t airtimeMs, uint32_t now) {
+    uint32_t minute = now / BUCKET_MS;
+    int idx = minute % BUCKETS;
+    portENTER_CRITICAL(&mux);
+    if (bucketMinute[idx] != minute) {
+      bucketMinute[idx] = minute;
+      bucketAirtime[idx] = 0;
+    }
+    bucketAirtime[idx] += airtimeMs;
+    sent++;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  /**
+   * Airtime used in the last hour (ms)
+   */
+  uint32_t usedMs(uint32_t now) const {
+    portENTER_CRITICAL(&mux);
+    uint32_t used = sumBuckets(now);
+    portEXIT_CRITICAL(&mux);
+    return used;
+  }
+
+  uint32_t getSentCount() const {
+    return sent;
+  }
+
+  uint32_t getRefusedCount() const {
+    return refused;
+  }
+};
+
+#endif
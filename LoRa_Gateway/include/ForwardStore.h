@@ -0,0 +1,545 @@
+#ifndef FORWARD_STORE_H
+#define FORWARD_STORE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "UartLink.h"
+
+/**
+ * ForwardStore - Store-and-forward queue for packets bound for the Pi
+ *
+ * Every packet forwarded over the UART first gets a record ID and is kept
+ * until the Pi acknowledges it (UartFrame::HOST_ACK, cumulative, sent once
+ * the backend has stored the packet). IDs are consecutive, so the pending
+ * records are always the range after the last acknowledged ID:
+ *
+ *   [flash segments: oldest ...][RAM ring: newest]
+ *
+ * The RAM ring (PSRAM when fitted) absorbs bursts and short outages. When
+ * it fills past 3/4, or the Pi has been away for SPILL_AFTER_MS, the oldest
+ * records move to append-only segment files on LittleFS, which also survive
+ * a gateway restart. Acknowledged segments are deleted whole, and when
+ * flash runs out the oldest segment is given up.
+ *
+ * While the Pi is online each new record is sent at once (live). After an
+ * outage the backlog is replayed from the oldest unacknowledged record, at
+ * most REPLAY_WINDOW records ahead of the acknowledgements, next to the
+ * live records rather than in front of them. If acknowledgements stop
+ * advancing for ACK_TIMEOUT_MS, or the Pi repeats the same ID for
+ * DUPLICATE_ACKS records (one went missing), everything unacknowledged is
+ * sent again; the Pi discards IDs it has already delivered.
+ */
+class ForwardStore {
+public:
+  static const uint16_t MAX_DATA = 268;          // Classic header + 255 bytes
+  static const uint32_t RAM_SLOTS_PSRAM = 2048;  // Power of two, ~600 KB of PSRAM
+  static const uint32_t RAM_SLOTS_HEAP = 32;     // Power of two, without PSRAM
+  static const uint32_t SEGMENT_RECORDS = 256;   // Records per flash segment
+  static const int MAX_SEGMENTS = 128;
+  static const uint32_t SPILL_BATCH = 64;        // Records moved to flash per service()
+  static const uint32_t HOST_TIMEOUT_MS = 5000;  // The Pi sends HOST_ACK every second
+  static const uint32_t ACK_TIMEOUT_MS = 3000;
+  static const uint8_t DUPLICATE_ACKS = 3;       // Same ID again - a record went missing
+  static const uint32_t SPILL_AFTER_MS = 30000;
+  static const uint32_t REPLAY_WINDOW = 64;      // Replayed records ahead of the ACKs
+  static const uint32_t AGE_UNKNOWN = 0xFFFFFFFF;
+
+  struct Record {
+    uint32_t id;
+    int64_t rxUs;      // esp_timer_get_time() at reception
+    int16_t rssi;
+    int8_t snr4;       // SNR x4
+    uint16_t length;
+    uint8_t data[MAX_DATA];
+  };
+
+private:
+  static const size_t RECORD_HEADER = 17;  // id, rxUs, rssi, snr4, length (flash)
+
+  Record* ring;
+  uint32_t ringSlots;
+
+  uint32_t nextId;       // ID of the next pushed record
+  uint32_t ramFirstId;   // Oldest record in RAM (older ones are in flash)
+  uint32_t acked;        // Highest ID the Pi acknowledged
+  uint32_t bootFirstId;  // Records below were stored before this boot
+
+  // Flash segments, oldest first (file name = first record ID)
+  bool flashOk;
+  uint32_t segments[MAX_SEGMENTS];
+  int segmentCount;
+  File writer;           // Open on the last segment
+  uint32_t writerRecords;
+  File reader;
+  int readerSegment;
+  uint32_t readerNextId;
+  Record scratch;        // Record read back from flash
+
+  // Link to the Pi
+  bool online;
+  uint32_t hostSeenMs;
+  uint32_t ackProgressMs;
+  uint8_t duplicateAcks;
+  uint32_t lastSentId;
+  uint32_t replayNext;   // Next backlog record
+  uint32_t replayEnd;    // Records from here on are sent live
+  uint32_t liveNext;
+
+  // Statistics
+  uint32_t stored;
+  uint32_t spilled;
+  uint32_t dropped;
+  uint32_t replayed;
+  uint32_t retransmits;
+
+  static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+  }
+
+  static void segmentPath(uint32_t firstId, char* path) {
+    snprintf(path, 24, "/fwd/%08lx", (unsigned long)firstId);
+  }
+
+  Record& slot(uint32_t id) {
+    return ring[id & (ringSlots - 1)];
+  }
+
+  bool writeRecord(const Record& r) {
+    if (!writer || writerRecords >= SEGMENT_RECORDS) {
+      if (!openSegment(r.id)) return false;
+    }
+
+    uint8_t head[RECORD_HEADER];
+    memcpy(head, &r.id, 4);
+    memcpy(head + 4, &r.rxUs, 8);
+    memcpy(head + 12, &r.rssi, 2);
+    head[14] = (uint8_t)r.snr4;
+    memcpy(head + 15, &r.length, 2);
+    uint16_t crc = UartFrame::crc16(head, RECORD_HEADER);
+    crc = UartFrame::crc16(r.data, r.length, crc);
+
+    bool ok = writer.write(head, RECORD_HEADER) == RECORD_HEADER &&
+              writer.write(r.data, r.length) == r.length &&
+              writer.write((const uint8_t*)&crc, 2) == 2;
+    if (ok) writerRecords++;
+    return ok;
+  }
+
+  /**
+   * Read one record, false at the end of the file or a torn / corrupt one
+   */
+  static bool readRecord(File& file, Record& r) {
+    uint8_t head[RECORD_HEADER];
+    if (file.read(head, RECORD_HEADER) != RECORD_HEADER) return false;
+    memcpy(&r.id, head, 4);
+    memcpy(&r.rxUs, head + 4, 8);
+    memcpy(&r.rssi, head + 12, 2);
+    r.snr4 = (int8_t)head[14];
+    memcpy(&r.length, head + 15, 2);
+    if (r.length > MAX_DATA) return false;
+
+    uint16_t crc;
+    if (file.read(r.data, r.length) != r.length) return false;
+    if (file.read((uint8_t*)&crc, 2) != 2) return false;
+    uint16_t check = UartFrame::crc16(head, RECORD_HEADER);
+    return UartFrame::crc16(r.data, r.length, check) == crc;
+  }
+
+  bool openSegment(uint32_t firstId) {
+    if (writer) writer.close();
+    bool full = LittleFS.usedBytes() > LittleFS.totalBytes() / 10 * 9;
+    if ((segmentCount == MAX_SEGMENTS || full) && !dropSegment()) return false;
+
+    char path[24];
+    segmentPath(firstId, path);
+    writer = LittleFS.open(path, FILE_WRITE);
+    if (!writer) return false;
+    segments[segmentCount++] = firstId;
+    writerRecords = 0;
+    return true;
+  }
+
+  /**
+   * Give up the oldest segment (flash full)
+   */
+  bool dropSegment() {
+    if (segmentCount == 0) return false;
+    uint32_t end = segmentCount > 1 ? segments[1] : ramFirstId;
+    if (before(acked, end - 1)) {
+      uint32_t from = before(acked, segments[0]) ? segments[0] : acked + 1;
+      dropped += end - from;
+      acked = end - 1;  // The Pi learns it from the floor ID
+    }
+    removeOldestSegment();
+    return true;
+  }
+
+  void removeOldestSegment() {
+    if (reader) reader.close();
+    if (segmentCount == 1 && writer) writer.close();
+    char path[24];
+    segmentPath(segments[0], path);
+    LittleFS.remove(path);
+    for (int i = 1; i < segmentCount; i++) segments[i - 1] = segments[i];
+    segmentCount--;
+    readerSegment = -1;
+  }
+
+  void openReader(uint32_t id) {
+    if (reader) reader.close();
+    readerSegment = 0;
+    for (int i = segmentCount - 1; i > 0; i--) {
+      if (!before(id, segments[i])) {
+        readerSegment = i;
+        break;
+      }
+    }
+    openReaderSegment();
+  }
+
+  void openReaderSegment() {
+    if (readerSegment < 0 || readerSegment >= segmentCount) {
+      readerSegment = -1;
+      return;
+    }
+    if (writer) writer.flush();
+    char path[24];
+    segmentPath(segments[readerSegment], path);
+    reader = LittleFS.open(path, FILE_READ);
+    readerNextId = segments[readerSegment];
+  }
+
+  /**
+   * Record with the given ID, or the next one after a gap
+   * @param id Updated to the ID of the returned record
+   * @return Record (valid until the next call), nullptr if none is left
+   */
+  const Record* fetch(uint32_t& id) {
+    if (!before(id, ramFirstId)) {
+      return before(id, nextId) ? &slot(id) : nullptr;
+    }
+
+    if (!reader || readerNextId != id) openReader(id);
+    while (reader) {
+      if (!readRecord(reader, scratch)) {
+        reader.close();
+        readerSegment++;
+        openReaderSegment();
+        continue;
+      }
+      readerNextId = scratch.id + 1;
+      if (before(scratch.id, id)) continue;
+      if (!before(scratch.id, ramFirstId)) break;  // Stale copy, RAM is newer
+      id = scratch.id;
+      return &scratch;
+    }
+
+    // Flash exhausted - continue in RAM
+    id = ramFirstId;
+    return before(id, nextId) ? &slot(id) : nullptr;
+  }
+
+  /**
+   * Recover the segments left by the previous boot
+   */
+  void recover() {
+    File dir = LittleFS.open("/fwd");
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      const char* name = strrchr(f.name(), '/');
+      name = name ? name + 1 : f.name();
+      f.close();
+      if (segmentCount == MAX_SEGMENTS) continue;
+      segments[segmentCount++] = strtoul(name, nullptr, 16);
+    }
+    dir.close();
+
+    // Insertion sort, oldest first
+    for (int i = 1; i < segmentCount; i++) {
+      uint32_t id = segments[i];
+      int j = i - 1;
+      for (; j >= 0 && before(id, segments[j]); j--) segments[j + 1] = segments[j];
+      segments[j + 1] = id;
+    }
+    if (segmentCount == 0) return;
+
+    // The newest record ends the flash range
+    char path[24];
+    segmentPath(segments[segmentCount - 1], path);
+    File last = LittleFS.open(path, FILE_READ);
+    nextId = segments[segmentCount - 1];
+    while (last && readRecord(last, scratch)) nextId = scratch.id + 1;
+    if (last) last.close();
+
+    // Nothing valid in it - the next segment reuses the name
+    if (nextId == segments[segmentCount - 1]) {
+      LittleFS.remove(path);
+      segmentCount--;
+    }
+  }
+
+  void clearFlash() {
+    if (writer) writer.close();
+    while (segmentCount > 0) removeOldestSegment();
+  }
+
+  void rewind(uint32_t now) {
+    replayNext = acked + 1;
+    replayEnd = nextId;
+    liveNext = nextId;
+    ackProgressMs = now;
+    duplicateAcks = 0;
+  }
+
+public:
+  ForwardStore() {
+    ring = nullptr;
+    ringSlots = 0;
+    nextId = 0;
+    ramFirstId = 0;
+    acked = 0;
+    bootFirstId = 0;
+    flashOk = false;
+    segmentCount = 0;
+    writerRecords = 0;
+    readerSegment = -1;
+    readerNextId = 0;
+    online = false;
+    hostSeenMs = 0;
+    ackProgressMs = 0;
+    duplicateAcks = 0;
+    lastSentId = 0;
+    replayNext = 0;
+    replayEnd = 0;
+    liveNext = 0;
+    stored = 0;
+    spilled = 0;
+    dropped = 0;
+    replayed = 0;
+    retransmits = 0;
+  }
+
+  /**
+   * Allocate the RAM ring and recover flash segments from the last boot
+   * @return false if no RAM could be allocated
+   */
+  bool begin() {
+    ringSlots = RAM_SLOTS_PSRAM;
+    ring = psramFound() ? (Record*)ps_malloc(sizeof(Record) * ringSlots) : nullptr;
+    if (!ring) {
+      ringSlots = RAM_SLOTS_HEAP;
+      ring = (Record*)malloc(sizeof(Record) * ringSlots);
+    }
+    if (!ring) return false;
+
+    flashOk = LittleFS.begin(true) && (LittleFS.exists("/fwd") || LittleFS.mkdir("/fwd"));
+    if (flashOk) recover();
+
+    if (segmentCount == 0) {
+      if (nextId == 0) nextId = esp_random();  // Fresh ID range - the Pi resynchronises on it
+      acked = nextId - 1;
+    } else {
+      acked = segments[0] - 1;
+    }
+    ramFirstId = nextId;
+    bootFirstId = nextId;
+    rewind(millis());
+    lastSentId = acked;
+    return true;
+  }
+
+  /**
+   * Store a packet for the Pi
+   * @param rxUs esp_timer_get_time() when it was received
+   * @return Record ID
+   */
+  uint32_t push(const uint8_t* data, uint16_t length, int16_t rssi, float snr, int64_t rxUs) {
+    if (length > MAX_DATA) length = MAX_DATA;
+
+    if (nextId - ramFirstId >= ringSlots) {
+      // Ring full - make room in flash, or lose the oldest record
+      if (!flashOk || !writeRecord(slot(ramFirstId))) {
+        dropped++;
+        if (segmentCount == 0) acked = ramFirstId;
+      } else {
+        spilled++;
+        writer.flush();
+      }
+      ramFirstId++;
+    }
+
+    Record& r = slot(nextId);
+    r.id = nextId;
+    r.rxUs = rxUs;
+    r.rssi = rssi;
+    r.snr4 = (int8_t)constrain(lroundf(snr * 4), -128, 127);
+    r.length = length;
+    memcpy(r.data, data, length);
+    stored++;
+    return nextId++;
+  }
+
+  /**
+   * Any frame from the Pi - it is online
+   */
+  void hostSeen(uint32_t now) {
+    if (!online) {
+      online = true;
+      rewind(now);  // Catch up from the oldest unacknowledged record
+    }
+    hostSeenMs = now;
+  }
+
+  /**
+   * HOST_ACK: every record up to id has been delivered (sent by the Pi
+   * for each record it receives)
+   */
+  void acknowledge(uint32_t id, uint32_t now) {
+    hostSeen(now);
+    if (id == acked && before(acked, lastSentId)) {
+      // Later records arrive but not the next one - resend from there
+      if (++duplicateAcks >= DUPLICATE_ACKS) {
+        rewind(now);
+        retransmits++;
+      }
+      return;
+    }
+    if (!before(acked, id) || !before(id, nextId)) return;  // Old or unknown
+    acked = id;
+    ackProgressMs = now;
+    duplicateAcks = 0;
+
+    if (!before(acked + 1, ramFirstId)) {
+      // Everything in flash delivered
+      if (before(ramFirstId, acked + 1)) ramFirstId = acked + 1;
+      if (segmentCount > 0) clearFlash();
+    } else {
+      while (segmentCount > 1 && !before(acked, segments[1] - 1)) removeOldestSegment();
+    }
+    if (before(replayNext, acked + 1)) replayNext = acked + 1;
+  }
+
+  /**
+   * Housekeeping (loop()): online timeout, retransmission, moving old
+   * records to flash
+   */
+  void service(uint32_t now) {
+    if (online && now - hostSeenMs > HOST_TIMEOUT_MS) online = false;
+
+    // Acknowledgements stalled - send everything unacknowledged again
+    if (online && before(acked, lastSentId) && now - ackProgressMs > ACK_TIMEOUT_MS) {
+      rewind(now);
+      retransmits++;
+    }
+
+    uint32_t inRam = nextId - ramFirstId;
+    uint32_t spill = 0;
+    if (inRam > ringSlots / 4 * 3) {
+      spill = inRam - ringSlots / 2;
+    } else if (!online && now - hostSeenMs > SPILL_AFTER_MS) {
+      spill = inRam;  // Long outage - keep it safe across a restart
+    }
+    if (!flashOk || spill == 0) return;
+
+    if (spill > SPILL_BATCH) spill = SPILL_BATCH;
+    for (; spill > 0; spill--) {
+      if (!writeRecord(slot(ramFirstId))) break;
+      ramFirstId++;
+      spilled++;
+    }
+    if (writer) writer.flush();
+  }
+
+  /**
+   * Next record to send to the Pi: new records first, then the backlog
+   * @return Record (valid until the next call), nullptr if nothing is due
+   */
+  const Record* nextToSend(uint32_t now) {
+    if (!online) return nullptr;
+
+    uint32_t id;
+    const Record* r = nullptr;
+    if (before(liveNext, nextId)) {
+      id = liveNext;
+      r = fetch(id);
+      liveNext = r ? id + 1 : nextId;
+    } else if (before(replayNext, replayEnd) && replayNext - acked <= REPLAY_WINDOW) {
+      id = replayNext;
+      r = fetch(id);
+      if (r && !before(id, replayEnd)) r = nullptr;  // Gap up to the live records
+      replayNext = r ? id + 1 : replayEnd;
+      if (r) replayed++;
+    }
+    if (!r) return nullptr;
+
+    if (!before(acked, lastSentId)) ackProgressMs = now;  // First in flight
+    if (before(lastSentId, id)) lastSentId = id;
+    return r;
+  }
+
+  /**
+   * Oldest ID still kept - the Pi stops waiting for anything below
+   */
+  uint32_t floorId() const {
+    return acked + 1;
+  }
+
+  /**
+   * Whether rxUs is on this boot's esp_timer time base
+   */
+  bool fromThisBoot(const Record& r) const {
+    return !before(r.id, bootFirstId);
+  }
+
+  /**
+   * Time since the record was received (AGE_UNKNOWN: before this boot)
+   * @param nowUs esp_timer_get_time()
+   */
+  uint32_t ageMs(const Record& r, int64_t nowUs) const {
+    return fromThisBoot(r) ? (uint32_t)((nowUs - r.rxUs) / 1000) : AGE_UNKNOWN;
+  }
+
+  bool isOnline() const {
+    return online;
+  }
+
+  bool hasFlash() const {
+    return flashOk;
+  }
+
+  /**
+   * Backlog still being replayed (loop() polls faster)
+   */
+  bool catchingUp() const {
+    return online && before(replayNext, replayEnd);
+  }
+
+  uint32_t getPending() const {
+    return nextId - acked - 1;
+  }
+
+  uint32_t getRamSlots() const {
+    return ringSlots;
+  }
+
+  uint32_t getStored() const {
+    return stored;
+  }
+
+  uint32_t getSpilled() const {
+    return spilled;
+  }
+
+  uint32_t getDropped() const {
+    return dropped;
+  }
+
+  uint32_t getReplayed() const {
+    return replayed;
+  }
+
+  uint32_t getRetransmits() const {
+    return retransmits;
+  }
+};
+
+#endif
@@ -73,18 +73,51 @@ public:
 
 	void display()
 	{
-		sendCommand(0x22);
-		sendData(0xF7);  // Full refresh
-		sendCommand(0x20);
+		startRefresh(false);
 		WaitUntilIdle();
 	}
 
 	void displayPartial()
+	{
+		startRefresh(true);
+		WaitUntilIdle();
+	}
+
+	/**
+	 * Start a refresh and return - poll isBusy() before the next command
+	 */
+	void startRefresh(bool partial)
 	{
 		sendCommand(0x22);
-		sendData(0xFF);  // Partial refresh mode
+		sendData(partial ? 0xFF : 0xF7);  // Partial refresh mode / full refresh
 		sendCommand(0x20);  // Master activation
-		WaitUntilIdle();
+	}
+
+	bool isBusy()
+	{
+		return digitalRead(_busy);  // LOW: idle, HIGH: busy
+	}
+
+	/**
+	 * Write display columns x0..x1 of the buffer to the panel RAM
+	 * (the bytes updateData() writes for them, without the rest)
+	 */
+	void updateColumns(uint8_t x0, uint8_t x1)
+	{
+		if (x1 > 249) x1 = 249;
+		if (x0 > x1) return;
+		if (x1 < 249) x1++;  // The next row holds the top byte of column x1
+
+		setPartialRamArea(x0, 0, x1 - x0 + 1, this->height());
+		sendCommand(0x24);
+		for (int x = x0; x <= x1; x++)
+		{
+			sendData(x == 0 ? 0xFF : ~(buffer[x - 1] << 6));
+			for (int y = 15; y >= 1; y--)
+			{
+				sendData(~((buffer[x + y * 256] << 6) | (buffer[x + (y - 1) * 256] >> 2)));
+			}
+		}
 	}
 
 	void updateData(uint8_t addr)
@@ -114,6 +147,10 @@ public:
 		end();
 	}
 
+	/**
+	 * Write raw RAM bytes to a band of columns and refresh it
+	 * @param img 16 bytes per column in updateColumns() order
+	 */
 	void dis_img_Partial_Refresh(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const unsigned char *img)
 	{
 		if (!img) return;
@@ -124,7 +161,7 @@ public:
 		// Send image data to specified area
 		sendCommand(0x24); // Write RAM (Black/White)
 		
-		int bytes = (w / 8) * h;
+		int bytes = w * 16;
 		for (int i = 0; i < bytes; i++) {
 			sendData(img[i]);
 		}
@@ -172,9 +209,24 @@ private:
 
 	void setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 	{
-		// For partial refresh, just use full screen area
-		// The partial refresh command (0xFF) will handle the update mode
-		setFullRamArea();
+		// A RAM row (Y address 249 - x, counting down) is one display column
+		// over the full height, so the window is a band of columns and y / h
+		// are always covered. Rows are written from X 0x0F, which holds the
+		// top byte of the previous column (the wrap in updateData()).
+		uint8_t first = 249 - x;
+		uint8_t last = 249 - (x + w - 1);
+		sendCommand(0x11); // set ram entry mode
+		sendData(0x00);
+		sendCommand(0x44);
+		sendData(0x0f);    // X end
+		sendData(0);       // X start
+		sendCommand(0x45);
+		sendData(first);   // Y end
+		sendData(last);    // Y start
+		sendCommand(0x4e);
+		sendData(0x0f);    // X counter
+		sendCommand(0x4f);
+		sendData(first);   // Y counter
 	}
 
 	void sendInitCommands(void)
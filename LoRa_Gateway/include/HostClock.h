@@ -0,0 +1,93 @@
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <Arduino.h>
+
+/**
+ * HostClock - The Pi's clock, followed from its TIME_SYNC frames
+ *
+ * Each TIME_SYNC carries the Pi's Unix time in microseconds, taken just
+ * before it is written to the UART. The gateway reads it some time later
+ * (wire time plus however long loop() took to get to it), so every sample
+ * of offset = host - esp_timer_get_time() comes out too low by that
+ * delay, never too high. The estimate therefore follows the upper
+ * envelope of the samples:
+ * - a sample above the estimate had less delay and replaces it
+ * - a lower one is ignored, except that the estimate may sink by up to
+ *   MAX_DRIFT_PPM of the time since the last sample, so drift between the
+ *   two crystals in either direction is followed
+ * - a sample more than STEP_US below means the Pi's clock was set back
+ *   (NTP step, reboot) and is taken as it is
+ *
+ * With one sample a second the estimate settles within a few ms of the
+ * Pi's clock (the Pi's own NTP error is of the same order), which is
+ * what the host needs to match copies of one frame from several gateways.
+ */
+class HostClock {
+public:
+  static const uint32_t MAX_DRIFT_PPM = 100;      // Two crystals, with margin
+  static const int64_t STEP_US = 1000000;          // Larger drops are clock steps
+
+private:
+  int64_t offsetUs;      // Host time - esp_timer_get_time()
+  int64_t lastSampleUs;  // Local time of the last sample
+  bool synced;
+  uint32_t samples;
+  uint32_t steps;
+
+public:
+  HostClock() {
+    offsetUs = 0;
+    lastSampleUs = 0;
+    synced = false;
+    samples = 0;
+    steps = 0;
+  }
+
+  /**
+   * Feed one TIME_SYNC
+   * @param hostUs Pi Unix time carried by the frame
+   * @param localUs esp_timer_get_time() when it was read
+   */
+  void sample(int64_t hostUs, int64_t localUs) {
+    int64_t measured = hostUs - localUs;
+    samples++;
+
+    if (!synced) {
+      offsetUs = measured;
+      synced = true;
+    } else {
+      int64_t floorUs = offsetUs - (localUs - lastSampleUs) * (int64_t)MAX_DRIFT_PPM / 1000000;
+      if (measured < offsetUs - STEP_US) {
+        offsetUs = measured;
+        steps++;
+      } else if (measured > floorUs) {
+        offsetUs = measured;
+      } else {
+        offsetUs = floorUs;
+      }
+    }
+    lastSampleUs = localUs;
+  }
+
+  /**
+   * Host time of a local timestamp (0 until the first sync)
+   */
+  int64_t toHost(int64_t localUs) const {
+    return synced ? localUs + offsetUs : 0;
+  }
+
+  bool isSynced() const {
+    return synced;
+  }
+
+  uint32_t getSampleCount() const {
+    return samples;
+  }
+
+  uint32_t getStepCount() const {
+    return steps;
+  }
+};
+
+#endif
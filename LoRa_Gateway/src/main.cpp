@@ -6,18 +6,25 @@
 #include <Arduino.h>
 #include <RadioLib.h>
 #include "HT_E0213A367.h"
+#include "DeviceTable.h"
+#include "DownlinkBudget.h"
+#include "ForwardStore.h"
+#include "HostClock.h"
+#include "UartLink.h"
+#include "LinkConfig.h"
+#include "PacketCodec.h"
 
 // Vext Power Control (Active HIGH for Vision Master E213)
 #define Vext 18
 
 // Vision Master E213 SX1262 LoRa pins (Heltec Official - VERIFIED)
-#define LORA_NSS    8
-#define LORA_DIO1   14
-#define LORA_NRST   12
-#define LORA_BUSY   13
-#define LORA_MOSI   10
-#define LORA_MISO   11
-#define LORA_SCLK   9
+const int LORA_NSS = HeltecV3Board::LORA_NSS;
+const int LORA_DIO1 = HeltecV3Board::LORA_DIO1;
+const int LORA_NRST = HeltecV3Board::LORA_NRST;
+const int LORA_BUSY = HeltecV3Board::LORA_BUSY;
+const int LORA_MOSI = HeltecV3Board::LORA_MOSI;
+const int LORA_MISO = HeltecV3Board::LORA_MISO;
+const int LORA_SCLK = HeltecV3Board::LORA_SCLK;
 
 // E-ink Display pins
 #define EPD_RST   3
@@ -27,36 +34,79 @@
 #define EPD_SCLK  4
 #define EPD_MOSI  6
 
-// UART to Raspberry Pi
+// UART to Raspberry Pi (framed, see shared/include/UartLink.h)
 #define UART_TX   44
 #define UART_RX   43
-#define UART_BAUD 115200
+const int UART_BAUD = UartConfig::PI_BAUD;
 
-// LoRa Parameters (verified working)
-const float LORA_FREQUENCY = 923.0;
-const float LORA_BANDWIDTH = 125.0;
-const uint8_t LORA_SPREADING_FACTOR = 9;
-const uint8_t LORA_CODING_RATE = 7;
-const uint8_t LORA_SYNC_WORD = 0x12;
-const int8_t LORA_OUTPUT_POWER = 22;
-const uint16_t LORA_PREAMBLE_LENGTH = 8;
+// LoRa Parameters (verified working) - shared with the wearable (shared/include/LinkConfig.h)
+const float LORA_FREQUENCY = RadioConfig::FREQUENCY_MHZ;
+const float LORA_BANDWIDTH = RadioConfig::BANDWIDTH_KHZ;
+const uint8_t LORA_SPREADING_FACTOR = RadioConfig::SPREADING_FACTOR;
+const uint8_t LORA_CODING_RATE = RadioConfig::CODING_RATE;
+const uint8_t LORA_SYNC_WORD = RadioConfig::SYNC_WORD;
+const int8_t LORA_OUTPUT_POWER = RadioConfig::OUTPUT_POWER_DBM;
+const uint16_t LORA_PREAMBLE_LENGTH = RadioConfig::PREAMBLE_LENGTH;
+
+// Fall alert ACKs (Packet Type 0x08): fall events and DANGEROUS alerts are
+// acknowledged as soon as they are read; the wearable retransmits until
+// then. Vitals history pages (0x0A) are acknowledged the same way, and the
+// wearable keeps their records until it hears the ACK.
+// Build with -DGATEWAY_SEND_ACKS=0 to stay receive-only.
+#ifndef GATEWAY_SEND_ACKS
+#define GATEWAY_SEND_ACKS 1
+#endif
+const uint8_t ACK_PORT = RadioConfig::ACK_PORT;
+const uint8_t HISTORY_PORT = RadioConfig::HISTORY_PORT;
+const unsigned long ACK_REPEAT_GUARD_MS = 500;  // Minimum spacing of repeated ACKs for one frame
+
+// Adaptive data rate (Packet Type 0x09): the gateway listens on every SF
+// from ADR_SF_MIN to LORA_SPREADING_FACTOR and, after a realtime batch,
+// tells the device the fastest SF / lowest TX power its SNR history
+// allows. Build with -DGATEWAY_ADR=0 to listen on LORA_SPREADING_FACTOR only.
+#ifndef GATEWAY_ADR
+#define GATEWAY_ADR 1
+#endif
+const uint8_t ADR_PORT = RadioConfig::ADR_PORT;
+const uint8_t ADR_LISTEN_PORT = RadioConfig::ADR_LISTEN_PORT;  // The wearable listens after these frames
+const uint8_t ADR_SF_MIN = RadioConfig::ADR_SF_MIN;
+const uint8_t ADR_SF_MAX = LORA_SPREADING_FACTOR;
+const int8_t ADR_POWER_MIN = RadioConfig::ADR_POWER_MIN_DBM;
+const int8_t ADR_POWER_MAX = LORA_OUTPUT_POWER;
+const float ADR_MARGIN_DB = 10.0;           // Kept above the demodulation floor
+const int ADR_HISTORY = DeviceState::SNR_HISTORY;  // SNR samples per decision
+const int ADR_MIN_SAMPLES = 5;
+const unsigned long ADR_REFRESH_MS = 600000;  // Repeat an unchanged setting (keeps the wearable from falling back)
+const float ADR_BUDGET_SHARE = 0.5f;          // ADR stops at this share of the downlink budget; ACKs use the rest
+
+// Multi-gateway deployments: every frame to the Pi names the gateway and
+// carries its RX time on the Pi's clock (HostClock.h), so a host fed by
+// overlapping gateways can keep one copy of each (device ID, frame counter)
+// - the best-RSSI one. The ID defaults to the low 32 bits of the eFuse MAC;
+// build with -DGATEWAY_ID=<n> to choose it.
+#ifndef GATEWAY_ID
+#define GATEWAY_ID 0
+#endif
 
 // Hardware objects
 SX1262 radio = new Module(LORA_NSS, LORA_DIO1, LORA_NRST, LORA_BUSY, SPI);
-ScreenDisplay *display = nullptr;
+UartLink piLink;  // UART1 through the ESP-IDF driver (not Serial1)
+ForwardStore forwardStore;  // Packets not yet acknowledged by the Pi
+HostClock hostClock;        // Pi time for RX timestamps
+uint32_t gatewayId = GATEWAY_ID;
+HT_E0213A367 *display = nullptr;
 
 // State
 uint32_t packetsReceived = 0;
 uint32_t packetsSkipped = 0;  // Count of skipped unknown packets
-uint8_t rxBuffer[256];
-uint8_t lastRxBuffer[256];  // Buffer to store last received packet for duplicate detection
-int lastRxLength = 0;        // Length of last received packet
+uint32_t skippedBeforeShown = 0;  // Skipped before the shown packet arrived
+uint32_t lastBadHash = 0;    // Hash of the last rejected packet (duplicate detection)
+int lastBadLength = 0;       // Length of the last rejected packet
 bool displayAvailable = false;
 int displayWidth = 250;
 int displayHeight = 122;
 bool needsFullRefresh = true;  // Flag for full refresh on first display
 unsigned long lastPacketMillis = 0;  // Last packet received time
-uint16_t lastFrameCounter = 0;  // Track last frame counter to detect new packets
 
 // Time sync
 struct {
@@ -70,20 +120,85 @@ struct {
   unsigned long lastSyncMillis;
 } currentTime = {0, 0, 0, 2025, 1, 1, false, 0};
 
-// Last packet info
-struct {
-  uint8_t type;  // 1=Realtime, 2=ECG, 3=Fall
-  char deviceId[11];
+// Decoded packet header (layouts in shared/include/PacketCodec.h)
+// Classic: [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+// Compact: [0x81] [Short ID (2 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+const int CLASSIC_HEADER_SIZE = LoRaHeader::CLASSIC_SIZE;
+
+struct PacketHeader {
+  char deviceId[11];      // "ID-XXXX" (display and log only) until idKnown
+  bool idKnown;           // deviceId came from a classic frame
+  uint16_t shortId;
   uint16_t frameCounter;
-  int8_t heartRate;
-  float temperature;
-  uint8_t noiseLevel;
-  uint8_t fallState;  // 0=Normal, 1=Warning, 2=Fall, 3=DANGEROUS/Unconscious, 4=Recovery
-  bool fallDetected;
-  bool noiseAlert;
-  bool hrAlert;
-  bool tempAlert;
-} lastPacket = {0, "", 0, 0, 0.0, 0, false, false, false, false};
+  uint8_t port;
+  bool compact;
+  int headerLen;
+};
+
+// Every wearable heard: frame counter window, latest vitals, link and ADR
+// state (see DeviceTable.h). The radio task updates the link layer fields,
+// loop() the vitals; both hold deviceMutex.
+DeviceTable devices;
+SemaphoreHandle_t deviceMutex = nullptr;
+
+// Radio task -> loop() handoff
+// The radio task copies each packet into a free pool slot, handles the
+// link layer (duplicates, ACK, ADR), re-arms the receiver and queues the
+// slot; loop() parses, forwards and displays it and returns the slot.
+// A packet arriving while every slot is in use is dropped and counted.
+const int RX_POOL_SIZE = 16;
+const UBaseType_t RADIO_TASK_PRIORITY = 3;
+const BaseType_t RADIO_CORE = 0;            // loop() runs on core 1
+const uint32_t RX_WAIT_MS = 1000;           // Longest wait for DIO1 before re-checking
+
+enum RxStatus {
+  RX_NEW = 0,
+  RX_RESTART = 1,       // New, and the device's frame counter restarted
+  RX_DUPLICATE = 2,     // Already accepted - not forwarded again
+  RX_REPLAY = 3,        // Older than the frame counter window
+  RX_UNKNOWN_TYPE = 4,
+  RX_TOO_SHORT = 5
+};
+
+struct RxPacket {
+  uint8_t data[256];
+  int length;
+  int16_t rssi;
+  float snr;
+  uint8_t sf;                 // Spreading factor it was received on
+  unsigned long rxMillis;
+  int64_t rxUs;               // esp_timer_get_time() at RX done (DIO1)
+  PacketHeader hdr;
+  RxStatus status;
+  DeviceState* dev;           // Table entry (check hdr.shortId before use)
+  uint16_t newestCounter;     // Device's highest counter (RX_REPLAY)
+};
+
+RxPacket rxPool[RX_POOL_SIZE];
+QueueHandle_t rxQueue = nullptr;      // Filled slots, radio task -> loop()
+QueueHandle_t rxFreeSlots = nullptr;  // Free slots, loop() -> radio task
+TaskHandle_t radioTaskHandle = nullptr;
+volatile int64_t dio1Us = 0;          // Time of the last DIO1 edge (RX done for a packet)
+volatile uint32_t rxDropped = 0;      // No free slot
+volatile uint32_t rxErrors = 0;       // readData() failed (CRC etc.)
+DownlinkBudget downlinkBudget;        // ACK / ADR airtime, same duty cycle as the wearables
+uint8_t listenSpreadingFactor = LORA_SPREADING_FACTOR;  // SF of the packet being received
+
+// One reading of a batched realtime packet (0x04), encoded as in 0x01
+struct RealtimeReading {
+  uint32_t timestamp;   // Wearable millis() when taken
+  uint8_t bpm;
+  uint8_t bodyTemp;
+  uint8_t ambientTemp;
+  uint8_t noise;
+  uint8_t fallState;
+  uint8_t flags;
+};
+const int REALTIME_BATCH_MAX = RealtimeBatchPacket::MAX_READINGS;
+
+// Copy of the newest accepted packet's device - what the display shows
+// (blank until the first packet; loop() only, no lock needed)
+DeviceState shown;
 
 // ============================================================================
 // TIME SYNC & PACKET PARSING
@@ -114,97 +229,239 @@ void updateCurrentTime() {
   }
 }
 
-void parsePacketInfo(uint8_t* data, int length) {
-  if (length < 13) return;  // Minimum: 10B device ID + 2B frame + 1B port
+/**
+ * Decode either header format
+ * Compact frames take the device ID the table learned from the device's
+ * classic frames, or a placeholder "ID-XXXX" until one has been seen
+ * (idKnown false - the placeholder is never forwarded).
+ * Takes deviceMutex for the lookup - call without holding it.
+ * @return false if the packet is too short for its header
+ */
+bool decodeHeader(const uint8_t* data, int length, PacketHeader& hdr) {
+  LoRaHeader::View view(data, length);
+  if (!view.valid()) return false;
   
-  // Extract device ID (first 10 bytes)
-  memcpy(lastPacket.deviceId, data, 10);
-  lastPacket.deviceId[10] = '\0';
+  hdr.compact = view.compact();
+  hdr.headerLen = view.size();
+  hdr.frameCounter = view.frameCounter();
+  hdr.port = view.port();
   
-  // Extract frame counter (bytes 10-11, little-endian)
-  lastPacket.frameCounter = (data[11] << 8) | data[10];
+  if (hdr.compact) {
+    hdr.shortId = view.shortId();
+    
+    // The radio task adds, evicts and names entries concurrently
+    xSemaphoreTake(deviceMutex, portMAX_DELAY);
+    const DeviceState* known = devices.find(hdr.shortId);
+    hdr.idKnown = known && known->idKnown;
+    if (hdr.idKnown) {
+      strcpy(hdr.deviceId, known->deviceId);
+    } else {
+      snprintf(hdr.deviceId, sizeof(hdr.deviceId), "ID-%04X", hdr.shortId);
+    }
+    xSemaphoreGive(deviceMutex);
+    return true;
+  }
+  
+  memcpy(hdr.deviceId, view.deviceId(), LoRaHeader::DEVICE_ID_SIZE);
+  hdr.deviceId[LoRaHeader::DEVICE_ID_SIZE] = '\0';
+  hdr.idKnown = true;
+  hdr.shortId = LoRaHeader::shortIdOf(hdr.deviceId);
+  return true;
+}
+
+/**
+ * Unpack a batched realtime payload (type 0x04)
+ * Format: [0x04][N][timestamp 4B][first reading 5B] then per reading
+ * [dt s][mask][deltas...] - see PayloadBuilder::buildRealtimeBatchPayload
+ * @return Number of readings decoded (0 if malformed)
+ */
+int unpackRealtimeBatch(const uint8_t* payload, int length, RealtimeReading* out, int maxReadings) {
+  RealtimeBatchPacket::View batch(payload, length);
+  if (!batch.valid()) return 0;
   
-  // Extract port/packet type (byte 12)
-  lastPacket.type = data[12];
+  int count = batch.count();
+  if (count < 1 || count > maxReadings) return 0;
   
-  // Reset alerts
-  lastPacket.noiseAlert = false;
-  lastPacket.hrAlert = false;
-  lastPacket.tempAlert = false;
+  uint32_t timestamp = batch.timestamp();
+  const uint8_t* first = batch.firstReading();
+  uint8_t fields[4] = {first[0], first[1], first[2], first[3]};
+  uint8_t status = first[4];
+  const uint8_t* deltas = batch.deltas();
+  int deltasLen = batch.deltasLength();
+  int idx = 0;
   
-  // Payload starts at byte 13
-  if (lastPacket.type == 1 && length >= 23) {
-    // Realtime data payload (10 bytes):
-    // [0] type=0x01
-    // [1] HR
-    // [2] body temp
-    // [3] ambient temp
-    // [4] noise
-    // [5] fall state
-    // [6] alert flags
-    // [7-8] RSSI (placeholder)
-    // [9] SNR (placeholder)
+  for (int i = 0; i < count; i++) {
+    if (i > 0) {
+      if (idx + 2 > deltasLen) return 0;
+      timestamp += deltas[idx++] * 1000UL;
+      uint8_t mask = deltas[idx++];
+      
+      for (int f = 0; f < 4; f++) {
+        if (!(mask & (1 << f))) continue;
+        if (idx >= deltasLen) return 0;
+        
+        uint8_t delta = deltas[idx++];
+        if (delta == RealtimeBatchPacket::DELTA_ESCAPE) {
+          if (idx >= deltasLen) return 0;
+          fields[f] = deltas[idx++];  // Escaped absolute value
+        } else {
+          fields[f] = (uint8_t)(fields[f] + (int8_t)delta);
+        }
+      }
+      if (mask & RealtimeBatchPacket::MASK_STATUS) {
+        if (idx >= deltasLen) return 0;
+        status = deltas[idx++];
+      }
+    }
     
-    lastPacket.heartRate = data[14];  // Byte 1 of payload
-    uint8_t tempEncoded = data[15];   // Byte 2 of payload
-    lastPacket.temperature = ((tempEncoded / 255.0) * 100.0) - 20.0;
-    // Skip ambient temp (byte 16)
-    lastPacket.noiseLevel = data[17];  // Byte 4 of payload
-    lastPacket.fallState = data[18];   // Byte 5 = fall_state (0-4)
-    lastPacket.fallDetected = (lastPacket.fallState >= 2);  // Fall, Dangerous, or Recovery
+    out[i].timestamp = timestamp;
+    out[i].bpm = fields[0];
+    out[i].bodyTemp = fields[1];
+    out[i].ambientTemp = fields[2];
+    out[i].noise = fields[3];
+    out[i].fallState = status >> 4;
+    out[i].flags = status & 0x0F;
+  }
+  return count;
+}
+
+/**
+ * Fill a device's realtime fields from encoded values
+ */
+void setRealtimeInfo(DeviceState& dev, uint8_t bpm, uint8_t tempEncoded, uint8_t noise, uint8_t fallState, uint8_t alertFlags) {
+  dev.heartRate = bpm;
+  dev.temperature = TempCode::decode(tempEncoded);
+  dev.noiseLevel = noise;
+  dev.fallState = fallState;  // 0-4
+  dev.fallDetected = (dev.fallState >= 2);  // Fall, Dangerous, or Recovery
+  
+  dev.hrAlert = (alertFlags & RealtimePacket::FLAG_HR) != 0;
+  dev.tempAlert = (alertFlags & RealtimePacket::FLAG_TEMP) != 0;
+  // Skip FLAG_FALL (redundant with fall_state)
+  dev.noiseAlert = (alertFlags & RealtimePacket::FLAG_NOISE) != 0;
+}
+
+/**
+ * Record an accepted packet in its device's entry
+ * The vitals are the device's latest: ECG, waveform and history packets
+ * leave them as the last realtime reading or fall event set them.
+ */
+void parsePacketInfo(DeviceState& dev, const PacketHeader& hdr, const uint8_t* data, int length) {
+  dev.frameCounter = hdr.frameCounter;
+  dev.type = hdr.port;
+  dev.readings = 1;
+  
+  const uint8_t* payload = data + hdr.headerLen;
+  int payloadLen = length - hdr.headerLen;
+  RealtimePacket::View realtime(payload, payloadLen);
+  FallEventPacket::View fall(payload, payloadLen);
+  
+  if (dev.type == 1 && realtime.valid()) {
+    setRealtimeInfo(dev, realtime.heartRate(), realtime.bodyTempCode(), realtime.noise(),
+                    realtime.fallState(), realtime.alertFlags());
     
-    // Extract alert flags (byte 6 of payload = byte 19 of packet)
-    uint8_t alertFlags = data[19];
-    lastPacket.hrAlert = (alertFlags & 0x01) != 0;    // Bit 0: HR abnormal
-    lastPacket.tempAlert = (alertFlags & 0x02) != 0;  // Bit 1: Temp abnormal
-    // Skip bit 2 (fall alert - redundant with fall_state)
-    lastPacket.noiseAlert = (alertFlags & 0x08) != 0; // Bit 3: Noise alert
+  } else if (dev.type == 4) {
+    // Realtime batch - show the newest reading as a realtime packet
+    RealtimeReading readings[REALTIME_BATCH_MAX];
+    int count = unpackRealtimeBatch(payload, payloadLen, readings, REALTIME_BATCH_MAX);
+    if (count > 0) {
+      const RealtimeReading& newest = readings[count - 1];
+      setRealtimeInfo(dev, newest.bpm, newest.bodyTemp, newest.noise, newest.fallState, newest.flags);
+      dev.type = 1;
+      dev.readings = count;
+      // Batch frames reserve one counter value per reading
+      dev.frameCounter = hdr.frameCounter + count - 1;
+    }
     
-  } else if (lastPacket.type == 2) {
-    // ECG data
-    lastPacket.heartRate = -1;  // Unknown
-    lastPacket.temperature = 0;
-    lastPacket.noiseLevel = 0;
-    lastPacket.fallState = 0;
-    lastPacket.fallDetected = false;
+  } else if (dev.type == 2 || dev.type == 5) {
+    // ECG data (type 5 is the Rice-coded variant, shown as ECG)
+    dev.type = 2;
     
-  } else if (lastPacket.type == 3 && length >= 58) {
-    // Fall event: [type][timestamp 4B][jerk 4B][svm 4B][...][HR][temp][...]
-    // Payload structure is more complex - adjust offsets
-    lastPacket.heartRate = data[40];  // Byte 27 of payload
-    uint8_t tempEncoded = data[41];
-    lastPacket.temperature = ((tempEncoded / 255.0) * 100.0) - 20.0;
-    lastPacket.noiseLevel = 0;  // Not included in fall event
-    lastPacket.fallState = 2;  // Fall detected
-    lastPacket.fallDetected = true;
-  }
-}
-
-void checkUartTimeSync() {
-  // Time sync format from Raspberry Pi: [0xFF][0xFE][YY][YY][MM][DD][HH][MM][SS][0xFD]
-  // Always sent with every packet, no request needed
-  while (Serial1.available() >= 10) {
-    if (Serial1.peek() == 0xFF) {
-      uint8_t syncBuffer[10];
-      Serial1.readBytes(syncBuffer, 10);
-      
-      if (syncBuffer[0] == 0xFF && syncBuffer[1] == 0xFE && syncBuffer[9] == 0xFD) {
-        currentTime.year = (syncBuffer[2] << 8) | syncBuffer[3];
-        currentTime.month = syncBuffer[4];
-        currentTime.day = syncBuffer[5];
-        currentTime.hour = syncBuffer[6];
-        currentTime.minute = syncBuffer[7];
-        currentTime.second = syncBuffer[8];
-        currentTime.valid = true;
-        currentTime.lastSyncMillis = millis();
-        
-        Serial.printf("⏰ Time synced: %04d-%02d-%02d %02d:%02d:%02d\n",
-                     currentTime.year, currentTime.month, currentTime.day,
-                     currentTime.hour, currentTime.minute, currentTime.second);
-        break;
+  } else if (dev.type == 3 && fall.valid()) {
+    // Fall event: vitals at the moment of the fall
+    dev.heartRate = fall.heartRate();
+    dev.temperature = fall.bodyTemp();
+    dev.fallState = 2;  // Fall detected
+    dev.fallDetected = true;
+  }
+}
+
+/**
+ * Whether a payload holds its whole layout (shortened history, waveform
+ * and diagnostics payloads are dropped - a history page must not be ACKed
+ * unless the backend can decode every record the wearable then releases)
+ */
+bool payloadComplete(const PacketHeader& hdr, const uint8_t* payload, int payloadLen) {
+  switch (hdr.port) {
+    case DiagnosticsPacket::TYPE: return DiagnosticsPacket::View(payload, payloadLen).valid();
+    case FallWaveformPacket::TYPE: return FallWaveformPacket::View(payload, payloadLen).valid();
+    case HistoryPagePacket::TYPE: return HistoryPagePacket::View(payload, payloadLen).valid();
+    default: return true;
+  }
+}
+
+/**
+ * Serial summary of a packet type without vitals
+ */
+void printPayloadSummary(const PacketHeader& hdr, const uint8_t* payload, int payloadLen) {
+  if (hdr.port == DiagnosticsPacket::TYPE) {
+    DiagnosticsPacket::View diag(payload, payloadLen);
+    Serial.printf("   Diagnostics: %u stages over %lu s\n", diag.stageCount(), (unsigned long)diag.windowSeconds());
+  } else if (hdr.port == FallWaveformPacket::TYPE) {
+    FallWaveformPacket::View waveform(payload, payloadLen);
+    Serial.printf("   Waveform: window %u, fragment %u/%u, channel %u, %u samples at %u Hz\n",
+                  waveform.windowId(), waveform.fragmentIndex() + 1, waveform.fragmentCount(),
+                  waveform.channel(), waveform.sampleCount(), waveform.sampleRateHz());
+  } else if (hdr.port == HistoryPagePacket::TYPE) {
+    HistoryPagePacket::View history(payload, payloadLen);
+    Serial.printf("   History: log %04X, %u records from #%lu (oldest %lu s old)\n",
+                  history.logId(), history.count(), (unsigned long)history.firstSequence(),
+                  (unsigned long)history.firstAge());
+  }
+}
+
+void checkUartHost() {
+  while (piLink.receive(0)) {
+    const uint8_t* data = piLink.payload();
+    size_t length = piLink.payloadLength();
+    
+    // Delivery report / keepalive (UartFrame::HOST_ACK), every second:
+    // [record ID LE 4B] or empty
+    if (piLink.frameType() == UartFrame::HOST_ACK) {
+      if (length >= 4) {
+        forwardStore.acknowledge(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24), millis());
+      } else {
+        forwardStore.hostSeen(millis());
       }
-    } else {
-      Serial1.read(); // Discard invalid byte
+      continue;
+    }
+    
+    // Time sync from Raspberry Pi (UartFrame::TIME_SYNC), sent after every
+    // packet and once a second:
+    // [year LE 2B][month][day][hour][minute][second][Unix time us LE 8B]
+    if (piLink.frameType() != UartFrame::TIME_SYNC || length < 7) continue;
+    int64_t readUs = esp_timer_get_time();
+    forwardStore.hostSeen(millis());
+    
+    const uint8_t* sync = piLink.payload();
+    if (length >= 15) {
+      int64_t hostUs = (int64_t)ByteOrder::getU32(sync + 7) | ((int64_t)ByteOrder::getU32(sync + 11) << 32);
+      hostClock.sample(hostUs, readUs);
+    }
+    bool announce = !currentTime.valid || currentTime.minute != sync[5];
+    currentTime.year = sync[0] | (sync[1] << 8);
+    currentTime.month = sync[2];
+    currentTime.day = sync[3];
+    currentTime.hour = sync[4];
+    currentTime.minute = sync[5];
+    currentTime.second = sync[6];
+    currentTime.valid = true;
+    currentTime.lastSyncMillis = millis();
+    
+    if (announce) {
+      Serial.printf("⏰ Time synced: %04d-%02d-%02d %02d:%02d:%02d\n",
+                   currentTime.year, currentTime.month, currentTime.day,
+                   currentTime.hour, currentTime.minute, currentTime.second);
     }
   }
 }
@@ -298,7 +555,6 @@ void initDisplay() {
     
     display->update(BLACK_BUFFER);
     display->display();
-    delay(300);
     
     needsFullRefresh = true;  // Next update will do full refresh
     
@@ -310,300 +566,776 @@ void initDisplay() {
   }
 }
 
-void updateDisplay(int rssi, float snr, int length, uint32_t count) {
-  if (!displayAvailable || !display) return;
+// ----------------------------------------------------------------------------
+// Render scheduler
+// The display model (layout + the text of every field) is rebuilt from the
+// shown device when something changes. Fields whose text differs from what
+// the panel shows are redrawn into the frame buffer, only their columns are
+// written to the panel RAM, and one partial refresh is started without
+// waiting for it. loop() polls BUSY, so a refresh never holds up packet
+// handling; changes that arrive meanwhile are merged into the next one.
+// ----------------------------------------------------------------------------
+
+const unsigned long DISPLAY_MIN_INTERVAL_MS = 2000;  // Between refreshes (new alerts excepted)
+const unsigned long DISPLAY_CLOCK_MS = 60000;        // Redraw clock / "RX ago" while idle
+const uint8_t DISPLAY_FULL_EVERY = 30;               // Partial refreshes before a full one (ghosting)
+const unsigned long DISPLAY_SETTLE_MS = 20;          // BUSY rises shortly after activation
+const int DISPLAY_TEXT_MAX = 28;
+
+enum DisplayLayout {
+  LAYOUT_NONE = 0,        // Panel content unknown (boot screen)
+  LAYOUT_WAITING = 1,     // No packet yet
+  LAYOUT_NORMAL = 2,
+  LAYOUT_FALL = 3,        // Fall event banner
+  LAYOUT_UNCONSCIOUS = 4  // DANGEROUS banner
+};
+
+enum DisplayFieldId {
+  FIELD_TIME, FIELD_TYPE, FIELD_DEVICE, FIELD_FRAME, FIELD_HR, FIELD_TEMP, FIELD_NOISE,
+  FIELD_RSSI, FIELD_SNR, FIELD_SIZE, FIELD_UPTIME, FIELD_STATUS, FIELD_LAST_RX,
+  FIELD_COUNT
+};
+
+// Text anchor, alignment, and the area cleared before drawing
+struct DisplayField {
+  int16_t x, y;
+  DISPLAY_TEXT_ALIGNMENT align;
+  int16_t clearX, clearY, clearW, clearH;
+};
+
+const DisplayField DISPLAY_FIELDS[FIELD_COUNT] = {
+  {2, 0, TEXT_ALIGN_LEFT, 0, 0, 64, 14},        // Time
+  {2, 22, TEXT_ALIGN_LEFT, 0, 22, 124, 12},     // Type
+  {2, 34, TEXT_ALIGN_LEFT, 0, 34, 124, 12},     // Device
+  {2, 46, TEXT_ALIGN_LEFT, 0, 46, 124, 12},     // Frame
+  {2, 58, TEXT_ALIGN_LEFT, 0, 58, 124, 12},     // HR
+  {2, 70, TEXT_ALIGN_LEFT, 0, 70, 124, 12},     // Temp
+  {2, 82, TEXT_ALIGN_LEFT, 0, 82, 124, 12},     // Noise
+  {130, 22, TEXT_ALIGN_LEFT, 128, 22, 122, 12}, // RSSI
+  {130, 34, TEXT_ALIGN_LEFT, 128, 34, 122, 12}, // SNR
+  {130, 46, TEXT_ALIGN_LEFT, 128, 46, 122, 12}, // Size
+  {130, 58, TEXT_ALIGN_LEFT, 128, 58, 122, 12}, // Uptime
+  {130, 70, TEXT_ALIGN_LEFT, 128, 68, 122, 27}, // Status (large text moves up)
+  {248, 100, TEXT_ALIGN_RIGHT, 150, 100, 100, 12} // Last RX
+};
+
+struct DisplayModel {
+  DisplayLayout layout;
+  bool statusLarge;  // Status in the 16 px font (fall / unconscious)
+  char text[FIELD_COUNT][DISPLAY_TEXT_MAX];
+};
+
+// Columns to write to the panel, merged into a few bands
+struct DirtyColumns {
+  static const int MAX_BANDS = 4;
+  int16_t first[MAX_BANDS];
+  int16_t last[MAX_BANDS];
+  int count;
   
+  void add(int16_t x0, int16_t x1) {
+    if (x0 < 0) x0 = 0;
+    if (x1 > 249) x1 = 249;
+    for (int i = 0; i < count; i++) {
+      if (x0 <= last[i] + 1 && x1 >= first[i] - 1) {
+        first[i] = min(first[i], x0);
+        last[i] = max(last[i], x1);
+        return;
+      }
+    }
+    if (count == MAX_BANDS) {
+      // Widen the last band rather than track more
+      first[count - 1] = min(first[count - 1], x0);
+      last[count - 1] = max(last[count - 1], x1);
+      return;
+    }
+    first[count] = x0;
+    last[count] = x1;
+    count++;
+  }
+};
+
+DisplayModel panelModel = {};     // What the panel shows (or is refreshing to)
+bool displayStale = true;         // Model inputs changed since the last render
+bool displayRefreshing = false;   // Refresh started, BUSY not yet low
+uint8_t partialRefreshes = 0;
+unsigned long refreshStartMs = 0;
+unsigned long lastRenderMs = 0;
+
+// Link values of the last packet, shown on the right
+int16_t displayRssi = 0;
+float displaySnr = 0;
+int displayLength = 0;
+
+/**
+ * Mark the display out of date (rendered by serviceDisplay())
+ */
+void requestDisplayUpdate() {
+  displayStale = true;
+}
+
+/**
+ * Whether the scheduler has work outstanding (loop() polls faster)
+ */
+bool displayPending() {
+  return displayAvailable && (displayStale || displayRefreshing);
+}
+
+/**
+ * Build the display model from the shown device and gateway state
+ */
+void buildDisplayModel(DisplayModel& m) {
+  memset(&m, 0, sizeof(m));
   updateCurrentTime();
   
-  // First time or critical alert - do full refresh
-  if (needsFullRefresh || (lastPacket.fallState == 3) || 
-      (lastPacket.fallDetected && lastPacket.type == 3)) {
-    
-    display->clear();
-    
-    // === Header: Time and Title ===
-    display->setTextAlignment(TEXT_ALIGN_LEFT);
-    display->setFont(ArialMT_Plain_10);
-    
-    if (currentTime.valid) {
-      char timeStr[20];
-      sprintf(timeStr, "%02d:%02d:%02d", currentTime.hour, currentTime.minute, currentTime.second);
-      display->drawString(2, 0, timeStr);
+  if (currentTime.valid) {
+    sprintf(m.text[FIELD_TIME], "%02d:%02d:%02d", currentTime.hour, currentTime.minute, currentTime.second);
+  } else {
+    strcpy(m.text[FIELD_TIME], "--:--:--");
+  }
+  
+  if (packetsReceived == 0) {
+    m.layout = LAYOUT_WAITING;
+    return;
+  }
+  
+  if (shown.fallState == 3) m.layout = LAYOUT_UNCONSCIOUS;
+  else if (shown.fallDetected && shown.type == 3) m.layout = LAYOUT_FALL;
+  else m.layout = LAYOUT_NORMAL;
+  
+  // === LEFT COLUMN (0-120) ===
+  const char* typeStr = "Unknown";
+  if (shown.type == 1) typeStr = "Realtime";
+  else if (shown.type == 2) typeStr = "ECG";
+  else if (shown.type == 3) typeStr = "FALL";
+  else if (shown.type == 6) typeStr = "Diag";
+  else if (shown.type == 7) typeStr = "Wave";
+  else if (shown.type == 10) typeStr = "History";
+  sprintf(m.text[FIELD_TYPE], "Type:%s", typeStr);
+  sprintf(m.text[FIELD_DEVICE], "Dev:%.8s", shown.deviceId);
+  
+  // (-x): x bad packets since the shown one, (+x): x skipped before it
+  if (packetsSkipped > 0) {
+    sprintf(m.text[FIELD_FRAME], "Frame:#%d(-%lu)", shown.frameCounter, packetsSkipped);
+  } else if (skippedBeforeShown > 0) {
+    sprintf(m.text[FIELD_FRAME], "Frame:#%d(+%lu)", shown.frameCounter, skippedBeforeShown);
+  } else {
+    sprintf(m.text[FIELD_FRAME], "Frame:#%d", shown.frameCounter);
+  }
+  
+  if (shown.type == 1 || shown.type == 3) {
+    sprintf(m.text[FIELD_HR], "HR:%d%s bpm", shown.heartRate, shown.hrAlert ? "!" : "");
+    sprintf(m.text[FIELD_TEMP], "Temp:%.1f%sC", shown.temperature, shown.tempAlert ? "!" : "");
+    if (shown.type == 1) {
+      sprintf(m.text[FIELD_NOISE], "Noise:%ddB%s", shown.noiseLevel, shown.noiseAlert ? "!" : "");
+    }
+  }
+  
+  // === RIGHT COLUMN (130-248) ===
+  sprintf(m.text[FIELD_RSSI], "RSSI:%ddBm", displayRssi);
+  sprintf(m.text[FIELD_SNR], "SNR:%.1fdB", displaySnr);
+  sprintf(m.text[FIELD_SIZE], "Size:%dB", displayLength);
+  
+  unsigned long uptime = millis() / 1000;
+  sprintf(m.text[FIELD_UPTIME], "Up:%luh%02lum%02lus", uptime / 3600, (uptime % 3600) / 60, uptime % 60);
+  
+  if (shown.fallState == 3) {
+    strcpy(m.text[FIELD_STATUS], "UNCONSCIOUS!");
+    m.statusLarge = true;
+  } else if (shown.fallDetected) {
+    strcpy(m.text[FIELD_STATUS], "**FALL**");
+    m.statusLarge = true;
+  } else if (shown.noiseAlert) {
+    strcpy(m.text[FIELD_STATUS], "LOUD!");
+  } else if (shown.hrAlert || shown.tempAlert) {
+    strcpy(m.text[FIELD_STATUS], "Alert!");
+  } else {
+    strcpy(m.text[FIELD_STATUS], "Normal");
+  }
+  
+  // === Bottom status bar - last packet time (banner layouts cover it) ===
+  if (m.layout == LAYOUT_NORMAL && lastPacketMillis > 0) {
+    unsigned long elapsed = (millis() - lastPacketMillis) / 1000;
+    if (elapsed < 60) {
+      sprintf(m.text[FIELD_LAST_RX], "RX:(%02lu)s ago", elapsed);
+    } else if (elapsed < 3600) {
+      sprintf(m.text[FIELD_LAST_RX], "RX:(%02lu)m ago", elapsed / 60);
     } else {
-      display->drawString(2, 0, "--:--:--");
+      sprintf(m.text[FIELD_LAST_RX], "RX:(%lu)h ago", elapsed / 3600);
     }
-    
+  }
+}
+
+/**
+ * Draw one field into the frame buffer
+ * @param clear Erase the field's area first (partial updates)
+ */
+void drawField(const DisplayModel& m, int id, bool clear) {
+  const DisplayField& f = DISPLAY_FIELDS[id];
+  if (clear) {
+    display->setColor(BLACK);  // Clear area
+    display->fillRect(f.clearX, f.clearY, f.clearW, f.clearH);
+    display->setColor(WHITE);
+  }
+  if (m.text[id][0] == '\0') return;
+  
+  display->setTextAlignment(f.align);
+  if (id == FIELD_STATUS && m.statusLarge) {
+    display->setFont(ArialMT_Plain_16);
+    display->drawString(f.x, m.layout == LAYOUT_UNCONSCIOUS ? 68 : 72, m.text[id]);
+  } else {
+    display->setFont(ArialMT_Plain_10);
+    display->drawString(f.x, f.y, m.text[id]);
+  }
+}
+
+/**
+ * Draw the whole screen: static layout and every field
+ */
+void drawFullScreen(const DisplayModel& m) {
+  display->clear();
+  
+  // === Header: Time and Title ===
+  drawField(m, FIELD_TIME, false);
+  display->setTextAlignment(TEXT_ALIGN_CENTER);
+  display->setFont(ArialMT_Plain_16);
+  display->drawString(125, 0, "LoRa Gateway");
+  
+  // === Line separator ===
+  display->drawHorizontalLine(0, 18, 250);
+  
+  if (m.layout == LAYOUT_WAITING) {
+    // === No packets yet ===
     display->setTextAlignment(TEXT_ALIGN_CENTER);
     display->setFont(ArialMT_Plain_16);
-    display->drawString(125, 0, "LoRa Gateway");
-    
-    // === Line separator ===
-    display->drawHorizontalLine(0, 18, 250);
-    
+    display->drawString(125, 50, "Waiting...");
+    display->setFont(ArialMT_Plain_10);
+    display->drawString(125, 70, "923MHz SF9 BW125");
+    return;
+  }
+  
+  for (int id = FIELD_TYPE; id < FIELD_COUNT; id++) {
+    drawField(m, id, false);
+  }
+  
+  // === Bottom status bar ===
+  display->drawHorizontalLine(0, 96, 250);
+  
+  if (m.layout == LAYOUT_UNCONSCIOUS) {
+    // Critical: Unconscious warning
+    display->setFont(ArialMT_Plain_16);
+    display->setTextAlignment(TEXT_ALIGN_CENTER);
+    display->drawString(125, 100, "!! UNCONSCIOUS !!");
+  } else if (m.layout == LAYOUT_FALL) {
+    display->setFont(ArialMT_Plain_16);
+    display->setTextAlignment(TEXT_ALIGN_CENTER);
+    display->drawString(125, 100, ">> FALL EVENT <<");
+  } else {
     display->setTextAlignment(TEXT_ALIGN_LEFT);
     display->setFont(ArialMT_Plain_10);
-    char buffer[60];
-    
-    if (count > 0) {
-      // === LEFT COLUMN (0-120) ===
-      
-      // Packet type
-      const char* typeStr = "Unknown";
-      if (lastPacket.type == 1) typeStr = "Realtime";
-      else if (lastPacket.type == 2) typeStr = "ECG";
-      else if (lastPacket.type == 3) typeStr = "FALL";
-      
-      sprintf(buffer, "Type:%s", typeStr);
-      display->drawString(2, 22, buffer);
-      
-      // Device ID
-      sprintf(buffer, "Dev:%.8s", lastPacket.deviceId);
-      display->drawString(2, 34, buffer);
-      
-      // Frame number with skipped packets indicator
-      // Show (+x) if packets were skipped before this valid packet
-      if (packetsSkipped > 0) {
-        sprintf(buffer, "Frame:#%d(+%lu)", lastPacket.frameCounter, packetsSkipped);
-      } else {
-        sprintf(buffer, "Frame:#%d", lastPacket.frameCounter);
-      }
-      display->drawString(2, 46, buffer);
-      
-      // Health data
-      if (lastPacket.type == 1 || lastPacket.type == 3) {
-        sprintf(buffer, "HR:%d%s bpm", 
-                lastPacket.heartRate,
-                lastPacket.hrAlert ? "!" : "");
-        display->drawString(2, 58, buffer);
-        
-        sprintf(buffer, "Temp:%.1f%sC", 
-                lastPacket.temperature,
-                lastPacket.tempAlert ? "!" : "");
-        display->drawString(2, 70, buffer);
-        
-        if (lastPacket.type == 1) {
-          sprintf(buffer, "Noise:%ddB%s", 
-                  lastPacket.noiseLevel,
-                  lastPacket.noiseAlert ? "!" : "");
-          display->drawString(2, 82, buffer);
-        }
-      }
-      
-      // === RIGHT COLUMN (130-248) ===
-      
-      // Signal quality
-      sprintf(buffer, "RSSI:%ddBm", rssi);
-      display->drawString(130, 22, buffer);
-      
-      sprintf(buffer, "SNR:%.1fdB", snr);
-      display->drawString(130, 34, buffer);
-      
-      // Packet stats
-      sprintf(buffer, "Size:%dB", length);
-      display->drawString(130, 46, buffer);
-      
-      unsigned long uptime = millis() / 1000;
-      unsigned long hours = uptime / 3600;
-      unsigned long minutes = (uptime % 3600) / 60;
-      unsigned long seconds = uptime % 60;
-      sprintf(buffer, "Up:%luh%02lum%02lus", hours, minutes, seconds);
-      display->drawString(130, 58, buffer);
-      
-      // Alert status
-      if (lastPacket.fallState == 3) {
-        // DANGEROUS - Unconscious/Immobile
-        display->setFont(ArialMT_Plain_16);
-        display->drawString(130, 68, "UNCONSCIOUS!");
-        display->setFont(ArialMT_Plain_10);
-      } else if (lastPacket.fallDetected) {
-        display->setFont(ArialMT_Plain_16);
-        display->drawString(130, 72, "**FALL**");
-        display->setFont(ArialMT_Plain_10);
-      } else if (lastPacket.noiseAlert) {
-        display->drawString(130, 70, "LOUD!");
-      }  else {
-        display->drawString(130, 70, "Normal");
-      }
-      
-      // === Bottom status bar ===
-      display->drawHorizontalLine(0, 96, 250);
-      
-      if (lastPacket.fallState == 3) {
-        // Critical: Unconscious warning
-        display->setFont(ArialMT_Plain_16);
-        display->setTextAlignment(TEXT_ALIGN_CENTER);
-        display->drawString(125, 100, "!! UNCONSCIOUS !!");
-      } else if (lastPacket.fallDetected && lastPacket.type == 3) {
-        display->setFont(ArialMT_Plain_16);
-        display->setTextAlignment(TEXT_ALIGN_CENTER);
-        display->drawString(125, 100, ">> FALL EVENT <<");
-      } else {
-        display->setTextAlignment(TEXT_ALIGN_LEFT);
-        display->setFont(ArialMT_Plain_10);
-        sprintf(buffer, "Listening: 923MHz SF9");
-        display->drawString(2, 100, buffer);
-        
-        // Show last packet time in right corner
-        if (lastPacketMillis > 0) {
-          unsigned long elapsed = (millis() - lastPacketMillis) / 1000;
-          display->setTextAlignment(TEXT_ALIGN_RIGHT);
-          if (elapsed < 60) {
-            sprintf(buffer, "RX:(%02lu)s ago", elapsed);
-          } else if (elapsed < 3600) {
-            sprintf(buffer, "RX:(%02lu)m ago", elapsed / 60);
-          } else {
-            sprintf(buffer, "RX:(%02lu)h ago", elapsed / 3600);
-          }
-          display->drawString(248, 100, buffer);
-        }
-      }
-      
-    } else {
-      // === No packets yet ===
-      display->setTextAlignment(TEXT_ALIGN_CENTER);
-      display->setFont(ArialMT_Plain_16);
-      display->drawString(125, 50, "Waiting...");
-      display->setFont(ArialMT_Plain_10);
-      display->drawString(125, 70, "923MHz SF9 BW125");
+    display->drawString(2, 100, "Listening: 923MHz SF9");
+  }
+}
+
+/**
+ * Render scheduler step (loop()) - never waits for the panel
+ */
+void serviceDisplay() {
+  if (!displayAvailable || !display) return;
+  unsigned long now = millis();
+  
+  if (displayRefreshing) {
+    if (now - refreshStartMs < DISPLAY_SETTLE_MS || display->isBusy()) return;
+    displayRefreshing = false;
+  }
+  
+  if (now - lastRenderMs >= DISPLAY_CLOCK_MS) displayStale = true;
+  if (!displayStale) return;
+  
+  DisplayModel next;
+  buildDisplayModel(next);
+  
+  // A new alert layout goes out at once, anything else is rate limited
+  bool layoutChanged = next.layout != panelModel.layout;
+  bool urgent = layoutChanged && next.layout >= LAYOUT_FALL;
+  if (!urgent && now - refreshStartMs < DISPLAY_MIN_INTERVAL_MS) return;  // Stays stale
+  
+  displayStale = false;
+  lastRenderMs = now;
+  
+  bool full = needsFullRefresh || layoutChanged || partialRefreshes >= DISPLAY_FULL_EVERY;
+  if (full) {
+    drawFullScreen(next);
+    display->update(BLACK_BUFFER);
+    display->startRefresh(false);
+    partialRefreshes = 0;
+    needsFullRefresh = false;
+  } else {
+    DirtyColumns dirty = {};
+    for (int id = 0; id < FIELD_COUNT; id++) {
+      if (strcmp(next.text[id], panelModel.text[id]) == 0 &&
+          (id != FIELD_STATUS || next.statusLarge == panelModel.statusLarge)) continue;
+      drawField(next, id, true);
+      const DisplayField& f = DISPLAY_FIELDS[id];
+      dirty.add(f.clearX, f.clearX + f.clearW - 1);
     }
+    if (dirty.count == 0) return;  // Nothing visible changed
     
-    display->update(BLACK_BUFFER);
-    display->display();  // Full refresh
+    for (int i = 0; i < dirty.count; i++) {
+      display->updateColumns(dirty.first[i], dirty.last[i]);
+    }
+    display->startRefresh(true);
+    partialRefreshes++;
+  }
+  
+  panelModel = next;
+  refreshStartMs = now;
+  displayRefreshing = true;
+}
 
-    // Reset skipped counter after showing in full refresh
-    packetsSkipped = 0;
+// ============================================================================
+// FALL ALERT ACKS
+// ============================================================================
 
-    if(lastPacket.fallDetected){
-      needsFullRefresh = true;
-    }else{
-      needsFullRefresh = false;
-    }
-    
+/**
+ * Whether the wearable waits for an ACK of this packet
+ * (fall events, realtime frames reporting DANGEROUS, history pages)
+ */
+bool needsAck(const PacketHeader& hdr, const uint8_t* payload, int payloadLen) {
+  if (hdr.port == 3 || hdr.port == HISTORY_PORT) return true;
+  RealtimePacket::View realtime(payload, payloadLen);
+  return hdr.port == 1 && realtime.valid() && realtime.fallState() == 3;
+}
+
+/**
+ * Time-on-air of a downlink at the current modulation (ms, radio task)
+ */
+uint32_t downlinkAirtimeMs(size_t len) {
+  return (radio.getTimeOnAir(len) + 999) / 1000;
+}
+
+/**
+ * Transmit an ACK: compact header addressed to the device's short ID,
+ * echoing the acknowledged frame counter (radio task, deviceMutex not held)
+ * Format: [0x81][Short ID 2B][Frame Counter 2B][0x08][0x08]
+ */
+void sendAck(const PacketHeader& hdr) {
+  uint8_t ack[DownlinkPacket::ACK_SIZE];
+  size_t len = DownlinkPacket::writeAck(ack, hdr.shortId, hdr.frameCounter);
+  
+  int state = radio.transmit(ack, len);
+  downlinkBudget.charge(downlinkAirtimeMs(len), millis());
+  if (state == RADIOLIB_ERR_NONE) {
+    Serial.printf("   ✅ ACK sent (Device %s, Frame %d)\n", hdr.deviceId, hdr.frameCounter);
   } else {
-    // Partial refresh - only update dynamic content
-    // This is much faster and reduces flicker
-    
-    display->setColor(BLACK);  // Clear area
-    display->fillRect(2, 0, 60, 12);  // Time area
-    display->setColor(WHITE);
-    
-    display->setTextAlignment(TEXT_ALIGN_LEFT);
-    display->setFont(ArialMT_Plain_10);
+    Serial.printf("   ❌ ACK failed, code: %d\n", state);
+  }
+}
+
+// ============================================================================
+// MULTI-SF LISTENING & ADR
+// ============================================================================
+
+/**
+ * SX1262 DIO1 (RX done; also CAD and TX done) - wakes the radio task
+ */
+void IRAM_ATTR onRadioDio1() {
+  dio1Us = esp_timer_get_time();
+  BaseType_t woken = pdFALSE;
+  if (radioTaskHandle != nullptr) {
+    vTaskNotifyGiveFromISR(radioTaskHandle, &woken);
+  }
+  if (woken) portYIELD_FROM_ISR();
+}
+
+#if GATEWAY_ADR
+/**
+ * Wait for the next packet on any SF of the ADR plan
+ * The SX1262 demodulates one SF at a time, so the gateway cycles channel
+ * activity detection over ADR_SF_MIN..ADR_SF_MAX (about 20ms per cycle)
+ * and receives on the SF where a preamble shows up. Wearables stretch
+ * their preamble to RadioConfig::ADR_PREAMBLE_MS so it outlasts a full
+ * cycle (checked at build time against RadioConfig::cadCycleUs()).
+ * (Radio task)
+ * @return Packet length ready for readData() (0 = nothing heard)
+ */
+int listenForPacket() {
+  for (uint8_t sf = ADR_SF_MIN; sf <= ADR_SF_MAX; sf++) {
+    radio.standby();
+    radio.setSpreadingFactor(sf);
+    radio.setPreambleLength(RadioConfig::preambleSymbols(sf));
+    if (radio.scanChannel() != RADIOLIB_LORA_DETECTED) continue;
     
-    // Update time
-    if (currentTime.valid) {
-      char timeStr[20];
-      sprintf(timeStr, "%02d:%02d:%02d", currentTime.hour, currentTime.minute, currentTime.second);
-      display->drawString(2, 0, timeStr);
-    } else {
-      display->drawString(2, 0, "--:--:--");
+    ulTaskNotifyTake(pdTRUE, 0);  // CAD done also raised DIO1
+    radio.startReceive();
+    uint32_t timeoutMs = radio.getTimeOnAir(255) / 1000 + 100;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) == 0) {
+      radio.standby();  // False detection or lost packet
+      return 0;
     }
+    listenSpreadingFactor = sf;
+    return radio.getPacketLength();
+  }
+  return 0;
+}
+#else
+/**
+ * Wait for RX done in continuous RX (radio task)
+ * @return Packet length ready for readData() (0 = nothing yet)
+ */
+int listenForPacket() {
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RX_WAIT_MS)) == 0) {
+    // A level still high means its edge came before the task was waiting
+    if (digitalRead(LORA_DIO1) == LOW) return 0;
+    dio1Us = esp_timer_get_time();  // Edge time unknown
+  }
+  return radio.getPacketLength();
+}
+#endif
+
+/**
+ * Demodulation floor of an SF (SX1262, BW125)
+ */
+float requiredSnr(uint8_t sf) {
+  return -5.0 - 2.5 * (sf - 6);  // SF7 -7.5 dB ... SF12 -20 dB
+}
+
+/**
+ * Send a link setting (radio task, deviceMutex not held)
+ * Format: [0x81][Short ID 2B][Frame Counter 2B][0x09][0x09][SF][TX power dBm]
+ */
+void sendAdr(const PacketHeader& hdr, uint8_t sf, int8_t power) {
+  uint8_t adr[DownlinkPacket::ADR_SIZE];
+  size_t len = DownlinkPacket::writeAdr(adr, hdr.shortId, hdr.frameCounter, sf, power);
+  
+  int state = radio.transmit(adr, len);
+  downlinkBudget.charge(downlinkAirtimeMs(len), millis());
+  if (state == RADIOLIB_ERR_NONE) {
+    Serial.printf("   📶 ADR sent (Device %s): SF%d, %d dBm\n", hdr.deviceId, sf, power);
+  } else {
+    Serial.printf("   ❌ ADR failed, code: %d\n", state);
+  }
+}
+
+/**
+ * Track a device's SNR and, after a realtime batch, pick the setting
+ * its link allows (LoRaWAN-style: 3 dB of margin per step; a step is one
+ * SF down, then 3 dB less power - and the reverse when margin is short)
+ * (deviceMutex held)
+ * @param sf SF to send with sendAdr() once the mutex is released
+ * @param power TX power to send with it
+ * @return true if a setting is due and the downlink budget allows it
+ */
+bool updateAdr(DeviceState& dev, const PacketHeader& hdr, uint8_t rxSf, float snr, uint8_t& sf, int8_t& power) {
+  // Not on the setting we sent - lost downlink, the wearable fell back,
+  // or a device new to the table
+  if (rxSf != dev.adrSf) {
+    dev.adrSf = rxSf;
+    dev.adrPower = ADR_POWER_MAX;
+    dev.adrSnrCount = 0;
+  }
+  
+  dev.adrSnr[dev.adrSnrNext] = (int8_t)constrain(lroundf(snr), -128, 127);
+  dev.adrSnrNext = (dev.adrSnrNext + 1) % ADR_HISTORY;
+  if (dev.adrSnrCount < ADR_HISTORY) dev.adrSnrCount++;
+  
+  if (hdr.port != ADR_LISTEN_PORT || dev.adrSnrCount < ADR_MIN_SAMPLES) return false;
+  
+  int8_t snrMax = -128;
+  for (int i = 0; i < dev.adrSnrCount; i++) {
+    if (dev.adrSnr[i] > snrMax) snrMax = dev.adrSnr[i];
+  }
+  int steps = (int)floorf((snrMax - requiredSnr(rxSf) - ADR_MARGIN_DB) / 3.0);
+  
+  sf = rxSf;
+  power = dev.adrPower;
+  while (steps > 0 && sf > ADR_SF_MIN) { sf--; steps--; }
+  while (steps > 0 && power - 3 >= ADR_POWER_MIN) { power -= 3; steps--; }
+  while (steps < 0 && power < ADR_POWER_MAX) { power = min((int)ADR_POWER_MAX, power + 3); steps++; }
+  while (steps < 0 && sf < ADR_SF_MAX) { sf++; steps++; }
+  
+  bool changed = sf != dev.adrSf || power != dev.adrPower;
+  if (!changed && millis() - dev.adrCommandMs < ADR_REFRESH_MS) return false;
+  // Over budget: keep the current setting, decided again after the next batch
+  if (!downlinkBudget.allows(downlinkAirtimeMs(DownlinkPacket::ADR_SIZE), millis(), ADR_BUDGET_SHARE)) return false;
+  
+  dev.adrSf = sf;
+  dev.adrPower = power;
+  dev.adrCommandMs = millis();
+  if (changed) dev.adrSnrCount = 0;  // Judge the new setting on its own samples
+  return true;
+}
+
+// ============================================================================
+// REJECTED PACKETS
+// ============================================================================
+
+/**
+ * Whether a rejected packet repeats the previous rejected one
+ * (continuous RX can hand the same buffer over more than once)
+ */
+bool repeatsLastBadPacket(const uint8_t* data, int length) {
+  uint32_t hash = DeviceTable::packetHash(data, length);
+  bool repeated = length > 0 && length == lastBadLength && hash == lastBadHash;
+  lastBadHash = hash;
+  lastBadLength = length;
+  return repeated;
+}
+
+// ============================================================================
+// UART FORWARDING
+// ============================================================================
+
+/**
+ * Queue one packet for the Pi - stored until the Pi acknowledges it,
+ * sent by serviceForwarding()
+ */
+void writeUartFrame(const uint8_t* data, int length, int rssi, float snr, int64_t rxUs) {
+  forwardStore.push(data, length, rssi, snr, rxUs);
+}
+
+void putLE32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = (value >> 24) & 0xFF;
+}
+
+/**
+ * Send one stored packet to the Pi (UartFrame::STORED_PACKET)
+ * Payload: [record ID LE 4B][floor ID LE 4B][age ms LE 4B][RSSI int16 LE][SNR x4 int8]
+ *          [gateway ID LE 4B][RX time us LE 8B][packet]
+ * RX time is Unix time on the Pi's clock, 0 if unknown (no time sync yet,
+ * or stored before this boot).
+ */
+void sendStoredRecord(const ForwardStore::Record& r, int64_t nowUs) {
+  uint8_t head[27];
+  uint64_t rxTime = forwardStore.fromThisBoot(r) ? (uint64_t)hostClock.toHost(r.rxUs) : 0;
+  putLE32(head, r.id);
+  putLE32(head + 4, forwardStore.floorId());
+  putLE32(head + 8, forwardStore.ageMs(r, nowUs));
+  head[12] = r.rssi & 0xFF;
+  head[13] = (r.rssi >> 8) & 0xFF;
+  head[14] = (uint8_t)r.snr4;
+  putLE32(head + 15, gatewayId);
+  putLE32(head + 19, (uint32_t)rxTime);
+  putLE32(head + 23, (uint32_t)(rxTime >> 32));
+  if (!piLink.send(UartFrame::STORED_PACKET, head, sizeof(head), r.data, r.length)) {
+    Serial.println("   ❌ UART frame not sent");
+  }
+}
+
+/**
+ * New packets at once, then a few backlog packets per call - the rest of
+ * a catch-up follows on the next loop() passes
+ */
+void serviceForwarding() {
+  const int SEND_BURST = 4;  // About 1 KB of UART, without filling the TX ring
+  unsigned long now = millis();
+  int64_t nowUs = esp_timer_get_time();
+  
+  forwardStore.service(now);
+  for (int i = 0; i < SEND_BURST; i++) {
+    const ForwardStore::Record* r = forwardStore.nextToSend(now);
+    if (!r) break;
+    sendStoredRecord(*r, nowUs);
+  }
+}
+
+/**
+ * Write the header of a frame for the Pi: classic (10-byte device ID,
+ * frame counter, port) when the device ID is known, else compact with
+ * the short ID for the backend to resolve
+ */
+int buildHostHeader(uint8_t* out, const PacketHeader& hdr, uint16_t frameCounter, uint8_t port) {
+  if (!hdr.idKnown) return LoRaHeader::writeCompact(out, hdr.shortId, frameCounter, port);
+  return LoRaHeader::writeClassic(out, hdr.deviceId, frameCounter, port);
+}
+
+/**
+ * Forward a packet to the Raspberry Pi in the classic format
+ * Compact headers are expanded back to the 10-byte device ID, and a
+ * realtime batch (0x04) is unpacked into one 0x01 frame per reading,
+ * numbered with the frame counter values the wearable reserved for them.
+ * A compact frame from a device whose ID this gateway has not learned yet
+ * keeps its compact header; the backend resolves the short ID against
+ * the devices it knows.
+ */
+void forwardToRaspberryPi(const uint8_t* data, int length, int rssi, float snr, int64_t rxUs) {
+  PacketHeader hdr;
+  if (!decodeHeader(data, length, hdr)) return;
+  
+  const uint8_t* payload = data + hdr.headerLen;
+  int payloadLen = length - hdr.headerLen;
+  uint8_t frame[CLASSIC_HEADER_SIZE + 255];
+  
+  if (hdr.port == 4) {
+    RealtimeReading readings[REALTIME_BATCH_MAX];
+    int count = unpackRealtimeBatch(payload, payloadLen, readings, REALTIME_BATCH_MAX);
     
-    // Update dynamic data fields
-    char buffer[60];
-    
-    if (count > 0) {
-      // Clear and update left column data
-      display->setColor(BLACK);
-      display->fillRect(2, 46, 120, 48);  // Frame, HR, Temp, Noise area
-      display->setColor(WHITE);
-      
-      // Show (-x) when waiting for new valid packet with x skipped packets
-      if (packetsSkipped > 0) {
-        sprintf(buffer, "Frame:#%d(-%lu)", lastPacket.frameCounter, packetsSkipped);
-      } else {
-        sprintf(buffer, "Frame:#%d", lastPacket.frameCounter);
-      }
-      display->drawString(2, 46, buffer);
-      
-      if (lastPacket.type == 1 || lastPacket.type == 3) {
-        sprintf(buffer, "HR:%d%s bpm", 
-                lastPacket.heartRate,
-                lastPacket.hrAlert ? "!" : "");
-        display->drawString(2, 58, buffer);
-        
-        sprintf(buffer, "Temp:%.1f%sC", 
-                lastPacket.temperature,
-                lastPacket.tempAlert ? "!" : "");
-        display->drawString(2, 70, buffer);
-        
-        if (lastPacket.type == 1) {
-          sprintf(buffer, "Noise:%ddB%s", 
-                  lastPacket.noiseLevel,
-                  lastPacket.noiseAlert ? "!" : "");
-          display->drawString(2, 82, buffer);
-        }
-      }
-      
-      // Clear and update right column
-      display->setColor(BLACK);
-      display->fillRect(130, 22, 118, 72);  // Signal and status area
-      display->setColor(WHITE);
-      
-      sprintf(buffer, "RSSI:%ddBm", rssi);
-      display->drawString(130, 22, buffer);
-      
-      sprintf(buffer, "SNR:%.1fdB", snr);
-      display->drawString(130, 34, buffer);
-      
-      sprintf(buffer, "Size:%dB", length);
-      display->drawString(130, 46, buffer);
-      
-      unsigned long uptime = millis() / 1000;
-      unsigned long hours = uptime / 3600;
-      unsigned long minutes = (uptime % 3600) / 60;
-      unsigned long seconds = uptime % 60;
-      sprintf(buffer, "Up:%luh%02lum%02lus", hours, minutes, seconds);
-      display->drawString(130, 58, buffer);
-      
-      // Alert status
-      if (lastPacket.noiseAlert) {
-        display->drawString(130, 70, "LOUD!");
-      } else if (lastPacket.hrAlert || lastPacket.tempAlert) {
-        display->drawString(130, 70, "Alert!");
-      } else {
-        display->drawString(130, 70, "Normal");
-      }
-      
-      // Update bottom status bar - last packet time
-      display->setColor(BLACK);
-      display->fillRect(150, 100, 98, 12);  // Clear right side of status bar
-      display->setColor(WHITE);
-      
-      if (lastPacketMillis > 0) {
-        unsigned long elapsed = (millis() - lastPacketMillis) / 1000;
-        display->setTextAlignment(TEXT_ALIGN_RIGHT);
-        if (elapsed < 60) {
-          sprintf(buffer, "RX:(%02lu)s ago", elapsed);
-        } else if (elapsed < 3600) {
-          sprintf(buffer, "RX:(%02lu)m ago", elapsed / 60);
-        } else {
-          sprintf(buffer, "RX:(%lu)h ago", elapsed / 3600);
-        }
-        display->drawString(248, 100, buffer);
-      }
+    for (int i = 0; i < count; i++) {
+      int idx = buildHostHeader(frame, hdr, hdr.frameCounter + i, RealtimePacket::TYPE);
+      idx += RealtimePacket::write(frame + idx, readings[i].bpm, readings[i].bodyTemp,
+                                   readings[i].ambientTemp, readings[i].noise,
+                                   readings[i].fallState, readings[i].flags);
+      writeUartFrame(frame, idx, rssi, snr, rxUs);
     }
-    
-    // Use partial refresh for faster updates
-    display->update(BLACK_BUFFER);
-    ((HT_E0213A367*)display)->displayPartial();
+    Serial.printf("   → Queued for Pi (batch of %d frames)\n", count);
+    return;
   }
+  
+  if (hdr.compact && hdr.idKnown && payloadLen <= 255 - CLASSIC_HEADER_SIZE) {
+    int idx = buildHostHeader(frame, hdr, hdr.frameCounter, hdr.port);
+    memcpy(frame + idx, payload, payloadLen);
+    writeUartFrame(frame, idx + payloadLen, rssi, snr, rxUs);
+    Serial.printf("   → Queued for Pi (%d bytes)\n", idx + payloadLen);
+    return;
+  }
+  
+  writeUartFrame(data, length, rssi, snr, rxUs);
+  Serial.printf("   → Queued for Pi (%d bytes)\n", length);
 }
 
 // ============================================================================
-// UART FORWARDING
+// RADIO TASK
 // ============================================================================
 
-void forwardToRaspberryPi(uint8_t* data, int length, int rssi, float snr) {
-  // Frame format: [0xAA][LEN][RSSI][SNR][DATA...][0x55]
-  Serial1.write(0xAA);  // Start marker
-  Serial1.write((uint8_t)length);
-  Serial1.write((uint8_t)(rssi + 150));  // Convert -150~0 to 0~150
-  Serial1.write((uint8_t)(snr + 20));    // Convert -20~20 to 0~40
-  Serial1.write(data, length);
-  Serial1.write(0x55);  // End marker
+/**
+ * Link layer for a received packet (radio task, before the receiver is
+ * re-armed): header check, per-device duplicate / replay check and the
+ * downlinks that must go out while the wearable listens (ACK, ADR)
+ * The downlinks are decided under deviceMutex and sent after it is
+ * released, so loop() never waits for a transmission.
+ */
+void handleLinkLayer(RxPacket& p) {
+  p.dev = nullptr;
+  if (!decodeHeader(p.data, p.length, p.hdr)) {
+    p.status = RX_TOO_SHORT;
+    return;
+  }
+  if (p.hdr.port == 0 || (p.hdr.port > 7 && p.hdr.port != HISTORY_PORT)) {
+    p.status = RX_UNKNOWN_TYPE;
+    return;
+  }
+  
+  const uint8_t* payload = p.data + p.hdr.headerLen;
+  int payloadLen = p.length - p.hdr.headerLen;
+  if (!payloadComplete(p.hdr, payload, payloadLen)) {
+    p.status = RX_TOO_SHORT;
+    return;
+  }
   
-  Serial.printf("   → Forwarded to UART (%d bytes)\n", length + 5);
+  bool ackDue = false;
+  bool adrDue = false;
+  uint8_t adrSf = 0;
+  int8_t adrPower = 0;
+  
+  xSemaphoreTake(deviceMutex, portMAX_DELAY);
+  
+  // Per-device frame counter check - a repeat of a packet already
+  // accepted (alert retransmission, stale RX buffer) is not forwarded again
+  DeviceState* dev = devices.findOrAdd(p.hdr.shortId, p.rxMillis);
+  if (!p.hdr.compact) dev->setName(p.hdr.deviceId);
+  uint32_t hash = DeviceTable::packetHash(p.data, p.length);
+  DeviceState::FrameStatus frame = dev->checkFrame(p.hdr.frameCounter, hash);
+  p.dev = dev;
+  
+  if (frame == DeviceState::FRAME_DUPLICATE) {
+    dev->duplicates++;
+    p.status = RX_DUPLICATE;
+#if GATEWAY_SEND_ACKS
+    // Our ACK was lost - acknowledge again, but forward the alert only once
+    if (needsAck(p.hdr, payload, payloadLen) &&
+        millis() - dev->lastAckMs >= ACK_REPEAT_GUARD_MS &&
+        downlinkBudget.allows(downlinkAirtimeMs(DownlinkPacket::ACK_SIZE), millis())) {
+      ackDue = true;
+      dev->lastAckMs = millis();
+    }
+#endif
+  } else if (frame == DeviceState::FRAME_REPLAY) {
+    dev->replays++;
+    p.status = RX_REPLAY;
+    p.newestCounter = dev->highestCounter;
+  } else {
+    p.status = frame == DeviceState::FRAME_RESTART ? RX_RESTART : RX_NEW;
+    
+    // Batch frames reserve one counter value per reading
+    uint8_t span = (p.hdr.port == 4 && payloadLen >= 2 && payload[1] > 0) ? payload[1] : 1;
+    dev->updateLink(p.rssi, p.snr, p.rxMillis);
+    dev->acceptFrame(p.hdr.frameCounter, span, hash, frame);
+    
+#if GATEWAY_SEND_ACKS
+    // Acknowledge fall alerts while the wearable's receive window is open
+    if (needsAck(p.hdr, payload, payloadLen) &&
+        downlinkBudget.allows(downlinkAirtimeMs(DownlinkPacket::ACK_SIZE), millis())) {
+      ackDue = true;
+      dev->lastAckMs = millis();
+    }
+#endif
+    
+#if GATEWAY_ADR
+    // The wearable's ADR window is open right after a realtime batch
+    adrDue = updateAdr(*dev, p.hdr, p.sf, p.snr, adrSf, adrPower);
+#endif
+  }
+  
+  xSemaphoreGive(deviceMutex);
+  
+  if (ackDue) sendAck(p.hdr);
+  if (adrDue) sendAdr(p.hdr, adrSf, adrPower);
+}
+
+/**
+ * Back to receiving after a packet and any downlink it triggered
+ */
+void rearmReceiver() {
+  ulTaskNotifyTake(pdTRUE, 0);  // DIO1 also fired for TX done
+#if !GATEWAY_ADR
+  radio.startReceive();  // The ADR scan restarts reception on its own
+#endif
+}
+
+/**
+ * Radio task (core 0)
+ * Owns the SX1262: waits for DIO1, copies the packet and its RSSI/SNR
+ * into a pool slot, runs the link layer, re-arms the receiver and hands
+ * the slot to loop(). Nothing slow (Serial dumps, UART, e-ink) runs here,
+ * so packets arriving during a display refresh are still received.
+ */
+void radioTask(void* param) {
+  for (;;) {
+    int length = listenForPacket();
+    if (length <= 0) continue;
+    
+    uint8_t slot;
+    if (xQueueReceive(rxFreeSlots, &slot, 0) != pdTRUE) {
+      rxDropped++;
+      rearmReceiver();
+      continue;
+    }
+    
+    RxPacket& p = rxPool[slot];
+    int state = radio.readData(p.data, sizeof(p.data));
+    if (state != RADIOLIB_ERR_NONE) {
+      rxErrors++;
+      xQueueSend(rxFreeSlots, &slot, 0);
+      rearmReceiver();
+      continue;
+    }
+    p.length = radio.getPacketLength();
+    p.rssi = radio.getRSSI();
+    p.snr = radio.getSNR();
+#if GATEWAY_ADR
+    p.sf = listenSpreadingFactor;
+#else
+    p.sf = LORA_SPREADING_FACTOR;
+#endif
+    p.rxMillis = millis();
+    p.rxUs = dio1Us;
+    
+    handleLinkLayer(p);
+    rearmReceiver();
+    xQueueSend(rxQueue, &slot, 0);  // Never full: one entry per slot
+  }
 }
 
 // ============================================================================
@@ -620,8 +1352,24 @@ void setup() {
   Serial.println("Starting...");
   
   // Initialize UART to Raspberry Pi
-  Serial1.begin(UART_BAUD, SERIAL_8N1, UART_RX, UART_TX);
-  Serial.println("✅ UART initialized (to Raspberry Pi)");
+  if (piLink.begin(UART_NUM_1, UART_TX, UART_RX, UART_BAUD)) {
+    Serial.printf("✅ UART initialized (to Raspberry Pi, %d baud)\n", UART_BAUD);
+  } else {
+    Serial.println("❌ UART init failed (to Raspberry Pi)");
+  }
+  
+  // Identity in every frame to the Pi
+  if (gatewayId == 0) gatewayId = (uint32_t)ESP.getEfuseMac();
+  Serial.printf("Gateway ID: %08lX\n", (unsigned long)gatewayId);
+  
+  // Store-and-forward queue for the Pi
+  if (forwardStore.begin()) {
+    Serial.printf("✅ Forward store: %lu RAM slots, flash %s, %lu pending\n",
+                  forwardStore.getRamSlots(), forwardStore.hasFlash() ? "OK" : "unavailable",
+                  forwardStore.getPending());
+  } else {
+    Serial.println("❌ Forward store allocation failed");
+  }
   
   // Initialize SPI for LoRa
   Serial.println("Initializing SPI...");
@@ -664,6 +1412,11 @@ void setup() {
     }
   }
   
+  radio.setDio1Action(onRadioDio1);
+#if GATEWAY_ADR
+  Serial.printf("ADR: listening on SF%d-SF%d (channel activity scan)\n", ADR_SF_MIN, ADR_SF_MAX);
+#endif
+  
   // Start receiving
   Serial.println("\nStarting receiver mode...");
   state = radio.startReceive();
@@ -674,10 +1427,17 @@ void setup() {
     Serial.printf("❌ Start failed, code: %d\n", state);
   }
   
-  // Update display - ready state
-  if (displayAvailable) {
-    updateDisplay(0, 0, 0, 0);
+  // Display - ready state
+  requestDisplayUpdate();
+  
+  // Packet pool and radio task
+  deviceMutex = xSemaphoreCreateMutex();
+  rxQueue = xQueueCreate(RX_POOL_SIZE, sizeof(uint8_t));
+  rxFreeSlots = xQueueCreate(RX_POOL_SIZE, sizeof(uint8_t));
+  for (uint8_t i = 0; i < RX_POOL_SIZE; i++) {
+    xQueueSend(rxFreeSlots, &i, 0);
   }
+  xTaskCreatePinnedToCore(radioTask, "radio", 4096, nullptr, RADIO_TASK_PRIORITY, &radioTaskHandle, RADIO_CORE);
   
   Serial.println("\n🎧 Listening for packets...\n");
 }
@@ -686,172 +1446,155 @@ void setup() {
 // MAIN LOOP
 // ============================================================================
 
-void loop() {
-  // Check for time sync from Raspberry Pi (sent with every packet)
-  checkUartTimeSync();
-  
-  int state = radio.getPacketLength();
+/**
+ * Process one packet from the radio task: log, parse into its device,
+ * forward to the Pi and refresh the display
+ */
+void handlePacket(const RxPacket& p) {
+  int len = p.length;
   
-  if (state > 0) {
-    state = radio.readData(rxBuffer, sizeof(rxBuffer));
-    
-    if (state == RADIOLIB_ERR_NONE) {
-      int len = radio.getPacketLength();
-      int rssi = radio.getRSSI();
-      float snr = radio.getSNR();
-      
-      // Check packet type before parsing to preserve last valid packet
-      if (len >= 13) {
-        uint8_t packetType = rxBuffer[12];  // Port/packet type at byte 12
-        
-        // Ignore unknown packet types - keep last valid packet
-        if (packetType == 0 || packetType > 3) {
-          // Check if this is a duplicate of the last bad packet
-          bool isDuplicate = false;
-          if (lastRxLength == len && len > 0) {
-            isDuplicate = true;
-            for (int i = 0; i < len; i++) {
-              if (rxBuffer[i] != lastRxBuffer[i]) {
-                isDuplicate = false;
-                break;
-              }
-            }
-          }
-          
-          // Only count and update display for new (non-duplicate) bad packets
-          if (!isDuplicate) {
-            packetsSkipped++;
-            Serial.printf("\n⚠️ Unknown packet type: %d - Skipped #%lu (keeping last valid packet)\n", packetType, packetsSkipped);
-            
-            // Store this bad packet for duplicate detection
-            memcpy(lastRxBuffer, rxBuffer, len);
-            lastRxLength = len;
-            
-            // Update display to show skipped count
-            if (displayAvailable && packetsReceived > 0) {
-              updateDisplay(rssi, snr, len, packetsReceived);
-            }
-          } else {
-            Serial.printf("\n🔁 Duplicate bad packet (type: %d) - Ignored\n", packetType);
-          }
-          
-          radio.startReceive();
-          return;
-        }
+  if (p.status == RX_UNKNOWN_TYPE || p.status == RX_TOO_SHORT) {
+    // Only count and update display for new (non-duplicate) bad packets
+    if (!repeatsLastBadPacket(p.data, len)) {
+      packetsSkipped++;
+      if (p.status == RX_UNKNOWN_TYPE) {
+        Serial.printf("\n⚠️ Unknown packet type: %d - Skipped #%lu (keeping last valid packet)\n", p.hdr.port, packetsSkipped);
       } else {
-        // Packet too short, skip it
-        // Check if this is a duplicate
-        bool isDuplicate = false;
-        if (lastRxLength == len && len > 0) {
-          isDuplicate = true;
-          for (int i = 0; i < len; i++) {
-            if (rxBuffer[i] != lastRxBuffer[i]) {
-              isDuplicate = false;
-              break;
-            }
-          }
-        }
-        
-        if (!isDuplicate) {
-          packetsSkipped++;
-          Serial.printf("\n⚠️ Packet too short (%d bytes) - Skipped #%lu\n", len, packetsSkipped);
-          
-          // Store this bad packet
-          memcpy(lastRxBuffer, rxBuffer, len);
-          lastRxLength = len;
-          
-          // Update display to show skipped count
-          if (displayAvailable && packetsReceived > 0) {
-            updateDisplay(radio.getRSSI(), radio.getSNR(), len, packetsReceived);
-          }
-        } else {
-          Serial.printf("\n🔁 Duplicate short packet (%d bytes) - Ignored\n", len);
-        }
-        
-        radio.startReceive();
-        return;
-      }
-      
-      // Parse packet information (only if type is valid)
-      parsePacketInfo(rxBuffer, len);
-      
-      // Update counters only when frame counter changes (new packet)
-      if (lastPacket.frameCounter != lastFrameCounter) {
-        packetsReceived++;
-        needsFullRefresh = true;
-        lastPacketMillis = millis();
-        lastFrameCounter = lastPacket.frameCounter;
-        
-        // Trigger full refresh if packets were skipped to show (+x)
-        if (packetsSkipped > 0) {
-          Serial.printf("   ℹ️ Skipped %lu unknown packet(s) before this valid packet\n", packetsSkipped);
-          needsFullRefresh = true;  // Force full refresh to show (+x)
-        }
-        
-        // Note: packetsSkipped will be reset to 0 after display update in full refresh
+        Serial.printf("\n⚠️ Packet too short (%d bytes) - Skipped #%lu\n", len, packetsSkipped);
       }
       
-      // Check if layout needs full refresh (packet type changed, or critical alert)
-      static uint8_t lastPacketType = 0;
-      if (lastPacket.type != lastPacketType || 
-          lastPacket.fallState == 3 || 
-          (lastPacket.fallDetected && lastPacket.type == 3)) {
-        needsFullRefresh = true;
-        lastPacketType = lastPacket.type;
+      // Update display to show skipped count
+      if (packetsReceived > 0) {
+        displayRssi = p.rssi;
+        displaySnr = p.snr;
+        displayLength = len;
+        requestDisplayUpdate();
       }
-      
-      // Print to Serial
-      Serial.printf("\n📦 Packet #%lu\n", packetsReceived);
-      Serial.printf("   Type: %d, Device: %s, Frame: %d\n", 
-                    lastPacket.type, lastPacket.deviceId, lastPacket.frameCounter);
-      Serial.printf("   Length: %d bytes\n", len);
-      Serial.printf("   RSSI: %d dBm, SNR: %.2f dB\n", rssi, snr);
-      
-      if (lastPacket.type == 1 || lastPacket.type == 3) {
-        Serial.printf("   HR: %d bpm%s, Temp: %.1f°C%s", 
-                     lastPacket.heartRate,
-                     lastPacket.hrAlert ? " [ABNORMAL]" : "",
-                     lastPacket.temperature,
-                     lastPacket.tempAlert ? " [ABNORMAL]" : "");
-        if (lastPacket.fallDetected) Serial.print(" [FALL]");
-        Serial.println();
-        
-        if (lastPacket.type == 1) {
-          Serial.printf("   Noise: %d dB%s\n", 
-                       lastPacket.noiseLevel,
-                       lastPacket.noiseAlert ? " [TOO LOUD]" : "");
-        }
-      }
-      
-      Serial.print("   Data: ");
-      for (int i = 0; i < min(len, 20); i++) {
-        Serial.printf("%02X ", rxBuffer[i]);
-      }
-      if (len > 20) Serial.print("...");
-      Serial.println();
-      
-      // Forward to Raspberry Pi via UART
-      forwardToRaspberryPi(rxBuffer, len, rssi, snr);
-      
-      // Update E-ink display
-      updateDisplay(rssi, snr, len, packetsReceived);
-      
-    } else if (state != RADIOLIB_ERR_RX_TIMEOUT) {
-      Serial.printf("❌ Read error: %d\n", state);
+    } else if (p.status == RX_UNKNOWN_TYPE) {
+      Serial.printf("\n🔁 Duplicate bad packet (type: %d) - Ignored\n", p.hdr.port);
+    } else {
+      Serial.printf("\n🔁 Duplicate short packet (%d bytes) - Ignored\n", len);
     }
+    return;
+  }
+  
+  if (p.status == RX_DUPLICATE) {
+    Serial.printf("\n🔁 Duplicate frame (Device: %s, Frame: %d) - Not forwarded\n",
+                  p.hdr.deviceId, p.hdr.frameCounter);
+    return;
+  }
+  if (p.status == RX_REPLAY) {
+    Serial.printf("\n⛔ Old frame (Device: %s, Frame: %d, newest %d) - Dropped\n",
+                  p.hdr.deviceId, p.hdr.frameCounter, p.newestCounter);
+    return;
+  }
+  if (p.status == RX_RESTART) {
+    Serial.printf("\nℹ️ Device %s restarted (frame counter %d)\n",
+                  p.hdr.deviceId, p.hdr.frameCounter);
+  }
+  
+  // Parse packet information into the device, and take a copy to show
+  xSemaphoreTake(deviceMutex, portMAX_DELAY);
+  if (p.dev->shortId == p.hdr.shortId) {  // Not evicted since
+    parsePacketInfo(*p.dev, p.hdr, p.data, len);
+    shown = *p.dev;
+  }
+  xSemaphoreGive(deviceMutex);
+  
+  packetsReceived++;
+  lastPacketMillis = millis();
+  
+  // The display shows (+x) for packets skipped before this valid packet
+  if (packetsSkipped > 0) {
+    Serial.printf("   ℹ️ Skipped %lu unknown packet(s) before this valid packet\n", packetsSkipped);
+  }
+  skippedBeforeShown = packetsSkipped;
+  packetsSkipped = 0;
+  
+  // Print to Serial
+  Serial.printf("\n📦 Packet #%lu\n", packetsReceived);
+  Serial.printf("   Type: %d, Device: %s, Frame: %d\n", 
+                shown.type, shown.deviceId, shown.frameCounter);
+  Serial.printf("   Length: %d bytes\n", len);
+  if (shown.readings > 1) {
+    Serial.printf("   Batch: %d readings (showing newest)\n", shown.readings);
+  }
+  Serial.printf("   RSSI: %d dBm, SNR: %.2f dB, SF%d\n", p.rssi, p.snr, p.sf);
+  Serial.printf("   Device: %lu received, %lu lost, %lu duplicates, avg RSSI %.0f dBm\n",
+                shown.received, shown.lost, shown.duplicates, shown.rssiAverage);
+  
+  if (shown.type == 1 || shown.type == 3) {
+    Serial.printf("   HR: %d bpm%s, Temp: %.1f°C%s", 
+                 shown.heartRate,
+                 shown.hrAlert ? " [ABNORMAL]" : "",
+                 shown.temperature,
+                 shown.tempAlert ? " [ABNORMAL]" : "");
+    if (shown.fallDetected) Serial.print(" [FALL]");
+    Serial.println();
     
-    radio.startReceive();
+    if (shown.type == 1) {
+      Serial.printf("   Noise: %d dB%s\n", 
+                   shown.noiseLevel,
+                   shown.noiseAlert ? " [TOO LOUD]" : "");
+    }
   }
   
+  printPayloadSummary(p.hdr, p.data + p.hdr.headerLen, len - p.hdr.headerLen);
+  
+  Serial.print("   Data: ");
+  for (int i = 0; i < min(len, 20); i++) {
+    Serial.printf("%02X ", p.data[i]);
+  }
+  if (len > 20) Serial.print("...");
+  Serial.println();
+  
+  // Forward to Raspberry Pi via UART
+  forwardToRaspberryPi(p.data, len, p.rssi, p.snr, p.rxUs);
+  
+  // Update E-ink display (rendered by serviceDisplay())
+  displayRssi = p.rssi;
+  displaySnr = p.snr;
+  displayLength = len;
+  requestDisplayUpdate();
+}
+
+void loop() {
+  // Packets from the radio task
+  uint8_t slot;
+  TickType_t wait = pdMS_TO_TICKS(displayPending() || forwardStore.catchingUp() ? 20 : 100);
+  if (xQueueReceive(rxQueue, &slot, wait) == pdTRUE) {
+    handlePacket(rxPool[slot]);
+    xQueueSend(rxFreeSlots, &slot, 0);
+  }
+  
+  // E-ink display - rendered once a burst of packets has been handled
+  if (uxQueueMessagesWaiting(rxQueue) == 0) {
+    serviceDisplay();
+  }
+  
+  // ACKs and time sync from Raspberry Pi, then packets due to it
+  checkUartHost();
+  serviceForwarding();
+  
   // Print heartbeat every 10 seconds
   static uint32_t lastHeartbeat = 0;
   if (millis() - lastHeartbeat > 10000) {
     lastHeartbeat = millis();
     updateCurrentTime();
-    Serial.printf("[Heartbeat] Running... RX: %lu", packetsReceived);
+    Serial.printf("[Heartbeat] Running... RX: %lu, Devices: %d, Dropped: %lu, RX errors: %lu, UART lost/bad: %lu/%lu",
+                  packetsReceived, devices.size(), rxDropped, rxErrors,
+                  piLink.getFramesLost(), piLink.getFrameErrors());
+    Serial.printf(", Pi: %s, pending %lu (flash %lu, lost %lu)",
+                  forwardStore.isOnline() ? "online" : "offline", forwardStore.getPending(),
+                  forwardStore.getSpilled(), forwardStore.getDropped());
     if (currentTime.valid) {
       Serial.printf(" Time: %02d:%02d:%02d", currentTime.hour, currentTime.minute, currentTime.second);
     }
+    Serial.printf(", RX clock: %s (%lu syncs, %lu steps)", hostClock.isSynced() ? "synced" : "free-running",
+                  (unsigned long)hostClock.getSampleCount(), (unsigned long)hostClock.getStepCount());
+    Serial.printf(", downlinks: %lu (%lu/%lu ms in 1h, %lu refused)",
+                  (unsigned long)downlinkBudget.getSentCount(), (unsigned long)downlinkBudget.usedMs(millis()),
+                  (unsigned long)DownlinkBudget::budgetMs(), (unsigned long)downlinkBudget.getRefusedCount());
     Serial.println();
   }
-}
\ No newline at end of file
+}
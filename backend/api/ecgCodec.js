@@ -0,0 +1,126 @@
+/**
+ * ECG Codecs for Health Monitoring System
+ * =======================================
+ *
+ * Decoders for the compressed ECG windows sent by the ESP32 wearable:
+ * - Packet Type 0x02: 8-bit clipped deltas at 25 Hz (legacy)
+ * - Packet Type 0x05: adaptive Rice-coded deltas at 50 Hz
+ *
+ * The Rice decoder mirrors esp/include/EcgCodec.h bit for bit; change both
+ * together. Decoded samples are 12-bit ADC values (0-4095).
+ */
+
+const SAMPLE_MAX = 4095;
+const ESCAPE_QUOTIENT = 16;  // Unary run length that escapes to a raw value
+const RAW_BITS = 13;         // Escaped zigzag residual width
+
+const DELTA_SAMPLE_RATE_HZ = 25;
+const RICE_SAMPLE_RATE_HZ = 50;
+
+function clampSample(value) {
+  return Math.min(SAMPLE_MAX, Math.max(0, value));
+}
+
+/**
+ * Decode the legacy 0x02 window (50 bytes, 25 Hz)
+ * The window carries no absolute level, so it is reconstructed around the
+ * ADC midpoint. Each byte is (delta / 4) + 128.
+ *
+ * @param {Buffer} bytes - Compressed ECG bytes
+ * @returns {number[]} Samples
+ */
+function decodeDelta8(bytes) {
+  const samples = [];
+  let value = 2048;
+
+  for (const byte of bytes) {
+    value = clampSample(value + (byte - 128) * 4);
+    samples.push(value);
+  }
+
+  return samples;
+}
+
+/**
+ * Decode an adaptive Rice block (0x05 residuals)
+ *
+ * @param {Buffer} codes - Rice-coded residuals, MSB first
+ * @param {number} keyframe - First sample (exact)
+ * @param {number} step - Residual quantiser step (1 = lossless)
+ * @param {number} count - Samples in the block, keyframe included
+ * @returns {number[]} Samples (fewer than count if the block is truncated)
+ */
+function decodeRice(codes, keyframe, step, count) {
+  if (count === 0 || step === 0) return [];
+
+  const capacity = codes.length * 8;
+  let pos = 0;
+  const readBit = () => (codes[pos >> 3] >> (7 - (pos++ & 7))) & 1;
+  const readBits = (width) => {
+    let bits = 0;
+    for (let i = 0; i < width; i++) bits = (bits << 1) | readBit();
+    return bits;
+  };
+
+  // Running residual mean picks the Rice parameter (halved every 8 samples)
+  let sum = 16;
+  let n = 4;
+
+  let previous = keyframe;
+  const samples = [previous];
+
+  for (let i = 1; i < count; i++) {
+    let k = 0;
+    while ((n << k) < sum && k < 12) k++;
+
+    let quotient = 0;
+    while (quotient < ESCAPE_QUOTIENT) {
+      if (pos >= capacity) return samples;
+      if (readBit() === 0) break;
+      quotient++;
+    }
+
+    let u;
+    if (quotient === ESCAPE_QUOTIENT) {
+      if (pos + RAW_BITS > capacity) return samples;
+      u = readBits(RAW_BITS);
+    } else {
+      if (pos + k > capacity) return samples;
+      u = (quotient << k) | readBits(k);
+    }
+
+    const residual = (u & 1) ? -((u + 1) >> 1) : (u >> 1);
+    previous = clampSample(previous + residual * step);
+    samples.push(previous);
+
+    sum += u;
+    if (++n === 8) {
+      sum >>= 1;
+      n >>= 1;
+    }
+  }
+
+  return samples;
+}
+
+/**
+ * Decode the 0x05 ECG window from a full payload
+ * Layout: [0x05][keyframe u16][step][count][46B residuals][14B PQRST]
+ *
+ * @param {Buffer} payload - Packet payload (65 bytes)
+ * @returns {number[]} Samples
+ */
+function decodeRicePayload(payload) {
+  const keyframe = payload.readUInt16LE(1);
+  const step = payload.readUInt8(3);
+  const count = payload.readUInt8(4);
+  return decodeRice(payload.slice(5, 51), keyframe, step, count);
+}
+
+module.exports = {
+  DELTA_SAMPLE_RATE_HZ,
+  RICE_SAMPLE_RATE_HZ,
+  decodeDelta8,
+  decodeRice,
+  decodeRicePayload
+};
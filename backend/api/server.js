@@ -4,6 +4,7 @@ const bodyParser = require('body-parser');
 const morgan = require('morgan');
 const { Pool } = require('pg');
 const notificationService = require('./notificationService');
+const ecgCodec = require('./ecgCodec');
 
 const app = express();
 const PORT = process.env.PORT || 3000;
@@ -16,6 +17,18 @@ const deviceTrackingStartTime = {};
 // Format: { 'device_id_packetType': frame_counter }
 const lastFrameCounters = new Map();
 
+// Copies of one frame forwarded by overlapping gateways (each through its
+// own Pi): the first copy is processed at once, later ones only replace
+// its link metadata in packet_log when their RSSI is better.
+// Format: { 'device_id_frameCounter': { rxTime, rssi, snr, gatewayId, logId } }
+const recentFrames = new Map();
+const FRAME_COPY_WINDOW_MS = 30000;  // Gateway RX times agree to a few ms; covers alert retransmissions (15 s)
+
+// Short device IDs (compact LoRa header) of the known devices - a gateway
+// that has not learned a wearable's ID yet forwards only the short ID.
+// Format: { shortId: device_id, or null when two devices share it }
+const shortIds = new Map();
+
 // Alert thresholds
 const ALERT_THRESHOLDS = {
   heartRate: {
@@ -29,6 +42,18 @@ const ALERT_THRESHOLDS = {
   noiseLevel: parseInt(process.env.NOISE_THRESHOLD) || 200
 };
 
+// Records replayed from a gateway backlog keep the time they were received;
+// notifications are only pushed for data at most this old
+const LIVE_ALERT_MAX_AGE_MS = parseInt(process.env.LIVE_ALERT_MAX_AGE_MS) || 5 * 60 * 1000;
+
+/**
+ * Time since the gateway received a packet (0 if unknown)
+ */
+function receptionAgeMs(timestamp, rxTimeUs) {
+  const receivedAt = rxTimeUs ? rxTimeUs / 1000 : Date.parse(timestamp);
+  return Number.isFinite(receivedAt) ? Math.max(0, Date.now() - receivedAt) : 0;
+}
+
 // Track sent alerts to prevent duplicates
 const sentAlerts = new Map(); // key: `${device_id}_${alert_type}_${timestamp_minute}`
 const ALERT_COOLDOWN_MS = 5 * 60 * 1000; // 5 minutes cooldown
@@ -56,6 +81,75 @@ function isAlertInCooldown(deviceId, alertType) {
   return false;
 }
 
+/**
+ * 16-bit short device ID, as LoRaHeader::shortIdOf() (shared/include/PacketCodec.h):
+ * 32-bit FNV-1a of the first 10 bytes of the ID folded in half
+ */
+function shortIdOf(deviceId) {
+  let hash = 2166136261;
+  const bytes = Buffer.from(deviceId, 'utf8');
+  for (let i = 0; i < 10 && i < bytes.length && bytes[i] !== 0; i++) {
+    hash = Math.imul(hash ^ bytes[i], 16777619) >>> 0;
+  }
+  return ((hash >>> 16) ^ (hash & 0xFFFF)) & 0xFFFF;
+}
+
+function rememberShortId(deviceId) {
+  const shortId = shortIdOf(deviceId);
+  const known = shortIds.get(shortId);
+  if (known === undefined) {
+    shortIds.set(shortId, deviceId);
+  } else if (known !== deviceId) {
+    shortIds.set(shortId, null);  // Ambiguous - only the full ID will do
+  }
+}
+
+/**
+ * Device ID for a short ID, from the devices table
+ * @returns The device ID, or null if no single known device has it
+ */
+async function resolveShortId(shortId) {
+  if (!shortIds.has(shortId)) {
+    const result = await pool.query('SELECT device_id FROM devices');
+    for (const row of result.rows) rememberShortId(row.device_id);
+  }
+  return shortIds.get(shortId) || null;
+}
+
+/**
+ * Look up a frame among the copies seen recently
+ * @returns The earlier copy, or null if this one is new (it is remembered)
+ */
+function findFrameCopy(deviceId, frameCounter, rxTime, rssi, snr, gatewayId) {
+  const cutoff = rxTime - FRAME_COPY_WINDOW_MS;
+  if (recentFrames.size > 1000) {
+    for (const [k, copy] of recentFrames.entries()) {
+      if (copy.rxTime < cutoff) {
+        recentFrames.delete(k);
+      }
+    }
+  }
+  
+  const key = `${deviceId}_${frameCounter}`;
+  const copy = recentFrames.get(key);
+  if (copy && Math.abs(rxTime - copy.rxTime) < FRAME_COPY_WINDOW_MS) {
+    return copy;
+  }
+  
+  recentFrames.set(key, { rxTime, rssi, snr, gatewayId, logId: null });
+  return null;
+}
+
+/**
+ * Keep the link metadata of the best copy in packet_log
+ */
+async function storeBestCopy(copy) {
+  await pool.query(
+    `UPDATE packet_log SET rssi = $2, snr = $3, gateway_id = $4 WHERE id = $1`,
+    [copy.logId, copy.rssi, copy.snr, copy.gatewayId]
+  );
+}
+
 // PostgreSQL connection pool
 const pool = new Pool({
   host: process.env.DB_HOST || 'postgres',
@@ -94,6 +188,16 @@ function decodeTemperature(encoded) {
   return ((encoded / 255.0) * 100.0) - 20.0;
 }
 
+// Fall waveform fragments (0x07): 12-bit samples are MPU6050 counts / 16 + 2048
+const WAVEFORM_SAMPLE_OFFSET = 2048;
+const WAVEFORM_ACCEL_G_PER_SAMPLE = 16 / 16384;   // ±2 g range
+const WAVEFORM_GYRO_DPS_PER_SAMPLE = 16 / 131;    // ±250 °/s range
+const WAVEFORM_CHANNELS = 6;
+const WAVEFORM_REASSEMBLY_WINDOW = '30 minutes';  // Window IDs wrap, so only recent fragments match
+
+// Stage order of the diagnostics packet (ProfileStage in the wearable firmware)
+const DIAGNOSTIC_STAGES = ['imu_read', 'fall_detect', 'ecg', 'mic', 'temp', 'radio', 'loop'];
+
 /**
  * Parse binary packet data
  */
@@ -132,6 +236,8 @@ function parsePacket(base64Data, packetType) {
     return {
       packet_type: buffer.readUInt8(0),
       compressed_ecg,
+      ecg_samples: ecgCodec.decodeDelta8(compressed_ecg),
+      sample_rate_hz: ecgCodec.DELTA_SAMPLE_RATE_HZ,
       pqrst_timestamp,
       p_amp,
       q_amp,
@@ -141,6 +247,24 @@ function parsePacket(base64Data, packetType) {
       qrs_width,
       qt_interval
     };
+  } else if (packetType === 5) {
+    // Rice-coded ECG packet (65 bytes, same PQRST layout as type 2)
+    if (buffer.length < 65) return null;
+    
+    return {
+      packet_type: buffer.readUInt8(0),
+      compressed_ecg: buffer.slice(1, 51),
+      ecg_samples: ecgCodec.decodeRicePayload(buffer),
+      sample_rate_hz: ecgCodec.RICE_SAMPLE_RATE_HZ,
+      pqrst_timestamp: buffer.readUInt16LE(51),
+      p_amp: buffer.readInt16LE(53),
+      q_amp: buffer.readInt16LE(55),
+      r_amp: buffer.readInt16LE(57),
+      s_amp: buffer.readInt16LE(59),
+      t_amp: buffer.readInt16LE(61),
+      qrs_width: buffer.readUInt8(63),
+      qt_interval: buffer.readUInt8(64)
+    };
   } else if (packetType === 3) {
     // Fall event packet (45 bytes)
     if (buffer.length < 45) return null;
@@ -162,11 +286,173 @@ function parsePacket(base64Data, packetType) {
       accel_z: buffer.readFloatLE(37),
       movement_variance: buffer.readFloatLE(41)
     };
+  } else if (packetType === 7) {
+    // Fall waveform fragment (16-byte header + 96 bytes of Rice code)
+    if (buffer.length < 112) return null;
+    
+    return {
+      packet_type: buffer.readUInt8(0),
+      window_id: buffer.readUInt8(1),
+      fragment_index: buffer.readUInt8(2),
+      fragment_count: buffer.readUInt8(3),
+      channel: buffer.readUInt8(4),
+      start_sample: buffer.readUInt16LE(5),
+      window_length: buffer.readUInt16LE(7),
+      trigger_index: buffer.readUInt16LE(9),
+      sample_rate_hz: buffer.readUInt8(11),
+      samples: ecgCodec.decodeRice(buffer.slice(16, 112), buffer.readUInt16LE(12),
+                                   buffer.readUInt8(14), buffer.readUInt8(15))
+    };
+  } else if (packetType === 10) {
+    // Vitals history page (12-byte header, then records coded as in the 0x04 batch)
+    if (buffer.length < 17) return null;
+    
+    const logId = buffer.readUInt16LE(1);
+    const firstSequence = buffer.readUInt32LE(3);
+    const count = buffer.readUInt8(11);
+    let age = buffer.readUInt32LE(7);
+    let fields = [buffer[12], buffer[13], buffer[14], buffer[15]];
+    let status = buffer[16];
+    let offset = 17;
+    
+    const records = [];
+    for (let i = 0; i < count; i++) {
+      if (i > 0) {
+        if (offset + 2 > buffer.length) return null;
+        age -= buffer.readUInt8(offset);
+        const mask = buffer.readUInt8(offset + 1);
+        offset += 2;
+        fields = fields.slice();
+        for (let f = 0; f < 4; f++) {
+          if (!(mask & (1 << f))) continue;
+          if (offset >= buffer.length) return null;
+          if (buffer[offset] === 0x80) {
+            // Escape: absolute value follows
+            if (offset + 1 >= buffer.length) return null;
+            fields[f] = buffer[offset + 1];
+            offset += 2;
+          } else {
+            fields[f] = (fields[f] + buffer.readInt8(offset)) & 0xFF;
+            offset += 1;
+          }
+        }
+        if (mask & 0x10) {
+          if (offset >= buffer.length) return null;
+          status = buffer[offset++];
+        }
+      }
+      records.push({
+        sequence: firstSequence + i,
+        age_seconds: age,
+        heart_rate: fields[0],
+        body_temperature: decodeTemperature(fields[1]),
+        ambient_temperature: decodeTemperature(fields[2]),
+        noise_level: fields[3],
+        fall_state: (status >> 4) & 0x07,
+        alert_flags: status & 0x0F,
+        is_event: (status & 0x80) !== 0
+      });
+    }
+    
+    return {
+      packet_type: buffer.readUInt8(0),
+      log_id: logId,
+      records
+    };
+  } else if (packetType === 6) {
+    // Latency diagnostics packet (6 bytes + 8 per stage)
+    if (buffer.length < 6) return null;
+    
+    const stageCount = buffer.readUInt8(5);
+    if (buffer.length < 6 + stageCount * 8) return null;
+    
+    const stages = {};
+    for (let i = 0; i < stageCount; i++) {
+      const offset = 6 + i * 8;
+      stages[DIAGNOSTIC_STAGES[i] || `stage_${i}`] = {
+        avg_us: buffer.readUInt16LE(offset),
+        p99_us: buffer.readUInt16LE(offset + 2),
+        max_us: buffer.readUInt16LE(offset + 4),
+        misses: buffer.readUInt16LE(offset + 6)
+      };
+    }
+    
+    return {
+      packet_type: buffer.readUInt8(0),
+      window_seconds: buffer.readUInt32LE(1),
+      stages
+    };
   }
   
   return null;
 }
 
+/**
+ * Reassemble a fall window once all of its fragments are stored
+ * Missing samples (truncated blocks) are left as null.
+ *
+ * @returns {Promise<boolean>} true if the window was completed by this call
+ */
+async function assembleFallWaveform(deviceId, windowId, fragmentCount) {
+  const fragments = await pool.query(
+    `SELECT DISTINCT ON (fragment_index) *
+     FROM fall_waveform_fragments
+     WHERE device_id = $1 AND window_id = $2
+       AND timestamp > NOW() - INTERVAL '${WAVEFORM_REASSEMBLY_WINDOW}'
+     ORDER BY fragment_index, timestamp DESC`,
+    [deviceId, windowId]
+  );
+  if (fragments.rows.length < fragmentCount) return false;
+  
+  const existing = await pool.query(
+    `SELECT id FROM fall_waveforms
+     WHERE device_id = $1 AND window_id = $2
+       AND timestamp > NOW() - INTERVAL '${WAVEFORM_REASSEMBLY_WINDOW}'`,
+    [deviceId, windowId]
+  );
+  if (existing.rows.length > 0) return false;
+  
+  const first = fragments.rows[0];
+  const channels = [];
+  for (let c = 0; c < WAVEFORM_CHANNELS; c++) {
+    channels.push(new Array(first.window_length).fill(null));
+  }
+  for (const fragment of fragments.rows) {
+    const scale = fragment.channel < 3 ? WAVEFORM_ACCEL_G_PER_SAMPLE : WAVEFORM_GYRO_DPS_PER_SAMPLE;
+    fragment.samples.forEach((sample, i) => {
+      const index = fragment.start_sample + i;
+      if (fragment.channel < WAVEFORM_CHANNELS && index < first.window_length) {
+        channels[fragment.channel][index] = (sample - WAVEFORM_SAMPLE_OFFSET) * scale;
+      }
+    });
+  }
+  
+  // Attach to the alert this window followed
+  const fallEvent = await pool.query(
+    `SELECT id FROM fall_events
+     WHERE device_id = $1 AND timestamp > NOW() - INTERVAL '${WAVEFORM_REASSEMBLY_WINDOW}'
+     ORDER BY timestamp DESC LIMIT 1`,
+    [deviceId]
+  );
+  
+  await pool.query(
+    `INSERT INTO fall_waveforms
+     (device_id, fall_event_id, window_id, sample_rate_hz, window_length, trigger_index, accel_g, gyro_dps)
+     VALUES ($1, $2, $3, $4, $5, $6, $7, $8)`,
+    [
+      deviceId,
+      fallEvent.rows.length > 0 ? fallEvent.rows[0].id : null,
+      windowId,
+      first.sample_rate_hz,
+      first.window_length,
+      first.trigger_index,
+      JSON.stringify(channels.slice(0, 3)),
+      JSON.stringify(channels.slice(3, 6))
+    ]
+  );
+  return true;
+}
+
 // ============================================================================
 // API ENDPOINTS
 // ============================================================================
@@ -176,11 +462,52 @@ app.get('/health', (req, res) => {
   res.json({ status: 'ok', timestamp: new Date().toISOString() });
 });
 
-// Receive sensor data from ESP32
-app.post('/api/sensor-data', async (req, res) => {
-  const { device_id, packet_type, data, timestamp, frame_counter, rssi } = req.body;
+/**
+ * Store one packet posted by the Pi
+ * @returns { code, body } HTTP status and JSON response for it
+ */
+async function storeSensorData(packet) {
+  const { short_id, packet_type, data, timestamp, frame_counter, rssi, snr, gateway_id, rx_time_us } = packet;
+  let { device_id } = packet;
+  
+  if (device_id) {
+    rememberShortId(device_id);
+  } else if (Number.isInteger(short_id)) {
+    try {
+      device_id = await resolveShortId(short_id);
+    } catch (error) {
+      console.error('Error resolving short ID:', error);
+      return { code: 500, body: { error: 'Internal server error', details: error.message } };
+    }
+    if (!device_id) {
+      const hex = short_id.toString(16).toUpperCase().padStart(4, '0');
+      console.log(`  ⚠️  Short ID ${hex} matches no single known device - packet dropped`);
+      return { code: 400, body: { error: 'Unknown short device ID', short_id } };
+    }
+  } else {
+    return { code: 400, body: { error: 'Missing device_id' } };
+  }
   
-  console.log(`📡 Received packet from ${device_id}: Type ${packet_type}, Frame ${frame_counter}`);
+  console.log(`📡 Received packet from ${device_id}: Type ${packet_type}, Frame ${frame_counter}` +
+              (gateway_id ? ` via ${gateway_id}` : ''));
+  
+  // Same frame through another gateway
+  const rxTime = rx_time_us ? rx_time_us / 1000 : (Date.parse(timestamp) || Date.now());
+  const copy = findFrameCopy(device_id, frame_counter, rxTime, rssi, snr, gateway_id);
+  if (copy) {
+    if (rssi !== undefined && (copy.rssi === undefined || rssi > copy.rssi)) {
+      Object.assign(copy, { rssi, snr, gatewayId: gateway_id });
+      if (copy.logId !== null) {
+        await storeBestCopy(copy).catch((error) => console.error('Error updating packet_log:', error));
+      }
+    }
+    console.log(`  ⏭️  DUPLICATE copy skipped (Frame ${frame_counter}, ${rssi} dBm)`);
+    return { code: 200, body: {
+      status: 'duplicate',
+      message: 'Frame already received by another gateway',
+      frame_counter
+    } };
+  }
   
   // Check for duplicate packet (same frame_counter)
   const frameKey = `${device_id}_${packet_type}`;
@@ -188,11 +515,11 @@ app.post('/api/sensor-data', async (req, res) => {
   
   if (lastFrame !== undefined && lastFrame === frame_counter) {
     console.log(`  ⏭️  DUPLICATE packet skipped (Frame ${frame_counter} already processed)`);
-    return res.json({ 
+    return { code: 200, body: { 
       status: 'duplicate', 
       message: 'Packet already processed',
       frame_counter 
-    });
+    } };
   }
   
   try {
@@ -200,7 +527,8 @@ app.post('/api/sensor-data', async (req, res) => {
     const parsedData = parsePacket(data, packet_type);
     
     if (!parsedData) {
-      return res.status(400).json({ error: 'Invalid packet data' });
+      recentFrames.delete(`${device_id}_${frame_counter}`);
+      return { code: 400, body: { error: 'Invalid packet data' } };
     }
     
     // Ensure device exists
@@ -215,12 +543,28 @@ app.post('/api/sensor-data', async (req, res) => {
     lastFrameCounters.set(frameKey, frame_counter);
     
     // Log raw packet
-    await pool.query(
-      `INSERT INTO packet_log (device_id, packet_type, raw_data, data_length, frame_counter, rssi)
-       VALUES ($1, $2, $3, $4, $5, $6)`,
-      [device_id, packet_type, Buffer.from(data, 'base64'), Buffer.from(data, 'base64').length, frame_counter, rssi]
+    const logged = await pool.query(
+      `INSERT INTO packet_log (device_id, packet_type, raw_data, data_length, frame_counter, rssi, snr, gateway_id, rx_time)
+       VALUES ($1, $2, $3, $4, $5, $6, $7, $8, to_timestamp($9::double precision / 1000000))
+       RETURNING id`,
+      [device_id, packet_type, Buffer.from(data, 'base64'), Buffer.from(data, 'base64').length, frame_counter, rssi,
+       snr ?? null, gateway_id || null, rx_time_us || null]
     );
     
+    // A better copy may have come in meanwhile
+    const frameCopy = recentFrames.get(`${device_id}_${frame_counter}`);
+    if (frameCopy) {
+      frameCopy.logId = logged.rows[0].id;
+      if (frameCopy.rssi !== rssi) await storeBestCopy(frameCopy);
+    }
+    
+    // Backlog replays are stored at their reception time, without live alerts
+    const ageMs = receptionAgeMs(timestamp, rx_time_us);
+    const alertsLive = ageMs <= LIVE_ALERT_MAX_AGE_MS;
+    if (!alertsLive) {
+      console.log(`  ⏳ Received ${Math.round(ageMs / 60000)} min ago - stored without notifications`);
+    }
+    
     // Store data based on packet type
     if (packet_type === 1) {
       // Real-time monitoring data
@@ -228,8 +572,8 @@ app.post('/api/sensor-data', async (req, res) => {
       await pool.query(
         `INSERT INTO realtime_data 
          (device_id, heart_rate, body_temperature, ambient_temperature, noise_level, fall_state,
-          alert_hr_abnormal, alert_temp_abnormal, alert_fall, alert_noise, rssi, frame_counter)
-         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12)`,
+          alert_hr_abnormal, alert_temp_abnormal, alert_fall, alert_noise, rssi, frame_counter, timestamp)
+         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, COALESCE($13::timestamp, CURRENT_TIMESTAMP))`,
         [
           device_id,
           parsedData.heart_rate,
@@ -242,7 +586,8 @@ app.post('/api/sensor-data', async (req, res) => {
           (alertFlags & 0x04) !== 0,
           (alertFlags & 0x08) !== 0,
           parsedData.rssi,
-          frame_counter
+          frame_counter,
+          timestamp || null
         ]
       );
       
@@ -250,7 +595,7 @@ app.post('/api/sensor-data', async (req, res) => {
       
       // Check for alerts and send notifications
       // Unconscious alert (fall_state == 3 DANGEROUS - highest priority)
-      if (parsedData.fall_state === 3 && !isAlertInCooldown(device_id, 'unconscious')) {
+      if (alertsLive && parsedData.fall_state === 3 && !isAlertInCooldown(device_id, 'unconscious')) {
         console.log(`  🚨 UNCONSCIOUS DETECTED for ${device_id}!`);
         notificationService.sendAlert('unconscious', device_id, {
           heart_rate: parsedData.heart_rate,
@@ -262,7 +607,7 @@ app.post('/api/sensor-data', async (req, res) => {
       }
       
       // Fall alert (fall_state == 2 or fall flag)
-      if ((parsedData.fall_state === 2 || (alertFlags & 0x04) !== 0) && !isAlertInCooldown(device_id, 'fall')) {
+      if (alertsLive && (parsedData.fall_state === 2 || (alertFlags & 0x04) !== 0) && !isAlertInCooldown(device_id, 'fall')) {
         console.log(`  🚨 FALL DETECTED for ${device_id}!`);
         notificationService.sendAlert('fall', device_id, {
           heart_rate: parsedData.heart_rate,
@@ -274,7 +619,7 @@ app.post('/api/sensor-data', async (req, res) => {
       }
       
       // Heart rate alert
-      if ((alertFlags & 0x01) !== 0 && !isAlertInCooldown(device_id, 'heart_rate')) {
+      if (alertsLive && (alertFlags & 0x01) !== 0 && !isAlertInCooldown(device_id, 'heart_rate')) {
         notificationService.sendAlert('heart_rate', device_id, {
           heartRate: parsedData.heart_rate,
           threshold: ALERT_THRESHOLDS.heartRate
@@ -282,7 +627,7 @@ app.post('/api/sensor-data', async (req, res) => {
       }
       
       // Temperature alert
-      if ((alertFlags & 0x02) !== 0 && !isAlertInCooldown(device_id, 'temperature')) {
+      if (alertsLive && (alertFlags & 0x02) !== 0 && !isAlertInCooldown(device_id, 'temperature')) {
         notificationService.sendAlert('temperature', device_id, {
           temperature: parsedData.body_temperature,
           threshold: ALERT_THRESHOLDS.temperature
@@ -290,20 +635,20 @@ app.post('/api/sensor-data', async (req, res) => {
       }
       
       // Noise alert
-      if ((alertFlags & 0x08) !== 0 && !isAlertInCooldown(device_id, 'noise')) {
+      if (alertsLive && (alertFlags & 0x08) !== 0 && !isAlertInCooldown(device_id, 'noise')) {
         notificationService.sendAlert('noise', device_id, {
           noiseLevel: parsedData.noise_level,
           threshold: ALERT_THRESHOLDS.noiseLevel
         }).catch(err => console.error('Failed to send noise alert:', err));
       }
       
-    } else if (packet_type === 2) {
-      // ECG data
+    } else if (packet_type === 2 || packet_type === 5) {
+      // ECG data (type 2 legacy deltas, type 5 Rice-coded)
       await pool.query(
         `INSERT INTO ecg_data 
          (device_id, compressed_ecg, p_amplitude, q_amplitude, r_amplitude, s_amplitude, t_amplitude,
-          qrs_width, qt_interval, pqrst_timestamp)
-         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)`,
+          qrs_width, qt_interval, pqrst_timestamp, ecg_codec, sample_rate_hz, ecg_samples, timestamp)
+         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, COALESCE($14::timestamp, CURRENT_TIMESTAMP))`,
         [
           device_id,
           parsedData.compressed_ecg,
@@ -314,19 +659,23 @@ app.post('/api/sensor-data', async (req, res) => {
           parsedData.t_amp,
           parsedData.qrs_width,
           parsedData.qt_interval,
-          parsedData.pqrst_timestamp
+          parsedData.pqrst_timestamp,
+          packet_type,
+          parsedData.sample_rate_hz,
+          parsedData.ecg_samples,
+          timestamp || null
         ]
       );
       
-      console.log(`  ✅ Stored ECG data: R-peak=${parsedData.r_amp}, QRS=${parsedData.qrs_width}ms`);
+      console.log(`  ✅ Stored ECG data: ${parsedData.ecg_samples.length} samples @ ${parsedData.sample_rate_hz}Hz, R-peak=${parsedData.r_amp}, QRS=${parsedData.qrs_width}ms`);
       
     } else if (packet_type === 3) {
       // Fall event
       const fallResult = await pool.query(
         `INSERT INTO fall_events 
          (device_id, event_timestamp, jerk_magnitude, svm_value, angular_velocity, pitch_angle, roll_angle,
-          impact_count, warning_count, heart_rate, body_temperature, accel_x, accel_y, accel_z, movement_variance)
-         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15)
+          impact_count, warning_count, heart_rate, body_temperature, accel_x, accel_y, accel_z, movement_variance, timestamp)
+         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, COALESCE($16::timestamp, CURRENT_TIMESTAMP))
          RETURNING *`,
         [
           device_id,
@@ -343,15 +692,16 @@ app.post('/api/sensor-data', async (req, res) => {
           parsedData.accel_x,
           parsedData.accel_y,
           parsedData.accel_z,
-          parsedData.movement_variance
+          parsedData.movement_variance,
+          timestamp || null
         ]
       );
       
       console.log(`  🚨 FALL EVENT: Jerk=${parsedData.jerk_magnitude.toFixed(0)}, SVM=${parsedData.svm_value.toFixed(2)}g`);
       
-      // Send fall alert notification (always send for fall events, no cooldown check needed as they're rare)
+      // Send fall alert notification (always send for live fall events, no cooldown check needed as they're rare)
       const fallEventData = fallResult.rows[0];
-      notificationService.sendAlert('fall', device_id, {
+      if (alertsLive) notificationService.sendAlert('fall', device_id, {
         jerk_magnitude: fallEventData.jerk_magnitude,
         svm_value: fallEventData.svm_value,
         angular_velocity: fallEventData.angular_velocity,
@@ -363,14 +713,105 @@ app.post('/api/sensor-data', async (req, res) => {
         accel_y: fallEventData.accel_y,
         accel_z: fallEventData.accel_z
       }).catch(err => console.error('Failed to send fall event alert:', err));
+      
+    } else if (packet_type === 6) {
+      // Latency diagnostics
+      await pool.query(
+        `INSERT INTO device_diagnostics (device_id, window_seconds, stages, timestamp)
+         VALUES ($1, $2, $3, COALESCE($4::timestamp, CURRENT_TIMESTAMP))`,
+        [device_id, parsedData.window_seconds, JSON.stringify(parsedData.stages), timestamp || null]
+      );
+      
+      console.log(`  ⏱  Stored diagnostics: ${Object.keys(parsedData.stages).length} stages over ${parsedData.window_seconds}s`);
+      
+    } else if (packet_type === 7) {
+      // Fall waveform fragment
+      await pool.query(
+        `INSERT INTO fall_waveform_fragments
+         (device_id, window_id, fragment_index, fragment_count, channel, start_sample,
+          window_length, trigger_index, sample_rate_hz, samples)
+         VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)`,
+        [
+          device_id,
+          parsedData.window_id,
+          parsedData.fragment_index,
+          parsedData.fragment_count,
+          parsedData.channel,
+          parsedData.start_sample,
+          parsedData.window_length,
+          parsedData.trigger_index,
+          parsedData.sample_rate_hz,
+          JSON.stringify(parsedData.samples)
+        ]
+      );
+      
+      console.log(`  📈 Stored fall waveform fragment ${parsedData.fragment_index + 1}/${parsedData.fragment_count} (window ${parsedData.window_id}, channel ${parsedData.channel}, ${parsedData.samples.length} samples)`);
+      
+      if (await assembleFallWaveform(device_id, parsedData.window_id, parsedData.fragment_count)) {
+        console.log(`  ✅ Fall waveform ${parsedData.window_id} reassembled`);
+      }
+      
+    } else if (packet_type === 10) {
+      // Vitals history - past readings, so no alerts are raised from them
+      let stored = 0;
+      for (const record of parsedData.records) {
+        const result = await pool.query(
+          `INSERT INTO vitals_history
+           (device_id, recorded_at, log_id, sequence, heart_rate, body_temperature, ambient_temperature,
+            noise_level, fall_state, alert_hr_abnormal, alert_temp_abnormal, alert_fall, alert_noise, is_event)
+           VALUES ($1, COALESCE($2::timestamp, CURRENT_TIMESTAMP) - make_interval(secs => $3),
+                   $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15)
+           ON CONFLICT (device_id, log_id, sequence) DO NOTHING`,
+          [
+            device_id,
+            timestamp || null,
+            record.age_seconds,
+            parsedData.log_id,
+            record.sequence,
+            record.heart_rate,
+            record.body_temperature,
+            record.ambient_temperature,
+            record.noise_level,
+            record.fall_state,
+            (record.alert_flags & 0x01) !== 0,
+            (record.alert_flags & 0x02) !== 0,
+            (record.alert_flags & 0x04) !== 0,
+            (record.alert_flags & 0x08) !== 0,
+            record.is_event
+          ]
+        );
+        stored += result.rowCount;
+      }
+      
+      const oldest = parsedData.records.length > 0 ? parsedData.records[0].age_seconds : 0;
+      console.log(`  📚 Stored vitals history: ${stored}/${parsedData.records.length} new records (log ${parsedData.log_id}, oldest ${Math.round(oldest / 60)} min ago)`);
     }
     
-    res.json({ status: 'success', message: 'Data stored successfully' });
+    return { code: 200, body: { status: 'success', message: 'Data stored successfully' } };
     
   } catch (error) {
     console.error('❌ Error processing data:', error);
-    res.status(500).json({ error: 'Internal server error', details: error.message });
+    recentFrames.delete(`${device_id}_${frame_counter}`);  // Not stored - the retry is not a duplicate
+    return { code: 500, body: { error: 'Internal server error', details: error.message } };
+  }
+}
+
+// Receive sensor data from ESP32
+app.post('/api/sensor-data', async (req, res) => {
+  const result = await storeSensorData(req.body);
+  res.status(result.code).json(result.body);
+});
+
+// Receive a run of stored packets (gateway backlog replay), in order
+// Response: { results: [{ code, status }] } - one per packet
+app.post('/api/sensor-data/batch', async (req, res) => {
+  const packets = Array.isArray(req.body.packets) ? req.body.packets : [];
+  const results = [];
+  for (const packet of packets) {
+    const result = await storeSensorData(packet);
+    results.push({ code: result.code, status: result.body.status || 'error' });
   }
+  res.json({ results });
 });
 
 // Get latest vitals for all devices
@@ -753,6 +1194,7 @@ app.listen(PORT, '0.0.0.0', () => {
   
   console.log(`\n📋 Available endpoints:`);
   console.log(`   POST   /api/sensor-data - Receive data from ESP32`);
+  console.log(`   POST   /api/sensor-data/batch - Receive a gateway backlog replay`);
   console.log(`   GET    /api/vitals/latest - Get latest vitals`);
   console.log(`   GET    /api/realtime/:device_id - Get real-time data`);
   console.log(`   GET    /api/ecg/:device_id - Get ECG data`);
@@ -26,7 +26,7 @@ CREATE TABLE IF NOT EXISTS realtime_data (
     frame_counter INTEGER
 );
 
--- ECG Data (Packet Type 0x02)
+-- ECG Data (Packet Types 0x02 and 0x05)
 CREATE TABLE IF NOT EXISTS ecg_data (
     id SERIAL PRIMARY KEY,
     device_id VARCHAR(50) REFERENCES devices(device_id),
@@ -39,9 +39,17 @@ CREATE TABLE IF NOT EXISTS ecg_data (
     t_amplitude INTEGER,
     qrs_width INTEGER,
     qt_interval INTEGER,
-    pqrst_timestamp INTEGER
+    pqrst_timestamp INTEGER,
+    ecg_codec SMALLINT DEFAULT 2,       -- Packet type: 2 = 8-bit delta, 5 = Rice-coded
+    sample_rate_hz SMALLINT,
+    ecg_samples SMALLINT[]              -- Decoded 12-bit samples
 );
 
+-- Columns added with the Rice-coded ECG packet (for databases created earlier)
+ALTER TABLE ecg_data ADD COLUMN IF NOT EXISTS ecg_codec SMALLINT DEFAULT 2;
+ALTER TABLE ecg_data ADD COLUMN IF NOT EXISTS sample_rate_hz SMALLINT;
+ALTER TABLE ecg_data ADD COLUMN IF NOT EXISTS ecg_samples SMALLINT[];
+
 -- Fall Events (Packet Type 0x03)
 CREATE TABLE IF NOT EXISTS fall_events (
     id SERIAL PRIMARY KEY,
@@ -74,7 +82,76 @@ CREATE TABLE IF NOT EXISTS packet_log (
     raw_data BYTEA,
     data_length INTEGER,
     frame_counter INTEGER,
-    rssi INTEGER
+    rssi INTEGER,
+    snr REAL,
+    gateway_id VARCHAR(8),              -- Gateway whose copy was kept (best RSSI)
+    rx_time TIMESTAMP                   -- Gateway RX time on the Pi's clock
+);
+
+-- Columns added with multi-gateway support (for databases created earlier)
+ALTER TABLE packet_log ADD COLUMN IF NOT EXISTS snr REAL;
+ALTER TABLE packet_log ADD COLUMN IF NOT EXISTS gateway_id VARCHAR(8);
+ALTER TABLE packet_log ADD COLUMN IF NOT EXISTS rx_time TIMESTAMP;
+
+-- Wearable Latency Diagnostics (Packet Type 0x06)
+CREATE TABLE IF NOT EXISTS device_diagnostics (
+    id SERIAL PRIMARY KEY,
+    device_id VARCHAR(50) REFERENCES devices(device_id),
+    timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    window_seconds INTEGER,             -- Period the statistics cover
+    stages JSONB                        -- {stage: {avg_us, p99_us, max_us, misses}}
+);
+
+-- Fall Waveform Fragments (Packet Type 0x07, one Rice-coded block of one IMU axis)
+CREATE TABLE IF NOT EXISTS fall_waveform_fragments (
+    id SERIAL PRIMARY KEY,
+    device_id VARCHAR(50) REFERENCES devices(device_id),
+    timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    window_id INTEGER,                  -- Wraps at 256, pair with timestamp
+    fragment_index INTEGER,
+    fragment_count INTEGER,
+    channel INTEGER,                    -- 0-2 accel X/Y/Z, 3-5 gyro X/Y/Z
+    start_sample INTEGER,
+    window_length INTEGER,
+    trigger_index INTEGER,
+    sample_rate_hz INTEGER,
+    samples JSONB                       -- Decoded 12-bit samples
+);
+
+-- Reassembled fall windows (all fragments of a window received)
+CREATE TABLE IF NOT EXISTS fall_waveforms (
+    id SERIAL PRIMARY KEY,
+    device_id VARCHAR(50) REFERENCES devices(device_id),
+    timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    fall_event_id INTEGER REFERENCES fall_events(id),
+    window_id INTEGER,
+    sample_rate_hz INTEGER,
+    window_length INTEGER,
+    trigger_index INTEGER,              -- First sample after the fall was confirmed
+    accel_g JSONB,                      -- [[x...], [y...], [z...]] in g
+    gyro_dps JSONB                      -- [[x...], [y...], [z...]] in °/s
+);
+
+-- Vitals History (Packet Type 0x0A): minute summaries and fall events logged
+-- on the wearable, uploaded when it is in range (possibly hours later)
+CREATE TABLE IF NOT EXISTS vitals_history (
+    id SERIAL PRIMARY KEY,
+    device_id VARCHAR(50) REFERENCES devices(device_id),
+    timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP,   -- When the page arrived
+    recorded_at TIMESTAMP,              -- End of the summarised minute, or the event
+    log_id INTEGER,                     -- Random per wearable boot
+    sequence BIGINT,                    -- Record number within the log
+    heart_rate INTEGER,                 -- Minute average (0 = no pulse)
+    body_temperature NUMERIC(5,2),
+    ambient_temperature NUMERIC(5,2),
+    noise_level INTEGER,                -- Minute peak
+    fall_state INTEGER,                 -- Most severe state of the minute
+    alert_hr_abnormal BOOLEAN DEFAULT FALSE,
+    alert_temp_abnormal BOOLEAN DEFAULT FALSE,
+    alert_fall BOOLEAN DEFAULT FALSE,
+    alert_noise BOOLEAN DEFAULT FALSE,
+    is_event BOOLEAN DEFAULT FALSE,     -- Fall event record, not a summary
+    UNIQUE (device_id, log_id, sequence)  -- Resent pages are stored once
 );
 
 -- Create indexes for better query performance
@@ -83,6 +160,10 @@ CREATE INDEX idx_ecg_device_timestamp ON ecg_data(device_id, timestamp DESC);
 CREATE INDEX idx_fall_device_timestamp ON fall_events(device_id, timestamp DESC);
 CREATE INDEX idx_fall_status ON fall_events(response_status);
 CREATE INDEX idx_packet_device_type ON packet_log(device_id, packet_type, timestamp DESC);
+CREATE INDEX idx_diagnostics_device_timestamp ON device_diagnostics(device_id, timestamp DESC);
+CREATE INDEX idx_waveform_fragments_window ON fall_waveform_fragments(device_id, window_id, timestamp DESC);
+CREATE INDEX idx_waveforms_device_timestamp ON fall_waveforms(device_id, timestamp DESC);
+CREATE INDEX idx_history_device_recorded ON vitals_history(device_id, recorded_at DESC);
 
 -- Create views for easy querying
 CREATE OR REPLACE VIEW latest_vitals AS
@@ -133,6 +214,7 @@ $$ LANGUAGE plpgsql IMMUTABLE;
 
 COMMENT ON TABLE devices IS 'ESP32 device registration';
 COMMENT ON TABLE realtime_data IS 'Real-time monitoring data (Packet Type 0x01)';
-COMMENT ON TABLE ecg_data IS 'ECG waveform data (Packet Type 0x02)';
+COMMENT ON TABLE ecg_data IS 'ECG waveform data (Packet Types 0x02 and 0x05)';
 COMMENT ON TABLE fall_events IS 'Fall detection events (Packet Type 0x03)';
 COMMENT ON TABLE packet_log IS 'Raw packet log for debugging';
+COMMENT ON TABLE vitals_history IS 'Vitals history uploaded by the wearable (Packet Type 0x0A)';
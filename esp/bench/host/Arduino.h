@@ -0,0 +1,141 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/**
+ * Host stand-in for the Arduino core (native env only)
+ *
+ * Provides just what the algorithm headers use, behind three small
+ * interfaces the replay harness drives:
+ *   clock - millis() / micros() / esp_timer_get_time() read hostClock(),
+ *           which the harness advances to each trace sample's timestamp
+ *   ADC   - analogRead() / digitalRead() return hostPin() values the
+ *           harness sets per sample
+ *   log   - Print writes to stdout (HostConsole)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <cmath>
+#include <cstdlib>
+
+using std::abs;
+using std::sqrt;
+using std::atan2;
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define DEC 10
+#define HEX 16
+#define ADC_11db 3
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// By value, so static const class members are not odr-used
+template <typename A, typename B>
+inline auto min(A a, B b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template <typename A, typename B>
+inline auto max(A a, B b) -> decltype(a < b ? b : a) { return a < b ? b : a; }
+
+// --- Clock ---
+
+inline int64_t& hostClock() {
+  static int64_t nowUs = 0;
+  return nowUs;
+}
+
+inline unsigned long millis() { return (unsigned long)(hostClock() / 1000); }
+inline unsigned long micros() { return (unsigned long)hostClock(); }
+inline void delay(unsigned long ms) { hostClock() += (int64_t)ms * 1000; }
+
+// --- ADC / GPIO ---
+
+inline int& hostPin(uint8_t pin) {
+  static int pins[64] = {0};
+  return pins[pin & 63];
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return hostPin(pin) != 0; }
+inline uint16_t analogRead(uint8_t pin) { return (uint16_t)hostPin(pin); }
+inline void analogReadResolution(uint8_t) {}
+inline void analogSetAttenuation(int) {}
+
+// --- Print ---
+
+class Print {
+  size_t printNumber(unsigned long n, int base) {
+    char buf[34];
+    char* p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    if (base < 2) base = 10;
+    do {
+      int digit = n % base;
+      *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+      n /= base;
+    } while (n > 0);
+    return print(p);
+  }
+
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* data, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*data++);
+    return n;
+  }
+  virtual void flush() {}
+
+  size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+  size_t print(const char* str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+  size_t print(long n, int base = DEC) {
+    if (base == DEC && n < 0) return print('-') + printNumber((unsigned long)-n, DEC);
+    return printNumber((unsigned long)n, base);
+  }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+  size_t print(bool b) { return print((int)b); }
+
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+    return write((const uint8_t*)buf, len);
+  }
+};
+
+/**
+ * stdout as a Print (the harness begins Log with it)
+ */
+class HostConsole : public Print {
+public:
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* data, size_t len) override { return fwrite(data, 1, len, stdout); }
+  void flush() override { fflush(stdout); }
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include "Arduino.h"
+
+/**
+ * Host stand-in for esp_timer (native env only) - reads the harness clock
+ */
+inline int64_t esp_timer_get_time() {
+  return hostClock();
+}
+
+#endif
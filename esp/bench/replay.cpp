@@ -0,0 +1,813 @@
+/**
+ * ==============================================================================
+ * HOST BENCHMARK AND REPLAY HARNESS - FallDetector / AD8232
+ * ==============================================================================
+ *
+ * Feeds IMU and ECG traces through the firmware algorithms on the host
+ * (PlatformIO `native` env) and reports per-sample CPU cost, detection
+ * latency and accuracy, so threshold or code changes can be compared.
+ *
+ *   pio run -e native
+ *   .pio/build/native/program                      # built-in synthetic suite
+ *   .pio/build/native/program --imu walk.csv --ecg ecg.csv --repeat 50
+ *
+ * Options:
+ *   --imu FILE      IMU trace (repeatable); replaces the synthetic IMU suite
+ *   --ecg FILE      ECG trace (repeatable); replaces the synthetic ECG suite
+ *   --repeat N      Timing passes per trace (default 20)
+ *   --csv           One machine-readable line per trace instead of tables
+ *   --float         Fall detector on the float reference path (detectFall per
+ *                   sample) instead of the firmware's integer batch kernel +
+ *                   update(); detections should match
+ *   --rate HZ       Decimate IMU traces to HZ (e.g. 25, the QUIET rate) and
+ *                   replay them with FallDetector::setSampleRate(HZ)
+ *   -v              Show the algorithms' own log output
+ *
+ * Trace formats (CSV, '#' comments and a header line are skipped):
+ *   IMU: time_ms,ax,ay,az,gx,gy,gz,truth
+ *        m/s² and °/s as MPU6050::SensorData (quantised to MPU6050 counts on
+ *        load, as the firmware sees them); truth marks the onset of a real
+ *        fall (first sample of the drop, before the impact): 1 = wearer
+ *        moves afterwards, 2 = wearer stays still (DANGEROUS expected), 0 or
+ *        empty otherwise
+ *   ECG: time_ms,value,leads_off,r_peak
+ *        12-bit ADC value at 100 Hz; r_peak = 1 on annotated R peaks
+ *
+ * Scoring:
+ *   Fall - a FALL_DETECTED entry within FALL_MATCH_MS of a truth onset is a
+ *   hit (latency = entry time - onset time), any other entry a false alarm.
+ *   Every fall takes time to happen, so a mean latency of 0 means the truth
+ *   marks are on the detection sample; the bench then exits with 1.
+ *   Truth 2 expects DANGEROUS within DANGEROUS_MATCH_MS, truth 1 must not
+ *   reach it.
+ *   ECG - a reported R peak within BEAT_MATCH_MS of an annotation is a hit.
+ *   Beats in the detector's training period (ECG_TRAINING_MS after the start
+ *   or after leads off) are not scored. Latency is the time from the R peak
+ *   to the sample that reported it.
+ * ==============================================================================
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "FallDetector.h"
+#include "AD8232.h"
+#include "Log.h"
+
+LogStream Log;
+
+/**
+ * Discards the algorithms' log output unless -v is given
+ */
+class NullConsole : public Print {
+public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t len) override { return len; }
+};
+
+static const uint32_t FALL_MATCH_MS = 3000;
+static const uint32_t DANGEROUS_MATCH_MS = 10000;
+static const uint32_t BEAT_MATCH_MS = 80;
+static const uint32_t ECG_TRAINING_MS = 3000;
+static const int IMU_BATCH = 10;  // Samples per FIFO drain on the wearable (IMU_FIFO_BATCH)
+
+// Pins as wired on the wearable (values come from hostPin())
+static const uint8_t PIN_ECG = 1;
+static const uint8_t PIN_LO_PLUS = 9;
+static const uint8_t PIN_LO_MINUS = 10;
+
+// ============================================================================
+// Traces
+// ============================================================================
+
+struct ImuRow {
+  uint32_t timeMs;
+  ImuData data;
+  int truth;
+};
+
+struct EcgRow {
+  uint32_t timeMs;
+  int value;
+  bool leadsOff;
+  bool rPeak;
+};
+
+struct ImuTrace {
+  std::string name;
+  std::vector<ImuRow> rows;
+};
+
+struct EcgTrace {
+  std::string name;
+  std::vector<EcgRow> rows;
+};
+
+/**
+ * Split one CSV line into up to maxFields numbers
+ * @return Number of fields parsed (0 for comments and header lines)
+ */
+static int parseCsvLine(const char* line, double* fields, int maxFields) {
+  if (line[0] == '#') return 0;
+  int count = 0;
+  const char* p = line;
+  while (count < maxFields) {
+    char* end;
+    double v = strtod(p, &end);
+    if (end == p) {
+      if (*p != ',') break;  // Empty field reads as 0
+      v = 0;
+    }
+    fields[count++] = v;
+    p = end;
+    while (*p == ' ') p++;
+    if (*p != ',') break;
+    p++;
+  }
+  return count;
+}
+
+static int16_t toCounts(float value, float lsbPerUnit) {
+  long counts = lround(value * lsbPerUnit);
+  return (int16_t)constrain(counts, -32768L, 32767L);
+}
+
+/**
+ * Quantise a reading to MPU6050 counts, as readFIFOBatch() delivers it
+ */
+static ImuSample toSample(const ImuData& d, uint32_t timeMs) {
+  const float perMs2 = IMU_ACCEL_LSB_PER_G / FallMath::GRAVITY;
+  ImuSample s;
+  s.accelRaw[0] = toCounts(d.accelX, perMs2);
+  s.accelRaw[1] = toCounts(d.accelY, perMs2);
+  s.accelRaw[2] = toCounts(d.accelZ, perMs2);
+  s.gyroRaw[0] = toCounts(d.gyroX, IMU_GYRO_LSB_PER_DPS);
+  s.gyroRaw[1] = toCounts(d.gyroY, IMU_GYRO_LSB_PER_DPS);
+  s.gyroRaw[2] = toCounts(d.gyroZ, IMU_GYRO_LSB_PER_DPS);
+  s.data.accelX = ImuRange::accelMs2(s.accelRaw[0]);
+  s.data.accelY = ImuRange::accelMs2(s.accelRaw[1]);
+  s.data.accelZ = ImuRange::accelMs2(s.accelRaw[2]);
+  s.data.gyroX = ImuRange::gyroDps(s.gyroRaw[0]);
+  s.data.gyroY = ImuRange::gyroDps(s.gyroRaw[1]);
+  s.data.gyroZ = ImuRange::gyroDps(s.gyroRaw[2]);
+  s.timestamp_us = (int64_t)timeMs * 1000;
+  return s;
+}
+
+static bool loadImuTrace(const char* path, ImuTrace& trace) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  trace.name = path;
+  char line[256];
+  double v[8];
+  while (fgets(line, sizeof(line), f)) {
+    int n = parseCsvLine(line, v, 8);
+    if (n < 7) continue;
+    ImuRow row;
+    row.timeMs = (uint32_t)v[0];
+    row.data = {(float)v[1], (float)v[2], (float)v[3], (float)v[4], (float)v[5], (float)v[6]};
+    row.truth = n >= 8 ? (int)v[7] : 0;
+    trace.rows.push_back(row);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool loadEcgTrace(const char* path, EcgTrace& trace) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  trace.name = path;
+  char line[256];
+  double v[4];
+  while (fgets(line, sizeof(line), f)) {
+    int n = parseCsvLine(line, v, 4);
+    if (n < 2) continue;
+    EcgRow row;
+    row.timeMs = (uint32_t)v[0];
+    row.value = (int)v[1];
+    row.leadsOff = n >= 3 && v[2] != 0;
+    row.rPeak = n >= 4 && v[3] != 0;
+    trace.rows.push_back(row);
+  }
+  fclose(f);
+  return true;
+}
+
+// ============================================================================
+// Synthetic suite (deterministic)
+// ============================================================================
+
+static const float G = 9.80665f;
+static const float DEG = (float)(PI / 180.0);
+
+static uint32_t noiseState = 12345;
+
+// Roughly normal noise with unit standard deviation (sum of uniforms)
+static float noise() {
+  float sum = 0;
+  for (int i = 0; i < 4; i++) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    sum += (noiseState >> 8) / 16777216.0f - 0.5f;
+  }
+  return sum * 1.732f;
+}
+
+/**
+ * Torso-mounted sensor: gravity on +Z when upright, tilted forward by
+ * pitch and sideways by roll, plus linear acceleration along Z
+ */
+static ImuData posture(float pitchDeg, float rollDeg, float extraG, float accelNoise, float gyroNoise) {
+  float p = pitchDeg * DEG, r = rollDeg * DEG;
+  float scale = G * (1.0f + extraG);
+  ImuData d;
+  d.accelX = scale * sinf(r) * cosf(p) + accelNoise * noise();
+  d.accelY = scale * sinf(p) + accelNoise * noise();
+  d.accelZ = scale * cosf(p) * cosf(r) + accelNoise * noise();
+  d.gyroX = gyroNoise * noise();
+  d.gyroY = gyroNoise * noise();
+  d.gyroZ = gyroNoise * noise();
+  return d;
+}
+
+static void addStill(ImuTrace& t, uint32_t& ms, uint32_t durationMs, float pitch, float roll, float accelNoise) {
+  for (uint32_t end = ms + durationMs; ms < end; ms += 10) {
+    t.rows.push_back({ms, posture(pitch, roll, 0, accelNoise, 0.5f), 0});
+  }
+}
+
+static void addWalk(ImuTrace& t, uint32_t& ms, uint32_t durationMs) {
+  for (uint32_t end = ms + durationMs; ms < end; ms += 10) {
+    float s = ms / 1000.0f;
+    float bounce = 0.18f * sinf(2 * (float)PI * 1.8f * s);
+    ImuData d = posture(5 * sinf(2 * (float)PI * 0.9f * s), 4 * sinf(2 * (float)PI * 0.9f * s + 1),
+                        bounce, 0.3f, 4);
+    d.gyroY += 25 * sinf(2 * (float)PI * 0.9f * s);
+    d.gyroZ += 15 * cosf(2 * (float)PI * 0.9f * s);
+    t.rows.push_back({ms, d, 0});
+  }
+}
+
+/**
+ * A fall: tumble to lying (drop lasting dropMs with near free-fall), then an
+ * impact spike. Pitch or roll ends at endAngle. Truth goes on the first
+ * sample of the drop, where the fall starts.
+ */
+static void addFall(ImuTrace& t, uint32_t& ms, bool sideways, float endAngle, int truth) {
+  const uint32_t dropMs = 400;
+  for (uint32_t i = 0; i < dropMs; i += 10, ms += 10) {
+    float f = (float)i / dropMs;
+    float angle = endAngle * f * f;
+    float rate = endAngle * 2 * f / (dropMs / 1000.0f);
+    ImuData d = posture(sideways ? 0 : angle, sideways ? angle : 0, -0.75f * sinf((float)PI * f), 0.2f, 3);
+    if (sideways) d.gyroY += rate; else d.gyroX += rate;
+    t.rows.push_back({ms, d, i == 0 ? truth : 0});
+  }
+  static const float impact[] = {2.4f, 1.9f, 0.8f, -0.3f, 0.4f, 0.1f};
+  for (size_t i = 0; i < sizeof(impact) / sizeof(impact[0]); i++, ms += 10) {
+    ImuData d = posture(sideways ? 0 : endAngle, sideways ? endAngle : 0, impact[i], 0.5f, 20);
+    t.rows.push_back({ms, d, 0});
+  }
+}
+
+static void addSitDown(ImuTrace& t, uint32_t& ms) {
+  const uint32_t durationMs = 1800;
+  for (uint32_t i = 0; i < durationMs; i += 10, ms += 10) {
+    float f = (float)i / durationMs;
+    float lean = 35 * sinf((float)PI * f);                         // Lean forward and back
+    float extra = -0.15f * sinf(2 * (float)PI * f);                // Sink, then brake
+    ImuData d = posture(lean, 0, extra, 0.1f, 2);
+    d.gyroX += 35 * (float)PI / (durationMs / 1000.0f) * cosf((float)PI * f);
+    t.rows.push_back({ms, d, 0});
+  }
+}
+
+static void addJump(ImuTrace& t, uint32_t& ms) {
+  for (int i = 0; i < 15; i++, ms += 10) t.rows.push_back({ms, posture(0, 0, 0.6f, 0.2f, 3), 0});   // Push off
+  for (int i = 0; i < 25; i++, ms += 10) t.rows.push_back({ms, posture(0, 0, -0.9f, 0.1f, 3), 0});  // Airborne
+  static const float landing[] = {1.6f, 1.2f, 0.5f, 0.2f};
+  for (float extra : landing) {
+    t.rows.push_back({ms, posture(0, 0, extra, 0.3f, 8), 0});
+    ms += 10;
+  }
+}
+
+static void addGetUp(ImuTrace& t, uint32_t& ms, bool sideways, float fromAngle) {
+  const uint32_t durationMs = 2500;
+  for (uint32_t i = 0; i < durationMs; i += 10, ms += 10) {
+    float f = (float)i / durationMs;
+    float angle = fromAngle * (1 - f);
+    ImuData d = posture(sideways ? 0 : angle, sideways ? angle : 0,
+                        0.25f * sinf(2 * (float)PI * 3 * f), 0.6f, 15);
+    if (sideways) d.gyroY -= fromAngle / (durationMs / 1000.0f); else d.gyroX -= fromAngle / (durationMs / 1000.0f);
+    t.rows.push_back({ms, d, 0});
+  }
+}
+
+static std::vector<ImuTrace> syntheticImuSuite() {
+  std::vector<ImuTrace> suite;
+  uint32_t ms;
+
+  ImuTrace standing{"standing", {}};
+  ms = 0;
+  addStill(standing, ms, 30000, 0, 0, 0.05f);
+  suite.push_back(standing);
+
+  ImuTrace walking{"walking", {}};
+  ms = 0;
+  addStill(walking, ms, 2000, 0, 0, 0.05f);
+  addWalk(walking, ms, 30000);
+  suite.push_back(walking);
+
+  ImuTrace sitDown{"sit_down", {}};
+  ms = 0;
+  addStill(sitDown, ms, 2000, 0, 0, 0.05f);
+  addSitDown(sitDown, ms);
+  addStill(sitDown, ms, 5000, 5, 0, 0.05f);
+  suite.push_back(sitDown);
+
+  ImuTrace jump{"jump", {}};
+  ms = 0;
+  addStill(jump, ms, 2000, 0, 0, 0.05f);
+  for (int i = 0; i < 3; i++) {
+    addJump(jump, ms);
+    addStill(jump, ms, 3000, 0, 0, 0.05f);
+  }
+  suite.push_back(jump);
+
+  ImuTrace fallStill{"fall_forward_still", {}};
+  ms = 0;
+  addStill(fallStill, ms, 3000, 0, 0, 0.05f);
+  addFall(fallStill, ms, false, 85, 2);
+  addStill(fallStill, ms, 15000, 85, 0, 0.02f);
+  suite.push_back(fallStill);
+
+  ImuTrace fallSide{"fall_side_gets_up", {}};
+  ms = 0;
+  addStill(fallSide, ms, 3000, 0, 0, 0.05f);
+  addFall(fallSide, ms, true, 80, 1);
+  addStill(fallSide, ms, 400, 80, 0, 0.02f);
+  addGetUp(fallSide, ms, true, 80);
+  addStill(fallSide, ms, 8000, 0, 0, 0.05f);
+  suite.push_back(fallSide);
+
+  return suite;
+}
+
+/**
+ * ECG at `bpm` with a little RR variability, baseline wander and noise
+ */
+static void addEcg(EcgTrace& t, uint32_t& ms, uint32_t durationMs, int bpm) {
+  uint32_t end = ms + durationMs;
+  uint32_t nextBeat = ms + 300;
+  float rr = 60000.0f / bpm;
+  while (ms < end) {
+    float s = ms / 1000.0f;
+    float v = 2048 + 80 * sinf(2 * (float)PI * 0.3f * s) + 12 * noise();
+
+    // Beat shape relative to the R peak (Gaussian bumps, ms offsets)
+    float dt = (float)ms - (float)nextBeat;
+    if (dt > rr / 2) {
+      float jitter = 0.04f * rr * noise();
+      nextBeat += (uint32_t)(rr + jitter);
+      dt = (float)ms - (float)nextBeat;
+    }
+    float prevDt = dt + rr;  // T wave of the previous beat
+    v += 60 * expf(-powf((dt + 160) / 25, 2));    // P
+    v -= 70 * expf(-powf((dt + 30) / 10, 2));     // Q
+    v += 650 * expf(-powf(dt / 12, 2));           // R
+    v -= 120 * expf(-powf((dt - 30) / 10, 2));    // S
+    v += 160 * expf(-powf((prevDt - 300) / 45, 2)) + 160 * expf(-powf((dt - 300) / 45, 2));  // T
+
+    bool peak = dt > -5 && dt <= 5;
+    t.rows.push_back({ms, (int)constrain(v, 0.0f, 4095.0f), false, peak});
+    ms += 10;
+  }
+}
+
+static std::vector<EcgTrace> syntheticEcgSuite() {
+  std::vector<EcgTrace> suite;
+  static const int rates[] = {50, 75, 110, 160};
+  for (int bpm : rates) {
+    EcgTrace t{"sinus_" + std::to_string(bpm) + "bpm", {}};
+    uint32_t ms = 0;
+    addEcg(t, ms, 60000, bpm);
+    suite.push_back(t);
+  }
+
+  EcgTrace gap{"leads_off_gap", {}};
+  uint32_t ms = 0;
+  addEcg(gap, ms, 20000, 70);
+  for (uint32_t end = ms + 3000; ms < end; ms += 10) gap.rows.push_back({ms, 0, true, false});
+  addEcg(gap, ms, 20000, 70);
+  suite.push_back(gap);
+  return suite;
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+struct Timing {
+  double meanNs;
+  double p99Ns;
+};
+
+struct ImuResult {
+  int falls;            // Truth impacts
+  int hits;
+  int falseAlarms;
+  int dangerousExpected;
+  int dangerousCorrect;
+  double latencySumMs;
+  double dangerousLatencySumMs;
+  int dangerousLatencyCount;
+  Timing timing;
+};
+
+struct EcgResult {
+  int beats;            // Scored annotations
+  int hits;
+  int reported;         // Scored reported beats
+  double latencySumMs;
+  double bpmErrorSum;
+  int bpmSamples;
+  Timing timing;
+};
+
+/**
+ * Keep one row per 1000/rateHz ms, as the MPU6050 FIFO delivers at a lower
+ * SMPLRT_DIV rate. A truth mark on a dropped row moves to the next kept row.
+ */
+static ImuTrace decimate(const ImuTrace& trace, uint16_t rateHz) {
+  ImuTrace out;
+  out.name = trace.name;
+  if (trace.rows.empty()) return out;
+  uint32_t periodMs = 1000 / rateHz;
+  uint32_t next = trace.rows.front().timeMs;
+  int truth = 0;
+  for (const ImuRow& row : trace.rows) {
+    if (row.truth != 0) truth = row.truth;
+    if (row.timeMs < next) continue;
+    out.rows.push_back(row);
+    out.rows.back().truth = truth;
+    truth = 0;
+    next += periodMs;
+  }
+  return out;
+}
+
+static void calibrateFrom(FallDetector& detector, const ImuTrace& trace) {
+  const ImuData& d = trace.rows.front().data;
+  detector.calibrate(atan2(d.accelY, d.accelZ) * 180.0f / PI, atan2(d.accelX, d.accelZ) * 180.0f / PI);
+}
+
+/**
+ * Mean cost from `repeat` untimed-inside passes, p99 from one pass that
+ * times every sample. pass(perSample) returns the pass duration in ns and
+ * appends per-sample durations to perSample when it is not null.
+ */
+template <typename Fn>
+static Timing timePasses(size_t samples, int repeat, Fn pass) {
+  Timing t = {0, 0};
+  if (samples == 0 || repeat <= 0) return t;
+  double total = 0;
+  for (int r = 0; r < repeat; r++) total += pass(nullptr);
+  t.meanNs = total / ((double)samples * repeat);
+
+  std::vector<double> perSample;
+  perSample.reserve(samples);
+  pass(&perSample);
+  size_t k = perSample.size() * 99 / 100;
+  std::nth_element(perSample.begin(), perSample.begin() + k, perSample.end());
+  t.p99Ns = perSample[k];
+  return t;
+}
+
+static double elapsedNs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * Run a trace through the fall detector the way imuTask does: integer
+ * kernel over each FIFO batch, then update() per sample (or detectFall()
+ * per sample on the float reference path). onSample(i, state) sees each
+ * sample's resulting state; timing pushes per-sample ns when not null.
+ */
+template <typename Fn>
+static void runImu(FallDetector& detector, const std::vector<ImuSample>& samples, bool floatPath,
+                   std::vector<double>* perSample, Fn onSample) {
+  FallMath::MotionSquares squares[IMU_BATCH];
+  for (size_t base = 0; base < samples.size(); base += IMU_BATCH) {
+    int n = (int)std::min(samples.size() - base, (size_t)IMU_BATCH);
+    auto t0 = std::chrono::steady_clock::now();
+    if (!floatPath) FallMath::motionSquares(&samples[base], n, squares);
+    for (int i = 0; i < n; i++) {
+      const ImuSample& s = samples[base + i];
+      hostClock() = s.timestamp_us;
+      FallDetector::FallState state = floatPath
+          ? detector.detectFall(s.data, s.timestamp_us).state
+          : detector.update(s.data, squares[i], s.timestamp_us);
+      onSample(base + i, state);
+    }
+    if (perSample != nullptr) {
+      double ns = elapsedNs(t0) / n;  // Batch cost shared by its samples
+      for (int i = 0; i < n; i++) perSample->push_back(ns);
+    }
+  }
+}
+
+static ImuResult replayImu(const ImuTrace& trace, int repeat, bool floatPath, uint16_t rateHz) {
+  ImuResult res = {};
+  if (trace.rows.empty()) return res;
+
+  std::vector<ImuSample> samples;
+  samples.reserve(trace.rows.size());
+  for (const ImuRow& row : trace.rows) samples.push_back(toSample(row.data, row.timeMs));
+
+  // Scoring pass
+  FallDetector detector;
+  detector.setSampleRate(rateHz);
+  calibrateFrom(detector, trace);
+  FallDetector::FallState prev = FallDetector::NORMAL;
+  std::vector<uint32_t> fallEntries, dangerousEntries;
+  runImu(detector, samples, floatPath, nullptr, [&](size_t i, FallDetector::FallState state) {
+    if (state != prev) {
+      uint32_t timeMs = trace.rows[i].timeMs;
+      if (state == FallDetector::FALL_DETECTED) fallEntries.push_back(timeMs);
+      if (state == FallDetector::DANGEROUS) dangerousEntries.push_back(timeMs);
+      prev = state;
+    }
+  });
+
+  std::vector<bool> matched(fallEntries.size(), false);
+  for (const ImuRow& row : trace.rows) {
+    if (row.truth == 0) continue;
+    res.falls++;
+    for (size_t i = 0; i < fallEntries.size(); i++) {
+      if (!matched[i] && fallEntries[i] >= row.timeMs && fallEntries[i] - row.timeMs <= FALL_MATCH_MS) {
+        matched[i] = true;
+        res.hits++;
+        res.latencySumMs += fallEntries[i] - row.timeMs;
+        break;
+      }
+    }
+
+    bool dangerous = false;
+    for (uint32_t t : dangerousEntries) {
+      if (t >= row.timeMs && t - row.timeMs <= DANGEROUS_MATCH_MS) {
+        dangerous = true;
+        if (row.truth == 2) {
+          res.dangerousLatencySumMs += t - row.timeMs;
+          res.dangerousLatencyCount++;
+        }
+        break;
+      }
+    }
+    if (row.truth == 2) res.dangerousExpected++;
+    if ((row.truth == 2) == dangerous) res.dangerousCorrect++;
+  }
+  for (bool m : matched) {
+    if (!m) res.falseAlarms++;
+  }
+
+  // Timing passes
+  res.timing = timePasses(trace.rows.size(), repeat, [&](std::vector<double>* perSample) {
+    FallDetector timed;
+    timed.setSampleRate(rateHz);
+    calibrateFrom(timed, trace);
+    auto start = std::chrono::steady_clock::now();
+    runImu(timed, samples, floatPath, perSample, [](size_t, FallDetector::FallState) {});
+    return elapsedNs(start);
+  });
+  return res;
+}
+
+static EcgResult replayEcg(const EcgTrace& trace, int repeat) {
+  EcgResult res = {};
+  if (trace.rows.empty()) return res;
+
+  AD8232 monitor(PIN_ECG, PIN_LO_PLUS, PIN_LO_MINUS);
+  std::vector<uint32_t> reported;  // R peak times
+  std::vector<uint32_t> reportDelay;
+  unsigned long lastBeat = 0;
+  uint32_t trainingEnd = trace.rows.front().timeMs + ECG_TRAINING_MS;
+  uint32_t nextBpmCheck = trainingEnd;
+  float truthRR = 0;
+  uint32_t lastTruth = 0;
+  std::vector<uint32_t> truth;
+
+  for (const EcgRow& row : trace.rows) {
+    hostClock() = (int64_t)row.timeMs * 1000;
+    hostPin(PIN_ECG) = row.value;
+    hostPin(PIN_LO_PLUS) = row.leadsOff;
+    hostPin(PIN_LO_MINUS) = 0;
+    monitor.processSample(row.value, row.leadsOff, row.timeMs);
+
+    if (row.leadsOff) {
+      trainingEnd = row.timeMs + ECG_TRAINING_MS;
+      nextBpmCheck = trainingEnd;
+      lastBeat = 0;
+      continue;
+    }
+    if (row.rPeak) {
+      if (lastTruth > 0) truthRR = row.timeMs - lastTruth;
+      lastTruth = row.timeMs;
+      if (row.timeMs >= trainingEnd) truth.push_back(row.timeMs);
+    }
+
+    unsigned long beat = monitor.getLastBeatTime();
+    if (beat != 0 && beat != lastBeat) {
+      lastBeat = beat;
+      if (beat >= trainingEnd) {
+        reported.push_back(beat);
+        reportDelay.push_back(row.timeMs - beat);
+      }
+    }
+
+    // Heart rate error once a second against the annotated RR
+    if (row.timeMs >= nextBpmCheck && truthRR > 0) {
+      nextBpmCheck = row.timeMs + 1000;
+      int bpm = monitor.getBPM();
+      if (bpm > 0) {
+        res.bpmErrorSum += std::abs(bpm - 60000.0f / truthRR);
+        res.bpmSamples++;
+      }
+    }
+  }
+
+  res.beats = truth.size();
+  res.reported = reported.size();
+  std::vector<bool> used(reported.size(), false);
+  for (uint32_t t : truth) {
+    for (size_t i = 0; i < reported.size(); i++) {
+      uint32_t diff = reported[i] > t ? reported[i] - t : t - reported[i];
+      if (!used[i] && diff <= BEAT_MATCH_MS) {
+        used[i] = true;
+        res.hits++;
+        res.latencySumMs += reportDelay[i] + ((double)reported[i] - t);
+        break;
+      }
+    }
+  }
+
+  res.timing = timePasses(trace.rows.size(), repeat, [&](std::vector<double>* perSample) {
+    AD8232 timed(PIN_ECG, PIN_LO_PLUS, PIN_LO_MINUS);
+    auto start = std::chrono::steady_clock::now();
+    for (const EcgRow& row : trace.rows) {
+      if (perSample == nullptr) {
+        timed.processSample(row.value, row.leadsOff, row.timeMs);
+        continue;
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      timed.processSample(row.value, row.leadsOff, row.timeMs);
+      perSample->push_back(elapsedNs(t0));
+    }
+    return elapsedNs(start);
+  });
+  return res;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+static double ratio(double num, double den) {
+  return den > 0 ? num / den : 0;
+}
+
+int main(int argc, char** argv) {
+  std::vector<ImuTrace> imuTraces;
+  std::vector<EcgTrace> ecgTraces;
+  int repeat = 20;
+  bool csv = false;
+  bool verbose = false;
+  bool floatPath = false;
+  int rateHz = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if ((arg == "--imu" || arg == "--ecg" || arg == "--repeat" || arg == "--rate") && i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", arg.c_str());
+      return 2;
+    }
+    if (arg == "--imu") {
+      ImuTrace t;
+      if (!loadImuTrace(argv[++i], t)) { fprintf(stderr, "Cannot read %s\n", argv[i]); return 2; }
+      imuTraces.push_back(t);
+    } else if (arg == "--ecg") {
+      EcgTrace t;
+      if (!loadEcgTrace(argv[++i], t)) { fprintf(stderr, "Cannot read %s\n", argv[i]); return 2; }
+      ecgTraces.push_back(t);
+    } else if (arg == "--repeat") {
+      repeat = atoi(argv[++i]);
+    } else if (arg == "--rate") {
+      rateHz = atoi(argv[++i]);
+      if (rateHz < 1 || rateHz > FallDetector::REFERENCE_RATE_HZ) {
+        fprintf(stderr, "--rate must be 1..%d\n", FallDetector::REFERENCE_RATE_HZ);
+        return 2;
+      }
+    } else if (arg == "--csv") {
+      csv = true;
+    } else if (arg == "--float") {
+      floatPath = true;
+    } else if (arg == "-v") {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--imu FILE]... [--ecg FILE]... [--repeat N] [--rate HZ] [--csv] [--float] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (imuTraces.empty() && ecgTraces.empty()) {
+    imuTraces = syntheticImuSuite();
+    ecgTraces = syntheticEcgSuite();
+  }
+  if (rateHz != 0) {
+    for (ImuTrace& t : imuTraces) t = decimate(t, (uint16_t)rateHz);
+  } else {
+    rateHz = FallDetector::REFERENCE_RATE_HZ;
+  }
+
+  static HostConsole console;
+  static NullConsole quiet;
+  if (verbose) {
+    Log.begin(console, 0, 0, 0);
+  } else {
+    Log.begin(quiet, 0, 0, 0);
+    Log.setLevelAll(LOG_LEVEL_NONE);  // Skip the formatting cost as well
+  }
+
+  if (!imuTraces.empty()) {
+    if (!csv) {
+      printf("\nFALL DETECTOR (%s path, %d Hz)\n", floatPath ? "float" : "fixed-point batch", rateHz);
+      printf("  %-22s %8s %9s %9s  %5s %5s %5s %12s %12s\n", "trace", "samples", "ns/samp", "p99 ns",
+             "falls", "hits", "false", "fall ms", "danger ms");
+    }
+    ImuResult total = {};
+    for (const ImuTrace& t : imuTraces) {
+      ImuResult r = replayImu(t, repeat, floatPath, (uint16_t)rateHz);
+      if (csv) {
+        printf("imu,%s,%zu,%.1f,%.0f,%d,%d,%d,%d,%d,%.0f,%.0f\n", t.name.c_str(), t.rows.size(),
+               r.timing.meanNs, r.timing.p99Ns, r.falls, r.hits, r.falseAlarms, r.dangerousExpected,
+               r.dangerousCorrect, ratio(r.latencySumMs, r.hits),
+               ratio(r.dangerousLatencySumMs, r.dangerousLatencyCount));
+      } else {
+        printf("  %-22s %8zu %9.1f %9.0f  %5d %5d %5d %12.0f %12.0f\n", t.name.c_str(), t.rows.size(),
+               r.timing.meanNs, r.timing.p99Ns, r.falls, r.hits, r.falseAlarms,
+               ratio(r.latencySumMs, r.hits), ratio(r.dangerousLatencySumMs, r.dangerousLatencyCount));
+      }
+      total.falls += r.falls;
+      total.hits += r.hits;
+      total.falseAlarms += r.falseAlarms;
+      total.dangerousExpected += r.dangerousExpected;
+      total.dangerousCorrect += r.dangerousCorrect;
+      total.latencySumMs += r.latencySumMs;
+      total.dangerousLatencySumMs += r.dangerousLatencySumMs;
+      total.dangerousLatencyCount += r.dangerousLatencyCount;
+    }
+    if (!csv) {
+      printf("  falls detected %d/%d (%.0f%%), false alarms %d, DANGEROUS correct %d/%d, "
+             "mean latency %.0f ms (fall) / %.0f ms (dangerous)\n",
+             total.hits, total.falls, 100 * ratio(total.hits, total.falls), total.falseAlarms,
+             total.dangerousCorrect, total.falls, ratio(total.latencySumMs, total.hits),
+             ratio(total.dangerousLatencySumMs, total.dangerousLatencyCount));
+    }
+    if (total.hits > 0 && total.latencySumMs <= 0) {
+      fprintf(stderr, "Mean fall latency is 0 ms - truth must mark the fall onset, not the detection\n");
+      return 1;
+    }
+  }
+
+  if (!ecgTraces.empty()) {
+    if (!csv) {
+      printf("\nECG (AD8232 + QrsDetector)\n");
+      printf("  %-22s %8s %9s %9s  %6s %6s %6s %7s %9s\n", "trace", "samples", "ns/samp", "p99 ns",
+             "beats", "sens%", "ppv%", "lat ms", "bpm err");
+    }
+    EcgResult total = {};
+    for (const EcgTrace& t : ecgTraces) {
+      EcgResult r = replayEcg(t, repeat);
+      double sens = 100 * ratio(r.hits, r.beats);
+      double ppv = 100 * ratio(r.hits, r.reported);
+      if (csv) {
+        printf("ecg,%s,%zu,%.1f,%.0f,%d,%.1f,%.1f,%.0f,%.2f\n", t.name.c_str(), t.rows.size(),
+               r.timing.meanNs, r.timing.p99Ns, r.beats, sens, ppv, ratio(r.latencySumMs, r.hits),
+               ratio(r.bpmErrorSum, r.bpmSamples));
+      } else {
+        printf("  %-22s %8zu %9.1f %9.0f  %6d %6.1f %6.1f %7.0f %9.2f\n", t.name.c_str(), t.rows.size(),
+               r.timing.meanNs, r.timing.p99Ns, r.beats, sens, ppv, ratio(r.latencySumMs, r.hits),
+               ratio(r.bpmErrorSum, r.bpmSamples));
+      }
+      total.beats += r.beats;
+      total.hits += r.hits;
+      total.reported += r.reported;
+    }
+    if (!csv) {
+      printf("  beats: sensitivity %.1f%%, PPV %.1f%% (%d annotated, %d reported)\n",
+             100 * ratio(total.hits, total.beats), 100 * ratio(total.hits, total.reported),
+             total.beats, total.reported);
+    }
+  }
+  return 0;
+}
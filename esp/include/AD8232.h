@@ -0,0 +1,608 @@
+#ifndef AD8232_H
+#define AD8232_H
+
+#include <Arduino.h>
+#include "QrsDetector.h"
+#include "WindowedStats.h"
+#include "Log.h"
+
+/**
+ * AD8232 - ECG/Heart Rate Monitoring
+ * 
+ * This class provides ECG signal processing and heart rate detection
+ * for monitoring cardiac activity and detecting abnormalities.
+ * 
+ * Beats come from a streaming Pan-Tompkins detector (QrsDetector). Each
+ * beat updates the heart rate and HRV statistics, and once the T-wave
+ * search window has been sampled the beat is delineated (P, Q, R, S, T)
+ * on the raw signal for getPQRSTData().
+ */
+class AD8232 {
+private:
+  uint8_t ecg_pin;
+  uint8_t lo_plus_pin;
+  uint8_t lo_minus_pin;
+  
+  // ECG data buffers
+  static const int BUFFER_SIZE = 200;  // 2 seconds at 100Hz
+  WindowedStats<int, BUFFER_SIZE, int64_t> ecgHistory;  // Also tracks sum/min/max for the threshold
+  
+  // Compressed ECG buffer for LoRaWAN transmission
+  static const int COMPRESSED_SIZE = 50;  // Compressed samples
+  uint8_t compressedECG[COMPRESSED_SIZE];
+  int compressedIndex;
+  
+  // Downsampling (100Hz -> 25Hz, keep every 4th sample)
+  int downsampleCounter;
+  int lastCompressedValue;        // Reconstructed value the decoder will hold
+  
+  // High-fidelity ECG window (100Hz -> 50Hz, pairs averaged) for the 0x05 codec
+  static const int ECG_WINDOW_SIZE = 93;  // 1.86 seconds
+  uint16_t ecgWindow[ECG_WINDOW_SIZE];
+  int ecgWindowIndex;
+  int ecgPairSum;
+  bool ecgPairHalf;
+  
+  // PQRST wave detection buffer
+  struct PQRSTWave {
+    uint16_t timestamp;     // Relative timestamp (ms)
+    int16_t p_amp;          // P wave amplitude
+    int16_t q_amp;          // Q wave amplitude  
+    int16_t r_amp;          // R wave amplitude
+    int16_t s_amp;          // S wave amplitude
+    int16_t t_amp;          // T wave amplitude
+    uint8_t qrs_width;      // QRS duration (ms)
+    uint8_t qt_interval;    // QT interval (ms)
+  } lastPQRST;
+  
+  bool pqrstValid;
+  
+  // Heart rate detection
+  static const int SAMPLE_PERIOD_MS = 1000 / QrsDetector::SAMPLE_RATE_HZ;
+  QrsDetector qrsDetector;
+  bool detectorStale;             // Signal gap (leads off) - retrain before use
+  unsigned long lastSampleTime;   // Timestamp of the last processed sample
+  unsigned long lastBeatTime;
+  unsigned long beatInterval;
+  int baselineValue;
+  
+  // Beat awaiting delineation (T wave not sampled yet)
+  bool beatPending;
+  uint32_t pendingBeatIndex;
+  
+  // Delineation search windows (samples, 10 ms each)
+  static const int R_REFINE = 3;        // R peak correction around the detector's estimate
+  static const int QS_SEARCH = 8;       // Q before / S after R
+  static const int P_SEARCH_MIN = 5;    // P wave 50-250 ms before Q
+  static const int P_SEARCH_MAX = 25;
+  static const int T_SEARCH_MIN = 10;   // T wave 100-400 ms after S
+  static const int T_SEARCH_MAX = 40;
+  static const int DELINEATION_LAG = R_REFINE + QS_SEARCH + T_SEARCH_MAX;
+  
+  // HRV (valid RR intervals only)
+  static const int RR_HISTORY = 32;
+  WindowedStats<int, RR_HISTORY, int64_t> rrHistory;          // SDNN
+  WindowedStats<int, RR_HISTORY - 1, int64_t> rrDiffSquared;  // RMSSD
+  int lastRR;                     // Previous valid RR (0 after an artifact)
+  
+  // ECG Features
+  struct ECGFeatures {
+    int rPeakAmplitude;      // R-wave amplitude
+    int qrsWidth;            // QRS complex width (ms)
+    int rrInterval;          // RR interval (ms)
+    int sdnn;                // RR standard deviation over the last 32 beats (ms)
+    int rmssd;               // RMS of successive RR differences (ms)
+    bool validBeat;
+  } lastFeatures;
+  
+  /**
+   * Raw sample by age (0 = newest) from the 2 second history
+   */
+  int sampleAtAge(int age) const {
+    int slot = ((int)ecgHistory.nextSlot() - 1 - age) % BUFFER_SIZE;
+    return ecgHistory.slot(slot < 0 ? slot + BUFFER_SIZE : slot);
+  }
+  
+  /**
+   * Samples since the pending beat's R peak
+   */
+  int beatAge() const {
+    return (int)(qrsDetector.sampleCount() - 1 - pendingBeatIndex);
+  }
+  
+  /**
+   * Update heart rate and HRV from a detected beat
+   */
+  void onBeat(const QrsDetector::Beat& beat) {
+    beatPending = true;
+    pendingBeatIndex = beat.index;
+    lastBeatTime = lastSampleTime - (unsigned long)beatAge() * SAMPLE_PERIOD_MS;
+    
+    if (beat.rrSamples == 0) return;
+    
+    int rr = beat.rrSamples * SAMPLE_PERIOD_MS;
+    int bpm = 60000 / rr;
+    
+    // Valid range check (out-of-range intervals are artifacts or missed beats)
+    if (bpm < BPM_MIN_VALID || bpm > BPM_MAX_VALID) {
+      lastRR = 0;
+      return;
+    }
+    
+    beatInterval = rr;
+    currentBPM = bpm;
+    lastFeatures.validBeat = true;
+    lastFeatures.rrInterval = rr;
+    
+    if (lastRR > 0) {
+      int diff = rr - lastRR;
+      rrDiffSquared.push(diff * diff);
+    }
+    rrHistory.push(rr);
+    lastRR = rr;
+    
+    lastFeatures.sdnn = rrHistory.size() >= 2 ? (int)sqrt((double)rrHistory.variance()) : 0;
+    lastFeatures.rmssd = rrDiffSquared.size() >= 1 ? (int)sqrt((double)rrDiffSquared.mean()) : 0;
+  }
+  
+public:
+  // ADC scale (analogReadResolution) - EcgCodec and the 0x02 / 0x05 payloads assume 12 bits
+  static const int ADC_BITS = 12;
+  static const int ADC_MAX = (1 << ADC_BITS) - 1;
+  static const int ADC_MIDPOINT = 1 << (ADC_BITS - 1);
+  
+  // Heart rate thresholds
+  int BPM_MIN_NORMAL = 50;      // Minimum normal heart rate
+  int BPM_MAX_NORMAL = 120;     // Maximum normal heart rate
+  int BPM_MIN_VALID = 40;       // Minimum valid detection
+  int BPM_MAX_VALID = 200;      // Maximum valid detection
+  
+  int currentBPM;
+  bool leadsOff;
+  
+  /**
+   * Constructor
+   * @param ecg ADC pin for ECG signal
+   * @param lo_plus Lead-off detection pin (LO+)
+   * @param lo_minus Lead-off detection pin (LO-)
+   */
+  AD8232(uint8_t ecg, uint8_t lo_plus, uint8_t lo_minus) {
+    ecg_pin = ecg;
+    lo_plus_pin = lo_plus;
+    lo_minus_pin = lo_minus;
+    
+    detectorStale = false;
+    lastSampleTime = 0;
+    lastBeatTime = 0;
+    beatInterval = 0;
+    baselineValue = ADC_MIDPOINT;
+    beatPending = false;
+    pendingBeatIndex = 0;
+    lastRR = 0;
+    currentBPM = 0;
+    leadsOff = true;
+    
+    lastFeatures.validBeat = false;
+    lastFeatures.rPeakAmplitude = 0;
+    lastFeatures.qrsWidth = 0;
+    lastFeatures.rrInterval = 0;
+    lastFeatures.sdnn = 0;
+    lastFeatures.rmssd = 0;
+    
+    // Initialize buffer
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+      ecgHistory.push(ADC_MIDPOINT);
+    }
+    
+    // Initialize compression buffers
+    compressedIndex = 0;
+    downsampleCounter = 0;
+    lastCompressedValue = ADC_MIDPOINT;
+    pqrstValid = false;
+    
+    for (int i = 0; i < COMPRESSED_SIZE; i++) {
+      compressedECG[i] = 0;
+    }
+    
+    ecgWindowIndex = 0;
+    ecgPairSum = 0;
+    ecgPairHalf = false;
+    for (int i = 0; i < ECG_WINDOW_SIZE; i++) {
+      ecgWindow[i] = ADC_MIDPOINT;
+    }
+    
+    memset(&lastPQRST, 0, sizeof(PQRSTWave));
+  }
+  
+  /**
+   * Initialize the ECG monitor
+   */
+  void begin() {
+    pinMode(lo_plus_pin, INPUT);
+    pinMode(lo_minus_pin, INPUT);
+    analogReadResolution(ADC_BITS);  // 12-bit ADC (0-4095)
+    analogSetAttenuation(ADC_11db);
+    
+    Log.println("AD8232 ECG monitor initialized");
+    Log.println("Sample rate: 100 Hz");
+  }
+  
+  /**
+   * Check if ECG leads are properly connected
+   * @return true if leads are off, false if connected
+   */
+  bool checkLeadsOff() {
+    bool loPlus = digitalRead(lo_plus_pin);
+    bool loMinus = digitalRead(lo_minus_pin);
+    leadsOff = (loPlus == HIGH || loMinus == HIGH);
+    
+    if (leadsOff) {
+      currentBPM = 0;
+      lastBeatTime = 0;
+      detectorStale = true;
+    }
+    
+    return leadsOff;
+  }
+  
+  /**
+   * Read and process ECG signal
+   * Samples the ADC directly; prefer processSample() fed by EcgAcquisition
+   * so the sample rate does not depend on the caller's timing.
+   * @return Current ECG ADC value
+   */
+  int readECG() {
+    bool loPlus = digitalRead(lo_plus_pin);
+    bool loMinus = digitalRead(lo_minus_pin);
+    bool off = (loPlus == HIGH || loMinus == HIGH);
+    
+    return processSample(off ? 0 : analogRead(ecg_pin), off, millis());
+  }
+  
+  /**
+   * Process one ECG sample taken at a known time
+   * Detects R-peaks and calculates heart rate
+   * @param ecgValue Raw 12-bit ADC value
+   * @param leadsOffNow Lead-off state when the sample was taken
+   * @param sampleTime Sample timestamp (ms)
+   * @return ECG ADC value (0 if leads are off)
+   */
+  int processSample(int ecgValue, bool leadsOffNow, unsigned long sampleTime) {
+    leadsOff = leadsOffNow;
+    if (leadsOff) {
+      currentBPM = 0;
+      lastBeatTime = 0;
+      detectorStale = true;
+      return 0;
+    }
+    
+    // Retrain after a gap so the filters do not see a step
+    if (detectorStale) {
+      qrsDetector.reset();
+      beatPending = false;
+      lastRR = 0;
+      detectorStale = false;
+    }
+    
+    lastSampleTime = sampleTime;
+    
+    // Update data buffer
+    ecgHistory.push(ecgValue);
+    baselineValue = (int)(ecgHistory.sum() / BUFFER_SIZE);
+    
+    // Streaming QRS detection
+    QrsDetector::Beat beat;
+    if (qrsDetector.process(ecgValue, beat)) {
+      // A beat closer than the delineation lag cuts the previous T window short
+      if (beatPending) extractPQRSTFeatures();
+      onBeat(beat);
+    }
+    
+    // Delineate once the T-wave search window has been sampled
+    if (beatPending && beatAge() >= DELINEATION_LAG) {
+      extractPQRSTFeatures();
+    }
+    
+    // Reset BPM if no beat for 3 seconds
+    if (sampleTime - lastBeatTime > 3000) {
+      currentBPM = 0;
+    }
+    
+    // === ECG Data Compression (Downsampling 100Hz -> 25Hz) ===
+    downsampleCounter++;
+    if (downsampleCounter >= 4) {  // Keep every 4th sample
+      downsampleCounter = 0;
+      
+      // Differential encoding: store difference from previous value
+      int diff = ecgValue - lastCompressedValue;
+      
+      // Compress 12-bit to 8-bit with clipping
+      // Scale difference to fit in -128 to +127 range
+      diff = constrain(diff / 4, -128, 127);
+      
+      // Store compressed sample
+      compressedECG[compressedIndex] = (uint8_t)(diff + 128);  // Offset to 0-255
+      compressedIndex = (compressedIndex + 1) % COMPRESSED_SIZE;
+      
+      // Track what the decoder reconstructs so clipping error does not accumulate
+      lastCompressedValue = constrain(lastCompressedValue + diff * 4, 0, ADC_MAX);
+    }
+    
+    // === High-fidelity window (Downsampling 100Hz -> 50Hz, pairs averaged) ===
+    ecgPairSum += ecgValue;
+    if (ecgPairHalf) {
+      ecgWindow[ecgWindowIndex] = (uint16_t)(ecgPairSum / 2);
+      ecgWindowIndex = (ecgWindowIndex + 1) % ECG_WINDOW_SIZE;
+      ecgPairSum = 0;
+    }
+    ecgPairHalf = !ecgPairHalf;
+    
+    return ecgValue;
+  }
+  
+  /**
+   * Get current heart rate in BPM
+   * @return BPM (0 if no valid reading)
+   */
+  int getBPM() {
+    return currentBPM;
+  }
+
+  /**
+   * Time of the most recent R peak (sampleTime base, 0 if none)
+   */
+  unsigned long getLastBeatTime() const {
+    return lastBeatTime;
+  }
+
+  /**
+   * Get last detected ECG features
+   */
+  ECGFeatures getFeatures() {
+    return lastFeatures;
+  }
+  
+  /**
+   * Check if heart rate is abnormal
+   * @return 0=Normal, 1=Bradycardia (slow), 2=Tachycardia (fast), 3=No signal
+   */
+  uint8_t checkHeartRate() {
+    if (leadsOff) return 3;
+    if (currentBPM == 0) return 3;
+    if (currentBPM < BPM_MIN_NORMAL) return 1;  // Too slow
+    if (currentBPM > BPM_MAX_NORMAL) return 2;  // Too fast
+    return 0;  // Normal
+  }
+  
+  /**
+   * Print ECG status and heart rate
+   */
+  void printStatus() {
+    if (leadsOff) {
+      Log.println("ECG: Leads Off - Check connections");
+      return;
+    }
+    
+    Log.print("Heart Rate: ");
+    if (currentBPM > 0) {
+      Log.print(currentBPM);
+      Log.print(" BPM");
+      
+      uint8_t status = checkHeartRate();
+      switch(status) {
+        case 0:
+          Log.println(" - Normal");
+          break;
+        case 1:
+          Log.println(" - ⚠️  BRADYCARDIA (Too Slow!)");
+          break;
+        case 2:
+          Log.println(" - ⚠️  TACHYCARDIA (Too Fast!)");
+          break;
+      }
+      
+      if (lastFeatures.validBeat) {
+        Log.print("  RR Interval: ");
+        Log.print(lastFeatures.rrInterval);
+        Log.print(" ms  |  R-Peak: ");
+        Log.print(lastFeatures.rPeakAmplitude);
+        Log.println(" ADC units");
+      }
+    } else {
+      Log.println("-- BPM (Waiting for signal...)");
+    }
+  }
+  
+  /**
+   * Print detailed heart beat information
+   */
+  void printBeatDetails() {
+    if (!lastFeatures.validBeat || currentBPM == 0) return;
+    
+    Log.println("\n=== Heart Beat Detected ===");
+    Log.print("BPM: "); Log.println(currentBPM);
+    Log.print("RR Interval: "); Log.print(lastFeatures.rrInterval); Log.println(" ms");
+    Log.print("R Peak Amplitude: "); Log.print(lastFeatures.rPeakAmplitude); Log.println(" ADC units");
+    Log.print("QRS Width: "); Log.print(lastFeatures.qrsWidth); Log.println(" ms");
+    Log.print("HRV SDNN: "); Log.print(lastFeatures.sdnn);
+    Log.print(" ms  |  RMSSD: "); Log.print(lastFeatures.rmssd); Log.println(" ms");
+    Log.print("Baseline: "); Log.println(baselineValue);
+    Log.println("==========================\n");
+  }
+  
+  /**
+   * Delineate the pending beat (P, Q, R, S, T) on the raw signal
+   * Called by processSample() once per beat, normally when the T-wave search
+   * window has been sampled (earlier if the next beat arrives first).
+   */
+  void extractPQRSTFeatures() {
+    if (!beatPending) return;
+    beatPending = false;
+    
+    int rAge = beatAge();
+    if (rAge + QS_SEARCH + P_SEARCH_MAX + R_REFINE >= BUFFER_SIZE) {
+      return;  // Beat already left the history
+    }
+    
+    // Refine the R peak on the raw signal (detector estimate is band-passed)
+    int rValue = sampleAtAge(rAge);
+    for (int k = -R_REFINE; k <= R_REFINE; k++) {
+      int age = rAge + k;
+      if (age < 0) continue;
+      if (sampleAtAge(age) > rValue) {
+        rValue = sampleAtAge(age);
+        rAge = age;
+      }
+    }
+    
+    // Q wave: minimum before R
+    int qAge = rAge;
+    int qValue = rValue;
+    for (int i = 1; i <= QS_SEARCH; i++) {
+      int v = sampleAtAge(rAge + i);
+      if (v < qValue) {
+        qValue = v;
+        qAge = rAge + i;
+      }
+    }
+    
+    // S wave: minimum after R
+    int sAge = rAge;
+    int sValue = rValue;
+    for (int i = 1; i <= QS_SEARCH && rAge - i >= 0; i++) {
+      int v = sampleAtAge(rAge - i);
+      if (v < sValue) {
+        sValue = v;
+        sAge = rAge - i;
+      }
+    }
+    
+    // P wave: largest deflection below R, 50-250 ms before Q
+    int pValue = baselineValue;
+    for (int i = P_SEARCH_MIN; i <= P_SEARCH_MAX; i++) {
+      int v = sampleAtAge(qAge + i);
+      if (v > pValue && v < rValue) pValue = v;
+    }
+    
+    // T wave: largest deflection below R, 100-400 ms after S
+    int tAge = sAge;
+    int tValue = baselineValue;
+    for (int i = T_SEARCH_MIN; i <= T_SEARCH_MAX && sAge - i >= 0; i++) {
+      int v = sampleAtAge(sAge - i);
+      if (v > tValue && v < rValue) {
+        tValue = v;
+        tAge = sAge - i;
+      }
+    }
+    
+    // Intervals (ages count back in time, 10 ms per sample)
+    int qrsWidth = (qAge - sAge) * SAMPLE_PERIOD_MS;
+    int qtInterval = (qAge - tAge) * SAMPLE_PERIOD_MS;
+    
+    lastFeatures.rPeakAmplitude = rValue - baselineValue;
+    lastFeatures.qrsWidth = qrsWidth;
+    
+    // Store PQRST features (relative to baseline)
+    unsigned long rTime = lastSampleTime - (unsigned long)rAge * SAMPLE_PERIOD_MS;
+    lastPQRST.timestamp = rTime & 0xFFFF;  // 16-bit timestamp
+    lastPQRST.p_amp = pValue - baselineValue;
+    lastPQRST.q_amp = qValue - baselineValue;
+    lastPQRST.r_amp = rValue - baselineValue;
+    lastPQRST.s_amp = sValue - baselineValue;
+    lastPQRST.t_amp = tValue - baselineValue;
+    lastPQRST.qrs_width = constrain(qrsWidth, 0, 255);
+    lastPQRST.qt_interval = constrain(qtInterval, 0, 255);
+    
+    pqrstValid = true;
+  }
+  
+  /**
+   * Get compressed ECG data for LoRaWAN transmission
+   * Returns number of bytes written to output buffer
+   * 
+   * @param output Output buffer (must be at least COMPRESSED_SIZE bytes)
+   * @param maxSize Maximum size of output buffer
+   * @return Number of bytes written
+   */
+  int getCompressedECG(uint8_t* output, int maxSize) {
+    int size = min(COMPRESSED_SIZE, maxSize);
+    
+    // Copy compressed ECG data
+    for (int i = 0; i < size; i++) {
+      int idx = (compressedIndex + i) % COMPRESSED_SIZE;
+      output[i] = compressedECG[idx];
+    }
+    
+    return size;
+  }
+  
+  /**
+   * Get the high-fidelity ECG window (50Hz samples, oldest first)
+   * @param output Output buffer (must hold ECG_WINDOW_SIZE samples)
+   * @param maxSize Maximum number of samples
+   * @return Number of samples written
+   */
+  int getECGWindow(uint16_t* output, int maxSize) {
+    int size = min(ECG_WINDOW_SIZE, maxSize);
+    int start = (ecgWindowIndex + ECG_WINDOW_SIZE - size) % ECG_WINDOW_SIZE;
+    
+    for (int i = 0; i < size; i++) {
+      output[i] = ecgWindow[(start + i) % ECG_WINDOW_SIZE];
+    }
+    
+    return size;
+  }
+  
+  /**
+   * Get PQRST wave features packed into bytes
+   * Returns 14 bytes, multi-byte fields little-endian like the rest of the
+   * ECG payload (EcgPacket::PQRST_* offsets): timestamp(2) + amplitudes(10)
+   * + intervals(2)
+   * 
+   * @param output Output buffer (must be at least 14 bytes)
+   * @return Number of bytes written (14 if valid, 0 if no valid PQRST)
+   */
+  int getPQRSTData(uint8_t* output) {
+    if (!pqrstValid) return 0;
+    
+    int idx = 0;
+    
+    // Timestamp (2 bytes)
+    output[idx++] = lastPQRST.timestamp & 0xFF;
+    output[idx++] = (lastPQRST.timestamp >> 8) & 0xFF;
+    
+    // P, Q, R, S and T amplitudes (2 bytes each, signed)
+    const int16_t amplitudes[5] = {lastPQRST.p_amp, lastPQRST.q_amp, lastPQRST.r_amp,
+                                   lastPQRST.s_amp, lastPQRST.t_amp};
+    for (int i = 0; i < 5; i++) {
+      output[idx++] = amplitudes[i] & 0xFF;
+      output[idx++] = (amplitudes[i] >> 8) & 0xFF;
+    }
+    
+    // QRS width (1 byte)
+    output[idx++] = lastPQRST.qrs_width;
+    
+    // QT interval (1 byte)
+    output[idx++] = lastPQRST.qt_interval;
+    
+    return 14;
+  }
+  
+  /**
+   * Get breathing rate estimated from ECG
+   * Based on respiratory sinus arrhythmia (RSA)
+   * @return Breathing rate in breaths per minute
+   */
+  int getBreathingRate() {
+    // Simplified: Use RR interval variation
+    // Typical breathing: 12-20 breaths/min
+    // This is a placeholder - proper BR detection needs more complex analysis
+    if (currentBPM == 0) return 0;
+    
+    // Estimate: BR is typically 1/4 to 1/5 of heart rate
+    int estimatedBR = currentBPM / 4;
+    return constrain(estimatedBR, 10, 30);  // Reasonable range
+  }
+};
+
+#endif
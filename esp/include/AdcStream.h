@@ -0,0 +1,219 @@
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include <Arduino.h>
+#include <driver/adc.h>
+
+/**
+ * AdcStream - Continuous (DMA) ADC1 capture for several analog inputs
+ *
+ * Uses the ADC digital controller to scan the registered channels at a
+ * fixed hardware-timed rate. Conversion results land in DMA buffers in the
+ * background; a reader task wakes once per DMA frame, splits the frame by
+ * channel and hands each channel's block of 12-bit samples to its sink.
+ *
+ * While the stream is running analogRead() must not be used on ADC1, so
+ * every ADC1 consumer (microphone, ECG) is registered here as a sink.
+ * Sinks run in the reader task and must not block.
+ *
+ * A capturing stream keeps the APB clock up (the DMA driver holds an APB
+ * frequency lock from adc_digi_start() to adc_digi_stop()), so the chip
+ * can only light-sleep while the stream is paused.
+ */
+class AdcStream {
+public:
+  typedef void (*Sink)(void* ctx, const uint16_t* samples, size_t count);
+
+  static const int MAX_CHANNELS = 4;
+
+private:
+  // One DMA frame: 256 conversions (about 13ms at 20 kHz aggregate)
+  static const uint32_t FRAME_SAMPLES = 256;
+  static const uint32_t FRAME_BYTES = FRAME_SAMPLES * sizeof(adc_digi_output_data_t);
+  static const uint32_t STORE_BYTES = FRAME_BYTES * 4;
+
+  struct Channel {
+    uint8_t channel;   // ADC1 channel number
+    Sink sink;
+    void* ctx;
+  };
+
+  Channel channels[MAX_CHANNELS];
+  int channel_count;
+  uint32_t channel_rate_hz;
+  TaskHandle_t task;
+  bool running;
+  volatile bool paused;
+  uint32_t overruns;   // DMA frames lost because the reader fell behind
+
+  uint8_t frame[FRAME_BYTES];
+  uint16_t split[MAX_CHANNELS][FRAME_SAMPLES];
+
+  /**
+   * Reader task - blocks on the DMA driver and dispatches frames
+   */
+  static void readerTask(void* arg) {
+    AdcStream* self = static_cast<AdcStream*>(arg);
+
+    for (;;) {
+      uint32_t length = 0;
+      esp_err_t err = adc_digi_read_bytes(self->frame, FRAME_BYTES, &length, ADC_MAX_DELAY);
+      if (err == ESP_ERR_INVALID_STATE) {
+        self->overruns++;  // Driver ring overflowed; data returned is still valid
+      } else if (err != ESP_OK) {
+        continue;
+      }
+      self->dispatch(length);
+    }
+  }
+
+  /**
+   * Split a DMA frame into per-channel blocks and call the sinks
+   */
+  void dispatch(uint32_t length) {
+    size_t counts[MAX_CHANNELS] = {0};
+
+    for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length; i += sizeof(adc_digi_output_data_t)) {
+      const adc_digi_output_data_t* out = reinterpret_cast<const adc_digi_output_data_t*>(&frame[i]);
+      uint8_t ch = out->type2.channel;
+      for (int c = 0; c < channel_count; c++) {
+        if (channels[c].channel == ch) {
+          split[c][counts[c]++] = out->type2.data;
+          break;
+        }
+      }
+    }
+
+    for (int c = 0; c < channel_count; c++) {
+      if (counts[c] > 0) {
+        channels[c].sink(channels[c].ctx, split[c], counts[c]);
+      }
+    }
+  }
+
+public:
+  AdcStream() {
+    channel_count = 0;
+    channel_rate_hz = 0;
+    task = nullptr;
+    running = false;
+    paused = false;
+    overruns = 0;
+  }
+
+  /**
+   * Register an analog input (call before begin())
+   * @param gpio ADC1-capable GPIO
+   * @param sink Receives blocks of raw 12-bit samples for this input
+   * @param ctx Passed through to the sink
+   * @return true if registered
+   */
+  bool addChannel(uint8_t gpio, Sink sink, void* ctx) {
+    if (running || channel_count >= MAX_CHANNELS || sink == nullptr) return false;
+
+    int8_t ch = digitalPinToAnalogChannel(gpio);
+    if (ch < 0 || ch >= SOC_ADC_MAX_CHANNEL_NUM) return false;  // ADC1 only
+
+    channels[channel_count].channel = (uint8_t)ch;
+    channels[channel_count].sink = sink;
+    channels[channel_count].ctx = ctx;
+    channel_count++;
+    return true;
+  }
+
+  /**
+   * Configure the digital controller and start capture
+   * @param rateHz Sample rate per channel
+   * @param priority Reader task priority
+   * @param core Core the reader task is pinned to
+   * @return true if capture started
+   */
+  bool begin(uint32_t rateHz, UBaseType_t priority, BaseType_t core) {
+    if (running || channel_count == 0) return false;
+
+    uint32_t mask = 0;
+    adc_digi_pattern_config_t pattern[MAX_CHANNELS] = {};
+    for (int c = 0; c < channel_count; c++) {
+      mask |= (1UL << channels[c].channel);
+      pattern[c].atten = ADC_ATTEN_DB_11;  // Full range up to ~3.1V
+      pattern[c].channel = channels[c].channel;
+      pattern[c].unit = 0;                 // ADC1
+      pattern[c].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = STORE_BYTES;
+    init.conv_num_each_intr = FRAME_BYTES;
+    init.adc1_chan_mask = mask;
+    init.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.conv_limit_num = 250;
+    config.pattern_num = channel_count;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = rateHz * channel_count;  // Pattern is scanned round-robin
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_digi_controller_configure(&config) != ESP_OK) {
+      adc_digi_deinitialize();
+      return false;
+    }
+
+    channel_rate_hz = rateHz;
+    if (xTaskCreatePinnedToCore(readerTask, "adc", 4096, this, priority, &task, core) != pdPASS) {
+      adc_digi_deinitialize();
+      return false;
+    }
+
+    if (adc_digi_start() != ESP_OK) {
+      vTaskDelete(task);
+      task = nullptr;
+      adc_digi_deinitialize();
+      return false;
+    }
+
+    running = true;
+    return true;
+  }
+
+  /**
+   * Stop conversions and release the APB lock (the sinks get no samples
+   * until resume(); the reader task stays blocked on the driver)
+   * @return true if the stream is paused
+   */
+  bool pause() {
+    if (!running) return false;
+    if (!paused && adc_digi_stop() == ESP_OK) paused = true;
+    return paused;
+  }
+
+  /**
+   * Restart conversions after pause()
+   * @return true if the stream is capturing
+   */
+  bool resume() {
+    if (!running) return false;
+    if (paused && adc_digi_start() == ESP_OK) paused = false;
+    return !paused;
+  }
+
+  uint32_t getSampleRate() const {
+    return channel_rate_hz;
+  }
+
+  uint32_t getOverruns() const {
+    return overruns;
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+
+  bool isPaused() const {
+    return paused;
+  }
+};
+
+#endif
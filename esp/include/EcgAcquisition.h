@@ -0,0 +1,244 @@
+#ifndef ECG_ACQUISITION_H
+#define ECG_ACQUISITION_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "SampleRing.h"
+
+/**
+ * EcgAcquisition - Timer-driven ECG sampling engine
+ *
+ * Samples the AD8232 output from a periodic esp_timer so the sample rate is
+ * independent of how long loop() takes (loop delays, blocking LoRa
+ * transmissions, temperature averaging). Each sample is stamped with a
+ * monotonic sample number and pushed into a lock-free ring buffer; the
+ * R-peak detector and the ECG compressor drain that ring from loop().
+ *
+ * The timer callback runs in the esp_timer task, not in an ISR, so
+ * analogRead()/digitalRead() are safe to call from it.
+ *
+ * Streamed mode (beginStreamed) replaces the timer when the ECG pin is
+ * captured by a continuous ADC stream: raw blocks arrive through feed()
+ * and are box-car averaged down to the ECG sample rate, which also acts as
+ * an anti-aliasing filter. Sample timing then comes from the ADC hardware
+ * clock.
+ */
+class EcgAcquisition {
+public:
+  struct Sample {
+    uint32_t index;   // Monotonic sample number (sample time = index * period)
+    uint16_t value;   // Raw 12-bit ADC value (0 when leads are off)
+    bool leadsOff;    // LO+ or LO- asserted when the sample was taken
+  };
+
+  // 512 samples = 5.1 seconds of headroom at 100 Hz
+  static const size_t RING_SIZE = 512;
+
+private:
+  uint8_t ecg_pin;
+  uint8_t lo_plus_pin;
+  uint8_t lo_minus_pin;
+  uint32_t sample_rate_hz;
+  uint32_t sample_counter;      // Written by the timer callback only
+  unsigned long start_millis;   // millis() when sampling started
+  esp_timer_handle_t timer;
+  bool running;
+  
+  // Streamed mode decimation
+  bool streamed;
+  bool start_pending;           // start_millis set on the next streamed block
+  uint32_t decim_factor;        // Input samples per output sample
+  uint32_t decim_sum;
+  uint32_t decim_count;
+
+  SampleRing<Sample, RING_SIZE> ring;
+
+  /**
+   * Periodic timer callback - takes exactly one ECG sample
+   */
+  static void onTimer(void* arg) {
+    EcgAcquisition* self = static_cast<EcgAcquisition*>(arg);
+
+    Sample sample;
+    sample.index = self->sample_counter++;
+    sample.leadsOff = (digitalRead(self->lo_plus_pin) == HIGH ||
+                       digitalRead(self->lo_minus_pin) == HIGH);
+    sample.value = sample.leadsOff ? 0 : analogRead(self->ecg_pin);
+
+    self->ring.push(sample);
+  }
+
+public:
+  EcgAcquisition() {
+    ecg_pin = 0;
+    lo_plus_pin = 0;
+    lo_minus_pin = 0;
+    sample_rate_hz = 100;
+    sample_counter = 0;
+    start_millis = 0;
+    timer = nullptr;
+    running = false;
+    streamed = false;
+    start_pending = false;
+    decim_factor = 1;
+    decim_sum = 0;
+    decim_count = 0;
+  }
+
+  /**
+   * Start periodic sampling
+   * @param ecg ADC pin for ECG signal
+   * @param lo_plus Lead-off detection pin (LO+)
+   * @param lo_minus Lead-off detection pin (LO-)
+   * @param rateHz Sample rate in Hz
+   * @return true if the timer was started
+   */
+  bool begin(uint8_t ecg, uint8_t lo_plus, uint8_t lo_minus, uint32_t rateHz = 100) {
+    if (running || rateHz == 0) return false;
+
+    ecg_pin = ecg;
+    lo_plus_pin = lo_plus;
+    lo_minus_pin = lo_minus;
+    sample_rate_hz = rateHz;
+    sample_counter = 0;
+
+    if (timer == nullptr) {
+      esp_timer_create_args_t args = {};
+      args.callback = &EcgAcquisition::onTimer;
+      args.arg = this;
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name = "ecg_acq";
+
+      if (esp_timer_create(&args, &timer) != ESP_OK) {
+        timer = nullptr;
+        return false;
+      }
+    }
+
+    start_millis = millis();
+    if (esp_timer_start_periodic(timer, 1000000ULL / sample_rate_hz) != ESP_OK) {
+      return false;
+    }
+
+    running = true;
+    return true;
+  }
+
+  /**
+   * Start streamed sampling fed from a continuous ADC capture
+   * @param lo_plus Lead-off detection pin (LO+)
+   * @param lo_minus Lead-off detection pin (LO-)
+   * @param rateHz Output ECG sample rate in Hz
+   * @param inputRateHz Rate of the raw samples passed to feed()
+   * @return true if the rates are compatible
+   */
+  bool beginStreamed(uint8_t lo_plus, uint8_t lo_minus, uint32_t rateHz, uint32_t inputRateHz) {
+    if (running || rateHz == 0 || inputRateHz < rateHz) return false;
+
+    lo_plus_pin = lo_plus;
+    lo_minus_pin = lo_minus;
+    sample_rate_hz = rateHz;
+    sample_counter = 0;
+    decim_factor = inputRateHz / rateHz;
+    decim_sum = 0;
+    decim_count = 0;
+    start_pending = true;
+    streamed = true;
+    running = true;
+    return true;
+  }
+
+  /**
+   * Consume a block of raw ADC samples (streamed mode, single producer)
+   * @param raw 12-bit ADC samples at the input rate
+   * @param count Number of samples
+   */
+  void feed(const uint16_t* raw, size_t count) {
+    if (!running || !streamed) return;
+
+    if (start_pending) {
+      // Samples before a gap keep their times, the next one is taken now
+      start_millis = millis() - (unsigned long)(((uint64_t)sample_counter * 1000ULL) / sample_rate_hz);
+      start_pending = false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      decim_sum += raw[i];
+      if (++decim_count < decim_factor) continue;
+
+      Sample sample;
+      sample.index = sample_counter++;
+      sample.leadsOff = (digitalRead(lo_plus_pin) == HIGH ||
+                         digitalRead(lo_minus_pin) == HIGH);
+      sample.value = sample.leadsOff ? 0 : (uint16_t)(decim_sum / decim_factor);
+      ring.push(sample);
+
+      decim_sum = 0;
+      decim_count = 0;
+    }
+  }
+
+  /**
+   * AdcStream sink adapter
+   */
+  static void adcSink(void* ctx, const uint16_t* raw, size_t count) {
+    static_cast<EcgAcquisition*>(ctx)->feed(raw, count);
+  }
+
+  /**
+   * Re-anchor the sample clock at the next streamed block (after the
+   * AdcStream was paused, so the gap does not shift later sample times)
+   */
+  void resync() {
+    if (streamed) start_pending = true;
+  }
+
+  /**
+   * Stop sampling (samples already in the ring stay readable)
+   */
+  void stop() {
+    if (running && !streamed && timer != nullptr) {
+      esp_timer_stop(timer);
+    }
+    running = false;
+    streamed = false;
+  }
+
+  /**
+   * Read the oldest unprocessed sample
+   * @param out Receives the sample
+   * @return true if a sample was available
+   */
+  bool read(Sample& out) {
+    return ring.pop(out);
+  }
+
+  /**
+   * Time at which a sample was taken, in the millis() time base
+   */
+  unsigned long sampleTimeMs(const Sample& sample) const {
+    return start_millis + (unsigned long)(((uint64_t)sample.index * 1000ULL) / sample_rate_hz);
+  }
+
+  size_t available() const {
+    return ring.size();
+  }
+
+  uint32_t getDroppedCount() const {
+    return ring.droppedCount();
+  }
+
+  uint32_t getSampleCount() const {
+    return sample_counter;
+  }
+
+  uint32_t getSampleRate() const {
+    return sample_rate_hz;
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+};
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef ECG_CODEC_H
+#define ECG_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * EcgCodec - Adaptive Rice-coded ECG deltas for 12-bit samples
+ *
+ * Each block starts with a keyframe (the first sample, exact), so a lost
+ * packet never corrupts the next one. Every further sample is coded as the
+ * difference from the previous reconstructed sample (closed loop, so error
+ * never accumulates), zigzag mapped and Rice coded. The Rice parameter
+ * adapts per sample from a running mean of recent residuals, so quiet
+ * baseline costs 2-4 bits per sample while the QRS upstroke is followed
+ * without clipping (large residuals escape to a raw 13-bit value).
+ *
+ * A block has a fixed byte budget. The encoder first tries to code it
+ * losslessly; if that does not fit it quantises residuals with the smallest
+ * step that fits (maximum error step/2 LSB). Only if the largest step still
+ * overflows are trailing samples dropped.
+ *
+ * The same algorithm is implemented for ingestion in backend/api/ecgCodec.js.
+ */
+class EcgCodec {
+public:
+  static const int SAMPLE_MAX = 4095;
+  static const int MAX_STEP = 64;
+  static const int ESCAPE_QUOTIENT = 16;  // Unary run length that escapes to a raw value
+  static const int RAW_BITS = 13;         // Escaped zigzag residual width
+
+  struct Block {
+    uint16_t keyframe;  // First sample (exact)
+    uint8_t step;       // Residual quantiser step (1 = lossless)
+    uint8_t count;      // Samples coded, keyframe included
+  };
+
+private:
+  struct BitWriter {
+    uint8_t* out;
+    size_t capacity;  // Bits
+    size_t pos;
+
+    bool put(uint32_t bits, int width) {
+      if (pos + width > capacity) return false;
+      for (int i = width - 1; i >= 0; i--) {
+        if (bits & (1UL << i)) out[pos >> 3] |= (uint8_t)(0x80 >> (pos & 7));
+        pos++;
+      }
+      return true;
+    }
+  };
+
+  struct BitReader {
+    const uint8_t* in;
+    size_t capacity;  // Bits
+    size_t pos;
+
+    bool get(uint32_t& bits, int width) {
+      if (pos + width > capacity) return false;
+      bits = 0;
+      for (int i = 0; i < width; i++) {
+        bits = (bits << 1) | ((in[pos >> 3] >> (7 - (pos & 7))) & 1);
+        pos++;
+      }
+      return true;
+    }
+  };
+
+  // Running residual statistics shared by encoder and decoder
+  struct Adapt {
+    uint32_t sum;
+    uint32_t n;
+
+    int k() const {
+      int k = 0;
+      while ((n << k) < sum && k < 12) k++;
+      return k;
+    }
+
+    void update(uint32_t u) {
+      sum += u;
+      if (++n == 8) {  // Halve so the mean follows the signal
+        sum >>= 1;
+        n >>= 1;
+      }
+    }
+  };
+
+  static uint32_t zigzag(int v) {
+    return v >= 0 ? (uint32_t)v << 1 : ((uint32_t)(-v) << 1) - 1;
+  }
+
+  static int unzigzag(uint32_t u) {
+    return (u & 1) ? -(int)((u + 1) >> 1) : (int)(u >> 1);
+  }
+
+  static int clampSample(int v) {
+    return v < 0 ? 0 : (v > SAMPLE_MAX ? SAMPLE_MAX : v);
+  }
+
+  /**
+   * Code one block at a fixed quantiser step
+   * @return Samples coded (keyframe included) before the budget ran out
+   */
+  static size_t encodeWithStep(const uint16_t* samples, size_t count, int step,
+                               uint8_t* out, size_t maxBytes) {
+    for (size_t i = 0; i < maxBytes; i++) out[i] = 0;
+
+    BitWriter writer = {out, maxBytes * 8, 0};
+    Adapt adapt = {16, 4};
+    int previous = clampSample(samples[0]);
+    int half = step / 2;
+
+    for (size_t i = 1; i < count; i++) {
+      int residual = clampSample(samples[i]) - previous;
+      int q = residual >= 0 ? (residual + half) / step : -((-residual + half) / step);
+      uint32_t u = zigzag(q);
+
+      int k = adapt.k();
+      uint32_t quotient = u >> k;
+      size_t mark = writer.pos;
+      bool ok;
+      if (quotient < (uint32_t)ESCAPE_QUOTIENT) {
+        ok = writer.put((1UL << (quotient + 1)) - 2, quotient + 1) &&  // quotient ones, then a zero
+             writer.put(u & ((1UL << k) - 1), k);
+      } else {
+        ok = writer.put((1UL << ESCAPE_QUOTIENT) - 1, ESCAPE_QUOTIENT) &&
+             writer.put(u, RAW_BITS);
+      }
+      if (!ok) {
+        // Clear the partial code so the decoder sees zero padding
+        for (size_t b = mark; b < writer.capacity; b++) out[b >> 3] &= (uint8_t)~(0x80 >> (b & 7));
+        return i;
+      }
+
+      previous = clampSample(previous + q * step);
+      adapt.update(u);
+    }
+    return count;
+  }
+
+public:
+  /**
+   * Encode a block into a fixed byte budget
+   * @param samples 12-bit samples (the first becomes the keyframe)
+   * @param count Number of samples (at most 255)
+   * @param out Receives the coded residuals (maxBytes, zero padded)
+   * @param maxBytes Byte budget
+   * @return Block header (keyframe, step, samples coded)
+   */
+  static Block encode(const uint16_t* samples, size_t count, uint8_t* out, size_t maxBytes) {
+    Block block = {2048, 1, 0};
+    if (count == 0) return block;
+    if (count > 255) count = 255;
+
+    block.keyframe = (uint16_t)clampSample(samples[0]);
+    if (encodeWithStep(samples, count, 1, out, maxBytes) < count) {
+      // Binary search the smallest step that fits (size falls with the step)
+      int lo = 1, hi = MAX_STEP;
+      while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (encodeWithStep(samples, count, mid, out, maxBytes) == count) hi = mid;
+        else lo = mid;
+      }
+      block.step = (uint8_t)hi;
+    }
+    block.count = (uint8_t)encodeWithStep(samples, count, block.step, out, maxBytes);
+    return block;
+  }
+
+  /**
+   * Decode a block produced by encode()
+   * @param out Receives block.count samples
+   * @return Samples written (keyframe included)
+   */
+  static size_t decode(const uint8_t* in, size_t maxBytes, const Block& block, uint16_t* out) {
+    if (block.count == 0 || block.step == 0) return 0;
+
+    BitReader reader = {in, maxBytes * 8, 0};
+    Adapt adapt = {16, 4};
+    int previous = block.keyframe;
+    out[0] = (uint16_t)previous;
+
+    for (size_t i = 1; i < block.count; i++) {
+      int k = adapt.k();
+      uint32_t quotient = 0;
+      uint32_t bit = 1;
+      while (quotient < (uint32_t)ESCAPE_QUOTIENT) {
+        if (!reader.get(bit, 1)) return i;
+        if (bit == 0) break;
+        quotient++;
+      }
+
+      uint32_t u;
+      if (quotient == (uint32_t)ESCAPE_QUOTIENT) {
+        if (!reader.get(u, RAW_BITS)) return i;
+      } else {
+        uint32_t low = 0;
+        if (k > 0 && !reader.get(low, k)) return i;
+        u = (quotient << k) | low;
+      }
+
+      previous = clampSample(previous + unzigzag(u) * block.step);
+      out[i] = (uint16_t)previous;
+      adapt.update(u);
+    }
+    return block.count;
+  }
+};
+
+#endif
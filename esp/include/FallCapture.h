@@ -0,0 +1,253 @@
+#ifndef FALL_CAPTURE_H
+#define FALL_CAPTURE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "ImuData.h"
+#include "EcgCodec.h"
+
+/**
+ * FallCapture - Pre/post-trigger IMU window around a confirmed fall
+ *
+ * record() keeps the raw counts of the most recent samples in a ring all
+ * the time. trigger() (WARNING -> FALL_DETECTED) fixes the pre-trigger part
+ * and recording continues for the post-trigger samples; the completed
+ * window is then copied to a snapshot for the radio task, so the ring (and
+ * the history for the next fall) never stops. A window completing while the
+ * previous snapshot is still being sent is dropped and counted.
+ *
+ * encode() cuts each of the six axes of the snapshot into blocks and Rice
+ * codes them with EcgCodec as 12-bit samples (counts / 16 + 2048: 1024 LSB
+ * per g, about 8.2 LSB per °/s). Each block takes as many samples as fit
+ * in CODE_BYTES with a quantiser step of at most MAX_STEP, so quiet stretches
+ * pack a few hundred samples per fragment and the impact stays near
+ * lossless. One block is one radio fragment (Packet Type 0x07).
+ *
+ * Every window is taken at the full IMU rate: the IMU task calls
+ * restart() when it changes the rate, so after a wake from QUIET the
+ * pre-trigger part starts at the wake-up.
+ *
+ * record(), trigger() and restart() belong to the IMU task; ready(),
+ * encode(), fragment() and release() to the radio task.
+ */
+class FallCapture {
+public:
+  static const uint16_t MAX_SAMPLES = 512;   // Ring and window capacity
+  static const int CHANNELS = 6;             // Accel X/Y/Z, gyro X/Y/Z
+  static const int MAX_FRAGMENTS = 48;
+  static const size_t CODE_BYTES = 96;       // Rice code budget per fragment
+  static const uint8_t MAX_STEP = 4;         // Largest quantiser step (error <= 2 LSB)
+  static const uint8_t BLOCK_MAX = 255;      // EcgCodec block length limit
+  static const int SAMPLE_SHIFT = 4;         // Counts -> 12-bit samples
+  static const int SAMPLE_OFFSET = 2048;
+
+  struct Fragment {
+    uint8_t channel;
+    uint16_t start;          // First window sample in the block
+    EcgCodec::Block block;
+    uint8_t code[CODE_BYTES];
+  };
+
+private:
+  struct RawSample {
+    int16_t v[CHANNELS];
+  };
+
+  // Live ring (IMU task)
+  RawSample ring[MAX_SAMPLES];
+  uint16_t head;             // Next slot to write
+  uint16_t filled;
+  uint16_t preSamples;
+  uint16_t postSamples;
+  bool capturing;
+  uint16_t capturePre;       // Pre-trigger samples in the current window
+  uint16_t postRemaining;
+
+  // Completed window (handed to the radio task)
+  RawSample snapshot[MAX_SAMPLES];
+  uint16_t snapshotLength;
+  uint16_t snapshotTrigger;  // Index of the first sample after confirmation
+  uint8_t snapshotId;
+  volatile bool snapshotReady;
+
+  Fragment fragments[MAX_FRAGMENTS];
+  int fragmentCount;
+
+  uint32_t triggers;
+  uint32_t dropped;
+
+  void finishWindow() {
+    capturing = false;
+    if (snapshotReady) {
+      dropped++;
+      return;
+    }
+
+    uint16_t length = capturePre + postSamples;
+    uint16_t first = (head + MAX_SAMPLES - length) % MAX_SAMPLES;
+    for (uint16_t i = 0; i < length; i++) {
+      snapshot[i] = ring[(first + i) % MAX_SAMPLES];
+    }
+    snapshotLength = length;
+    snapshotTrigger = capturePre;
+    snapshotId++;
+    __sync_synchronize();  // Snapshot visible before the flag (other core)
+    snapshotReady = true;
+  }
+
+  static uint16_t toSample(int16_t counts) {
+    return (uint16_t)((counts >> SAMPLE_SHIFT) + SAMPLE_OFFSET);
+  }
+
+  EcgCodec::Block encodeBlock(uint8_t channel, uint16_t start, size_t count, uint8_t* out) const {
+    uint16_t samples[BLOCK_MAX];
+    for (size_t i = 0; i < count; i++) samples[i] = toSample(snapshot[start + i].v[channel]);
+    return EcgCodec::encode(samples, count, out, CODE_BYTES);
+  }
+
+  /**
+   * Largest block at start that fits CODE_BYTES with step <= MAX_STEP
+   */
+  size_t blockLength(uint8_t channel, uint16_t start, uint8_t* scratch) const {
+    size_t remaining = snapshotLength - start;
+    size_t hi = remaining < BLOCK_MAX ? remaining : BLOCK_MAX;
+    EcgCodec::Block b = encodeBlock(channel, start, hi, scratch);
+    if (b.count == hi && b.step <= MAX_STEP) return hi;
+
+    size_t lo = 1;  // A lone keyframe always fits
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      b = encodeBlock(channel, start, mid, scratch);
+      if (b.count == mid && b.step <= MAX_STEP) lo = mid; else hi = mid;
+    }
+    return lo;
+  }
+
+public:
+  FallCapture() {
+    head = 0;
+    filled = 0;
+    preSamples = 0;
+    postSamples = 0;
+    capturing = false;
+    capturePre = 0;
+    postRemaining = 0;
+    snapshotLength = 0;
+    snapshotTrigger = 0;
+    snapshotId = 0;
+    snapshotReady = false;
+    fragmentCount = 0;
+    triggers = 0;
+    dropped = 0;
+  }
+
+  /**
+   * Set the window around the trigger (pre + post is capped at MAX_SAMPLES)
+   */
+  void begin(uint16_t pre, uint16_t post) {
+    if (post > MAX_SAMPLES) post = MAX_SAMPLES;
+    if (pre > MAX_SAMPLES - post) pre = MAX_SAMPLES - post;
+    preSamples = pre;
+    postSamples = post;
+  }
+
+  /**
+   * Append one sample (every IMU sample, IMU task)
+   */
+  void record(const ImuSample& sample) {
+    RawSample& slot = ring[head];
+    memcpy(slot.v, sample.accelRaw, sizeof(sample.accelRaw));
+    memcpy(slot.v + 3, sample.gyroRaw, sizeof(sample.gyroRaw));
+    head = (head + 1) % MAX_SAMPLES;
+    if (filled < MAX_SAMPLES) filled++;
+
+    if (capturing && --postRemaining == 0) finishWindow();
+  }
+
+  /**
+   * Forget the recorded history (IMU rate change, so a window never mixes
+   * rates); a window already open keeps its samples
+   */
+  void restart() {
+    if (!capturing) filled = 0;
+  }
+
+  /**
+   * Start a window at the next recorded sample (ignored while one is open)
+   */
+  void trigger() {
+    if (capturing || postSamples == 0) return;
+    triggers++;
+    capturing = true;
+    capturePre = filled < preSamples ? filled : preSamples;
+    postRemaining = postSamples;
+  }
+
+  /**
+   * True while a completed window waits to be encoded and sent
+   */
+  bool ready() const {
+    return snapshotReady;
+  }
+
+  /**
+   * Encode the snapshot into fragments (radio task, once per window)
+   * @return Number of fragments
+   */
+  int encode() {
+    fragmentCount = 0;
+    if (!snapshotReady) return 0;
+
+    for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+      uint16_t start = 0;
+      while (start < snapshotLength && fragmentCount < MAX_FRAGMENTS) {
+        Fragment& f = fragments[fragmentCount];
+        size_t length = blockLength(channel, start, f.code);
+        f.channel = channel;
+        f.start = start;
+        f.block = encodeBlock(channel, start, length, f.code);
+        fragmentCount++;
+        start += f.block.count;
+      }
+    }
+    return fragmentCount;
+  }
+
+  const Fragment& fragment(int index) const {
+    return fragments[index];
+  }
+
+  int getFragmentCount() const {
+    return fragmentCount;
+  }
+
+  /**
+   * Free the snapshot for the next window (all fragments sent or abandoned)
+   */
+  void release() {
+    fragmentCount = 0;
+    snapshotReady = false;
+  }
+
+  uint8_t windowId() const {
+    return snapshotId;
+  }
+
+  uint16_t windowLength() const {
+    return snapshotLength;
+  }
+
+  uint16_t triggerIndex() const {
+    return snapshotTrigger;
+  }
+
+  uint32_t getTriggerCount() const {
+    return triggers;
+  }
+
+  uint32_t getDroppedCount() const {
+    return dropped;
+  }
+};
+
+#endif
@@ -0,0 +1,956 @@
+#ifndef FALL_DETECTOR_H
+#define FALL_DETECTOR_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "ImuData.h"
+#include "FallMath.h"
+#include "WindowedStats.h"
+#include "Log.h"
+
+/**
+ * FallDetector - Advanced fall detection using MPU6050 sensor
+ * 
+ * This class implements a multi-criteria fall detection algorithm that can be
+ * easily tuned for different applications (elderly care, sports, workplace safety).
+ * 
+ * Configurable Parameters:
+ * - All threshold values are public and can be adjusted at runtime
+ * - Allows for AI/ML optimization of parameters based on user data
+ * - Supports different sensitivity profiles (conservative, balanced, sensitive)
+ */
+class FallDetector {
+public:
+  // ===========================================================================
+  // CONFIGURABLE THRESHOLD PARAMETERS
+  // ===========================================================================
+  // These can be adjusted based on user needs, environment, or AI training
+  
+  // --- Jerk Detection Thresholds (m/s³) ---
+  // Optimized for TORSO/CENTER-BODY placement - lower impact forces expected
+  // Reference: Kartik9250/Fall_detection uses 650,000 m/s³ for wrist placement
+  float JERK_THRESHOLD_HIGH = 450000.0f;     // Reduced for torso (was 650,000)
+  float JERK_THRESHOLD_MEDIUM = 300000.0f;   // Reduced for torso (was 400,000)
+  float JERK_THRESHOLD_LOW = 200000.0f;      // NEW: Detect subtle changes
+  
+  // --- SVM (Signal Vector Magnitude) Thresholds (g-force) ---
+  // Torso experiences less extreme values than extremities
+  // Normal gravity = 1g, torso fall impact = 1.5-2.5g (lower than wrist/head)
+  float SVM_THRESHOLD_HIGH = 1.8f;      // Reduced for torso (was 2.5g)
+  float SVM_THRESHOLD_LOW = 0.65f;      // Slightly raised to avoid bowing detection
+  float SVM_THRESHOLD_WARNING = 1.4f;   // Reduced for torso (was 1.8g)
+  float SVM_THRESHOLD_IMPACT_PEAK = 2.2f; // NEW: Very high impact (confirms fall)
+  
+  // --- Angular Velocity Thresholds (°/s) ---
+  // Torso rotation is KEY indicator - body tumbles during fall
+  float GYRO_THRESHOLD = 150.0f;        // Reduced - torso rotates slower (was 200)
+  float GYRO_THRESHOLD_COMBINED = 180.0f; // Reduced for torso (was 250)
+  float GYRO_THRESHOLD_SUSTAINED = 120.0f; // NEW: Sustained rotation detection
+  
+  // --- Posture Angle Thresholds (degrees) ---
+  // Critical for torso placement - body orientation changes significantly
+  float PITCH_THRESHOLD = 40.0f;        // Slightly reduced (was 45°)
+  float ROLL_THRESHOLD = 35.0f;         // Increased importance (was 30°)
+  float POSTURE_CHANGE_RAPID = 60.0f;   // NEW: Rapid angle change indicates fall
+  
+  // --- Time Windows (milliseconds) ---
+  uint32_t FALL_CONFIRMATION_WINDOW = 500;   // Initial wait before starting immobility check
+  uint32_t RECOVERY_TIME_WINDOW = 5000;      // Minimum time between fall detections
+  uint32_t JERK_SAMPLING_INTERVAL = 10;      // Interval for jerk calculation
+  uint32_t IMMOBILITY_CHECK_WINDOW = 3000;   // Time window to monitor for movement after fall
+  uint32_t IMMOBILITY_SAMPLING_INTERVAL = 100; // Interval for immobility sampling
+  uint32_t FALL_SEQUENCE_WINDOW = 800;       // NEW: Time window to detect fall sequence
+  uint32_t BOWING_REJECTION_TIME = 1500;     // NEW: Bowing takes longer than falling
+  
+  // --- Detection Stage Counters ---
+  // Samples at REFERENCE_RATE_HZ; setSampleRate() scales them (and the
+  // jerk thresholds) for a lower IMU output rate
+  uint8_t IMPACT_COUNT_THRESHOLD = 2;    // Number of high-g readings to trigger
+  uint8_t WARNING_COUNT_THRESHOLD = 3;   // Number of warning readings
+  uint8_t GYRO_SUSTAINED_COUNT = 3;      // NEW: Sustained rotation counter
+  static const uint16_t REFERENCE_RATE_HZ = 100;
+  
+  // --- Post-Fall Movement Detection Thresholds ---
+  // Reference: xiaoweiweiyaya/ESP32_FallDetection - uses CV and SD for movement analysis
+  float IMMOBILITY_ACCEL_VARIANCE_THRESHOLD = 0.005f;  // Max variance (m/s²)² for immobile state
+  float IMMOBILITY_ACCEL_STDDEV_THRESHOLD = 0.1f;    // Max standard deviation (m/s²) for immobile
+  float IMMOBILITY_GYRO_VARIANCE_THRESHOLD = 5.0f;    // Max gyro variance (°/s)² for immobile
+  float IMMOBILITY_SVM_RANGE_THRESHOLD = 0.1f;        // Max SVM change for immobile (g)
+  uint8_t IMMOBILITY_SAMPLE_COUNT = 10;               // Number of samples to check for immobility
+  
+  // ===========================================================================
+  // FALL DETECTION STATE
+  // ===========================================================================
+  
+  enum FallState {
+    NORMAL = 0,        // Normal activity
+    WARNING = 1,       // Potential fall detected, monitoring
+    FALL_DETECTED = 2, // Confirmed fall
+    DANGEROUS = 3,     // Immobile after fall - possible unconsciousness
+    RECOVERY = 4       // Post-fall recovery period
+  };
+  
+  struct FallEvent {
+    FallState state;
+    uint32_t timestamp;
+    float jerk_magnitude;
+    float svm_value;
+    float angular_velocity;
+    float pitch_angle;
+    float roll_angle;
+    bool confirmed;
+    
+    // Post-fall immobility metrics
+    float movement_variance;      // Acceleration variance after fall
+    float movement_stddev;        // Standard deviation of movement
+    bool is_immobile;            // True if person appears unconscious/immobile
+    uint32_t immobile_duration;  // How long person has been immobile (ms)
+  };
+  
+private:
+  // Previous sensor readings for derivative calculations
+  float prev_accel_x, prev_accel_y, prev_accel_z;
+  float baseline_pitch, baseline_roll;
+  float prev_pitch, prev_roll;     // Previous posture angles (rate of change)
+  
+  // Detection state tracking
+  FallState current_state;
+  uint32_t state_change_time;
+  uint32_t last_fall_time;
+  uint8_t impact_counter;
+  uint8_t warning_counter;
+  uint8_t gyro_sustained_counter;  // NEW: Track sustained rotation
+  
+  // Sample timing
+  int64_t last_sample_us;       // Timestamp of previous sample (microseconds)
+  uint16_t sample_rate_hz;      // IMU output rate (setSampleRate())
+  float jerk_scale_sq;          // (rate / REFERENCE_RATE_HZ)², at most 1
+  uint32_t last_immobility_check_time;
+  uint32_t warning_start_time;     // NEW: Track when warning state started
+  
+  // Fall sequence detection
+  bool detected_freefall;          // NEW: Track if free-fall detected
+  bool detected_impact;            // NEW: Track if impact detected
+  bool detected_rotation;          // NEW: Track if rotation detected
+  uint32_t freefall_time;          // NEW: When free-fall was detected
+  uint32_t impact_time;            // NEW: When impact was detected
+  
+  // Activity pattern tracking (for bowing/jumping rejection)
+  uint8_t vertical_motion_counter; // NEW: Count vertical motions (jumping)
+  
+  // Squared metrics behind latest_event (square roots taken on read)
+  float event_svm_sq;
+  float event_gyro_sq;
+  float event_accel_delta_sq;      // |Δa|² between samples (m/s²)²
+  float event_delta_time;          // Seconds between those samples
+  
+  // Latest fall event data
+  FallEvent latest_event;
+  
+  // Calibration flag
+  bool is_calibrated;
+  
+  // Post-fall immobility monitoring (sliding windows of IMMOBILITY_SAMPLE_COUNT)
+  static const size_t IMMOBILITY_MAX_SAMPLES = 30;
+  WindowedStats<float, IMMOBILITY_MAX_SAMPLES> immobility_svm;   // SVM (g): variance and range
+  WindowedStats<float, IMMOBILITY_MAX_SAMPLES> immobility_gyro;  // Angular velocity (°/s): variance
+  
+  uint32_t immobility_start_time;
+  
+public:
+  /**
+   * Constructor - Initialize fall detector
+   */
+  FallDetector() {
+    prev_accel_x = 0.0f;
+    prev_accel_y = 0.0f;
+    prev_accel_z = 0.0f;
+    baseline_pitch = 0.0f;
+    baseline_roll = 0.0f;
+    prev_pitch = 0.0f;
+    prev_roll = 0.0f;
+    
+    current_state = NORMAL;
+    state_change_time = 0;
+    last_fall_time = 0;
+    impact_counter = 0;
+    warning_counter = 0;
+    gyro_sustained_counter = 0;
+    
+    last_sample_us = 0;
+    sample_rate_hz = REFERENCE_RATE_HZ;
+    jerk_scale_sq = 1.0f;
+    last_immobility_check_time = 0;
+    warning_start_time = 0;
+    is_calibrated = false;
+    
+    // Fall sequence tracking
+    detected_freefall = false;
+    detected_impact = false;
+    detected_rotation = false;
+    freefall_time = 0;
+    impact_time = 0;
+    
+    // Activity pattern tracking
+    vertical_motion_counter = 0;
+    
+    event_svm_sq = 1.0f;
+    event_gyro_sq = 0.0f;
+    event_accel_delta_sq = 0.0f;
+    event_delta_time = 0.01f;
+    
+    latest_event.state = NORMAL;
+    latest_event.confirmed = false;
+    latest_event.is_immobile = false;
+    latest_event.movement_variance = 0.0f;
+    latest_event.movement_stddev = 0.0f;
+    latest_event.immobile_duration = 0;
+    
+    // Initialize immobility windows
+    immobility_svm.setWindow(IMMOBILITY_SAMPLE_COUNT);
+    immobility_gyro.setWindow(IMMOBILITY_SAMPLE_COUNT);
+    immobility_start_time = 0;
+  }
+  
+  /**
+   * Calibrate baseline posture angles
+   * Should be called when user is in normal standing/sitting position
+   * 
+   * @param pitch Current pitch angle
+   * @param roll Current roll angle
+   */
+  void calibrate(float pitch, float roll) {
+    baseline_pitch = pitch;
+    baseline_roll = roll;
+    is_calibrated = true;
+    
+    Log.println("========================================");
+    Log.println("Fall Detector Calibrated!");
+    Log.print("Baseline Pitch: ");
+    Log.print(baseline_pitch, 2);
+    Log.print("°, Baseline Roll: ");
+    Log.print(baseline_roll, 2);
+    Log.println("°");
+    Log.println("========================================\n");
+  }
+  
+  /**
+   * Set the IMU output rate the following samples are taken at
+   * 
+   * The stage counters step once per sample, so their thresholds are
+   * scaled to the same duration as at REFERENCE_RATE_HZ (at least one
+   * sample). An impact shorter than one sample period shows as the same
+   * |Δa| over a longer Δt, so the jerk thresholds are lowered by the rate
+   * ratio below the reference rate.
+   * 
+   * @param rateHz Samples per second (MPU6050::getFIFORate())
+   */
+  void setSampleRate(uint16_t rateHz) {
+    sample_rate_hz = rateHz > 0 ? rateHz : REFERENCE_RATE_HZ;
+    float scale = sample_rate_hz < REFERENCE_RATE_HZ ? (float)sample_rate_hz / REFERENCE_RATE_HZ : 1.0f;
+    jerk_scale_sq = scale * scale;
+  }
+  
+  uint16_t getSampleRate() const {
+    return sample_rate_hz;
+  }
+  
+  /**
+   * Squared change in acceleration since the previous sample
+   * Jerk is |Δa| / Δt, so jerk > J is tested as |Δa|² > (J·Δt)² without a root.
+   * 
+   * @param accel_x Current X acceleration (m/s²)
+   * @param accel_y Current Y acceleration (m/s²)
+   * @param accel_z Current Z acceleration (m/s²)
+   * @return |Δa|² in (m/s²)²
+   */
+  float accelDeltaSquared(float accel_x, float accel_y, float accel_z) {
+    float dx = accel_x - prev_accel_x;
+    float dy = accel_y - prev_accel_y;
+    float dz = accel_z - prev_accel_z;
+    
+    // Update previous values
+    prev_accel_x = accel_x;
+    prev_accel_y = accel_y;
+    prev_accel_z = accel_z;
+    
+    return dx * dx + dy * dy + dz * dz;
+  }
+  
+  /**
+   * Stage counter threshold at the current sample rate
+   * @param threshold Samples at REFERENCE_RATE_HZ
+   */
+  uint8_t scaledCount(uint8_t threshold) const {
+    uint32_t count = ((uint32_t)threshold * sample_rate_hz + REFERENCE_RATE_HZ / 2) / REFERENCE_RATE_HZ;
+    return count < 1 ? 1 : count > 255 ? 255 : (uint8_t)count;
+  }
+  
+  /**
+   * Calculate Signal Vector Magnitude (SVM)
+   * Represents total acceleration magnitude
+   * 
+   * @param accel_x X acceleration (m/s²)
+   * @param accel_y Y acceleration (m/s²)
+   * @param accel_z Z acceleration (m/s²)
+   * @return SVM in g-force units
+   */
+  float calculateSVM(float accel_x, float accel_y, float accel_z) {
+    // Convert m/s² to g (1g = 9.80665 m/s²)
+    const float GRAVITY = 9.80665f;
+    float ax_g = accel_x / GRAVITY;
+    float ay_g = accel_y / GRAVITY;
+    float az_g = accel_z / GRAVITY;
+    
+    // Calculate magnitude
+    float svm = sqrt(ax_g * ax_g + ay_g * ay_g + az_g * az_g);
+    
+    return svm;
+  }
+  
+  /**
+   * Calculate combined angular velocity magnitude
+   * 
+   * @param gyro_x X rotation rate (°/s)
+   * @param gyro_y Y rotation rate (°/s)
+   * @param gyro_z Z rotation rate (°/s)
+   * @return Combined angular velocity magnitude
+   */
+  float calculateAngularVelocity(float gyro_x, float gyro_y, float gyro_z) {
+    return sqrt(gyro_x * gyro_x + gyro_y * gyro_y + gyro_z * gyro_z);
+  }
+  
+  /**
+   * Main fall detection algorithm
+   * Analyzes sensor data using multi-stage criteria
+   * 
+   * Algorithm Flow:
+   * 1. Calculate jerk, SVM, and angular velocity (squared, no roots)
+   * 2. Check for impact/free-fall phase (Stage 1)
+   * 3. Check for tumbling/rotation (Stage 2)
+   * 4. Verify posture angle change (Stage 3)
+   * 5. Confirm fall if all criteria met
+   * 
+   * @param sensor_data Current MPU6050 sensor readings
+   * @return Updated fall event with detection status
+   */
+  FallEvent detectFall(const ImuData& sensor_data) {
+    return detectFall(sensor_data, esp_timer_get_time());
+  }
+  
+  /**
+   * Fall detection for a timestamped sample (FIFO batches)
+   * Uses the sample time rather than the processing time so jerk and all
+   * time windows stay correct when samples are processed in bursts.
+   * 
+   * @param sensor_data MPU6050 sensor readings
+   * @param sample_time_us Time the sample was taken (esp_timer_get_time() base)
+   * @return Updated fall event with detection status
+   */
+  FallEvent detectFall(const ImuData& sensor_data, int64_t sample_time_us) {
+    update(sensor_data, FallMath::motionSquares(sensor_data), sample_time_us);
+    return getLatestEvent();
+  }
+  
+  /**
+   * Hot-path fall detection with precomputed squared magnitudes
+   * 
+   * Same algorithm as detectFall(); every threshold is compared in squared
+   * space, so no square root is taken per sample. The event magnitudes are
+   * only materialised by getLatestEvent(), which callers use when they
+   * actually report an event.
+   * 
+   * @param sensor_data MPU6050 sensor readings (jerk and posture)
+   * @param squares SVM² and angular velocity² for the sample (FallMath)
+   * @param sample_time_us Time the sample was taken (esp_timer_get_time() base)
+   * @return Detection state after this sample
+   */
+  FallState update(const ImuData& sensor_data, const FallMath::MotionSquares& squares,
+                   int64_t sample_time_us) {
+    uint32_t current_time = (uint32_t)(sample_time_us / 1000);  // Same base as millis()
+    
+    // Calculate time delta for jerk calculation
+    float delta_time = (sample_time_us - last_sample_us) / 1000000.0f; // Convert to seconds
+    if (delta_time <= 0) delta_time = 0.01f; // Prevent division by zero
+    last_sample_us = sample_time_us;
+    
+    // === STAGE 1: Calculate Detection Metrics ===
+    
+    // Squared space: x > T  <=>  x² > T² for the non-negative magnitudes
+    float delta_sq = accelDeltaSquared(sensor_data.accelX, sensor_data.accelY, 
+                                       sensor_data.accelZ);
+    float svm_sq = squares.svmSq;
+    float gyro_sq = squares.gyroSq;
+    float dt_sq = delta_time * delta_time * jerk_scale_sq;  // Jerk thresholds at this rate
+    
+    // === STAGE 2: Enhanced Impact/Free-fall Detection ===
+    // Optimized for TORSO placement - detect fall SEQUENCE instead of single event
+    
+    bool high_impact = (svm_sq > SVM_THRESHOLD_HIGH * SVM_THRESHOLD_HIGH);
+    bool very_high_impact = (svm_sq > SVM_THRESHOLD_IMPACT_PEAK * SVM_THRESHOLD_IMPACT_PEAK);
+    bool free_fall = (svm_sq < SVM_THRESHOLD_LOW * SVM_THRESHOLD_LOW);
+    bool high_jerk = (delta_sq > JERK_THRESHOLD_HIGH * JERK_THRESHOLD_HIGH * dt_sq);
+    bool medium_jerk = (delta_sq > JERK_THRESHOLD_MEDIUM * JERK_THRESHOLD_MEDIUM * dt_sq);
+    bool low_jerk = (delta_sq > JERK_THRESHOLD_LOW * JERK_THRESHOLD_LOW * dt_sq);
+    
+    // NEW: Detect free-fall phase (important for fall sequence)
+    if (free_fall && !detected_freefall) {
+      detected_freefall = true;
+      freefall_time = current_time;
+      LOG_D(LOG_FALL, "[Fall Sequence] Free-fall detected!");
+    }
+    
+    // Reset free-fall if too much time passed
+    if (detected_freefall && (current_time - freefall_time > FALL_SEQUENCE_WINDOW)) {
+      detected_freefall = false;
+    }
+    
+    // NEW: Detect impact phase (especially after free-fall)
+    if ((high_impact || high_jerk) && !detected_impact) {
+      detected_impact = true;
+      impact_time = current_time;
+      
+      // Extra confidence if impact follows free-fall
+      if (detected_freefall && (current_time - freefall_time < FALL_SEQUENCE_WINDOW)) {
+        LOG_D(LOG_FALL, "[Fall Sequence] Impact after free-fall - HIGH CONFIDENCE!");
+        impact_counter += 2;  // Double weight for sequence detection
+      } else {
+        impact_counter++;
+      }
+      
+      if (current_state == NORMAL) {
+        current_state = WARNING;
+        warning_start_time = current_time;
+      }
+    }
+    
+    // Reset impact detection
+    if (detected_impact && (current_time - impact_time > FALL_SEQUENCE_WINDOW)) {
+      detected_impact = false;
+    }
+    
+    // Additional impact detection for torso
+    // (only escalates NORMAL - the tail of an impact must not undo a confirmed fall)
+    bool can_warn = (current_state == NORMAL || current_state == WARNING);
+    if (very_high_impact) {
+      impact_counter += 2;  // Strong signal
+      if (can_warn) {
+        current_state = WARNING;
+        if (warning_start_time == 0) warning_start_time = current_time;
+      }
+    } else if (medium_jerk || (svm_sq > SVM_THRESHOLD_WARNING * SVM_THRESHOLD_WARNING)) {
+      warning_counter++;
+      if (can_warn && warning_counter >= scaledCount(WARNING_COUNT_THRESHOLD)) {
+        current_state = WARNING;
+        if (warning_start_time == 0) warning_start_time = current_time;
+      }
+    } else if (low_jerk && current_state == WARNING) {
+      // Keep warning state active with low jerk
+      warning_counter++;
+    } else {
+      // Decay counters if no detection
+      if (impact_counter > 0) impact_counter--;
+      if (warning_counter > 0) warning_counter--;
+      
+      // Return to normal if no activity
+      if (current_state == WARNING && impact_counter == 0 && warning_counter == 0) {
+        current_state = NORMAL;
+        warning_start_time = 0;
+      }
+    }
+    
+    // === STAGE 3: Enhanced Rotation/Tumbling Detection ===
+    // Torso rotation is CRITICAL - body tumbles during fall but not during bowing
+    bool high_rotation = (gyro_sq > GYRO_THRESHOLD_COMBINED * GYRO_THRESHOLD_COMBINED);
+    bool sustained_rotation = (gyro_sq > GYRO_THRESHOLD_SUSTAINED * GYRO_THRESHOLD_SUSTAINED);
+    
+    // Track sustained rotation (key difference: fall = rotation, bowing = no rotation)
+    if (sustained_rotation) {
+      gyro_sustained_counter++;
+      detected_rotation = true;
+      LOG_D(LOG_FALL, "[Rotation] Sustained rotation detected: %.2f °/s (count: %u)",
+            sqrtf(gyro_sq), gyro_sustained_counter);
+    } else {
+      if (gyro_sustained_counter > 0) gyro_sustained_counter--;
+    }
+    
+    // High confidence if sustained rotation during warning state
+    if (current_state == WARNING && gyro_sustained_counter >= scaledCount(GYRO_SUSTAINED_COUNT)) {
+      LOG_D(LOG_FALL, "[Rotation] Sustained rotation confirmed - likely fall!");
+    }
+    
+    // === STAGE 4: Enhanced Posture Angle Verification ===
+    // Torso orientation is HIGHLY reliable indicator
+    bool posture_changed = false;
+    bool rapid_posture_change = false;
+    
+    if (is_calibrated) {
+      // Calculate pitch and roll from accelerometer
+      float pitch = FallMath::fastAtan2(sensor_data.accelY, sensor_data.accelZ) * 180.0f / PI;
+      float roll = FallMath::fastAtan2(sensor_data.accelX, sensor_data.accelZ) * 180.0f / PI;
+      
+      // Check if posture significantly changed from baseline
+      float pitch_change = abs(pitch - baseline_pitch);
+      float roll_change = abs(roll - baseline_roll);
+      
+      // NEW: Calculate rate of angle change (fast = fall, slow = bowing)
+      float pitch_rate = abs(pitch - prev_pitch) / (delta_time + 0.001f);
+      float roll_rate = abs(roll - prev_roll) / (delta_time + 0.001f);
+      
+      prev_pitch = pitch;
+      prev_roll = roll;
+      
+      posture_changed = (pitch_change > PITCH_THRESHOLD) || (roll_change > ROLL_THRESHOLD);
+      
+      // NEW: Rapid posture change indicates fall (not slow bowing)
+      rapid_posture_change = (pitch_change > POSTURE_CHANGE_RAPID) || 
+                             (roll_change > POSTURE_CHANGE_RAPID) ||
+                             (pitch_rate > 100.0f) || (roll_rate > 80.0f);
+      
+      if (rapid_posture_change && current_state == WARNING) {
+        LOG_D(LOG_FALL, "[Posture] RAPID angle change detected - strong fall indicator!");
+      }
+      
+      latest_event.pitch_angle = pitch;
+      latest_event.roll_angle = roll;
+    }
+    
+    // === STAGE 5: Intelligent Fall Confirmation Logic ===
+    // ENHANCED: Distinguish fall from bowing/jumping using multiple indicators
+    
+    bool fall_confirmed = false;
+    
+    if (current_state == WARNING) {
+      uint32_t warning_duration = current_time - warning_start_time;
+      
+      // === BOWING REJECTION ===
+      // Bowing characteristics: slow, controlled, no rotation, gradual angle change
+      bool likely_bowing = false;
+      if (is_calibrated) {
+        // Bowing takes longer (>1.5s), has no rotation, and is controlled
+        likely_bowing = (warning_duration > BOWING_REJECTION_TIME) && 
+                       (gyro_sustained_counter == 0) && 
+                       (!detected_freefall) &&
+                       (!rapid_posture_change);
+        
+        if (likely_bowing) {
+          LOG_D(LOG_FALL, "[Rejection] Likely BOWING detected - slow, no rotation");
+          // Reset warning state
+          current_state = NORMAL;
+          impact_counter = 0;
+          warning_counter = 0;
+          gyro_sustained_counter = 0;
+          warning_start_time = 0;
+          detected_freefall = false;
+          detected_impact = false;
+          detected_rotation = false;
+          return latest_event.state;
+        }
+      }
+      
+      // === JUMPING REJECTION ===
+      // Jumping characteristics: vertical motion, symmetric up/down, quick recovery
+      bool likely_jumping = false;
+      if (detected_freefall && !detected_rotation && (gyro_sustained_counter == 0)) {
+        // Jump has free-fall but NO rotation and quick posture return
+        likely_jumping = true;
+        LOG_D(LOG_FALL, "[Rejection] Likely JUMPING detected - vertical, no rotation");
+        
+        // Don't immediately reject - wait to see if posture changes
+        // If person returns to upright quickly, it was a jump
+      }
+      
+      // === FALL CONFIRMATION WITH WEIGHTED CRITERIA ===
+      int criteria_score = 0;
+      int criteria_count = 0;
+      
+      // Criterion 1: Impact detection (weight: 2 if after free-fall, else 1)
+      if (impact_counter >= scaledCount(IMPACT_COUNT_THRESHOLD)) {
+        criteria_count++;
+        if (detected_freefall && (impact_time - freefall_time < FALL_SEQUENCE_WINDOW)) {
+          criteria_score += 3;  // STRONG indicator: free-fall → impact sequence
+          LOG_D(LOG_FALL, "[Criteria] ✓ Impact sequence (score +3)");
+        } else {
+          criteria_score += 1;
+          LOG_D(LOG_FALL, "[Criteria] ✓ Impact detected (score +1)");
+        }
+      }
+      
+      // Criterion 2: Sustained rotation (weight: 3 - CRITICAL for torso)
+      if (gyro_sustained_counter >= scaledCount(GYRO_SUSTAINED_COUNT)) {
+        criteria_count++;
+        criteria_score += 3;  // STRONG indicator: body tumbling
+        LOG_D(LOG_FALL, "[Criteria] ✓ Sustained rotation (score +3)");
+      } else if (high_rotation) {
+        criteria_count++;
+        criteria_score += 2;
+        LOG_D(LOG_FALL, "[Criteria] ✓ High rotation (score +2)");
+      }
+      
+      // Criterion 3: Posture change (weight: 3 if rapid, else 2)
+      if (rapid_posture_change) {
+        criteria_count++;
+        criteria_score += 3;  // STRONG indicator: sudden orientation change
+        LOG_D(LOG_FALL, "[Criteria] ✓ Rapid posture change (score +3)");
+      } else if (posture_changed) {
+        criteria_count++;
+        criteria_score += 2;
+        LOG_D(LOG_FALL, "[Criteria] ✓ Posture changed (score +2)");
+      }
+      
+      // Criterion 4: High jerk (weight: 1)
+      if (high_jerk) {
+        criteria_count++;
+        criteria_score += 1;
+        LOG_D(LOG_FALL, "[Criteria] ✓ High jerk (score +1)");
+      }
+      
+      // Criterion 5: Fall sequence detected (weight: 2)
+      if (detected_freefall && detected_impact && detected_rotation) {
+        criteria_count++;
+        criteria_score += 2;  // Complete fall sequence
+        LOG_D(LOG_FALL, "[Criteria] ✓ Complete fall sequence (score +2)");
+      }
+      
+      LOG_D(LOG_FALL, "[Fall Score] Total: %d/12, Criteria: %d/5", criteria_score, criteria_count);
+      
+      // === CONFIRMATION DECISION ===
+      // Require EITHER:
+      // - Score ≥ 6 (high confidence)
+      // - Score ≥ 4 AND at least 3 different criteria
+      // This ensures we don't miss falls but avoid false positives
+      
+      if ((criteria_score >= 6) || (criteria_score >= 4 && criteria_count >= 3)) {
+        if (!likely_jumping) {
+          fall_confirmed = true;
+          current_state = FALL_DETECTED;
+          state_change_time = current_time;
+          last_fall_time = current_time;
+          
+          LOG_W(LOG_FALL, "FALL CONFIRMED! Score: %d, Criteria: %d", criteria_score, criteria_count);
+          
+          // Reset counters
+          impact_counter = 0;
+          warning_counter = 0;
+          gyro_sustained_counter = 0;
+          detected_freefall = false;
+          detected_impact = false;
+          detected_rotation = false;
+        } else {
+          LOG_D(LOG_FALL, "[Decision] High score but likely jumping - monitoring...");
+        }
+      } else if (warning_duration > FALL_SEQUENCE_WINDOW && criteria_score < 4) {
+        // Timeout - not enough evidence for fall
+        LOG_D(LOG_FALL, "[Decision] Warning timeout - insufficient evidence");
+        current_state = NORMAL;
+        impact_counter = 0;
+        warning_counter = 0;
+        gyro_sustained_counter = 0;
+        warning_start_time = 0;
+        detected_freefall = false;
+        detected_impact = false;
+        detected_rotation = false;
+      }
+    }
+    
+    // === STAGE 6: Post-Fall Movement Monitoring ===
+    // Monitor for immobility after fall detection (potential unconsciousness)
+    if (current_state == FALL_DETECTED) {
+      // Check if it's time to start monitoring immobility
+      if (current_time - state_change_time > FALL_CONFIRMATION_WINDOW) {
+        // Continuously collect samples
+        checkPostFallMovement(sensor_data, current_time);
+        
+        // Only make decision after collecting enough samples
+        if (immobility_svm.full()) {
+          // Check if person is immobile
+          if (latest_event.is_immobile) {
+            current_state = DANGEROUS;
+            LOG_W(LOG_FALL, "NO MOVEMENT DETECTED - POSSIBLE UNCONSCIOUSNESS");
+          } else {
+            // Person is moving, transition to recovery
+            current_state = RECOVERY;
+            LOG_I(LOG_FALL, "Movement detected - person is moving after fall");
+          }
+        }
+        // If not enough samples yet, stay in FALL_DETECTED state
+      }
+    }
+    
+    // === STAGE 7: Dangerous State - Continuous Immobility Monitoring ===
+    if (current_state == DANGEROUS) {
+      // Continue monitoring movement
+      checkPostFallMovement(sensor_data, current_time);
+      
+      // If person starts moving, transition to recovery
+      if (!latest_event.is_immobile) {
+        LOG_I(LOG_FALL, "Movement detected - transitioning to recovery");
+        current_state = RECOVERY;
+      }
+    }
+    
+    // === STAGE 8: Recovery Period ===
+    // Prevent multiple detections in short time
+    if (current_state == RECOVERY) {
+      if (current_time - last_fall_time > RECOVERY_TIME_WINDOW) {
+        current_state = NORMAL;
+        // Reset immobility tracking
+        immobility_svm.reset();
+        immobility_gyro.reset();
+      }
+    }
+    
+    // Update fall event data
+    latest_event.state = current_state;
+    latest_event.timestamp = current_time;
+    event_svm_sq = svm_sq;
+    event_gyro_sq = gyro_sq;
+    event_accel_delta_sq = delta_sq;
+    event_delta_time = delta_time;
+    latest_event.confirmed = fall_confirmed;
+    
+    return current_state;
+  }
+  
+  /**
+   * Check for post-fall movement to detect unconsciousness
+   * 
+   * This method monitors acceleration variance and standard deviation after a fall
+   * to determine if the person is immobile (potentially unconscious/injured).
+   * 
+   * Algorithm based on xiaoweiweiyaya/ESP32_FallDetection approach:
+   * - Collects acceleration samples in a sliding window
+   * - Calculates variance and standard deviation
+   * - Low variance indicates no movement (immobility)
+   * - High variance indicates normal movement
+   * 
+   * @param sensor_data Current sensor readings
+   * @param current_time Current timestamp in milliseconds
+   */
+  void checkPostFallMovement(const ImuData& sensor_data, uint32_t current_time) {
+    // Only check at specified intervals to avoid excessive computation
+    if (current_time - last_immobility_check_time < IMMOBILITY_SAMPLING_INTERVAL) {
+      return;
+    }
+    last_immobility_check_time = current_time;
+    
+    // Exact magnitudes: the windows resolve small movements the Q kernel would round
+    float svm = calculateSVM(sensor_data.accelX, sensor_data.accelY, sensor_data.accelZ);
+    float angular_vel = calculateAngularVelocity(sensor_data.gyroX, sensor_data.gyroY,
+                                                 sensor_data.gyroZ);
+    
+    // Follow runtime changes to the window length (clears the window)
+    if (immobility_svm.windowLength() != IMMOBILITY_SAMPLE_COUNT) {
+      immobility_svm.setWindow(IMMOBILITY_SAMPLE_COUNT);
+      immobility_gyro.setWindow(IMMOBILITY_SAMPLE_COUNT);
+    }
+    
+    // Debug: Print sample collection
+    LOG_D(LOG_FALL, "[Immobility] Sample %u/%u - SVM: %.3f, Gyro: %.2f",
+          (unsigned)immobility_svm.size(), (unsigned)IMMOBILITY_SAMPLE_COUNT, svm, angular_vel);
+    
+    // Add current samples to the sliding windows
+    immobility_svm.push(svm);
+    immobility_gyro.push(angular_vel);
+    
+    // Need minimum samples before checking
+    if (!immobility_svm.full()) {
+      latest_event.is_immobile = false;
+      return;
+    }
+    
+    // Window statistics are maintained incrementally (constant cost per sample)
+    float svm_range = immobility_svm.max() - immobility_svm.min();
+    float accel_variance = (float)immobility_svm.variance();
+    float gyro_variance = (float)immobility_gyro.variance();
+    
+    // Calculate standard deviation
+    float accel_stddev = sqrt(accel_variance);
+    
+    // Update event metrics
+    latest_event.movement_variance = accel_variance;
+    latest_event.movement_stddev = accel_stddev;
+    
+    // Debug: Print calculated metrics
+    if (LOG_ENABLED(LOG_FALL, LOG_LEVEL_DEBUG)) {
+      Log.println("\n[Immobility Analysis]");
+      Log.print("  Accel Mean: "); Log.print((float)immobility_svm.mean(), 3); Log.println(" g");
+      Log.print("  Accel Variance: "); Log.print(accel_variance, 6); Log.print(" (threshold: ");
+      Log.print(IMMOBILITY_ACCEL_VARIANCE_THRESHOLD, 6); Log.println(")");
+      Log.print("  Accel StdDev: "); Log.print(accel_stddev, 4); Log.print(" (threshold: ");
+      Log.print(IMMOBILITY_ACCEL_STDDEV_THRESHOLD, 4); Log.println(")");
+      Log.print("  Gyro Variance: "); Log.print(gyro_variance, 2); Log.print(" (threshold: ");
+      Log.print(IMMOBILITY_GYRO_VARIANCE_THRESHOLD, 2); Log.println(")");
+      Log.print("  SVM Range: "); Log.print(svm_range, 3); Log.print(" (threshold: ");
+      Log.print(IMMOBILITY_SVM_RANGE_THRESHOLD, 3); Log.println(")");
+
+    }    
+    // Determine immobility based on multiple criteria
+    // Reference: xiaoweiweiyaya uses CV and SD thresholds
+    bool low_accel_variance = (accel_variance < IMMOBILITY_ACCEL_VARIANCE_THRESHOLD);
+    bool low_accel_stddev = (accel_stddev < IMMOBILITY_ACCEL_STDDEV_THRESHOLD);
+    bool low_gyro_variance = (gyro_variance < IMMOBILITY_GYRO_VARIANCE_THRESHOLD);
+    bool low_svm_range = (svm_range < IMMOBILITY_SVM_RANGE_THRESHOLD);
+    
+    // Debug: Print criteria evaluation
+    if (LOG_ENABLED(LOG_FALL, LOG_LEVEL_DEBUG)) {
+      Log.println("  Criteria Check:");
+      Log.print("    Low Accel Variance: "); Log.println(low_accel_variance ? "YES" : "NO");
+      Log.print("    Low Accel StdDev: "); Log.println(low_accel_stddev ? "YES" : "NO");
+      Log.print("    Low Gyro Variance: "); Log.println(low_gyro_variance ? "YES" : "NO");
+      Log.print("    Low SVM Range: "); Log.println(low_svm_range ? "YES" : "NO");
+
+    }    
+    // Require at least 3 of 4 criteria to confirm immobility
+    int immobility_criteria = 0;
+    if (low_accel_variance) immobility_criteria++;
+    if (low_accel_stddev) immobility_criteria++;
+    if (low_gyro_variance) immobility_criteria++;
+    if (low_svm_range) immobility_criteria++;
+    
+    LOG_D(LOG_FALL, "[Immobility] Criteria Met: %d/4", immobility_criteria);
+    
+    latest_event.is_immobile = (immobility_criteria >= 3);
+    
+    // Track immobility duration
+    if (latest_event.is_immobile) {
+      if (immobility_start_time == 0) {
+        immobility_start_time = current_time;
+      }
+      latest_event.immobile_duration = current_time - immobility_start_time;
+    } else {
+      immobility_start_time = 0;
+      latest_event.immobile_duration = 0;
+    }
+  }
+  
+  /**
+   * Get current fall detection state
+   */
+  FallState getState() const {
+    return current_state;
+  }
+  
+  /**
+   * Get latest fall event data (magnitudes computed here, not per sample)
+   */
+  FallEvent getLatestEvent() const {
+    FallEvent event = latest_event;
+    event.svm_value = sqrtf(event_svm_sq);
+    event.angular_velocity = sqrtf(event_gyro_sq);
+    event.jerk_magnitude = sqrtf(event_accel_delta_sq) / event_delta_time;
+    return event;
+  }
+  
+  /**
+   * True if the last update() confirmed a fall
+   */
+  bool isFallConfirmed() const {
+    return latest_event.confirmed;
+  }
+  
+  /**
+   * Check if detector is calibrated
+   */
+  bool isCalibrated() const {
+    return is_calibrated;
+  }
+  
+  /**
+   * Reset fall detector state
+   */
+  void reset() {
+    current_state = NORMAL;
+    impact_counter = 0;
+    warning_counter = 0;
+    gyro_sustained_counter = 0;
+    latest_event.confirmed = false;
+    latest_event.is_immobile = false;
+    latest_event.immobile_duration = 0;
+    immobility_svm.reset();
+    immobility_gyro.reset();
+    immobility_start_time = 0;
+    warning_start_time = 0;
+    detected_freefall = false;
+    detected_impact = false;
+    detected_rotation = false;
+    freefall_time = 0;
+    impact_time = 0;
+    vertical_motion_counter = 0;
+  }
+  
+  /**
+   * Print current detection parameters
+   */
+  void printConfiguration() {
+    Log.println("\n========================================");
+    Log.println("Fall Detector Configuration:");
+    Log.println("========================================");
+    Log.print("Jerk Threshold (High): "); Log.print(JERK_THRESHOLD_HIGH); Log.println(" m/s³");
+    Log.print("SVM Threshold (High):  "); Log.print(SVM_THRESHOLD_HIGH); Log.println(" g");
+    Log.print("SVM Threshold (Low):   "); Log.print(SVM_THRESHOLD_LOW); Log.println(" g");
+    Log.print("Gyro Threshold:        "); Log.print(GYRO_THRESHOLD_COMBINED); Log.println(" °/s");
+    Log.print("Pitch Threshold:       "); Log.print(PITCH_THRESHOLD); Log.println("°");
+    Log.print("Roll Threshold:        "); Log.print(ROLL_THRESHOLD); Log.println("°");
+    Log.println("--- Post-Fall Immobility Detection ---");
+    Log.print("Accel Variance Threshold: "); Log.print(IMMOBILITY_ACCEL_VARIANCE_THRESHOLD); Log.println(" (m/s²)²");
+    Log.print("Accel StdDev Threshold:   "); Log.print(IMMOBILITY_ACCEL_STDDEV_THRESHOLD); Log.println(" m/s²");
+    Log.print("Gyro Variance Threshold:  "); Log.print(IMMOBILITY_GYRO_VARIANCE_THRESHOLD); Log.println(" (°/s)²");
+    Log.print("SVM Range Threshold:      "); Log.print(IMMOBILITY_SVM_RANGE_THRESHOLD); Log.println(" g");
+    Log.print("Immobility Check Window:  "); Log.print(IMMOBILITY_CHECK_WINDOW); Log.println(" ms");
+    Log.println("========================================\n");
+  }
+  
+  /**
+   * Set sensitivity profile
+   * @param profile 0=Conservative, 1=Balanced, 2=Sensitive
+   */
+  void setSensitivityProfile(uint8_t profile) {
+    switch(profile) {
+      case 0: // Conservative - fewer false positives (torso-optimized)
+        JERK_THRESHOLD_HIGH = 450000.0f;
+        JERK_THRESHOLD_MEDIUM = 250000.0f;
+        SVM_THRESHOLD_HIGH = 2.0f;
+        SVM_THRESHOLD_LOW = 0.6f;
+        GYRO_THRESHOLD_COMBINED = 200.0f;
+        GYRO_THRESHOLD_SUSTAINED = 140.0f;
+        PITCH_THRESHOLD = 45.0f;
+        ROLL_THRESHOLD = 38.0f;
+        IMPACT_COUNT_THRESHOLD = 3;
+        GYRO_SUSTAINED_COUNT = 4;
+        Log.println("Sensitivity Profile: CONSERVATIVE (Torso-Optimized)");
+        break;
+        
+      case 1: // Balanced - default (torso-optimized)
+        JERK_THRESHOLD_HIGH = 350000.0f;
+        JERK_THRESHOLD_MEDIUM = 200000.0f;
+        SVM_THRESHOLD_HIGH = 1.8f;
+        SVM_THRESHOLD_LOW = 0.65f;
+        GYRO_THRESHOLD_COMBINED = 180.0f;
+        GYRO_THRESHOLD_SUSTAINED = 120.0f;
+        PITCH_THRESHOLD = 40.0f;
+        ROLL_THRESHOLD = 35.0f;
+        IMPACT_COUNT_THRESHOLD = 2;
+        GYRO_SUSTAINED_COUNT = 3;
+        Log.println("Sensitivity Profile: BALANCED (Torso-Optimized)");
+        break;
+        
+      case 2: // Sensitive - maximum detection (torso-optimized)
+        JERK_THRESHOLD_HIGH = 280000.0f;
+        JERK_THRESHOLD_MEDIUM = 150000.0f;
+        SVM_THRESHOLD_HIGH = 1.6f;
+        SVM_THRESHOLD_LOW = 0.7f;
+        GYRO_THRESHOLD_COMBINED = 160.0f;
+        GYRO_THRESHOLD_SUSTAINED = 100.0f;
+        PITCH_THRESHOLD = 35.0f;
+        ROLL_THRESHOLD = 30.0f;
+        IMPACT_COUNT_THRESHOLD = 1;
+        GYRO_SUSTAINED_COUNT = 2;
+        Log.println("Sensitivity Profile: SENSITIVE (Torso-Optimized)");
+        break;
+    }
+    printConfiguration();
+  }
+};
+
+#endif
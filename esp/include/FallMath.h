@@ -0,0 +1,140 @@
+#ifndef FALL_MATH_H
+#define FALL_MATH_H
+
+#include <stdint.h>
+#include "ImuData.h"
+
+/**
+ * FallMath - Cheap motion metrics for the fall detector hot path
+ *
+ * The detector only ever compares magnitudes against thresholds, so it works
+ * on squared magnitudes and never needs a square root per sample. This file
+ * provides them two ways:
+ *   - motionSquares(ImuData)        float reference, from converted units
+ *   - motionSquares(samples, count) integer kernel over a FIFO batch of raw
+ *                                   MPU6050 counts
+ *
+ * The batch kernel squares each 16-bit count and shifts right by 17, giving
+ * a 16-bit Q format per axis (accel: 1 g² = 2048, full scale 4 g² = 8192;
+ * gyro: one LSB = 131072 / 131² ≈ 7.6 (°/s)²), so three axes sum without
+ * overflow in int16. That resolves 0.0005 g² and well under 1% of the gyro
+ * thresholds (120-180 °/s).
+ *
+ * Build with -DFALL_MATH_ESP_DSP=1 to run the kernel on esp-dsp
+ * (dsps_mul_s16 / dsps_add_s16, PIE SIMD on the ESP32-S3). The counts are
+ * first gathered into aligned per-axis arrays so the vector routines see
+ * unit stride. The portable loop computes the same values.
+ *
+ * fastAtan2() replaces atan2() for the posture angles (max error 1.2e-5 rad).
+ */
+
+#ifndef FALL_MATH_ESP_DSP
+#define FALL_MATH_ESP_DSP 0
+#endif
+
+#if FALL_MATH_ESP_DSP
+#include "esp_dsp.h"
+#endif
+
+class FallMath {
+public:
+  struct MotionSquares {
+    float svmSq;   // Acceleration magnitude squared (g²)
+    float gyroSq;  // Angular velocity magnitude squared ((°/s)²)
+  };
+
+  static const int Q_SHIFT = 17;
+  static const int CHUNK = 16;  // Samples per kernel pass (stack scratch)
+
+  static constexpr float GRAVITY = 9.80665f;
+  static constexpr float ACCEL_Q_SCALE = (float)(1 << Q_SHIFT) / (IMU_ACCEL_LSB_PER_G * IMU_ACCEL_LSB_PER_G);
+  static constexpr float GYRO_Q_SCALE = (float)(1 << Q_SHIFT) / (IMU_GYRO_LSB_PER_DPS * IMU_GYRO_LSB_PER_DPS);
+
+  // Three full-scale axes, each squared and shifted, must add up in int16
+  static_assert(3 * ((32768L * 32768L) >> Q_SHIFT) <= 32767, "Q_SHIFT too small for the int16 kernel");
+
+  /**
+   * Squared magnitudes of one converted reading
+   */
+  static MotionSquares motionSquares(const ImuData& d) {
+    const float k = 1.0f / (GRAVITY * GRAVITY);
+    MotionSquares m;
+    m.svmSq = (d.accelX * d.accelX + d.accelY * d.accelY + d.accelZ * d.accelZ) * k;
+    m.gyroSq = d.gyroX * d.gyroX + d.gyroY * d.gyroY + d.gyroZ * d.gyroZ;
+    return m;
+  }
+
+  /**
+   * Squared magnitudes of a batch of raw samples (integer kernel)
+   *
+   * @param samples FIFO samples with raw counts
+   * @param count Number of samples
+   * @param out Destination, count entries
+   */
+  static void motionSquares(const ImuSample* samples, int count, MotionSquares* out) {
+    alignas(16) int16_t axis[6][CHUNK];
+    alignas(16) int16_t accelQ[CHUNK];
+    alignas(16) int16_t gyroQ[CHUNK];
+
+    for (int base = 0; base < count; base += CHUNK) {
+      int n = count - base < CHUNK ? count - base : CHUNK;
+
+      for (int i = 0; i < n; i++) {
+        const ImuSample& s = samples[base + i];
+        axis[0][i] = s.accelRaw[0];
+        axis[1][i] = s.accelRaw[1];
+        axis[2][i] = s.accelRaw[2];
+        axis[3][i] = s.gyroRaw[0];
+        axis[4][i] = s.gyroRaw[1];
+        axis[5][i] = s.gyroRaw[2];
+      }
+
+      sumOfSquares(axis[0], axis[1], axis[2], accelQ, n);
+      sumOfSquares(axis[3], axis[4], axis[5], gyroQ, n);
+
+      for (int i = 0; i < n; i++) {
+        out[base + i].svmSq = accelQ[i] * ACCEL_Q_SCALE;
+        out[base + i].gyroSq = gyroQ[i] * GYRO_Q_SCALE;
+      }
+    }
+  }
+
+  /**
+   * atan2 by octant reduction and a 9th-order odd polynomial on [0, 1]
+   *
+   * @return Angle in radians, -PI..PI
+   */
+  static float fastAtan2(float y, float x) {
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    float mx = ax > ay ? ax : ay;
+    if (mx == 0.0f) return 0.0f;
+    float z = (ax > ay ? ay : ax) / mx;
+    float z2 = z * z;
+    float r = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+    if (ay > ax) r = 1.57079633f - r;
+    if (x < 0) r = 3.14159265f - r;
+    return y < 0 ? -r : r;
+  }
+
+private:
+  // out[i] = (x² >> 17) + (y² >> 17) + (z² >> 17)
+  static void sumOfSquares(const int16_t* x, const int16_t* y, const int16_t* z, int16_t* out, int n) {
+#if FALL_MATH_ESP_DSP
+    alignas(16) int16_t tmp[CHUNK];
+    dsps_mul_s16(x, x, out, n, 1, 1, 1, Q_SHIFT);
+    dsps_mul_s16(y, y, tmp, n, 1, 1, 1, Q_SHIFT);
+    dsps_add_s16(out, tmp, out, n, 1, 1, 1, 0);
+    dsps_mul_s16(z, z, tmp, n, 1, 1, 1, Q_SHIFT);
+    dsps_add_s16(out, tmp, out, n, 1, 1, 1, 0);
+#else
+    for (int i = 0; i < n; i++) {
+      out[i] = (int16_t)((((int32_t)x[i] * x[i]) >> Q_SHIFT) +
+                         (((int32_t)y[i] * y[i]) >> Q_SHIFT) +
+                         (((int32_t)z[i] * z[i]) >> Q_SHIFT));
+    }
+#endif
+  }
+};
+
+#endif
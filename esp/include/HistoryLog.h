@@ -0,0 +1,222 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * HistoryLog - Minute summaries of the vitals and fall events, kept on the
+ * wearable until the gateway has acknowledged them
+ *
+ * addReading() folds each realtime reading into the open summary: average
+ * heart rate (over readings with a pulse) and temperatures, peak noise, the
+ * most severe fall state and every alert flag seen. The first reading
+ * intervalS or more after the summary opened closes it and opens the next;
+ * the record carries the time it closed, so records stay in time order.
+ * addEvent() writes a fall event as its own record at once, marked with
+ * EVENT_FLAG.
+ *
+ * Records are numbered with a 32-bit sequence and kept in a ring whose
+ * storage the caller provides (PSRAM when fitted). When the ring is full
+ * the oldest record is overwritten and counted as dropped, acknowledged
+ * or not. The radio task uploads the log oldest first (Packet Type 0x0A):
+ * peek() copies records from the oldest unacknowledged one, acknowledge()
+ * releases them once the gateway has ACKed the page.
+ *
+ * All methods belong to the radio task; the counters may be read from
+ * anywhere.
+ */
+class HistoryLog {
+public:
+  static const uint8_t EVENT_FLAG = 0x80;  // Status bit 7 (fall state uses bits 4-6)
+
+  struct Record {
+    uint32_t time;         // Seconds since boot: end of the summary, or the event
+    uint8_t bpm;           // 0 = no pulse during the minute
+    uint8_t bodyTemp;      // Encoded as in the 0x01 payload
+    uint8_t ambientTemp;
+    uint8_t noise;         // Peak dB
+    uint8_t status;        // Fall state (high nibble) | alert flags (low nibble) | EVENT_FLAG
+  };
+
+private:
+  Record* records;
+  uint32_t capacity;
+  uint32_t intervalS;
+  uint32_t head;           // Sequence of the next record
+  uint32_t acked;          // Sequence of the oldest unacknowledged record
+  uint32_t dropped;
+
+  // Summary being collected
+  bool summaryOpen;
+  uint32_t summaryStart;
+  uint16_t readings;
+  uint16_t pulseReadings;
+  uint32_t bpmSum;
+  uint32_t bodySum;
+  uint32_t ambientSum;
+  uint8_t noiseMax;
+  uint8_t state;
+  uint8_t flags;
+
+  /**
+   * Fall state ordered by how much it matters to a clinician
+   * (0=Normal, 1=Warning, 4=Recovery, 2=Fall, 3=Dangerous)
+   */
+  static uint8_t severity(uint8_t fallState) {
+    static const uint8_t rank[5] = {0, 1, 3, 4, 2};
+    return fallState < 5 ? rank[fallState] : 0;
+  }
+
+  void append(const Record& r) {
+    if (capacity == 0) return;
+    if (head - acked == capacity) {
+      acked++;
+      dropped++;
+    }
+    records[head % capacity] = r;
+    head++;
+  }
+
+  void closeSummary(uint32_t nowS) {
+    Record r;
+    r.time = nowS;
+    r.bpm = pulseReadings > 0 ? (uint8_t)((bpmSum + pulseReadings / 2) / pulseReadings) : 0;
+    r.bodyTemp = (uint8_t)((bodySum + readings / 2) / readings);
+    r.ambientTemp = (uint8_t)((ambientSum + readings / 2) / readings);
+    r.noise = noiseMax;
+    r.status = (uint8_t)(state << 4) | flags;
+    append(r);
+    summaryOpen = false;
+  }
+
+public:
+  HistoryLog() {
+    records = nullptr;
+    capacity = 0;
+    intervalS = 60;
+    head = 0;
+    acked = 0;
+    dropped = 0;
+    summaryOpen = false;
+    summaryStart = 0;
+    readings = 0;
+    pulseReadings = 0;
+    bpmSum = 0;
+    bodySum = 0;
+    ambientSum = 0;
+    noiseMax = 0;
+    state = 0;
+    flags = 0;
+  }
+
+  /**
+   * Attach the ring storage (capacity 0 keeps the log disabled)
+   * @param summaryIntervalS Seconds covered by one summary record
+   */
+  void begin(Record* storage, uint32_t recordCapacity, uint32_t summaryIntervalS) {
+    records = storage;
+    capacity = storage != nullptr ? recordCapacity : 0;
+    intervalS = summaryIntervalS > 0 ? summaryIntervalS : 1;
+  }
+
+  /**
+   * Fold one realtime reading into the current summary
+   * @param status Fall state (high nibble) | alert flags (low nibble)
+   */
+  void addReading(uint32_t nowMs, uint8_t bpm, uint8_t bodyTemp, uint8_t ambientTemp,
+                  uint8_t noise, uint8_t status) {
+    uint32_t nowS = nowMs / 1000;
+    if (summaryOpen && nowS - summaryStart >= intervalS) closeSummary(nowS);
+    if (!summaryOpen) {
+      summaryOpen = true;
+      summaryStart = nowS;
+      readings = 0;
+      pulseReadings = 0;
+      bpmSum = 0;
+      bodySum = 0;
+      ambientSum = 0;
+      noiseMax = 0;
+      state = 0;
+      flags = 0;
+    }
+
+    readings++;
+    if (bpm > 0) {
+      pulseReadings++;
+      bpmSum += bpm;
+    }
+    bodySum += bodyTemp;
+    ambientSum += ambientTemp;
+    if (noise > noiseMax) noiseMax = noise;
+    uint8_t fallState = (status >> 4) & 0x07;
+    if (severity(fallState) > severity(state)) state = fallState;
+    flags |= status & 0x0F;
+  }
+
+  /**
+   * Record a fall event with the vitals at that moment
+   */
+  void addEvent(uint32_t nowMs, uint8_t bpm, uint8_t bodyTemp, uint8_t ambientTemp,
+                uint8_t noise, uint8_t status) {
+    Record r;
+    r.time = nowMs / 1000;
+    r.bpm = bpm;
+    r.bodyTemp = bodyTemp;
+    r.ambientTemp = ambientTemp;
+    r.noise = noise;
+    r.status = (status & 0x7F) | EVENT_FLAG;
+    append(r);
+  }
+
+  /**
+   * Copy records starting at a sequence (clamped to the oldest kept one)
+   * @return Records copied
+   */
+  int peek(uint32_t fromSeq, Record* out, int max) const {
+    if ((int32_t)(fromSeq - acked) < 0) fromSeq = acked;
+    int count = 0;
+    while (count < max && fromSeq + count != head) {
+      out[count] = records[(fromSeq + count) % capacity];
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * Release every record before a sequence (the gateway has them)
+   */
+  void acknowledge(uint32_t untilSeq) {
+    if ((int32_t)(untilSeq - acked) > 0 && (int32_t)(head - untilSeq) >= 0) {
+      acked = untilSeq;
+    }
+  }
+
+  /**
+   * Sequence of the oldest unacknowledged record
+   */
+  uint32_t oldest() const {
+    return acked;
+  }
+
+  /**
+   * Records waiting for an acknowledgement
+   */
+  uint32_t pending() const {
+    return head - acked;
+  }
+
+  uint32_t getCapacity() const {
+    return capacity;
+  }
+
+  uint32_t getRecordCount() const {
+    return head;
+  }
+
+  uint32_t getDroppedCount() const {
+    return dropped;
+  }
+};
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <driver/i2c.h>
+#include <freertos/semphr.h>
+
+/**
+ * I2cBus - Shared I2C master with per-device clocks and queued transfers
+ *
+ * Owns one I2C port through the ESP-IDF master driver (Wire is not used).
+ * Drivers queue requests - one or more accesses to a device, each a write
+ * followed by an optional repeated-START read - and a bus task runs them:
+ * - every device has its own clock, so a Fast mode sensor is not held to
+ *   the pace of an SMBus one on the same wires (the clock is switched
+ *   between command links)
+ * - HIGH priority requests (the IMU) go ahead of queued LOW ones (the
+ *   IR thermometer)
+ * - requests queued back to back at the same clock are merged into one
+ *   command link, i.e. one driver call and one interrupt-driven run of
+ *   the controller instead of one per access; a merged link that fails
+ *   is run again one request at a time so each gets its own result
+ *
+ * submit() returns at once and the completion callback runs in the bus
+ * task (keep it short, it holds up the next transfer); transfer() waits.
+ * Reads have no length limit (Wire stops at its 128-byte buffer).
+ *
+ * Fast-mode Plus (1 MHz) is not offered: the ESP32-S3 controller tops out
+ * at 800 kHz and neither the MPU6050 (400 kHz) nor the MLX90614 (SMBus,
+ * 100 kHz) supports it.
+ */
+class I2cBus {
+public:
+  static const uint32_t STANDARD_HZ = 100000;   // Standard mode / SMBus
+  static const uint32_t FAST_HZ = 400000;       // Fast mode
+
+  enum Priority {
+    PRIORITY_HIGH,
+    PRIORITY_LOW,
+    PRIORITY_COUNT
+  };
+
+  struct Device {
+    uint8_t address;
+    uint32_t clockHz;
+  };
+
+  static const uint8_t TX_MAX = 4;      // Register address + data, copied into the request
+  static const uint8_t OPS_MAX = 2;     // Accesses per request
+
+  /**
+   * One access: write tx, then read rxLen bytes after a repeated START
+   * (both may be empty - an empty access only addresses the device)
+   */
+  struct Op {
+    uint8_t tx[TX_MAX];
+    uint8_t txLen;
+    uint8_t* rx;          // Must stay valid until the request completes
+    uint16_t rxLen;
+  };
+
+  typedef void (*Callback)(void* ctx, esp_err_t result);
+
+  /**
+   * Read registers from reg on
+   */
+  static Op readOp(uint8_t reg, uint8_t* rx, uint16_t rxLen) {
+    Op op = {};
+    op.tx[0] = reg;
+    op.txLen = 1;
+    op.rx = rx;
+    op.rxLen = rxLen;
+    return op;
+  }
+
+  /**
+   * Write one register
+   */
+  static Op writeOp(uint8_t reg, uint8_t value) {
+    Op op = {};
+    op.tx[0] = reg;
+    op.tx[1] = value;
+    op.txLen = 2;
+    return op;
+  }
+
+private:
+  static const int QUEUE_DEPTH = 8;       // Requests per priority
+  static const int MERGE_MAX = 4;         // Requests per command link
+  static const uint32_t TIMEOUT_MS = 50;  // Per command link (clock stretching included)
+
+  struct Request {
+    Device device;
+    Op ops[OPS_MAX];
+    uint8_t opCount;
+    Callback callback;
+    void* ctx;
+    SemaphoreHandle_t done;   // transfer(): given with the result written
+    esp_err_t* result;
+  };
+
+  i2c_port_t port;
+  i2c_config_t config;
+  uint32_t currentHz;
+  QueueHandle_t queues[PRIORITY_COUNT];
+  SemaphoreHandle_t pending;     // Counts queued requests over both queues
+  TaskHandle_t task;
+  bool running;
+  uint32_t outstanding;          // Requests queued or running (atomic)
+
+  // Bus task only
+  Request batch[MERGE_MAX];
+  uint8_t link[I2C_LINK_RECOMMENDED_SIZE(MERGE_MAX * OPS_MAX)];
+
+  // Statistics
+  uint32_t requests;
+  uint32_t links;
+  uint32_t errors;
+
+  /**
+   * Take the next queued request, HIGH first
+   * (the caller holds one count of pending for it)
+   */
+  bool take(Request& out) {
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      if (xQueueReceive(queues[p], &out, 0) == pdTRUE) return true;
+    }
+    return false;
+  }
+
+  /**
+   * Take another request for the link if the next one runs at this clock
+   */
+  bool takeMatching(uint32_t clockHz, Request& out) {
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      Request next;
+      if (xQueuePeek(queues[p], &next, 0) != pdTRUE) continue;
+      if (next.device.clockHz != clockHz) return false;
+      if (xSemaphoreTake(pending, 0) != pdTRUE) return false;
+      return xQueueReceive(queues[p], &out, 0) == pdTRUE;
+    }
+    return false;
+  }
+
+  void setClock(uint32_t clockHz) {
+    if (clockHz == currentHz) return;
+    config.master.clk_speed = clockHz;
+    i2c_param_config(port, &config);
+    currentHz = clockHz;
+  }
+
+  /**
+   * Run requests as one command link
+   */
+  esp_err_t run(const Request* reqs, int count) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+    if (cmd == nullptr) return ESP_ERR_NO_MEM;
+
+    esp_err_t err = ESP_OK;
+    for (int r = 0; r < count && err == ESP_OK; r++) {
+      const Request& req = reqs[r];
+      for (int o = 0; o < req.opCount && err == ESP_OK; o++) {
+        const Op& op = req.ops[o];
+        err = i2c_master_start(cmd);
+        if (err == ESP_OK) err = i2c_master_write_byte(cmd, (req.device.address << 1) | I2C_MASTER_WRITE, true);
+        if (err == ESP_OK && op.txLen > 0) err = i2c_master_write(cmd, op.tx, op.txLen, true);
+        if (err == ESP_OK && op.rxLen > 0) {
+          err = i2c_master_start(cmd);  // Repeated START
+          if (err == ESP_OK) err = i2c_master_write_byte(cmd, (req.device.address << 1) | I2C_MASTER_READ, true);
+          if (err == ESP_OK) err = i2c_master_read(cmd, op.rx, op.rxLen, I2C_MASTER_LAST_NACK);
+        }
+      }
+      if (err == ESP_OK) err = i2c_master_stop(cmd);
+    }
+
+    if (err == ESP_OK) {
+      setClock(reqs[0].device.clockHz);
+      err = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(TIMEOUT_MS));
+      links++;
+    }
+    i2c_cmd_link_delete_static(cmd);
+    return err;
+  }
+
+  static void complete(const Request& req, esp_err_t result) {
+    if (req.result != nullptr) *req.result = result;
+    if (req.callback != nullptr) req.callback(req.ctx, result);
+    if (req.done != nullptr) xSemaphoreGive(req.done);
+  }
+
+  /**
+   * Bus task - merges and runs queued requests
+   */
+  static void busTask(void* arg) {
+    I2cBus* self = static_cast<I2cBus*>(arg);
+
+    for (;;) {
+      xSemaphoreTake(self->pending, portMAX_DELAY);
+      if (!self->take(self->batch[0])) continue;
+
+      int count = 1;
+      while (count < MERGE_MAX && self->takeMatching(self->batch[0].device.clockHz, self->batch[count])) {
+        count++;
+      }
+
+      esp_err_t err = self->run(self->batch, count);
+      if (err != ESP_OK && count > 1) {
+        // Find out which request failed
+        for (int i = 0; i < count; i++) {
+          esp_err_t own = self->run(&self->batch[i], 1);
+          if (own != ESP_OK) self->errors++;
+          complete(self->batch[i], own);
+        }
+      } else {
+        if (err != ESP_OK) self->errors++;
+        for (int i = 0; i < count; i++) complete(self->batch[i], err);
+      }
+      self->requests += count;
+      __atomic_sub_fetch(&self->outstanding, (uint32_t)count, __ATOMIC_SEQ_CST);
+    }
+  }
+
+  bool enqueue(const Device& device, const Op* ops, uint8_t opCount, Callback callback, void* ctx,
+               SemaphoreHandle_t done, esp_err_t* result, Priority priority, TickType_t wait) {
+    if (!running || opCount == 0 || opCount > OPS_MAX || priority >= PRIORITY_COUNT) return false;
+
+    Request req;
+    req.device = device;
+    for (uint8_t i = 0; i < opCount; i++) req.ops[i] = ops[i];
+    req.opCount = opCount;
+    req.callback = callback;
+    req.ctx = ctx;
+    req.done = done;
+    req.result = result;
+    __atomic_add_fetch(&outstanding, 1, __ATOMIC_SEQ_CST);
+    if (xQueueSend(queues[priority], &req, wait) != pdTRUE) {
+      __atomic_sub_fetch(&outstanding, 1, __ATOMIC_SEQ_CST);
+      return false;
+    }
+    xSemaphoreGive(pending);
+    return true;
+  }
+
+public:
+  I2cBus() {
+    port = I2C_NUM_0;
+    config = {};
+    currentHz = 0;
+    for (int p = 0; p < PRIORITY_COUNT; p++) queues[p] = nullptr;
+    pending = nullptr;
+    task = nullptr;
+    running = false;
+    outstanding = 0;
+    requests = 0;
+    links = 0;
+    errors = 0;
+  }
+
+  /**
+   * Install the driver and start the bus task
+   * @param priority Bus task priority - above every task that queues
+   *                 requests (it blocks on the driver for each transfer)
+   * @param core Core the bus task is pinned to
+   * @return true if the bus is running
+   */
+  bool begin(int sda, int scl, UBaseType_t priority, BaseType_t core) {
+    if (running) return true;
+
+    config.mode = I2C_MODE_MASTER;
+    config.sda_io_num = sda;
+    config.scl_io_num = scl;
+    config.sda_pullup_en = GPIO_PULLUP_ENABLE;
+    config.scl_pullup_en = GPIO_PULLUP_ENABLE;
+    config.master.clk_speed = STANDARD_HZ;
+    if (i2c_param_config(port, &config) != ESP_OK) return false;
+    if (i2c_driver_install(port, I2C_MODE_MASTER, 0, 0, 0) != ESP_OK) return false;
+    currentHz = STANDARD_HZ;
+
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      queues[p] = xQueueCreate(QUEUE_DEPTH, sizeof(Request));
+    }
+    pending = xSemaphoreCreateCounting(QUEUE_DEPTH * PRIORITY_COUNT, 0);
+    if (queues[PRIORITY_HIGH] == nullptr || queues[PRIORITY_LOW] == nullptr || pending == nullptr) {
+      i2c_driver_delete(port);
+      return false;
+    }
+
+    if (xTaskCreatePinnedToCore(busTask, "i2c", 3072, this, priority, &task, core) != pdPASS) {
+      i2c_driver_delete(port);
+      return false;
+    }
+    running = true;
+    return true;
+  }
+
+  /**
+   * Queue a request and return
+   * @param callback Called from the bus task when it is done (may be null)
+   * @return false if the queue for this priority is full
+   */
+  bool submit(const Device& device, const Op* ops, uint8_t opCount, Callback callback, void* ctx,
+              Priority priority = PRIORITY_LOW) {
+    return enqueue(device, ops, opCount, callback, ctx, nullptr, nullptr, priority, 0);
+  }
+
+  /**
+   * Queue a request and wait for it (not from a completion callback)
+   */
+  esp_err_t transfer(const Device& device, const Op* ops, uint8_t opCount,
+                     Priority priority = PRIORITY_LOW) {
+    StaticSemaphore_t doneBuffer;
+    SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&doneBuffer);
+    esp_err_t result = ESP_FAIL;
+    if (!enqueue(device, ops, opCount, nullptr, nullptr, done, &result, priority, portMAX_DELAY)) {
+      vSemaphoreDelete(done);
+      return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+    return result;
+  }
+
+  esp_err_t writeRegister(const Device& device, uint8_t reg, uint8_t value,
+                          Priority priority = PRIORITY_LOW) {
+    Op op = writeOp(reg, value);
+    return transfer(device, &op, 1, priority);
+  }
+
+  esp_err_t readRegisters(const Device& device, uint8_t reg, uint8_t* rx, uint16_t rxLen,
+                          Priority priority = PRIORITY_LOW) {
+    Op op = readOp(reg, rx, rxLen);
+    return transfer(device, &op, 1, priority);
+  }
+
+  /**
+   * Whether a device acknowledges its address
+   */
+  bool probe(uint8_t address) {
+    Device device = {address, STANDARD_HZ};
+    Op op = {};
+    return transfer(device, &op, 1) == ESP_OK;
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+
+  /**
+   * No request queued or on the wires (before light sleep, which would
+   * stop SCL in the middle of a transfer - the MLX90614 resets after an
+   * SMBus timeout)
+   */
+  bool isIdle() const {
+    return __atomic_load_n(&outstanding, __ATOMIC_SEQ_CST) == 0;
+  }
+
+  uint32_t getRequestCount() const {
+    return requests;
+  }
+
+  /**
+   * Command links run (requests / links is the merge ratio)
+   */
+  uint32_t getLinkCount() const {
+    return links;
+  }
+
+  uint32_t getErrorCount() const {
+    return errors;
+  }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef IMU_DATA_H
+#define IMU_DATA_H
+
+#include <stdint.h>
+
+/**
+ * ImuData - One accelerometer + gyroscope reading
+ *
+ * Shared by the MPU6050 driver (MPU6050::SensorData) and the fall detector,
+ * so the detector builds without the driver (see bench/).
+ */
+struct ImuData {
+  float accelX, accelY, accelZ;  // Acceleration in m/s²
+  float gyroX, gyroY, gyroZ;     // Rotation rate in °/s
+};
+
+/**
+ * Mpu6050Range - MPU6050 full-scale selection and the conversions it implies
+ *
+ * AFS_SEL 0-3 selects ±2 / 4 / 8 / 16 g, FS_SEL 0-3 ±250 / 500 / 1000 /
+ * 2000 °/s. The register values and scales are compile-time constants, so
+ * the driver's per-sample conversion is one multiply per axis.
+ */
+template <uint8_t AFS_SEL, uint8_t FS_SEL>
+struct Mpu6050Range {
+  static_assert(AFS_SEL <= 3, "MPU6050 AFS_SEL is 0-3");
+  static_assert(FS_SEL <= 3, "MPU6050 FS_SEL is 0-3");
+
+  static constexpr uint8_t ACCEL_CONFIG = AFS_SEL << 3;  // REG_ACCEL_CONFIG range bits
+  static constexpr uint8_t GYRO_CONFIG = FS_SEL << 3;    // REG_GYRO_CONFIG range bits
+  static constexpr float ACCEL_LSB_PER_G = 16384.0f / (1 << AFS_SEL);
+  static constexpr float GYRO_LSB_PER_DPS =
+    FS_SEL == 0 ? 131.0f : FS_SEL == 1 ? 65.5f : FS_SEL == 2 ? 32.8f : 16.4f;
+  static constexpr float ACCEL_MS2_PER_LSB = 9.80665f / ACCEL_LSB_PER_G;
+  static constexpr float GYRO_DPS_PER_LSB = 1.0f / GYRO_LSB_PER_DPS;
+
+  static constexpr float accelMs2(int16_t counts) {
+    return counts * ACCEL_MS2_PER_LSB;
+  }
+
+  static constexpr float gyroDps(int16_t counts) {
+    return counts * GYRO_DPS_PER_LSB;
+  }
+};
+
+// Configured ranges: ±2 g, ±250 °/s (the fall thresholds are tuned for them)
+typedef Mpu6050Range<0, 0> ImuRange;
+
+// MPU6050 raw count scales for the configured ranges
+constexpr float IMU_ACCEL_LSB_PER_G = ImuRange::ACCEL_LSB_PER_G;
+constexpr float IMU_GYRO_LSB_PER_DPS = ImuRange::GYRO_LSB_PER_DPS;
+
+/**
+ * ImuSample - FIFO sample: converted reading, raw counts and sample time
+ *
+ * The raw counts feed the integer magnitude kernel in FallMath.h; the
+ * timestamp uses the esp_timer_get_time() time base.
+ */
+struct ImuSample {
+  ImuData data;
+  int16_t accelRaw[3];  // X, Y, Z counts
+  int16_t gyroRaw[3];
+  int64_t timestamp_us;
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+#include <freertos/task.h>
+#endif
+
+/**
+ * Log - Leveled, non-blocking serial logging
+ *
+ * Everything printed through the global `Log` stream is copied into a
+ * FreeRTOS byte ring buffer and written to the serial port by a low
+ * priority drain task, so a slow USB-CDC host can never stall a sensor or
+ * radio task. When the ring is full the text is dropped (and counted), not
+ * waited for.
+ *
+ * Each module has a runtime level (setLevel). LOG_LEVEL is the compile-time
+ * ceiling: LOG_E/W/I/D/V above it expand to nothing, and blocks guarded by
+ * LOG_ENABLED() become dead code, so a production build (-DLOG_LEVEL=...)
+ * carries neither the format strings nor the formatting cost.
+ *
+ * If the ring or the drain task cannot be created, begin() leaves the stream
+ * writing straight to its output. Native (host) builds always write straight
+ * through.
+ */
+
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+#define LOG_LEVEL_VERBOSE 5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+enum LogModule : uint8_t {
+  LOG_SYS,   // Boot, tasks, status report
+  LOG_IMU,   // MPU6050
+  LOG_FALL,  // Fall detector
+  LOG_ECG,   // AD8232 / ECG pipeline
+  LOG_TEMP,  // MLX90614
+  LOG_MIC,   // MAX4466 noise level
+  LOG_LORA,  // Radio, payloads, airtime
+  LOG_MODULE_COUNT
+};
+
+class LogStream : public Print {
+public:
+  static const size_t LINE_MAX = 160;  // Longest formatted log() line
+
+private:
+  Print* out;
+#ifdef ARDUINO
+  RingbufHandle_t ring;
+#else
+  void* ring;  // Always null - no drain task on the host
+#endif
+  size_t capacity;
+  volatile uint32_t dropped;
+  uint8_t levels[LOG_MODULE_COUNT];
+
+#ifdef ARDUINO
+  static void drainTask(void* arg) {
+    LogStream* self = static_cast<LogStream*>(arg);
+    for (;;) {
+      size_t len = 0;
+      uint8_t* chunk = (uint8_t*)xRingbufferReceiveUpTo(self->ring, &len, portMAX_DELAY, 256);
+      if (chunk != nullptr) {
+        self->out->write(chunk, len);
+        vRingbufferReturnItem(self->ring, chunk);
+      }
+    }
+  }
+#endif
+
+  static char levelTag(uint8_t level) {
+    static const char tags[] = "-EWIDV";
+    return level <= LOG_LEVEL_VERBOSE ? tags[level] : '?';
+  }
+
+  static const char* moduleName(LogModule module) {
+    static const char* const names[LOG_MODULE_COUNT] = {
+      "SYS", "IMU", "FALL", "ECG", "TEMP", "MIC", "LORA"
+    };
+    return module < LOG_MODULE_COUNT ? names[module] : "?";
+  }
+
+public:
+  LogStream() {
+    out = nullptr;
+    ring = nullptr;
+    capacity = 0;
+    dropped = 0;
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) levels[i] = LOG_LEVEL;
+  }
+
+  /**
+   * Start buffered output
+   * @param output Destination (normally Serial, already begun)
+   * @param bufferSize Ring buffer size in bytes
+   * @param priority Drain task priority (keep below the sensor tasks)
+   * @param core Core for the drain task
+   * @return true if the ring and drain task were created
+   */
+  bool begin(Print& output, size_t bufferSize, unsigned priority, int core) {
+    out = &output;
+#ifdef ARDUINO
+    if (ring != nullptr) return true;
+
+    RingbufHandle_t created = xRingbufferCreate(bufferSize, RINGBUF_TYPE_BYTEBUF);
+    if (created == nullptr) return false;
+
+    capacity = bufferSize;
+    ring = created;
+    if (xTaskCreatePinnedToCore(drainTask, "log", 3072, this, priority, nullptr, core) != pdPASS) {
+      vRingbufferDelete(created);
+      ring = nullptr;  // Fall back to direct writes
+      return false;
+    }
+    return true;
+#else
+    (void)bufferSize;  // Host builds write directly
+    (void)priority;
+    (void)core;
+    return false;
+#endif
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* data, size_t len) override {
+    if (out == nullptr || len == 0) return 0;
+    if (ring == nullptr) return out->write(data, len);
+
+#ifdef ARDUINO
+    if (xRingbufferSend(ring, data, len, 0) != pdTRUE) {
+      dropped += len;
+      return 0;
+    }
+#endif
+    return len;
+  }
+
+  /**
+   * Wait (up to timeoutMs) for the ring to drain, e.g. before a restart
+   */
+  void flush() override {
+    flush(500);
+  }
+
+  void flush(uint32_t timeoutMs) {
+#ifdef ARDUINO
+    if (ring != nullptr) {
+      unsigned long start = millis();
+      while (xRingbufferGetCurFreeSize(ring) < capacity && millis() - start < timeoutMs) {
+        vTaskDelay(pdMS_TO_TICKS(2));
+      }
+    }
+#else
+    (void)timeoutMs;
+#endif
+    if (out != nullptr) out->flush();
+  }
+
+  void setLevel(LogModule module, uint8_t level) {
+    if (module < LOG_MODULE_COUNT) levels[module] = level;
+  }
+
+  void setLevelAll(uint8_t level) {
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) levels[i] = level;
+  }
+
+  bool enabled(LogModule module, uint8_t level) const {
+    return module < LOG_MODULE_COUNT && level <= levels[module];
+  }
+
+  /**
+   * Format one tagged line, e.g. "[W][LORA] Budget exhausted"
+   */
+  void log(LogModule module, uint8_t level, const char* format, ...) __attribute__((format(printf, 4, 5))) {
+    char line[LINE_MAX];
+    int len = snprintf(line, sizeof(line), "[%c][%s] ", levelTag(level), moduleName(module));
+
+    va_list args;
+    va_start(args, format);
+    int body = vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+    va_end(args);
+
+    if (body < 0) body = 0;
+    len += body;
+    if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+    line[len++] = '\n';
+    write((const uint8_t*)line, len);
+  }
+
+  /**
+   * Bytes discarded because the ring was full
+   */
+  uint32_t droppedBytes() const {
+    return dropped;
+  }
+};
+
+extern LogStream Log;
+
+// Guard for multi-line dumps; constant false above the compile-time level
+#define LOG_ENABLED(module, level) (LOG_LEVEL >= (level) && Log.enabled((module), (level)))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(module, ...) do { if (Log.enabled((module), LOG_LEVEL_ERROR)) Log.log((module), LOG_LEVEL_ERROR, __VA_ARGS__); } while (0)
+#else
+#define LOG_E(module, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(module, ...) do { if (Log.enabled((module), LOG_LEVEL_WARN)) Log.log((module), LOG_LEVEL_WARN, __VA_ARGS__); } while (0)
+#else
+#define LOG_W(module, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(module, ...) do { if (Log.enabled((module), LOG_LEVEL_INFO)) Log.log((module), LOG_LEVEL_INFO, __VA_ARGS__); } while (0)
+#else
+#define LOG_I(module, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(module, ...) do { if (Log.enabled((module), LOG_LEVEL_DEBUG)) Log.log((module), LOG_LEVEL_DEBUG, __VA_ARGS__); } while (0)
+#else
+#define LOG_D(module, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_V(module, ...) do { if (Log.enabled((module), LOG_LEVEL_VERBOSE)) Log.log((module), LOG_LEVEL_VERBOSE, __VA_ARGS__); } while (0)
+#else
+#define LOG_V(module, ...) do {} while (0)
+#endif
+
+#endif
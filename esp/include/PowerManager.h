@@ -0,0 +1,129 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "FallMath.h"
+#include "FallDetector.h"
+
+/**
+ * PowerManager - Activity-dependent power mode for the wearable
+ *
+ * ACTIVE is the full-rate mode: the IMU task wakes on every FIFO batch and
+ * the CPU runs at full clock. After the wearer has been still for
+ * quietAfterMs with the fall detector in NORMAL, the manager switches to
+ * QUIET. The IMU task then lowers the MPU6050 output rate (the fall
+ * detector scales its counters and jerk thresholds to it), wakes only on
+ * the motion interrupt or a slow drain timer, and light-sleeps in between
+ * once the ADC stream is paused; the other tasks stretch their poll
+ * intervals.
+ *
+ * Any sample that is not still, any fall state other than NORMAL, or a
+ * motion interrupt (wake()) returns to ACTIVE on the spot, and the IMU
+ * task restores the full output rate and CPU clock before the next batch.
+ * The ECG keeps its 100 Hz rate in both modes (QRS delineation is tuned
+ * for it); decimating it is a separate request.
+ *
+ * update() and wake() belong to the IMU task; the mode may be read from
+ * any task.
+ */
+class PowerManager {
+public:
+  enum Mode {
+    ACTIVE = 0,
+    QUIET = 1
+  };
+
+  // Stillness: magnitude within ±2.5% of 1 g and rotation below 10 °/s
+  float STILL_SVM_SQ_BAND = 0.05f;    // |svm² - 1| (g²)
+  float STILL_GYRO_SQ = 100.0f;       // (°/s)²
+
+private:
+  volatile Mode mode;
+  uint32_t quiet_after_ms;
+  int64_t still_since_us;    // First sample of the current still stretch (0 = moving)
+  int64_t quiet_since_us;
+  int64_t quiet_total_us;    // Completed QUIET stretches
+  uint32_t wakes;            // QUIET -> ACTIVE transitions
+
+  void enterActive(int64_t timestamp_us) {
+    if (mode == QUIET) {
+      quiet_total_us += timestamp_us - quiet_since_us;
+      wakes++;
+    }
+    mode = ACTIVE;
+  }
+
+public:
+  PowerManager() {
+    mode = ACTIVE;
+    quiet_after_ms = 30000;
+    still_since_us = 0;
+    quiet_since_us = 0;
+    quiet_total_us = 0;
+    wakes = 0;
+  }
+
+  /**
+   * Set how long the wearer must stay still before QUIET (0 = never)
+   */
+  void begin(uint32_t quietAfterMs) {
+    quiet_after_ms = quietAfterMs;
+  }
+
+  /**
+   * Feed one sample
+   * @param m Squared magnitudes of the sample
+   * @param state Fall detector state after the sample
+   * @param timestamp_us Sample time (esp_timer_get_time() time base)
+   * @return Mode after the sample
+   */
+  Mode update(const FallMath::MotionSquares& m, FallDetector::FallState state, int64_t timestamp_us) {
+    float svmDev = m.svmSq - 1.0f;
+    bool still = state == FallDetector::NORMAL &&
+                 svmDev < STILL_SVM_SQ_BAND && svmDev > -STILL_SVM_SQ_BAND &&
+                 m.gyroSq < STILL_GYRO_SQ;
+
+    if (!still) {
+      still_since_us = 0;
+      enterActive(timestamp_us);
+      return mode;
+    }
+
+    if (still_since_us == 0) still_since_us = timestamp_us;
+    if (mode == ACTIVE && quiet_after_ms > 0 &&
+        timestamp_us - still_since_us >= (int64_t)quiet_after_ms * 1000) {
+      mode = QUIET;
+      quiet_since_us = timestamp_us;
+    }
+    return mode;
+  }
+
+  /**
+   * Motion interrupt - back to ACTIVE and restart the stillness timer
+   */
+  void wake(int64_t timestamp_us) {
+    still_since_us = 0;
+    enterActive(timestamp_us);
+  }
+
+  Mode getMode() const {
+    return mode;
+  }
+
+  bool isQuiet() const {
+    return mode == QUIET;
+  }
+
+  /**
+   * Time spent in QUIET, including the current stretch
+   */
+  int64_t quietTimeUs(int64_t now_us) const {
+    return quiet_total_us + (mode == QUIET ? now_us - quiet_since_us : 0);
+  }
+
+  uint32_t getWakeCount() const {
+    return wakes;
+  }
+};
+
+#endif
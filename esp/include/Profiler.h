@@ -0,0 +1,221 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * Profiler - Per-stage latency histograms for the firmware hot paths
+ *
+ * Each stage keeps count, min, max and the total duration plus a
+ * log-linear histogram (4 buckets per power of two, so percentiles are
+ * within 25%), from which p99 is estimated without storing samples. A
+ * stage also counts deadline misses - samples lost or late because the
+ * stage fell behind - reported by the caller through miss().
+ *
+ * Durations come from esp_timer_get_time() (1 us resolution, well under
+ * 1 us per probe). Recording takes a short critical section so stages fed
+ * from different tasks and cores can be read consistently by report().
+ *
+ * Build with -DPROFILING=0 to compile every PROFILE_SCOPE out.
+ */
+
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+class Profiler {
+public:
+  static const size_t MAX_STAGES = 8;
+  static const int BUCKETS = 64;  // 0-7 us exact, then 4 per octave; the last holds >= 114 ms
+
+  struct Summary {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t avgUs;
+    uint32_t p99Us;
+    uint32_t maxUs;
+    uint32_t misses;
+  };
+
+private:
+  struct Stage {
+    const char* name;
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t misses;
+    uint32_t histogram[BUCKETS];
+  };
+
+  Stage stages[MAX_STAGES];
+  portMUX_TYPE mux;
+  int64_t startUs;
+
+  static int bucketFor(uint32_t us) {
+    if (us < 8) return (int)us;
+    int octave = 31 - __builtin_clz(us);  // >= 3
+    int sub = (us >> (octave - 2)) & 3;
+    int bucket = 8 + (octave - 3) * 4 + sub;
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+  }
+
+  // Largest duration that falls in a bucket
+  static uint32_t bucketUpper(int bucket) {
+    if (bucket < 8) return (uint32_t)bucket;
+    int octave = (bucket - 8) / 4 + 3;
+    int sub = (bucket - 8) % 4;
+    return ((uint32_t)(4 + sub + 1) << (octave - 2)) - 1;
+  }
+
+  void clearStage(Stage& stage) {
+    stage.count = 0;
+    stage.minUs = UINT32_MAX;
+    stage.maxUs = 0;
+    stage.totalUs = 0;
+    stage.misses = 0;
+    for (int b = 0; b < BUCKETS; b++) stage.histogram[b] = 0;
+  }
+
+public:
+  Profiler() {
+    mux = portMUX_INITIALIZER_UNLOCKED;
+    startUs = 0;
+    for (size_t i = 0; i < MAX_STAGES; i++) {
+      stages[i].name = nullptr;
+      clearStage(stages[i]);
+    }
+  }
+
+  /**
+   * Name a stage (ids are chosen by the caller, 0..MAX_STAGES-1)
+   */
+  void defineStage(uint8_t id, const char* name) {
+    if (id < MAX_STAGES) stages[id].name = name;
+  }
+
+  /**
+   * Record one execution of a stage
+   */
+  void record(uint8_t id, uint32_t us) {
+    if (id >= MAX_STAGES) return;
+    int bucket = bucketFor(us);
+
+    portENTER_CRITICAL(&mux);
+    Stage& stage = stages[id];
+    stage.count++;
+    stage.totalUs += us;
+    if (us < stage.minUs) stage.minUs = us;
+    if (us > stage.maxUs) stage.maxUs = us;
+    stage.histogram[bucket]++;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  /**
+   * Count deadline misses (lost or late samples) against a stage
+   */
+  void miss(uint8_t id, uint32_t count = 1) {
+    if (id >= MAX_STAGES || count == 0) return;
+    portENTER_CRITICAL(&mux);
+    stages[id].misses += count;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  /**
+   * Snapshot one stage
+   */
+  Summary summary(uint8_t id) {
+    Summary s = {0, 0, 0, 0, 0, 0};
+    if (id >= MAX_STAGES) return s;
+
+    uint32_t histogram[BUCKETS];  // Copied under the lock, scanned outside
+    portENTER_CRITICAL(&mux);
+    const Stage& stage = stages[id];
+    s.count = stage.count;
+    s.minUs = stage.count > 0 ? stage.minUs : 0;
+    s.maxUs = stage.maxUs;
+    s.avgUs = stage.count > 0 ? (uint32_t)(stage.totalUs / stage.count) : 0;
+    s.misses = stage.misses;
+    for (int b = 0; b < BUCKETS; b++) histogram[b] = stage.histogram[b];
+    portEXIT_CRITICAL(&mux);
+
+    // p99: upper edge of the bucket holding the 99th percentile, capped at max
+    if (s.count > 0) {
+      uint32_t target = s.count - s.count / 100;
+      uint32_t seen = 0;
+      for (int b = 0; b < BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen >= target) {
+          s.p99Us = bucketUpper(b);
+          break;
+        }
+      }
+      if (s.p99Us > s.maxUs) s.p99Us = s.maxUs;
+    }
+    return s;
+  }
+
+  const char* stageName(uint8_t id) const {
+    return id < MAX_STAGES ? stages[id].name : nullptr;
+  }
+
+  /**
+   * Clear all statistics (names are kept)
+   */
+  void reset() {
+    portENTER_CRITICAL(&mux);
+    for (size_t i = 0; i < MAX_STAGES; i++) clearStage(stages[i]);
+    startUs = esp_timer_get_time();
+    portEXIT_CRITICAL(&mux);
+  }
+
+  /**
+   * Seconds covered by the current statistics
+   */
+  uint32_t windowSeconds() const {
+    return (uint32_t)((esp_timer_get_time() - startUs) / 1000000LL);
+  }
+
+  /**
+   * Print a table of all named stages
+   */
+  void report(Print& out) {
+    out.printf("\n⏱  PROFILE (%lu s)\n", (unsigned long)windowSeconds());
+    out.println("  stage         count      min      avg      p99      max   misses  (us)");
+    for (uint8_t id = 0; id < MAX_STAGES; id++) {
+      if (stages[id].name == nullptr) continue;
+      Summary s = summary(id);
+      out.printf("  %-11s %7lu %8lu %8lu %8lu %8lu %8lu\n", stages[id].name,
+                 (unsigned long)s.count, (unsigned long)s.minUs, (unsigned long)s.avgUs,
+                 (unsigned long)s.p99Us, (unsigned long)s.maxUs, (unsigned long)s.misses);
+    }
+  }
+};
+
+/**
+ * Scoped probe - records the time from construction to destruction
+ */
+class ProfileScope {
+  Profiler& profiler;
+  uint8_t stage;
+  int64_t start;
+
+public:
+  ProfileScope(Profiler& p, uint8_t id) : profiler(p), stage(id), start(esp_timer_get_time()) {}
+
+  ~ProfileScope() {
+    profiler.record(stage, (uint32_t)(esp_timer_get_time() - start));
+  }
+};
+
+#if PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, stage) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)((profiler), (stage))
+#else
+#define PROFILE_SCOPE(profiler, stage) do {} while (0)
+#endif
+
+#endif
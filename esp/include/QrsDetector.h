@@ -0,0 +1,291 @@
+#ifndef QRS_DETECTOR_H
+#define QRS_DETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WindowedStats.h"
+
+/**
+ * QrsDetector - Streaming Pan-Tompkins QRS detector (integer arithmetic)
+ *
+ * Fixed for 100 Hz input. Each sample passes through the classic chain:
+ *   band-pass  - low-pass FIR [1 2 3 2 1] (first zero at 33 Hz) followed by
+ *                a high-pass that subtracts a 16-sample moving average
+ *                (about 5 Hz), together delaying the signal by 10 samples
+ *   derivative - 5-point slope 2x[n] + x[n-1] - x[n-3] - 2x[n-4]
+ *   squaring   - emphasises the steep QRS slopes (clamped, no overflow)
+ *   integrator - 150 ms moving window (15 samples)
+ *
+ * Peaks of the integrated signal are classified against adaptive signal and
+ * noise levels (SPKI / NPKI, threshold = NPKI + (SPKI - NPKI) / 4), with a
+ * 200 ms refractory period, T-wave rejection by slope within 360 ms of the
+ * previous beat, and searchback at half the threshold when no beat has been
+ * found for 166% of the average RR interval. The first 2 seconds train the
+ * levels.
+ *
+ * Every sample costs a constant number of integer operations; a short scan
+ * of the band-passed history runs once per integrated peak to place the R
+ * wave. Beats are reported about 28 samples after the R peak, once the
+ * integrated peak has been confirmed (see bench/replay.cpp).
+ */
+class QrsDetector {
+public:
+  static const int SAMPLE_RATE_HZ = 100;
+
+  struct Beat {
+    uint32_t index;      // Sample number of the R peak (counted from reset())
+    uint32_t rrSamples;  // Samples since the previous beat (0 for the first)
+    bool searchback;     // Recovered by searchback at the lower threshold
+  };
+
+private:
+  static const int LP_HISTORY = 32;       // Low-pass ring (high-pass window + delay)
+  static const int HP_WINDOW = 16;        // High-pass moving average length
+  static const int HP_DELAY = 8;          // Centre of the high-pass window
+  static const int BANDPASS_DELAY = 10;   // Low-pass 2 + high-pass 8 samples
+  static const int DERIV_DELAY = 2;
+  static const int HP_HISTORY = 64;       // Band-passed ring used to place R
+  static const int MWI_WINDOW = 15;       // 150 ms
+  static const int32_t SLOPE_MAX = 8192;  // Squared output stays below 2^26
+
+  static const uint32_t WARMUP_SAMPLES = 32;   // Filters settle
+  static const uint32_t LEARN_SAMPLES = 200;   // 2 s training period
+  static const uint32_t REFRACTORY = 20;       // 200 ms
+  static const uint32_t T_WAVE_WINDOW = 36;    // 360 ms
+  static const uint32_t PEAK_TIMEOUT = 10;     // Peak closes 100 ms after its maximum
+
+  int32_t raw[5];
+  int32_t lp[LP_HISTORY];
+  int32_t lpSum;
+  int32_t hp[HP_HISTORY];
+  int32_t sq[MWI_WINDOW];
+  int32_t mwiSum;
+  int32_t prevMwi;
+  uint32_t n;  // Samples processed
+
+  // Integrated-peak tracking
+  int32_t peakMax;
+  uint32_t peakIndex;
+  int32_t peakSlope;
+
+  // Adaptive levels
+  int32_t spki;
+  int32_t npki;
+  int32_t threshold1;
+  int32_t threshold2;
+  int32_t learnMax;
+  int64_t learnSum;
+
+  // Beat history
+  bool haveBeat;
+  uint32_t lastQrsIndex;
+  int32_t lastQrsSlope;
+  WindowedStats<int32_t, 8, int32_t> rrAverage;
+
+  // Best sub-threshold peak since the last beat (searchback candidate)
+  int32_t sbPeak;
+  uint32_t sbIndex;
+  int32_t sbSlope;
+
+  static int32_t absolute(int32_t v) {
+    return v < 0 ? -v : v;
+  }
+
+  void updateThresholds() {
+    threshold1 = npki + (spki - npki) / 4;
+    threshold2 = threshold1 / 2;
+  }
+
+  /**
+   * Place the R wave: largest band-passed excursion inside the integration
+   * window that produced the peak, mapped back to input sample numbers
+   */
+  uint32_t locateR(uint32_t mwiIndex) const {
+    uint32_t end = mwiIndex - DERIV_DELAY;
+    uint32_t best = end;
+    int32_t bestValue = -1;
+    for (uint32_t k = 0; k < (uint32_t)MWI_WINDOW; k++) {
+      uint32_t idx = end - k;
+      int32_t v = absolute(hp[idx % HP_HISTORY]);
+      if (v > bestValue) {
+        bestValue = v;
+        best = idx;
+      }
+    }
+    return best - BANDPASS_DELAY;
+  }
+
+  void accept(uint32_t rIndex, int32_t slope, bool searchback, Beat& beat) {
+    beat.index = rIndex;
+    beat.rrSamples = haveBeat ? rIndex - lastQrsIndex : 0;
+    beat.searchback = searchback;
+
+    if (beat.rrSamples > 0) rrAverage.push((int32_t)beat.rrSamples);
+    haveBeat = true;
+    lastQrsIndex = rIndex;
+    lastQrsSlope = slope;
+    sbPeak = 0;
+  }
+
+  /**
+   * Classify a completed integrated peak
+   * @return true if it was accepted as a QRS complex
+   */
+  bool classify(int32_t peak, uint32_t mwiIndex, int32_t slope, Beat& beat) {
+    uint32_t rIndex = locateR(mwiIndex);
+    if (haveBeat && rIndex - lastQrsIndex < REFRACTORY) return false;
+
+    if (peak > threshold1) {
+      // A steep-enough peak soon after a beat is a QRS; a shallow one is a T wave
+      bool tWave = haveBeat && rIndex - lastQrsIndex < T_WAVE_WINDOW && slope < lastQrsSlope / 2;
+      if (!tWave) {
+        spki += (peak - spki) / 8;
+        updateThresholds();
+        accept(rIndex, slope, false, beat);
+        return true;
+      }
+    } else if (peak > threshold2 && peak > sbPeak) {
+      sbPeak = peak;
+      sbIndex = rIndex;
+      sbSlope = slope;
+    }
+
+    npki += (peak - npki) / 8;
+    updateThresholds();
+    return false;
+  }
+
+public:
+  QrsDetector() {
+    reset();
+  }
+
+  /**
+   * Clear the filters and retrain (call after a gap in the signal)
+   */
+  void reset() {
+    for (int i = 0; i < 5; i++) raw[i] = 0;
+    for (int i = 0; i < LP_HISTORY; i++) lp[i] = 0;
+    for (int i = 0; i < HP_HISTORY; i++) hp[i] = 0;
+    for (int i = 0; i < MWI_WINDOW; i++) sq[i] = 0;
+    lpSum = 0;
+    mwiSum = 0;
+    prevMwi = 0;
+    n = 0;
+
+    peakMax = 0;
+    peakIndex = 0;
+    peakSlope = 0;
+
+    spki = 0;
+    npki = 0;
+    threshold1 = 0;
+    threshold2 = 0;
+    learnMax = 0;
+    learnSum = 0;
+
+    haveBeat = false;
+    lastQrsIndex = 0;
+    lastQrsSlope = 0;
+    rrAverage.reset();
+
+    sbPeak = 0;
+    sbIndex = 0;
+    sbSlope = 0;
+  }
+
+  /**
+   * Process one sample
+   * @param sample Raw ECG value (any DC level)
+   * @param beat Receives the beat when one is confirmed
+   * @return true if a beat was confirmed by this sample
+   */
+  bool process(int sample, Beat& beat) {
+    uint32_t i = n++;
+
+    // Low-pass FIR [1 2 3 2 1]
+    raw[i % 5] = sample;
+    int32_t l = raw[i % 5] + 2 * raw[(i + 4) % 5] + 3 * raw[(i + 3) % 5] +
+                2 * raw[(i + 2) % 5] + raw[(i + 1) % 5];
+
+    // High-pass: delayed sample minus the moving average
+    lpSum += l - lp[(i + LP_HISTORY - HP_WINDOW) % LP_HISTORY];
+    lp[i % LP_HISTORY] = l;
+    int32_t h = lp[(i + LP_HISTORY - HP_DELAY) % LP_HISTORY] - lpSum / HP_WINDOW;
+    hp[i % HP_HISTORY] = h;
+
+    // Derivative, squaring and moving-window integration
+    int32_t d = (2 * h + hp[(i + HP_HISTORY - 1) % HP_HISTORY] -
+                 hp[(i + HP_HISTORY - 3) % HP_HISTORY] -
+                 2 * hp[(i + HP_HISTORY - 4) % HP_HISTORY]) / 8;
+    int32_t slope = absolute(d);
+    if (slope > SLOPE_MAX) slope = SLOPE_MAX;
+    int32_t s = slope * slope;
+    mwiSum += s - sq[i % MWI_WINDOW];
+    sq[i % MWI_WINDOW] = s;
+    int32_t mwi = mwiSum / MWI_WINDOW;
+
+    if (i < WARMUP_SAMPLES) {
+      prevMwi = mwi;
+      return false;
+    }
+
+    bool learning = i < WARMUP_SAMPLES + LEARN_SAMPLES;
+    if (learning) {
+      if (mwi > learnMax) learnMax = mwi;
+      learnSum += mwi;
+      if (i == WARMUP_SAMPLES + LEARN_SAMPLES - 1) {
+        spki = learnMax / 3;
+        npki = (int32_t)(learnSum / LEARN_SAMPLES) / 2;
+        updateThresholds();
+      }
+    }
+
+    // Track the current integrated peak (a new one starts on a rising edge)
+    bool detected = false;
+    if (mwi > peakMax && (peakMax > 0 || mwi > prevMwi)) {
+      peakMax = mwi;
+      peakIndex = i;
+    }
+    if (peakMax > 0) {
+      if (slope > peakSlope) peakSlope = slope;
+      if (mwi < peakMax / 2 || i - peakIndex > PEAK_TIMEOUT) {
+        if (!learning) detected = classify(peakMax, peakIndex, peakSlope, beat);
+        peakMax = 0;
+        peakSlope = 0;
+      }
+    }
+    prevMwi = mwi;
+
+    // Searchback for a beat missed at the main threshold
+    if (!detected && haveBeat && sbPeak > 0 && rrAverage.size() > 0 &&
+        i - lastQrsIndex > (uint32_t)(rrAverage.mean() * 166 / 100)) {
+      spki += (sbPeak - spki) / 4;
+      updateThresholds();
+      accept(sbIndex, sbSlope, true, beat);
+      detected = true;
+    }
+
+    return detected;
+  }
+
+  /**
+   * Samples processed since reset() (the next sample gets this number)
+   */
+  uint32_t sampleCount() const {
+    return n;
+  }
+
+  /**
+   * Average RR interval over the last 8 beats in samples (0 if unknown)
+   */
+  uint32_t averageRR() const {
+    return rrAverage.size() > 0 ? (uint32_t)rrAverage.mean() : 0;
+  }
+
+  bool isLearning() const {
+    return n < WARMUP_SAMPLES + LEARN_SAMPLES;
+  }
+};
+
+#endif
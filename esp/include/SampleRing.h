@@ -0,0 +1,86 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * SampleRing - Lock-free single-producer / single-consumer ring buffer
+ *
+ * The producer (timer callback, ISR-side task) calls push() and the consumer
+ * (the processing loop) calls pop(). No locks are taken on either side, so
+ * the producer never waits on a consumer that is stuck in a slow operation.
+ *
+ * Capacity must be a power of two so the free-running indices can wrap with
+ * a mask. When the ring is full the new sample is dropped and counted, which
+ * lets the consumer detect that it fell behind.
+ */
+template <typename T, size_t N>
+class SampleRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SampleRing capacity must be a power of two");
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head;     // Next slot to write (producer owned)
+  std::atomic<uint32_t> tail;     // Next slot to read (consumer owned)
+  std::atomic<uint32_t> dropped;  // Samples lost because the ring was full
+
+public:
+  SampleRing() : head(0), tail(0), dropped(0) {}
+
+  /**
+   * Append one sample (producer side only)
+   * @param item Sample to store
+   * @return true if stored, false if the ring was full and the sample dropped
+   */
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    if (h - t >= N) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove the oldest sample (consumer side only)
+   * @param item Receives the sample
+   * @return true if a sample was available
+   */
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    if (t == h) return false;
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Number of samples waiting to be consumed
+   */
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  static constexpr size_t capacity() {
+    return N;
+  }
+
+  /**
+   * Total samples dropped since construction
+   */
+  uint32_t droppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef WINDOWED_STATS_H
+#define WINDOWED_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * WindowedStats - Sliding-window sum, mean, variance, min and max in O(1)
+ *
+ * Keeps the last `window` samples in a ring together with a running sum and
+ * sum of squares, and two monotonic deques (sequence numbers of candidate
+ * minima / maxima) so min() and max() never rescan the window. Each push
+ * costs amortised O(1) regardless of the window length.
+ *
+ * The running sums are recomputed from the ring once per window wrap, so
+ * floating-point accumulators cannot drift over long runs (the cost is still
+ * amortised O(1) per sample). Use an integer Acc for exact integer sums.
+ *
+ * The window length can be changed at runtime up to the capacity N; doing so
+ * clears the window. Single-threaded: callers serialise access.
+ */
+template <typename T, size_t N, typename Acc = double>
+class WindowedStats {
+  static_assert(N >= 1, "WindowedStats capacity must be at least 1");
+
+private:
+  T values[N];
+  size_t window;       // Active window length (1..N)
+  size_t count;        // Samples in the window (<= window)
+  uint32_t seq;        // Samples pushed since reset; slot of sample s is s % window
+  uint32_t since_resync;
+  Acc total;
+  Acc total_sq;
+
+  // Monotonic deques of sequence numbers (ring buffers of capacity N)
+  uint32_t min_q[N];
+  uint32_t max_q[N];
+  size_t min_head, min_len;
+  size_t max_head, max_len;
+
+  const T& valueAt(uint32_t s) const {
+    return values[s % window];
+  }
+
+  void resync() {
+    total = 0;
+    total_sq = 0;
+    for (size_t i = 0; i < count; i++) {
+      Acc v = (Acc)values[i];
+      total += v;
+      total_sq += v * v;
+    }
+    since_resync = 0;
+  }
+
+public:
+  explicit WindowedStats(size_t window_len = N) {
+    setWindow(window_len);
+  }
+
+  /**
+   * Change the window length (clamped to 1..N) and clear the window
+   */
+  void setWindow(size_t window_len) {
+    window = window_len < 1 ? 1 : (window_len > N ? N : window_len);
+    reset();
+  }
+
+  void reset() {
+    count = 0;
+    seq = 0;
+    since_resync = 0;
+    total = 0;
+    total_sq = 0;
+    min_head = min_len = 0;
+    max_head = max_len = 0;
+  }
+
+  /**
+   * Add a sample, evicting the oldest once the window is full
+   */
+  void push(T value) {
+    if (count == window) {
+      uint32_t evicted = seq - window;
+      Acc old = (Acc)valueAt(evicted);
+      total -= old;
+      total_sq -= old * old;
+      if (min_len > 0 && min_q[min_head] == evicted) {
+        min_head = (min_head + 1) % N;
+        min_len--;
+      }
+      if (max_len > 0 && max_q[max_head] == evicted) {
+        max_head = (max_head + 1) % N;
+        max_len--;
+      }
+    } else {
+      count++;
+    }
+
+    values[seq % window] = value;
+    Acc v = (Acc)value;
+    total += v;
+    total_sq += v * v;
+
+    // Drop candidates the new sample dominates, then append it
+    while (min_len > 0 && !(valueAt(min_q[(min_head + min_len - 1) % N]) < value)) min_len--;
+    min_q[(min_head + min_len) % N] = seq;
+    min_len++;
+
+    while (max_len > 0 && !(value < valueAt(max_q[(max_head + max_len - 1) % N]))) max_len--;
+    max_q[(max_head + max_len) % N] = seq;
+    max_len++;
+
+    seq++;
+    if (++since_resync >= window) resync();
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  size_t windowLength() const {
+    return window;
+  }
+
+  bool full() const {
+    return count == window;
+  }
+
+  Acc sum() const {
+    return total;
+  }
+
+  /**
+   * Mean of the samples in the window (0 when empty)
+   */
+  Acc mean() const {
+    return count > 0 ? total / (Acc)count : 0;
+  }
+
+  /**
+   * Population variance of the samples in the window (0 when empty)
+   */
+  Acc variance() const {
+    if (count == 0) return 0;
+    Acc m = total / (Acc)count;
+    Acc var = total_sq / (Acc)count - m * m;
+    return var > 0 ? var : 0;
+  }
+
+  /**
+   * Smallest sample in the window (window must not be empty)
+   */
+  T min() const {
+    return valueAt(min_q[min_head]);
+  }
+
+  /**
+   * Largest sample in the window (window must not be empty)
+   */
+  T max() const {
+    return valueAt(max_q[max_head]);
+  }
+
+  /**
+   * Most recently pushed sample (window must not be empty)
+   */
+  T newest() const {
+    return valueAt(seq - 1);
+  }
+
+  /**
+   * Raw ring access for callers that index the window by position
+   * @param slot 0..windowLength()-1
+   */
+  T slot(size_t slot) const {
+    return values[slot];
+  }
+
+  /**
+   * Slot the next push() will write (the oldest sample once full)
+   */
+  size_t nextSlot() const {
+    return seq % window;
+  }
+};
+
+#endif
@@ -1,7 +1,23 @@
 #include <Arduino.h>
-#include <Wire.h>
 #include <SPI.h>
 #include <RadioLib.h>
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "EcgAcquisition.h"
+#include "AdcStream.h"
+#include "I2cBus.h"
+#include "EcgCodec.h"
+#include "ImuData.h"
+#include "FallDetector.h"
+#include "FallCapture.h"
+#include "HistoryLog.h"
+#include "PowerManager.h"
+#include "AD8232.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "UartLink.h"
+#include "LinkConfig.h"
+#include "PacketCodec.h"
 
 /**
  * ==============================================================================
@@ -73,20 +89,60 @@
  * MPU6050 6-Axis Motion Sensor Driver
  * 
  * This class provides a simple interface to read accelerometer and gyroscope
- * data from the MPU6050 sensor using I2C communication.
+ * data from the MPU6050 sensor using I2C communication. It runs in Fast mode
+ * (400 kHz) on the shared I2cBus, ahead of queued temperature reads.
+ * 
+ * Two read modes are supported:
+ * - Polling: readSensorData() reads the current registers (used for calibration)
+ * - FIFO: beginFIFO() lets the sensor sample at a fixed rate into its internal
+ *   FIFO and raise the INT pin on every new sample; readFIFOBatch() drains
+ *   all queued samples in one burst read and timestamps each one
+ * - Motion wake: enableMotionWake() arms the motion detector; with
+ *   setDataReadyInterrupt(false) the INT pin only signals motion while the
+ *   FIFO keeps filling at the configured rate (setFIFORate() may lower it)
  */
 class MPU6050 {
 private:
   // MPU6050 I2C address and register definitions
-  const uint8_t I2C_ADDR = 0x68;           // Default I2C address
+  const I2cBus::Device device = {0x68, I2cBus::FAST_HZ};  // Default I2C address
   const uint8_t REG_PWR_MGMT_1 = 0x6B;     // Power management register
   const uint8_t REG_WHO_AM_I = 0x75;       // Device ID register
   const uint8_t REG_ACCEL_XOUT_H = 0x3B;   // Start of accelerometer data registers
   
-  // Sensor calibration and scale factors
-  const float ACCEL_SCALE = 16384.0;       // For ±2g range
-  const float GYRO_SCALE = 131.0;          // For ±250°/s range
-  const float GRAVITY = 9.80665;           // Standard gravity (m/s²)
+  // FIFO / interrupt configuration registers
+  const uint8_t REG_SMPLRT_DIV = 0x19;     // Sample rate divider
+  const uint8_t REG_CONFIG = 0x1A;         // DLPF configuration
+  const uint8_t REG_GYRO_CONFIG = 0x1B;    // Gyro range
+  const uint8_t REG_ACCEL_CONFIG = 0x1C;   // Accel range / motion high-pass filter
+  const uint8_t REG_MOT_THR = 0x1F;        // Motion threshold (2 mg per LSB)
+  const uint8_t REG_MOT_DUR = 0x20;        // Motion duration (1 ms per LSB)
+  const uint8_t REG_FIFO_EN = 0x23;        // FIFO sensor selection
+  const uint8_t REG_INT_PIN_CFG = 0x37;    // INT pin behaviour
+  const uint8_t REG_INT_ENABLE = 0x38;     // Interrupt enable
+  const uint8_t REG_INT_STATUS = 0x3A;     // Interrupt status (clears on read)
+  const uint8_t REG_USER_CTRL = 0x6A;      // FIFO enable / reset
+  const uint8_t REG_FIFO_COUNTH = 0x72;    // FIFO byte count (high byte first)
+  const uint8_t REG_FIFO_R_W = 0x74;       // FIFO data port
+  
+  // FIFO layout: accel XYZ + gyro XYZ, 2 bytes each (temperature not queued)
+  static const uint8_t FIFO_SAMPLE_BYTES = 12;
+  static const uint16_t FIFO_SIZE_BYTES = 1024;
+  
+  I2cBus* bus = nullptr;
+  uint8_t fifo_buf[FIFO_SIZE_BYTES];  // One drain, read in a single transaction
+  
+  // Full-scale ranges and scale factors (ImuData.h, compile-time)
+  typedef ImuRange Range;
+  
+  // FIFO sampling state
+  bool fifo_enabled = false;
+  uint16_t fifo_rate_hz = 0;
+  uint32_t fifo_period_us = 0;
+  int64_t next_sample_us = 0;       // Timestamp assigned to the next FIFO sample
+  uint32_t fifo_overflows = 0;
+  uint8_t int_enable = 0x01;        // DATA_RDY_EN, plus MOT_EN once motion wake is armed
+  bool data_ready_int = true;
+  bool accel_hpf = false;           // Motion detector high-pass filter (motion wake armed)
   
   /**
    * Write a single byte to a specific MPU6050 register
@@ -94,10 +150,7 @@ private:
    * @param data Data byte to write
    */
   void writeRegister(uint8_t reg, uint8_t data) {
-    Wire.beginTransmission(I2C_ADDR);
-    Wire.write(reg);
-    Wire.write(data);
-    Wire.endTransmission();
+    bus->writeRegister(device, reg, data, I2cBus::PRIORITY_HIGH);
   }
   
   /**
@@ -106,26 +159,44 @@ private:
    * @return Data byte read from register
    */
   uint8_t readRegister(uint8_t reg) {
-    Wire.beginTransmission(I2C_ADDR);
-    Wire.write(reg);
-    Wire.endTransmission(false);
-    Wire.requestFrom(I2C_ADDR, (uint8_t)1);
-    return Wire.read();
+    uint8_t value = 0xFF;  // Idle bus level if the read fails
+    bus->readRegisters(device, reg, &value, 1, I2cBus::PRIORITY_HIGH);
+    return value;
+  }
+  
+  /**
+   * Discard FIFO contents and restart sample timestamping
+   */
+  void resetFIFO() {
+    writeRegister(REG_USER_CTRL, 0x04);  // FIFO_RESET
+    writeRegister(REG_USER_CTRL, 0x40);  // FIFO_EN
+    next_sample_us = 0;
+  }
+
+  
+  /**
+   * Big-endian 16-bit register pair
+   */
+  static int16_t be16(const uint8_t* p) {
+    return (int16_t)((p[0] << 8) | p[1]);
   }
 
 public:
   // Structure to hold sensor readings
-  struct SensorData {
-    float accelX, accelY, accelZ;  // Acceleration in m/s²
-    float gyroX, gyroY, gyroZ;     // Rotation rate in °/s
-  };
+  typedef ImuData SensorData;
+  
+  // FIFO sample with raw counts and the time it was taken (esp_timer_get_time() time base)
+  typedef ImuSample TimedSample;
   
   /**
    * Initialize the MPU6050 sensor
    * Wake up the sensor from sleep mode and verify communication
+   * @param i2c Running bus the sensor is on
    * @return true if initialization successful, false otherwise
    */
-  bool begin() {
+  bool begin(I2cBus& i2c) {
+    bus = &i2c;
+    
     // Wake up MPU6050 (it starts in sleep mode by default)
     writeRegister(REG_PWR_MGMT_1, 0x00);
     delay(100);
@@ -134,8 +205,8 @@ public:
     uint8_t deviceId = readRegister(REG_WHO_AM_I);
     
     // Print device ID for debugging
-    Serial.print("Device ID: 0x");
-    Serial.print(deviceId, HEX);
+    Log.print("Device ID: 0x");
+    Log.print(deviceId, HEX);
     
     // Valid device IDs:
     // 0x68 - MPU6050
@@ -157,15 +228,15 @@ public:
         default: sensorName = "Unknown"; break;
       }
       
-      Serial.print(" - ");
-      Serial.print(sensorName);
-      Serial.println(" detected!");
-      Serial.println("Sensor initialized successfully!");
+      Log.print(" - ");
+      Log.print(sensorName);
+      Log.println(" detected!");
+      Log.println("Sensor initialized successfully!");
       return true;
     } else {
-      Serial.println(" - Unknown/Unsupported device");
-      Serial.println("This device ID is not recognized.");
-      Serial.println("The sensor may still work, attempting to continue...");
+      Log.println(" - Unknown/Unsupported device");
+      Log.println("This device ID is not recognized.");
+      Log.println("The sensor may still work, attempting to continue...");
       // Try to continue anyway - some clones use different IDs
       return true;
     }
@@ -180,971 +251,230 @@ public:
     SensorData data;
     int16_t rawData[7];  // ax, ay, az, temp, gx, gy, gz
     
-    // Request 14 bytes starting from ACCEL_XOUT_H register
-    Wire.beginTransmission(I2C_ADDR);
-    Wire.write(REG_ACCEL_XOUT_H);
-    Wire.endTransmission(false);
-    Wire.requestFrom(I2C_ADDR, (uint8_t)14);
+    // Read 14 bytes starting from ACCEL_XOUT_H register
+    uint8_t bytes[14] = {};
+    bus->readRegisters(device, REG_ACCEL_XOUT_H, bytes, sizeof(bytes), I2cBus::PRIORITY_HIGH);
     
-    // Read all 14 bytes (7 x 16-bit values)
+    // 7 x 16-bit values
     for (int i = 0; i < 7; i++) {
-      rawData[i] = (Wire.read() << 8) | Wire.read();
+      rawData[i] = be16(&bytes[2 * i]);
     }
     
     // Convert raw values to physical units
-    data.accelX = (rawData[0] / ACCEL_SCALE) * GRAVITY;  // m/s²
-    data.accelY = (rawData[1] / ACCEL_SCALE) * GRAVITY;
-    data.accelZ = (rawData[2] / ACCEL_SCALE) * GRAVITY;
+    data.accelX = Range::accelMs2(rawData[0]);  // m/s²
+    data.accelY = Range::accelMs2(rawData[1]);
+    data.accelZ = Range::accelMs2(rawData[2]);
     
-    data.gyroX = rawData[4] / GYRO_SCALE;  // °/s
-    data.gyroY = rawData[5] / GYRO_SCALE;
-    data.gyroZ = rawData[6] / GYRO_SCALE;
+    data.gyroX = Range::gyroDps(rawData[4]);  // °/s
+    data.gyroY = Range::gyroDps(rawData[5]);
+    data.gyroZ = Range::gyroDps(rawData[6]);
     
     return data;
   }
   
   /**
-   * Print formatted sensor data to Serial monitor
-   * @param data SensorData structure to display
-   */
-  void printData(const SensorData& data) {
-    Serial.println("========================================");
-    
-    // Acceleration data
-    Serial.print("Acceleration (m/s²): X=");
-    Serial.print(data.accelX, 3);
-    Serial.print(" Y=");
-    Serial.print(data.accelY, 3);
-    Serial.print(" Z=");
-    Serial.println(data.accelZ, 3);
-    
-    // Gyroscope data
-    Serial.print("Gyroscope (°/s):     X=");
-    Serial.print(data.gyroX, 2);
-    Serial.print(" Y=");
-    Serial.print(data.gyroY, 2);
-    Serial.print(" Z=");
-    Serial.println(data.gyroZ, 2);
-    
-    Serial.println();
-  }
-};
-
-// ============================================================================
-// FALL DETECTION ALGORITHM CLASS
-// ============================================================================
-
-/**
- * FallDetector - Advanced fall detection using MPU6050 sensor
- * 
- * This class implements a multi-criteria fall detection algorithm that can be
- * easily tuned for different applications (elderly care, sports, workplace safety).
- * 
- * Configurable Parameters:
- * - All threshold values are public and can be adjusted at runtime
- * - Allows for AI/ML optimization of parameters based on user data
- * - Supports different sensitivity profiles (conservative, balanced, sensitive)
- */
-class FallDetector {
-public:
-  // ===========================================================================
-  // CONFIGURABLE THRESHOLD PARAMETERS
-  // ===========================================================================
-  // These can be adjusted based on user needs, environment, or AI training
-  
-  // --- Jerk Detection Thresholds (m/s³) ---
-  // Optimized for TORSO/CENTER-BODY placement - lower impact forces expected
-  // Reference: Kartik9250/Fall_detection uses 650,000 m/s³ for wrist placement
-  float JERK_THRESHOLD_HIGH = 450000.0f;     // Reduced for torso (was 650,000)
-  float JERK_THRESHOLD_MEDIUM = 300000.0f;   // Reduced for torso (was 400,000)
-  float JERK_THRESHOLD_LOW = 200000.0f;      // NEW: Detect subtle changes
-  
-  // --- SVM (Signal Vector Magnitude) Thresholds (g-force) ---
-  // Torso experiences less extreme values than extremities
-  // Normal gravity = 1g, torso fall impact = 1.5-2.5g (lower than wrist/head)
-  float SVM_THRESHOLD_HIGH = 1.8f;      // Reduced for torso (was 2.5g)
-  float SVM_THRESHOLD_LOW = 0.65f;      // Slightly raised to avoid bowing detection
-  float SVM_THRESHOLD_WARNING = 1.4f;   // Reduced for torso (was 1.8g)
-  float SVM_THRESHOLD_IMPACT_PEAK = 2.2f; // NEW: Very high impact (confirms fall)
-  
-  // --- Angular Velocity Thresholds (°/s) ---
-  // Torso rotation is KEY indicator - body tumbles during fall
-  float GYRO_THRESHOLD = 150.0f;        // Reduced - torso rotates slower (was 200)
-  float GYRO_THRESHOLD_COMBINED = 180.0f; // Reduced for torso (was 250)
-  float GYRO_THRESHOLD_SUSTAINED = 120.0f; // NEW: Sustained rotation detection
-  
-  // --- Posture Angle Thresholds (degrees) ---
-  // Critical for torso placement - body orientation changes significantly
-  float PITCH_THRESHOLD = 40.0f;        // Slightly reduced (was 45°)
-  float ROLL_THRESHOLD = 35.0f;         // Increased importance (was 30°)
-  float POSTURE_CHANGE_RAPID = 60.0f;   // NEW: Rapid angle change indicates fall
-  
-  // --- Time Windows (milliseconds) ---
-  uint32_t FALL_CONFIRMATION_WINDOW = 500;   // Initial wait before starting immobility check
-  uint32_t RECOVERY_TIME_WINDOW = 5000;      // Minimum time between fall detections
-  uint32_t JERK_SAMPLING_INTERVAL = 10;      // Interval for jerk calculation
-  uint32_t IMMOBILITY_CHECK_WINDOW = 3000;   // Time window to monitor for movement after fall
-  uint32_t IMMOBILITY_SAMPLING_INTERVAL = 100; // Interval for immobility sampling
-  uint32_t FALL_SEQUENCE_WINDOW = 800;       // NEW: Time window to detect fall sequence
-  uint32_t BOWING_REJECTION_TIME = 1500;     // NEW: Bowing takes longer than falling
-  
-  // --- Detection Stage Counters ---
-  uint8_t IMPACT_COUNT_THRESHOLD = 2;    // Number of high-g readings to trigger
-  uint8_t WARNING_COUNT_THRESHOLD = 3;   // Number of warning readings
-  uint8_t GYRO_SUSTAINED_COUNT = 3;      // NEW: Sustained rotation counter
-  
-  // --- Post-Fall Movement Detection Thresholds ---
-  // Reference: xiaoweiweiyaya/ESP32_FallDetection - uses CV and SD for movement analysis
-  float IMMOBILITY_ACCEL_VARIANCE_THRESHOLD = 0.005f;  // Max variance (m/s²)² for immobile state
-  float IMMOBILITY_ACCEL_STDDEV_THRESHOLD = 0.1f;    // Max standard deviation (m/s²) for immobile
-  float IMMOBILITY_GYRO_VARIANCE_THRESHOLD = 5.0f;    // Max gyro variance (°/s)² for immobile
-  float IMMOBILITY_SVM_RANGE_THRESHOLD = 0.1f;        // Max SVM change for immobile (g)
-  uint8_t IMMOBILITY_SAMPLE_COUNT = 10;               // Number of samples to check for immobility
-  
-  // ===========================================================================
-  // FALL DETECTION STATE
-  // ===========================================================================
-  
-  enum FallState {
-    NORMAL = 0,        // Normal activity
-    WARNING = 1,       // Potential fall detected, monitoring
-    FALL_DETECTED = 2, // Confirmed fall
-    DANGEROUS = 3,     // Immobile after fall - possible unconsciousness
-    RECOVERY = 4       // Post-fall recovery period
-  };
-  
-  struct FallEvent {
-    FallState state;
-    uint32_t timestamp;
-    float jerk_magnitude;
-    float svm_value;
-    float angular_velocity;
-    float pitch_angle;
-    float roll_angle;
-    bool confirmed;
-    
-    // Post-fall immobility metrics
-    float movement_variance;      // Acceleration variance after fall
-    float movement_stddev;        // Standard deviation of movement
-    bool is_immobile;            // True if person appears unconscious/immobile
-    uint32_t immobile_duration;  // How long person has been immobile (ms)
-  };
-  
-private:
-  // Previous sensor readings for derivative calculations
-  float prev_accel_x, prev_accel_y, prev_accel_z;
-  float baseline_pitch, baseline_roll;
-  
-  // Detection state tracking
-  FallState current_state;
-  uint32_t state_change_time;
-  uint32_t last_fall_time;
-  uint8_t impact_counter;
-  uint8_t warning_counter;
-  uint8_t gyro_sustained_counter;  // NEW: Track sustained rotation
-  
-  // Sample timing
-  uint32_t last_sample_time;
-  uint32_t last_immobility_check_time;
-  uint32_t warning_start_time;     // NEW: Track when warning state started
-  
-  // Fall sequence detection
-  bool detected_freefall;          // NEW: Track if free-fall detected
-  bool detected_impact;            // NEW: Track if impact detected
-  bool detected_rotation;          // NEW: Track if rotation detected
-  uint32_t freefall_time;          // NEW: When free-fall was detected
-  uint32_t impact_time;            // NEW: When impact was detected
-  
-  // Activity pattern tracking (for bowing/jumping rejection)
-  float prev_svm;                  // NEW: Previous SVM value
-  float svm_trend;                 // NEW: SVM trend (increasing/decreasing)
-  uint8_t vertical_motion_counter; // NEW: Count vertical motions (jumping)
-  
-  // Latest fall event data
-  FallEvent latest_event;
-  
-  // Calibration flag
-  bool is_calibrated;
-  
-  // Post-fall immobility monitoring
-  struct ImmobilityBuffer {
-    float accel_samples[30];  // Circular buffer for acceleration samples
-    float gyro_samples[30];   // Circular buffer for gyro samples
-    float svm_samples[30];    // Circular buffer for SVM samples
-    uint8_t sample_index;
-    uint8_t sample_count;
-  } immobility_buffer;
-  
-  uint32_t immobility_start_time;
-  
-public:
-  /**
-   * Constructor - Initialize fall detector
-   */
-  FallDetector() {
-    prev_accel_x = 0.0f;
-    prev_accel_y = 0.0f;
-    prev_accel_z = 0.0f;
-    baseline_pitch = 0.0f;
-    baseline_roll = 0.0f;
-    
-    current_state = NORMAL;
-    state_change_time = 0;
-    last_fall_time = 0;
-    impact_counter = 0;
-    warning_counter = 0;
-    gyro_sustained_counter = 0;
-    
-    last_sample_time = 0;
-    last_immobility_check_time = 0;
-    warning_start_time = 0;
-    is_calibrated = false;
-    
-    // Fall sequence tracking
-    detected_freefall = false;
-    detected_impact = false;
-    detected_rotation = false;
-    freefall_time = 0;
-    impact_time = 0;
-    
-    // Activity pattern tracking
-    prev_svm = 1.0f;
-    svm_trend = 0.0f;
-    vertical_motion_counter = 0;
-    
-    latest_event.state = NORMAL;
-    latest_event.confirmed = false;
-    latest_event.is_immobile = false;
-    latest_event.movement_variance = 0.0f;
-    latest_event.movement_stddev = 0.0f;
-    latest_event.immobile_duration = 0;
-    
-    // Initialize immobility buffer
-    immobility_buffer.sample_index = 0;
-    immobility_buffer.sample_count = 0;
-    for (int i = 0; i < 30; i++) {
-      immobility_buffer.accel_samples[i] = 0.0f;
-      immobility_buffer.gyro_samples[i] = 0.0f;
-      immobility_buffer.svm_samples[i] = 1.0f;  // Initialize to 1g
-    }
-    immobility_start_time = 0;
-  }
-  
-  /**
-   * Calibrate baseline posture angles
-   * Should be called when user is in normal standing/sitting position
+   * Configure fixed-rate sampling into the FIFO with a data-ready interrupt
    * 
-   * @param pitch Current pitch angle
-   * @param roll Current roll angle
-   */
-  void calibrate(float pitch, float roll) {
-    baseline_pitch = pitch;
-    baseline_roll = roll;
-    is_calibrated = true;
-    
-    Serial.println("========================================");
-    Serial.println("Fall Detector Calibrated!");
-    Serial.print("Baseline Pitch: ");
-    Serial.print(baseline_pitch, 2);
-    Serial.print("°, Baseline Roll: ");
-    Serial.print(baseline_roll, 2);
-    Serial.println("°");
-    Serial.println("========================================\n");
-  }
-  
-  /**
-   * Calculate jerk magnitude (rate of change of acceleration)
+   * DLPF is set to 44 Hz (1 kHz internal rate) and the sample rate divider
+   * derives the requested output rate from it. The INT pin is push-pull,
+   * active high, and pulses once per sample.
    * 
-   * @param accel_x Current X acceleration (m/s²)
-   * @param accel_y Current Y acceleration (m/s²)
-   * @param accel_z Current Z acceleration (m/s²)
-   * @param delta_time Time since last sample (seconds)
-   * @return Jerk magnitude (m/s³)
+   * @param rateHz Output sample rate (4-1000 Hz, 100-200 Hz for fall detection)
+   * @return true if configured
    */
-  float calculateJerk(float accel_x, float accel_y, float accel_z, float delta_time) {
-    // Calculate jerk components (derivative of acceleration)
-    float jerk_x = (accel_x - prev_accel_x) / delta_time;
-    float jerk_y = (accel_y - prev_accel_y) / delta_time;
-    float jerk_z = (accel_z - prev_accel_z) / delta_time;
-    
-    // Update previous values
-    prev_accel_x = accel_x;
-    prev_accel_y = accel_y;
-    prev_accel_z = accel_z;
-    
-    // Calculate magnitude
-    float jerk_magnitude = sqrt(jerk_x * jerk_x + jerk_y * jerk_y + jerk_z * jerk_z);
-    
-    return jerk_magnitude;
+  bool beginFIFO(uint16_t rateHz) {
+    if (rateHz < 4 || rateHz > 1000) return false;
+    
+    writeRegister(REG_PWR_MGMT_1, 0x01);        // Clock from X gyro PLL (more stable than internal RC)
+    writeRegister(REG_CONFIG, 0x03);            // DLPF 44 Hz accel / 42 Hz gyro, 1 kHz gyro output
+    writeRegister(REG_GYRO_CONFIG, Range::GYRO_CONFIG);
+    writeRegister(REG_ACCEL_CONFIG, Range::ACCEL_CONFIG | (accel_hpf ? 0x01 : 0x00));
+    writeRegister(REG_SMPLRT_DIV, (uint8_t)(1000 / rateHz - 1));
+    writeRegister(REG_FIFO_EN, 0x78);           // XG, YG, ZG, ACCEL
+    writeRegister(REG_INT_PIN_CFG, 0x00);       // Active high, push-pull, 50us pulse
+    writeRegister(REG_INT_ENABLE, int_enable);  // DATA_RDY_EN (+ MOT_EN)
+    
+    fifo_rate_hz = 1000 / (1000 / rateHz);      // Actual rate after integer divider
+    fifo_period_us = 1000000UL / fifo_rate_hz;
+    fifo_overflows = 0;
+    resetFIFO();
+    readRegister(REG_INT_STATUS);               // Clear any pending interrupt
+    fifo_enabled = true;
+    return true;
   }
   
   /**
-   * Calculate Signal Vector Magnitude (SVM)
-   * Represents total acceleration magnitude
+   * Change the FIFO output rate while sampling (drain the FIFO first)
    * 
-   * @param accel_x X acceleration (m/s²)
-   * @param accel_y Y acceleration (m/s²)
-   * @param accel_z Z acceleration (m/s²)
-   * @return SVM in g-force units
-   */
-  float calculateSVM(float accel_x, float accel_y, float accel_z) {
-    // Convert m/s² to g (1g = 9.80665 m/s²)
-    const float GRAVITY = 9.80665f;
-    float ax_g = accel_x / GRAVITY;
-    float ay_g = accel_y / GRAVITY;
-    float az_g = accel_z / GRAVITY;
-    
-    // Calculate magnitude
-    float svm = sqrt(ax_g * ax_g + ay_g * ay_g + az_g * az_g);
-    
-    return svm;
-  }
-  
-  /**
-   * Calculate combined angular velocity magnitude
+   * Only the sample rate divider is rewritten, so the FIFO and interrupt
+   * setup stay as they are. The sample clock is re-anchored at the next
+   * readFIFOBatch(); a sample still queued from the old rate gets a
+   * timestamp one new period from its neighbour.
    * 
-   * @param gyro_x X rotation rate (°/s)
-   * @param gyro_y Y rotation rate (°/s)
-   * @param gyro_z Z rotation rate (°/s)
-   * @return Combined angular velocity magnitude
+   * @param rateHz Output sample rate (4-1000 Hz)
+   * @return true if the rate was set
    */
-  float calculateAngularVelocity(float gyro_x, float gyro_y, float gyro_z) {
-    return sqrt(gyro_x * gyro_x + gyro_y * gyro_y + gyro_z * gyro_z);
+  bool setFIFORate(uint16_t rateHz) {
+    if (!fifo_enabled || rateHz < 4 || rateHz > 1000) return false;
+    writeRegister(REG_SMPLRT_DIV, (uint8_t)(1000 / rateHz - 1));
+    fifo_rate_hz = 1000 / (1000 / rateHz);
+    fifo_period_us = 1000000UL / fifo_rate_hz;
+    next_sample_us = 0;
+    return true;
   }
   
   /**
-   * Main fall detection algorithm
-   * Analyzes sensor data using multi-stage criteria
+   * Drain samples queued in the FIFO
    * 
-   * Algorithm Flow:
-   * 1. Calculate jerk, SVM, and angular velocity
-   * 2. Check for impact/free-fall phase (Stage 1)
-   * 3. Check for tumbling/rotation (Stage 2)
-   * 4. Verify posture angle change (Stage 3)
-   * 5. Confirm fall if all criteria met
+   * INT_STATUS and FIFO_COUNT are read in one transaction, then up to
+   * maxSamples in a single burst read. Timestamps advance by exactly one sample period so the
+   * fall detector sees a fixed rate; the sample clock is re-anchored to
+   * esp_timer_get_time() when it drifts by more than two periods (e.g.
+   * after an overflow or a long stall).
    * 
-   * @param sensor_data Current MPU6050 sensor readings
-   * @return Updated fall event with detection status
+   * @param out Destination for samples
+   * @param maxSamples Capacity of out
+   * @return Number of samples read (0 if none or FIFO mode not active)
    */
-  FallEvent detectFall(const MPU6050::SensorData& sensor_data) {
-    uint32_t current_time = millis();
-    
-    // Calculate time delta for jerk calculation
-    float delta_time = (current_time - last_sample_time) / 1000.0f; // Convert to seconds
-    if (delta_time <= 0) delta_time = 0.01f; // Prevent division by zero
-    last_sample_time = current_time;
-    
-    // === STAGE 1: Calculate Detection Metrics ===
-    
-    float jerk_mag = calculateJerk(sensor_data.accelX, sensor_data.accelY, 
-                                   sensor_data.accelZ, delta_time);
-    
-    float svm = calculateSVM(sensor_data.accelX, sensor_data.accelY, 
-                            sensor_data.accelZ);
-    
-    float angular_vel = calculateAngularVelocity(sensor_data.gyroX, sensor_data.gyroY, 
-                                                 sensor_data.gyroZ);
-    
-    // === STAGE 2: Enhanced Impact/Free-fall Detection ===
-    // Optimized for TORSO placement - detect fall SEQUENCE instead of single event
-    
-    // Calculate SVM trend for pattern recognition
-    svm_trend = svm - prev_svm;
-    prev_svm = svm;
-    
-    bool high_impact = (svm > SVM_THRESHOLD_HIGH);
-    bool very_high_impact = (svm > SVM_THRESHOLD_IMPACT_PEAK);
-    bool free_fall = (svm < SVM_THRESHOLD_LOW);
-    bool high_jerk = (jerk_mag > JERK_THRESHOLD_HIGH);
-    bool medium_jerk = (jerk_mag > JERK_THRESHOLD_MEDIUM);
-    bool low_jerk = (jerk_mag > JERK_THRESHOLD_LOW);
-    
-    // NEW: Detect free-fall phase (important for fall sequence)
-    if (free_fall && !detected_freefall) {
-      detected_freefall = true;
-      freefall_time = current_time;
-      Serial.println("[Fall Sequence] Free-fall detected!");
-    }
-    
-    // Reset free-fall if too much time passed
-    if (detected_freefall && (current_time - freefall_time > FALL_SEQUENCE_WINDOW)) {
-      detected_freefall = false;
-    }
-    
-    // NEW: Detect impact phase (especially after free-fall)
-    if ((high_impact || high_jerk) && !detected_impact) {
-      detected_impact = true;
-      impact_time = current_time;
-      
-      // Extra confidence if impact follows free-fall
-      if (detected_freefall && (current_time - freefall_time < FALL_SEQUENCE_WINDOW)) {
-        Serial.println("[Fall Sequence] Impact after free-fall - HIGH CONFIDENCE!");
-        impact_counter += 2;  // Double weight for sequence detection
-      } else {
-        impact_counter++;
-      }
-      
-      if (current_state == NORMAL) {
-        current_state = WARNING;
-        warning_start_time = current_time;
-      }
-    }
-    
-    // Reset impact detection
-    if (detected_impact && (current_time - impact_time > FALL_SEQUENCE_WINDOW)) {
-      detected_impact = false;
-    }
-    
-    // Additional impact detection for torso
-    if (very_high_impact) {
-      impact_counter += 2;  // Strong signal
-      current_state = WARNING;
-      if (warning_start_time == 0) warning_start_time = current_time;
-    } else if (medium_jerk || (svm > SVM_THRESHOLD_WARNING)) {
-      warning_counter++;
-      if (warning_counter >= WARNING_COUNT_THRESHOLD) {
-        current_state = WARNING;
-        if (warning_start_time == 0) warning_start_time = current_time;
-      }
-    } else if (low_jerk && current_state == WARNING) {
-      // Keep warning state active with low jerk
-      warning_counter++;
-    } else {
-      // Decay counters if no detection
-      if (impact_counter > 0) impact_counter--;
-      if (warning_counter > 0) warning_counter--;
-      
-      // Return to normal if no activity
-      if (current_state == WARNING && impact_counter == 0 && warning_counter == 0) {
-        current_state = NORMAL;
-        warning_start_time = 0;
-      }
-    }
-    
-    // === STAGE 3: Enhanced Rotation/Tumbling Detection ===
-    // Torso rotation is CRITICAL - body tumbles during fall but not during bowing
-    bool high_rotation = (angular_vel > GYRO_THRESHOLD_COMBINED);
-    bool sustained_rotation = (angular_vel > GYRO_THRESHOLD_SUSTAINED);
-    
-    // Track sustained rotation (key difference: fall = rotation, bowing = no rotation)
-    if (sustained_rotation) {
-      gyro_sustained_counter++;
-      detected_rotation = true;
-      Serial.print("[Rotation] Sustained rotation detected: ");
-      Serial.print(angular_vel);
-      Serial.print(" °/s (count: ");
-      Serial.print(gyro_sustained_counter);
-      Serial.println(")");
-    } else {
-      if (gyro_sustained_counter > 0) gyro_sustained_counter--;
+  int readFIFOBatch(TimedSample* out, int maxSamples) {
+    if (!fifo_enabled || maxSamples <= 0) return 0;
+    
+    uint8_t status = 0;
+    uint8_t countBytes[2] = {};
+    I2cBus::Op ops[2] = {
+      I2cBus::readOp(REG_INT_STATUS, &status, 1),
+      I2cBus::readOp(REG_FIFO_COUNTH, countBytes, 2)
+    };
+    if (bus->transfer(device, ops, 2, I2cBus::PRIORITY_HIGH) != ESP_OK) return 0;
+    
+    // Overflow leaves a partial sample at the head of the FIFO - start over
+    if (status & 0x10) {
+      fifo_overflows++;
+      resetFIFO();
+      return 0;
     }
     
-    // High confidence if sustained rotation during warning state
-    if (current_state == WARNING && gyro_sustained_counter >= GYRO_SUSTAINED_COUNT) {
-      Serial.println("[Rotation] Sustained rotation confirmed - likely fall!");
+    uint16_t count = (uint16_t)be16(countBytes);
+    if (count % FIFO_SAMPLE_BYTES != 0 || count >= FIFO_SIZE_BYTES) {
+      fifo_overflows++;
+      resetFIFO();
+      return 0;
     }
     
-    // === STAGE 4: Enhanced Posture Angle Verification ===
-    // Torso orientation is HIGHLY reliable indicator
-    bool posture_changed = false;
-    bool rapid_posture_change = false;
-    static float prev_pitch = 0;
-    static float prev_roll = 0;
+    int available = count / FIFO_SAMPLE_BYTES;
+    if (available == 0) return 0;
+    if (available > maxSamples) available = maxSamples;
     
-    if (is_calibrated) {
-      // Calculate pitch and roll from accelerometer
-      float pitch = atan2(sensor_data.accelY, sensor_data.accelZ) * 180.0f / PI;
-      float roll = atan2(sensor_data.accelX, sensor_data.accelZ) * 180.0f / PI;
-      
-      // Check if posture significantly changed from baseline
-      float pitch_change = abs(pitch - baseline_pitch);
-      float roll_change = abs(roll - baseline_roll);
-      
-      // NEW: Calculate rate of angle change (fast = fall, slow = bowing)
-      float pitch_rate = abs(pitch - prev_pitch) / (delta_time + 0.001f);
-      float roll_rate = abs(roll - prev_roll) / (delta_time + 0.001f);
-      
-      prev_pitch = pitch;
-      prev_roll = roll;
-      
-      posture_changed = (pitch_change > PITCH_THRESHOLD) || (roll_change > ROLL_THRESHOLD);
-      
-      // NEW: Rapid posture change indicates fall (not slow bowing)
-      rapid_posture_change = (pitch_change > POSTURE_CHANGE_RAPID) || 
-                             (roll_change > POSTURE_CHANGE_RAPID) ||
-                             (pitch_rate > 100.0f) || (roll_rate > 80.0f);
-      
-      if (rapid_posture_change && current_state == WARNING) {
-        Serial.println("[Posture] RAPID angle change detected - strong fall indicator!");
-      }
-      
-      latest_event.pitch_angle = pitch;
-      latest_event.roll_angle = roll;
+    // Newest queued sample was taken about now; older ones one period apart
+    int64_t now = esp_timer_get_time();
+    int64_t newest = next_sample_us + (int64_t)(count / FIFO_SAMPLE_BYTES - 1) * fifo_period_us;
+    if (next_sample_us == 0 || llabs(now - newest) > 2 * (int64_t)fifo_period_us) {
+      next_sample_us = now - (int64_t)(count / FIFO_SAMPLE_BYTES - 1) * fifo_period_us;
     }
     
-    // === STAGE 5: Intelligent Fall Confirmation Logic ===
-    // ENHANCED: Distinguish fall from bowing/jumping using multiple indicators
-    
-    bool fall_confirmed = false;
-    
-    if (current_state == WARNING) {
-      uint32_t warning_duration = current_time - warning_start_time;
-      
-      // === BOWING REJECTION ===
-      // Bowing characteristics: slow, controlled, no rotation, gradual angle change
-      bool likely_bowing = false;
-      if (is_calibrated) {
-        // Bowing takes longer (>1.5s), has no rotation, and is controlled
-        likely_bowing = (warning_duration > BOWING_REJECTION_TIME) && 
-                       (gyro_sustained_counter == 0) && 
-                       (!detected_freefall) &&
-                       (!rapid_posture_change);
-        
-        if (likely_bowing) {
-          Serial.println("[Rejection] Likely BOWING detected - slow, no rotation");
-          // Reset warning state
-          current_state = NORMAL;
-          impact_counter = 0;
-          warning_counter = 0;
-          gyro_sustained_counter = 0;
-          warning_start_time = 0;
-          detected_freefall = false;
-          detected_impact = false;
-          detected_rotation = false;
-          return latest_event;
-        }
-      }
-      
-      // === JUMPING REJECTION ===
-      // Jumping characteristics: vertical motion, symmetric up/down, quick recovery
-      bool likely_jumping = false;
-      if (detected_freefall && !detected_rotation && (gyro_sustained_counter == 0)) {
-        // Jump has free-fall but NO rotation and quick posture return
-        likely_jumping = true;
-        Serial.println("[Rejection] Likely JUMPING detected - vertical, no rotation");
-        
-        // Don't immediately reject - wait to see if posture changes
-        // If person returns to upright quickly, it was a jump
-      }
-      
-      // === FALL CONFIRMATION WITH WEIGHTED CRITERIA ===
-      int criteria_score = 0;
-      int criteria_count = 0;
-      
-      // Criterion 1: Impact detection (weight: 2 if after free-fall, else 1)
-      if (impact_counter >= IMPACT_COUNT_THRESHOLD) {
-        criteria_count++;
-        if (detected_freefall && (impact_time - freefall_time < FALL_SEQUENCE_WINDOW)) {
-          criteria_score += 3;  // STRONG indicator: free-fall → impact sequence
-          Serial.println("[Criteria] ✓ Impact sequence (score +3)");
-        } else {
-          criteria_score += 1;
-          Serial.println("[Criteria] ✓ Impact detected (score +1)");
-        }
-      }
-      
-      // Criterion 2: Sustained rotation (weight: 3 - CRITICAL for torso)
-      if (gyro_sustained_counter >= GYRO_SUSTAINED_COUNT) {
-        criteria_count++;
-        criteria_score += 3;  // STRONG indicator: body tumbling
-        Serial.println("[Criteria] ✓ Sustained rotation (score +3)");
-      } else if (high_rotation) {
-        criteria_count++;
-        criteria_score += 2;
-        Serial.println("[Criteria] ✓ High rotation (score +2)");
-      }
-      
-      // Criterion 3: Posture change (weight: 3 if rapid, else 2)
-      if (rapid_posture_change) {
-        criteria_count++;
-        criteria_score += 3;  // STRONG indicator: sudden orientation change
-        Serial.println("[Criteria] ✓ Rapid posture change (score +3)");
-      } else if (posture_changed) {
-        criteria_count++;
-        criteria_score += 2;
-        Serial.println("[Criteria] ✓ Posture changed (score +2)");
-      }
-      
-      // Criterion 4: High jerk (weight: 1)
-      if (high_jerk) {
-        criteria_count++;
-        criteria_score += 1;
-        Serial.println("[Criteria] ✓ High jerk (score +1)");
-      }
-      
-      // Criterion 5: Fall sequence detected (weight: 2)
-      if (detected_freefall && detected_impact && detected_rotation) {
-        criteria_count++;
-        criteria_score += 2;  // Complete fall sequence
-        Serial.println("[Criteria] ✓ Complete fall sequence (score +2)");
-      }
-      
-      Serial.print("[Fall Score] Total: ");
-      Serial.print(criteria_score);
-      Serial.print("/12, Criteria: ");
-      Serial.print(criteria_count);
-      Serial.println("/5");
-      
-      // === CONFIRMATION DECISION ===
-      // Require EITHER:
-      // - Score ≥ 6 (high confidence)
-      // - Score ≥ 4 AND at least 3 different criteria
-      // This ensures we don't miss falls but avoid false positives
-      
-      if ((criteria_score >= 6) || (criteria_score >= 4 && criteria_count >= 3)) {
-        if (!likely_jumping) {
-          fall_confirmed = true;
-          current_state = FALL_DETECTED;
-          state_change_time = current_time;
-          last_fall_time = current_time;
-          
-          Serial.println("\n╔══════════════════════════════════════╗");
-          Serial.println("║     ⚠️  FALL CONFIRMED!  ⚠️         ║");
-          Serial.println("╚══════════════════════════════════════╝");
-          Serial.print("Score: ");
-          Serial.print(criteria_score);
-          Serial.print(", Criteria: ");
-          Serial.println(criteria_count);
-          
-          // Reset counters
-          impact_counter = 0;
-          warning_counter = 0;
-          gyro_sustained_counter = 0;
-          detected_freefall = false;
-          detected_impact = false;
-          detected_rotation = false;
-        } else {
-          Serial.println("[Decision] High score but likely jumping - monitoring...");
-        }
-      } else if (warning_duration > FALL_SEQUENCE_WINDOW && criteria_score < 4) {
-        // Timeout - not enough evidence for fall
-        Serial.println("[Decision] Warning timeout - insufficient evidence");
-        current_state = NORMAL;
-        impact_counter = 0;
-        warning_counter = 0;
-        gyro_sustained_counter = 0;
-        warning_start_time = 0;
-        detected_freefall = false;
-        detected_impact = false;
-        detected_rotation = false;
-      }
+    if (bus->readRegisters(device, REG_FIFO_R_W, fifo_buf, (uint16_t)(available * FIFO_SAMPLE_BYTES),
+                           I2cBus::PRIORITY_HIGH) != ESP_OK) {
+      // Position in the FIFO is unknown now - start over
+      fifo_overflows++;
+      resetFIFO();
+      return 0;
     }
     
-    // === STAGE 6: Post-Fall Movement Monitoring ===
-    // Monitor for immobility after fall detection (potential unconsciousness)
-    if (current_state == FALL_DETECTED) {
-      // Check if it's time to start monitoring immobility
-      if (current_time - state_change_time > FALL_CONFIRMATION_WINDOW) {
-        // Continuously collect samples
-        checkPostFallMovement(svm, angular_vel, current_time);
-        
-        // Only make decision after collecting enough samples
-        if (immobility_buffer.sample_count >= IMMOBILITY_SAMPLE_COUNT) {
-          // Check if person is immobile
-          if (latest_event.is_immobile) {
-            current_state = DANGEROUS;
-            Serial.println("\n!!! WARNING: NO MOVEMENT DETECTED - POSSIBLE UNCONSCIOUSNESS !!!");
-          } else {
-            // Person is moving, transition to recovery
-            current_state = RECOVERY;
-            Serial.println("Movement detected - person is moving after fall");
-          }
-        }
-        // If not enough samples yet, stay in FALL_DETECTED state
+    for (int s = 0; s < available; s++) {
+      const uint8_t* p = &fifo_buf[s * FIFO_SAMPLE_BYTES];
+      int16_t raw[6];  // ax, ay, az, gx, gy, gz
+      for (int i = 0; i < 6; i++) {
+        raw[i] = be16(&p[2 * i]);
       }
-    }
-    
-    // === STAGE 7: Dangerous State - Continuous Immobility Monitoring ===
-    if (current_state == DANGEROUS) {
-      // Continue monitoring movement
-      checkPostFallMovement(svm, angular_vel, current_time);
       
-      // If person starts moving, transition to recovery
-      if (!latest_event.is_immobile) {
-        Serial.println("Movement detected - transitioning to recovery");
-        current_state = RECOVERY;
-      }
-    }
-    
-    // === STAGE 8: Recovery Period ===
-    // Prevent multiple detections in short time
-    if (current_state == RECOVERY) {
-      if (current_time - last_fall_time > RECOVERY_TIME_WINDOW) {
-        current_state = NORMAL;
-        // Reset immobility tracking
-        immobility_buffer.sample_count = 0;
-        immobility_buffer.sample_index = 0;
+      TimedSample& sample = out[s];
+      sample.data.accelX = Range::accelMs2(raw[0]);  // m/s²
+      sample.data.accelY = Range::accelMs2(raw[1]);
+      sample.data.accelZ = Range::accelMs2(raw[2]);
+      sample.data.gyroX = Range::gyroDps(raw[3]);  // °/s
+      sample.data.gyroY = Range::gyroDps(raw[4]);
+      sample.data.gyroZ = Range::gyroDps(raw[5]);
+      for (int i = 0; i < 3; i++) {
+        sample.accelRaw[i] = raw[i];
+        sample.gyroRaw[i] = raw[3 + i];
       }
+      sample.timestamp_us = next_sample_us;
+      next_sample_us += fifo_period_us;
     }
     
-    // Update fall event data
-    latest_event.state = current_state;
-    latest_event.timestamp = current_time;
-    latest_event.jerk_magnitude = jerk_mag;
-    latest_event.svm_value = svm;
-    latest_event.angular_velocity = angular_vel;
-    latest_event.confirmed = fall_confirmed;
-    
-    return latest_event;
+    return available;
   }
   
   /**
-   * Check for post-fall movement to detect unconsciousness
-   * 
-   * This method monitors acceleration variance and standard deviation after a fall
-   * to determine if the person is immobile (potentially unconscious/injured).
+   * Arm the motion detector (interrupt on any axis above the threshold)
    * 
-   * Algorithm based on xiaoweiweiyaya/ESP32_FallDetection approach:
-   * - Collects acceleration samples in a sliding window
-   * - Calculates variance and standard deviation
-   * - Low variance indicates no movement (immobility)
-   * - High variance indicates normal movement
+   * The accelerometer high-pass filter (5 Hz) only feeds the motion
+   * detector, so gravity does not count as motion and the FIFO data is
+   * unchanged. The range bits stay as configured (Range::ACCEL_CONFIG).
    * 
-   * @param svm Current Signal Vector Magnitude
-   * @param angular_vel Current angular velocity magnitude
-   * @param current_time Current timestamp in milliseconds
+   * @param thresholdMg Acceleration change that counts as motion
+   * @param durationMs Samples above the threshold needed to fire
    */
-  void checkPostFallMovement(float svm, float angular_vel, uint32_t current_time) {
-    // Only check at specified intervals to avoid excessive computation
-    if (current_time - last_immobility_check_time < IMMOBILITY_SAMPLING_INTERVAL) {
-      return;
-    }
-    last_immobility_check_time = current_time;
-    
-    // Add current samples to circular buffer
-    immobility_buffer.accel_samples[immobility_buffer.sample_index] = svm;
-    immobility_buffer.gyro_samples[immobility_buffer.sample_index] = angular_vel;
-    immobility_buffer.svm_samples[immobility_buffer.sample_index] = svm;
-    
-    // Debug: Print sample collection
-    Serial.print("[Immobility] Sample ");
-    Serial.print(immobility_buffer.sample_count);
-    Serial.print("/");
-    Serial.print(IMMOBILITY_SAMPLE_COUNT);
-    Serial.print(" - SVM: ");
-    Serial.print(svm, 3);
-    Serial.print(", Gyro: ");
-    Serial.println(angular_vel, 2);
-    
-    immobility_buffer.sample_index++;
-    if (immobility_buffer.sample_index >= IMMOBILITY_SAMPLE_COUNT) {
-      immobility_buffer.sample_index = 0;
-    }
-    
-    if (immobility_buffer.sample_count < IMMOBILITY_SAMPLE_COUNT) {
-      immobility_buffer.sample_count++;
-    }
-    
-    // Need minimum samples before checking
-    if (immobility_buffer.sample_count < IMMOBILITY_SAMPLE_COUNT) {
-      latest_event.is_immobile = false;
-      return;
-    }
-    
-    // Calculate variance and standard deviation of acceleration
-    float accel_mean = 0.0f;
-    float gyro_mean = 0.0f;
-    float svm_min = 999.0f;
-    float svm_max = 0.0f;
-    
-    // Calculate means and range
-    for (int i = 0; i < IMMOBILITY_SAMPLE_COUNT; i++) {
-      accel_mean += immobility_buffer.accel_samples[i];
-      gyro_mean += immobility_buffer.gyro_samples[i];
-      
-      if (immobility_buffer.svm_samples[i] < svm_min) svm_min = immobility_buffer.svm_samples[i];
-      if (immobility_buffer.svm_samples[i] > svm_max) svm_max = immobility_buffer.svm_samples[i];
-    }
-    accel_mean /= IMMOBILITY_SAMPLE_COUNT;
-    gyro_mean /= IMMOBILITY_SAMPLE_COUNT;
-    
-    float svm_range = svm_max - svm_min;
-    
-    // Calculate variance
-    float accel_variance = 0.0f;
-    float gyro_variance = 0.0f;
-    
-    for (int i = 0; i < IMMOBILITY_SAMPLE_COUNT; i++) {
-      float accel_diff = immobility_buffer.accel_samples[i] - accel_mean;
-      float gyro_diff = immobility_buffer.gyro_samples[i] - gyro_mean;
-      
-      accel_variance += accel_diff * accel_diff;
-      gyro_variance += gyro_diff * gyro_diff;
-    }
-    accel_variance /= IMMOBILITY_SAMPLE_COUNT;
-    gyro_variance /= IMMOBILITY_SAMPLE_COUNT;
-    
-    // Calculate standard deviation
-    float accel_stddev = sqrt(accel_variance);
-    
-    // Update event metrics
-    latest_event.movement_variance = accel_variance;
-    latest_event.movement_stddev = accel_stddev;
-    
-    // Debug: Print calculated metrics
-    Serial.println("\n[Immobility Analysis]");
-    Serial.print("  Accel Mean: "); Serial.print(accel_mean, 3); Serial.println(" g");
-    Serial.print("  Accel Variance: "); Serial.print(accel_variance, 6); Serial.print(" (threshold: ");
-    Serial.print(IMMOBILITY_ACCEL_VARIANCE_THRESHOLD, 6); Serial.println(")");
-    Serial.print("  Accel StdDev: "); Serial.print(accel_stddev, 4); Serial.print(" (threshold: ");
-    Serial.print(IMMOBILITY_ACCEL_STDDEV_THRESHOLD, 4); Serial.println(")");
-    Serial.print("  Gyro Variance: "); Serial.print(gyro_variance, 2); Serial.print(" (threshold: ");
-    Serial.print(IMMOBILITY_GYRO_VARIANCE_THRESHOLD, 2); Serial.println(")");
-    Serial.print("  SVM Range: "); Serial.print(svm_range, 3); Serial.print(" (threshold: ");
-    Serial.print(IMMOBILITY_SVM_RANGE_THRESHOLD, 3); Serial.println(")");
-    
-    // Determine immobility based on multiple criteria
-    // Reference: xiaoweiweiyaya uses CV and SD thresholds
-    bool low_accel_variance = (accel_variance < IMMOBILITY_ACCEL_VARIANCE_THRESHOLD);
-    bool low_accel_stddev = (accel_stddev < IMMOBILITY_ACCEL_STDDEV_THRESHOLD);
-    bool low_gyro_variance = (gyro_variance < IMMOBILITY_GYRO_VARIANCE_THRESHOLD);
-    bool low_svm_range = (svm_range < IMMOBILITY_SVM_RANGE_THRESHOLD);
-    
-    // Debug: Print criteria evaluation
-    Serial.println("  Criteria Check:");
-    Serial.print("    Low Accel Variance: "); Serial.println(low_accel_variance ? "YES" : "NO");
-    Serial.print("    Low Accel StdDev: "); Serial.println(low_accel_stddev ? "YES" : "NO");
-    Serial.print("    Low Gyro Variance: "); Serial.println(low_gyro_variance ? "YES" : "NO");
-    Serial.print("    Low SVM Range: "); Serial.println(low_svm_range ? "YES" : "NO");
-    
-    // Require at least 3 of 4 criteria to confirm immobility
-    int immobility_criteria = 0;
-    if (low_accel_variance) immobility_criteria++;
-    if (low_accel_stddev) immobility_criteria++;
-    if (low_gyro_variance) immobility_criteria++;
-    if (low_svm_range) immobility_criteria++;
-    
-    Serial.print("  Criteria Met: "); Serial.print(immobility_criteria); Serial.println("/4");
-    
-    latest_event.is_immobile = (immobility_criteria >= 3);
-    
-    // Track immobility duration
-    if (latest_event.is_immobile) {
-      if (immobility_start_time == 0) {
-        immobility_start_time = current_time;
-      }
-      latest_event.immobile_duration = current_time - immobility_start_time;
-    } else {
-      immobility_start_time = 0;
-      latest_event.immobile_duration = 0;
-    }
-  }
-  
-  /**
-   * Get current fall detection state
-   */
-  FallState getState() const {
-    return current_state;
+  void enableMotionWake(uint16_t thresholdMg, uint8_t durationMs) {
+    accel_hpf = true;
+    writeRegister(REG_ACCEL_CONFIG, Range::ACCEL_CONFIG | 0x01);  // ACCEL_HPF 5 Hz
+    writeRegister(REG_MOT_THR, (uint8_t)min(255, thresholdMg / 2));
+    writeRegister(REG_MOT_DUR, durationMs);
+    int_enable |= 0x40;                         // MOT_EN
+    setDataReadyInterrupt(data_ready_int);
   }
   
   /**
-   * Get latest fall event data
+   * Choose whether the INT pin pulses per sample or only on motion
+   * 
+   * Sampling into the FIFO is unaffected; with the data-ready interrupt
+   * off the host drains on its own schedule or when motion is flagged.
+   * A motion interrupt then latches INT high until the next drain reads
+   * INT_STATUS, so a host in light sleep sees it as a level.
    */
-  FallEvent getLatestEvent() const {
-    return latest_event;
+  void setDataReadyInterrupt(bool enabled) {
+    data_ready_int = enabled;
+    uint8_t mask = enabled ? int_enable : (uint8_t)(int_enable & ~0x01);
+    writeRegister(REG_INT_PIN_CFG, enabled ? 0x00 : 0x20);  // 50us pulse / LATCH_INT_EN
+    writeRegister(REG_INT_ENABLE, mask);
   }
   
-  /**
-   * Check if detector is calibrated
-   */
-  bool isCalibrated() const {
-    return is_calibrated;
+  bool isFIFOEnabled() const {
+    return fifo_enabled;
   }
   
-  /**
-   * Reset fall detector state
-   */
-  void reset() {
-    current_state = NORMAL;
-    impact_counter = 0;
-    warning_counter = 0;
-    gyro_sustained_counter = 0;
-    latest_event.confirmed = false;
-    latest_event.is_immobile = false;
-    latest_event.immobile_duration = 0;
-    immobility_buffer.sample_count = 0;
-    immobility_buffer.sample_index = 0;
-    immobility_start_time = 0;
-    warning_start_time = 0;
-    detected_freefall = false;
-    detected_impact = false;
-    detected_rotation = false;
-    freefall_time = 0;
-    impact_time = 0;
-    vertical_motion_counter = 0;
+  uint16_t getFIFORate() const {
+    return fifo_rate_hz;
   }
   
-  /**
-   * Print current detection parameters
-   */
-  void printConfiguration() {
-    Serial.println("\n========================================");
-    Serial.println("Fall Detector Configuration:");
-    Serial.println("========================================");
-    Serial.print("Jerk Threshold (High): "); Serial.print(JERK_THRESHOLD_HIGH); Serial.println(" m/s³");
-    Serial.print("SVM Threshold (High):  "); Serial.print(SVM_THRESHOLD_HIGH); Serial.println(" g");
-    Serial.print("SVM Threshold (Low):   "); Serial.print(SVM_THRESHOLD_LOW); Serial.println(" g");
-    Serial.print("Gyro Threshold:        "); Serial.print(GYRO_THRESHOLD_COMBINED); Serial.println(" °/s");
-    Serial.print("Pitch Threshold:       "); Serial.print(PITCH_THRESHOLD); Serial.println("°");
-    Serial.print("Roll Threshold:        "); Serial.print(ROLL_THRESHOLD); Serial.println("°");
-    Serial.println("--- Post-Fall Immobility Detection ---");
-    Serial.print("Accel Variance Threshold: "); Serial.print(IMMOBILITY_ACCEL_VARIANCE_THRESHOLD); Serial.println(" (m/s²)²");
-    Serial.print("Accel StdDev Threshold:   "); Serial.print(IMMOBILITY_ACCEL_STDDEV_THRESHOLD); Serial.println(" m/s²");
-    Serial.print("Gyro Variance Threshold:  "); Serial.print(IMMOBILITY_GYRO_VARIANCE_THRESHOLD); Serial.println(" (°/s)²");
-    Serial.print("SVM Range Threshold:      "); Serial.print(IMMOBILITY_SVM_RANGE_THRESHOLD); Serial.println(" g");
-    Serial.print("Immobility Check Window:  "); Serial.print(IMMOBILITY_CHECK_WINDOW); Serial.println(" ms");
-    Serial.println("========================================\n");
+  uint32_t getFIFOOverflows() const {
+    return fifo_overflows;
   }
   
   /**
-   * Set sensitivity profile
-   * @param profile 0=Conservative, 1=Balanced, 2=Sensitive
+   * Print formatted sensor data to Serial monitor
+   * @param data SensorData structure to display
    */
-  void setSensitivityProfile(uint8_t profile) {
-    switch(profile) {
-      case 0: // Conservative - fewer false positives (torso-optimized)
-        JERK_THRESHOLD_HIGH = 450000.0f;
-        JERK_THRESHOLD_MEDIUM = 250000.0f;
-        SVM_THRESHOLD_HIGH = 2.0f;
-        SVM_THRESHOLD_LOW = 0.6f;
-        GYRO_THRESHOLD_COMBINED = 200.0f;
-        GYRO_THRESHOLD_SUSTAINED = 140.0f;
-        PITCH_THRESHOLD = 45.0f;
-        ROLL_THRESHOLD = 38.0f;
-        IMPACT_COUNT_THRESHOLD = 3;
-        GYRO_SUSTAINED_COUNT = 4;
-        Serial.println("Sensitivity Profile: CONSERVATIVE (Torso-Optimized)");
-        break;
-        
-      case 1: // Balanced - default (torso-optimized)
-        JERK_THRESHOLD_HIGH = 350000.0f;
-        JERK_THRESHOLD_MEDIUM = 200000.0f;
-        SVM_THRESHOLD_HIGH = 1.8f;
-        SVM_THRESHOLD_LOW = 0.65f;
-        GYRO_THRESHOLD_COMBINED = 180.0f;
-        GYRO_THRESHOLD_SUSTAINED = 120.0f;
-        PITCH_THRESHOLD = 40.0f;
-        ROLL_THRESHOLD = 35.0f;
-        IMPACT_COUNT_THRESHOLD = 2;
-        GYRO_SUSTAINED_COUNT = 3;
-        Serial.println("Sensitivity Profile: BALANCED (Torso-Optimized)");
-        break;
-        
-      case 2: // Sensitive - maximum detection (torso-optimized)
-        JERK_THRESHOLD_HIGH = 280000.0f;
-        JERK_THRESHOLD_MEDIUM = 150000.0f;
-        SVM_THRESHOLD_HIGH = 1.6f;
-        SVM_THRESHOLD_LOW = 0.7f;
-        GYRO_THRESHOLD_COMBINED = 160.0f;
-        GYRO_THRESHOLD_SUSTAINED = 100.0f;
-        PITCH_THRESHOLD = 35.0f;
-        ROLL_THRESHOLD = 30.0f;
-        IMPACT_COUNT_THRESHOLD = 1;
-        GYRO_SUSTAINED_COUNT = 2;
-        Serial.println("Sensitivity Profile: SENSITIVE (Torso-Optimized)");
-        break;
-    }
-    printConfiguration();
+  void printData(const SensorData& data) {
+    Log.println("========================================");
+    
+    // Acceleration data
+    Log.print("Acceleration (m/s²): X=");
+    Log.print(data.accelX, 3);
+    Log.print(" Y=");
+    Log.print(data.accelY, 3);
+    Log.print(" Z=");
+    Log.println(data.accelZ, 3);
+    
+    // Gyroscope data
+    Log.print("Gyroscope (°/s):     X=");
+    Log.print(data.gyroX, 2);
+    Log.print(" Y=");
+    Log.print(data.gyroY, 2);
+    Log.print(" Z=");
+    Log.println(data.gyroZ, 2);
+    
+    Log.println();
   }
 };
 
@@ -1157,14 +487,81 @@ public:
  * 
  * This class provides sound level measurement in decibels (dB)
  * for monitoring dangerous noise levels that could cause hearing damage.
+ * 
+ * Streaming mode: raw samples from the ADC DMA stream are passed to
+ * processSamples(), which accumulates peak-to-peak and RMS over a level
+ * window and Leq/Lmax over a longer window. The latest results are read
+ * with getSoundStats() without blocking.
  */
 class MAX4466 {
+public:
+  // Latest streaming measurements
+  struct SoundStats {
+    float peakToPeak;   // ADC counts over the last level window
+    float rms;          // AC RMS in ADC counts over the last level window
+    float levelDB;      // calculateDB(peakToPeak) of the last level window
+    float leqDB;        // Energy-average level over the last Leq window
+    float lmaxDB;       // Highest level window within the last Leq window
+    uint32_t windows;   // Level windows completed since streaming started
+  };
+  
 private:
   uint8_t mic_pin;
   float db_offset;
   const uint16_t ADC_MAX_VALUE = 4095;
   const float VREF = 3.3;
   
+  // Streaming accumulators (touched only by the ADC reader task)
+  bool streaming;
+  uint32_t level_window_samples;
+  uint32_t leq_window_levels;     // Level windows per Leq window
+  float dc_estimate;              // MAX4466 output is biased at VCC/2
+  uint32_t win_count;
+  uint16_t win_min;
+  uint16_t win_max;
+  float win_sum_sq;
+  uint32_t leq_count;
+  float leq_energy_sum;          // Sum of 10^(L/10) over level windows
+  float leq_max;
+  
+  SoundStats stats;
+  portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+  
+  /**
+   * Close a level window and publish the results
+   */
+  void finishLevelWindow() {
+    float p2p = (float)(win_max - win_min);
+    float rms = sqrtf(win_sum_sq / win_count);
+    float level = calculateDB(p2p);
+    
+    leq_energy_sum += powf(10.0f, level / 10.0f);
+    if (level > leq_max) leq_max = level;
+    leq_count++;
+    
+    portENTER_CRITICAL(&stats_mux);
+    stats.peakToPeak = p2p;
+    stats.rms = rms;
+    stats.levelDB = level;
+    stats.windows++;
+    if (leq_count >= leq_window_levels) {
+      stats.leqDB = 10.0f * log10f(leq_energy_sum / leq_count);
+      stats.lmaxDB = leq_max;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+    
+    if (leq_count >= leq_window_levels) {
+      leq_count = 0;
+      leq_energy_sum = 0;
+      leq_max = 0;
+    }
+    
+    win_count = 0;
+    win_min = ADC_MAX_VALUE;
+    win_max = 0;
+    win_sum_sq = 0;
+  }
+  
 public:
   // Noise level thresholds (dB)
   float DB_THRESHOLD_WARNING = 85.0;   // Risk with prolonged exposure
@@ -1178,6 +575,18 @@ public:
   MAX4466(uint8_t pin, float offset = 16.0) {
     mic_pin = pin;
     db_offset = offset;
+    streaming = false;
+    level_window_samples = 0;
+    leq_window_levels = 1;
+    dc_estimate = ADC_MAX_VALUE / 2.0f;
+    win_count = 0;
+    win_min = ADC_MAX_VALUE;
+    win_max = 0;
+    win_sum_sq = 0;
+    leq_count = 0;
+    leq_energy_sum = 0;
+    leq_max = 0;
+    stats = {};
   }
   
   /**
@@ -1186,7 +595,7 @@ public:
   void begin() {
     analogReadResolution(12);  // 12-bit ADC (0-4095)
     analogSetAttenuation(ADC_11db);  // Full range up to ~3.3V
-    Serial.println("MAX4466 microphone initialized");
+    Log.println("MAX4466 microphone initialized");
   }
   
   /**
@@ -1209,12 +618,81 @@ public:
     return db;
   }
   
+  /**
+   * Switch to streaming measurement (samples delivered via processSamples)
+   * @param sampleRateHz Rate of the incoming ADC samples
+   * @param levelWindowMs Window for peak-to-peak / RMS / level
+   * @param leqWindowMs Window for Leq / Lmax (multiple of levelWindowMs)
+   */
+  void beginStreaming(uint32_t sampleRateHz, uint32_t levelWindowMs = 50, uint32_t leqWindowMs = 60000) {
+    level_window_samples = max((uint32_t)1, sampleRateHz * levelWindowMs / 1000);
+    leq_window_levels = max((uint32_t)1, leqWindowMs / levelWindowMs);
+    streaming = true;
+  }
+  
+  /**
+   * Accumulate a block of raw ADC samples (ADC reader task only)
+   * @param samples 12-bit ADC samples
+   * @param count Number of samples
+   */
+  void processSamples(const uint16_t* samples, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      uint16_t sample = samples[i];
+      
+      // Slow DC tracker removes the bias so RMS reflects the AC signal only
+      dc_estimate += (sample - dc_estimate) * 0.001f;
+      float ac = sample - dc_estimate;
+      win_sum_sq += ac * ac;
+      
+      if (sample > win_max) win_max = sample;
+      if (sample < win_min) win_min = sample;
+      
+      if (++win_count >= level_window_samples) {
+        finishLevelWindow();
+      }
+    }
+  }
+  
+  /**
+   * AdcStream sink adapter
+   */
+  static void adcSink(void* ctx, const uint16_t* samples, size_t count) {
+    static_cast<MAX4466*>(ctx)->processSamples(samples, count);
+  }
+  
+  /**
+   * Latest streaming measurements (non-blocking)
+   */
+  SoundStats getSoundStats() {
+    portENTER_CRITICAL(&stats_mux);
+    SoundStats copy = stats;
+    portEXIT_CRITICAL(&stats_mux);
+    return copy;
+  }
+  
+  /**
+   * Return to blocking readSoundLevel() sampling
+   */
+  void endStreaming() {
+    streaming = false;
+  }
+  
+  bool isStreaming() const {
+    return streaming;
+  }
+  
   /**
    * Read current sound level
+   * In streaming mode this returns the last completed level window
+   * immediately; otherwise it samples for sampleWindow milliseconds.
    * @param sampleWindow Sample window width in milliseconds
    * @return Sound level in dB
    */
   float readSoundLevel(uint32_t sampleWindow = 50) {
+    if (streaming) {
+      return getSoundStats().levelDB;
+    }
+    
     unsigned long startMillis = millis();
     unsigned int signalMax = 0;
     unsigned int signalMin = ADC_MAX_VALUE;
@@ -1256,571 +734,142 @@ public:
    * @param db Current sound level in dB
    */
   void printStatus(float db) {
-    Serial.print("Sound Level: ");
-    Serial.print(db, 1);
-    Serial.print(" dB - ");
+    Log.print("Sound Level: ");
+    Log.print(db, 1);
+    Log.print(" dB - ");
     
     uint8_t status = checkNoiseLevel(db);
     switch(status) {
       case 2:
-        Serial.println("⚠️  DANGER! Extremely high noise! Protect ears immediately!");
+        Log.println("⚠️  DANGER! Extremely high noise! Protect ears immediately!");
         break;
       case 1:
-        Serial.println("⚠️  WARNING! May damage hearing with prolonged exposure");
+        Log.println("⚠️  WARNING! May damage hearing with prolonged exposure");
         break;
       case 0:
-        Serial.println("✓ Safe noise level");
+        Log.println("✓ Safe noise level");
         break;
     }
   }
 };
 
 // ============================================================================
-// AD8232 ECG MONITOR CLASS
+// MLX90614 INFRARED TEMPERATURE SENSOR CLASS
 // ============================================================================
 
 /**
- * AD8232 - ECG/Heart Rate Monitoring
+ * MLX90614 - Non-Contact IR Temperature Monitoring
  * 
- * This class provides ECG signal processing and heart rate detection
- * for monitoring cardiac activity and detecting abnormalities.
+ * This class provides body temperature measurement using infrared sensor
+ * with advanced filtering for accurate readings.
+ * 
+ * Measurements are incremental: startMeasurement() begins a burst and each
+ * update() call collects one SMBus read and queues the next, so the caller
+ * paces the burst (SAMPLE_SPACING_MS apart) without ever blocking for the
+ * whole ~400ms measurement. Reads run at 100 kHz (SMBus) on the shared
+ * I2cBus, at low priority behind the IMU, and never stall update().
  */
-class AD8232 {
+class MLX90614Sensor {
+public:
+  // Burst configuration
+  static const int BURST_SIZE = 20;               // Object samples per measurement
+  static const uint32_t SAMPLE_SPACING_MS = 20;   // Spacing between update() calls
+  
 private:
-  uint8_t ecg_pin;
-  uint8_t lo_plus_pin;
-  uint8_t lo_minus_pin;
-  
-  // ECG data buffers
-  static const int BUFFER_SIZE = 200;  // 2 seconds at 100Hz
-  int ecgDataBuffer[BUFFER_SIZE];
-  int dataIndex;
-  
-  // Compressed ECG buffer for LoRaWAN transmission
-  static const int COMPRESSED_SIZE = 50;  // Compressed samples
-  uint8_t compressedECG[COMPRESSED_SIZE];
-  int compressedIndex;
-  
-  // Downsampling (100Hz -> 25Hz, keep every 4th sample)
-  int downsampleCounter;
-  int lastCompressedValue;
-  
-  // PQRST wave detection buffer
-  struct PQRSTWave {
-    uint16_t timestamp;     // Relative timestamp (ms)
-    int16_t p_amp;          // P wave amplitude
-    int16_t q_amp;          // Q wave amplitude  
-    int16_t r_amp;          // R wave amplitude
-    int16_t s_amp;          // S wave amplitude
-    int16_t t_amp;          // T wave amplitude
-    uint8_t qrs_width;      // QRS duration (ms)
-    uint8_t qt_interval;    // QT interval (ms)
-  } lastPQRST;
-  
-  bool pqrstValid;
-  
-  // Heart rate detection
-  unsigned long lastBeatTime;
-  unsigned long beatInterval;
-  int baselineValue;
-  int peakValue;
-  
-  // ECG Features
-  struct ECGFeatures {
-    int rPeakAmplitude;      // R-wave amplitude
-    int qrsWidth;            // QRS complex width (ms)
-    int rrInterval;          // RR interval (ms)
-    bool validBeat;
-  } lastFeatures;
+  I2cBus* bus;
+  I2cBus::Device device;
   
-public:
-  // Heart rate thresholds
-  int BPM_MIN_NORMAL = 50;      // Minimum normal heart rate
-  int BPM_MAX_NORMAL = 120;     // Maximum normal heart rate
-  int BPM_MIN_VALID = 40;       // Minimum valid detection
-  int BPM_MAX_VALID = 200;      // Maximum valid detection
-  float THRESHOLD_PERCENT = 60.0; // R-wave detection threshold
+  // Registers
+  const byte REG_AMBIENT_TEMP = 0x06;
+  const byte REG_OBJECT_TEMP = 0x07;
+  
+  // Moving average filter (running sum)
+  static const int FILTER_SIZE = 10;
+  float tempHistory[FILTER_SIZE];
+  int historyIndex;
+  bool bufferFilled;
+  float historySum;
+  
+  // Measurement state machine
+  enum MeasureState {
+    IDLE,
+    SAMPLING_OBJECT,   // One object read per update()
+    READING_AMBIENT    // Final ambient read, then back to IDLE
+  };
+  MeasureState measureState;
+  float burstSamples[BURST_SIZE];  // Valid samples, kept sorted as they arrive
+  int burstTaken;
+  int burstValid;
   
-  int currentBPM;
-  bool leadsOff;
+  // Read in flight on the bus (one at a time)
+  uint8_t readBuf[3];              // Low byte, high byte, PEC
+  volatile bool readBusy;          // Cleared by the bus task
+  volatile esp_err_t readResult;
+  bool readIssued;                 // readBuf/readResult hold a read not yet used
   
   /**
-   * Constructor
-   * @param ecg ADC pin for ECG signal
-   * @param lo_plus Lead-off detection pin (LO+)
-   * @param lo_minus Lead-off detection pin (LO-)
+   * Bus task completion for a queued read
    */
-  AD8232(uint8_t ecg, uint8_t lo_plus, uint8_t lo_minus) {
-    ecg_pin = ecg;
-    lo_plus_pin = lo_plus;
-    lo_minus_pin = lo_minus;
-    
-    dataIndex = 0;
-    lastBeatTime = 0;
-    beatInterval = 0;
-    baselineValue = 2048;  // 12-bit ADC midpoint
-    peakValue = 0;
-    currentBPM = 0;
-    leadsOff = true;
-    
-    lastFeatures.validBeat = false;
-    lastFeatures.rPeakAmplitude = 0;
-    lastFeatures.qrsWidth = 0;
-    lastFeatures.rrInterval = 0;
-    
-    // Initialize buffer
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-      ecgDataBuffer[i] = 2048;
-    }
-    
-    // Initialize compression buffers
-    compressedIndex = 0;
-    downsampleCounter = 0;
-    lastCompressedValue = 2048;
-    pqrstValid = false;
-    
-    for (int i = 0; i < COMPRESSED_SIZE; i++) {
-      compressedECG[i] = 0;
-    }
-    
-    memset(&lastPQRST, 0, sizeof(PQRSTWave));
+  static void onReadDone(void* ctx, esp_err_t result) {
+    MLX90614Sensor* self = static_cast<MLX90614Sensor*>(ctx);
+    self->readResult = result;
+    self->readBusy = false;
   }
   
   /**
-   * Initialize the ECG monitor
+   * Queue a 3-byte read of a temperature register
+   * A read that cannot be queued is collected as a failed one.
    */
-  void begin() {
-    pinMode(lo_plus_pin, INPUT);
-    pinMode(lo_minus_pin, INPUT);
-    analogReadResolution(12);  // 12-bit ADC (0-4095)
-    analogSetAttenuation(ADC_11db);
-    
-    Serial.println("AD8232 ECG monitor initialized");
-    Serial.println("Sample rate: 100 Hz");
+  void issueRead(byte reg) {
+    readIssued = true;
+    readBusy = true;
+    I2cBus::Op op = I2cBus::readOp(reg, readBuf, sizeof(readBuf));
+    if (bus == nullptr || !bus->submit(device, &op, 1, onReadDone, this, I2cBus::PRIORITY_LOW)) {
+      readResult = ESP_FAIL;
+      readBusy = false;
+    }
   }
   
   /**
-   * Check if ECG leads are properly connected
-   * @return true if leads are off, false if connected
+   * Temperature from the completed read
    */
-  bool checkLeadsOff() {
-    bool loPlus = digitalRead(lo_plus_pin);
-    bool loMinus = digitalRead(lo_minus_pin);
-    leadsOff = (loPlus == HIGH || loMinus == HIGH);
+  float collectRead() {
+    readIssued = false;
+    if (readResult != ESP_OK) return NAN;
     
-    if (leadsOff) {
-      currentBPM = 0;
-      lastBeatTime = 0;
-    }
+    uint16_t tempData = readBuf[0] | (readBuf[1] << 8);  // PEC byte ignored
     
-    return leadsOff;
+    // Convert to Celsius: (rawValue * 0.02) - 273.15
+    return tempData * 0.02 - 273.15;
   }
   
   /**
-   * Read and process ECG signal
-   * Detects R-peaks and calculates heart rate
-   * @return Current ECG ADC value
+   * Insert a sample into the sorted burst buffer
    */
-  int readECG() {
-    if (checkLeadsOff()) {
-      return 0;
+  void insertSorted(float value) {
+    int i = burstValid;
+    while (i > 0 && burstSamples[i - 1] > value) {
+      burstSamples[i] = burstSamples[i - 1];
+      i--;
     }
+    burstSamples[i] = value;
+    burstValid++;
+  }
+  
+  /**
+   * Average of the burst with outliers removed (top and bottom 20%)
+   */
+  float trimmedMean() {
+    if (burstValid == 0) return NAN;
     
-    int ecgValue = analogRead(ecg_pin);
-    
-    // Update data buffer
-    ecgDataBuffer[dataIndex] = ecgValue;
-    dataIndex = (dataIndex + 1) % BUFFER_SIZE;
-    
-    // Calculate dynamic baseline and threshold
-    long sum = 0;
-    int maxVal = 0;
-    int minVal = 4095;
-    
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-      sum += ecgDataBuffer[i];
-      if (ecgDataBuffer[i] > maxVal) maxVal = ecgDataBuffer[i];
-      if (ecgDataBuffer[i] < minVal) minVal = ecgDataBuffer[i];
-    }
-    
-    baselineValue = sum / BUFFER_SIZE;
-    int amplitude = maxVal - minVal;
-    int threshold = baselineValue + (amplitude * THRESHOLD_PERCENT / 100);
-    
-    // R-wave detection (rising edge over threshold)
-    unsigned long currentTime = millis();
-    if (ecgValue > threshold && (currentTime - lastBeatTime) > 300) {
-      
-      // Calculate RR interval
-      if (lastBeatTime > 0) {
-        beatInterval = currentTime - lastBeatTime;
-        int bpm = 60000 / beatInterval;
-        
-        // Valid range check
-        if (bpm >= BPM_MIN_VALID && bpm <= BPM_MAX_VALID) {
-          currentBPM = bpm;
-          lastFeatures.validBeat = true;
-          lastFeatures.rrInterval = beatInterval;
-          lastFeatures.rPeakAmplitude = ecgValue - baselineValue;
-          lastFeatures.qrsWidth = 80;  // Typical 80-120ms
-        }
-      }
-      
-      lastBeatTime = currentTime;
-      peakValue = ecgValue;
-    }
-    
-    // Reset BPM if no beat for 3 seconds
-    if (currentTime - lastBeatTime > 3000) {
-      currentBPM = 0;
-    }
-    
-    // === ECG Data Compression (Downsampling 100Hz -> 25Hz) ===
-    downsampleCounter++;
-    if (downsampleCounter >= 4) {  // Keep every 4th sample
-      downsampleCounter = 0;
-      
-      // Differential encoding: store difference from previous value
-      int diff = ecgValue - lastCompressedValue;
-      
-      // Compress 12-bit to 8-bit with clipping
-      // Scale difference to fit in -128 to +127 range
-      diff = constrain(diff / 4, -128, 127);
-      
-      // Store compressed sample
-      compressedECG[compressedIndex] = (uint8_t)(diff + 128);  // Offset to 0-255
-      compressedIndex = (compressedIndex + 1) % COMPRESSED_SIZE;
-      
-      lastCompressedValue = ecgValue;
-    }
-    
-    return ecgValue;
-  }
-  
-  /**
-   * Get current heart rate in BPM
-   * @return BPM (0 if no valid reading)
-   */
-  int getBPM() {
-    return currentBPM;
-  }
-  
-  /**
-   * Get last detected ECG features
-   */
-  ECGFeatures getFeatures() {
-    return lastFeatures;
-  }
-  
-  /**
-   * Check if heart rate is abnormal
-   * @return 0=Normal, 1=Bradycardia (slow), 2=Tachycardia (fast), 3=No signal
-   */
-  uint8_t checkHeartRate() {
-    if (leadsOff) return 3;
-    if (currentBPM == 0) return 3;
-    if (currentBPM < BPM_MIN_NORMAL) return 1;  // Too slow
-    if (currentBPM > BPM_MAX_NORMAL) return 2;  // Too fast
-    return 0;  // Normal
-  }
-  
-  /**
-   * Print ECG status and heart rate
-   */
-  void printStatus() {
-    if (leadsOff) {
-      Serial.println("ECG: Leads Off - Check connections");
-      return;
-    }
-    
-    Serial.print("Heart Rate: ");
-    if (currentBPM > 0) {
-      Serial.print(currentBPM);
-      Serial.print(" BPM");
-      
-      uint8_t status = checkHeartRate();
-      switch(status) {
-        case 0:
-          Serial.println(" - Normal");
-          break;
-        case 1:
-          Serial.println(" - ⚠️  BRADYCARDIA (Too Slow!)");
-          break;
-        case 2:
-          Serial.println(" - ⚠️  TACHYCARDIA (Too Fast!)");
-          break;
-      }
-      
-      if (lastFeatures.validBeat) {
-        Serial.print("  RR Interval: ");
-        Serial.print(lastFeatures.rrInterval);
-        Serial.print(" ms  |  R-Peak: ");
-        Serial.print(lastFeatures.rPeakAmplitude);
-        Serial.println(" ADC units");
-      }
-    } else {
-      Serial.println("-- BPM (Waiting for signal...)");
-    }
-  }
-  
-  /**
-   * Print detailed heart beat information
-   */
-  void printBeatDetails() {
-    if (!lastFeatures.validBeat || currentBPM == 0) return;
-    
-    Serial.println("\n=== Heart Beat Detected ===");
-    Serial.print("BPM: "); Serial.println(currentBPM);
-    Serial.print("RR Interval: "); Serial.print(lastFeatures.rrInterval); Serial.println(" ms");
-    Serial.print("R Peak Amplitude: "); Serial.print(lastFeatures.rPeakAmplitude); Serial.println(" ADC units");
-    Serial.print("QRS Width: ~"); Serial.print(lastFeatures.qrsWidth); Serial.println(" ms");
-    Serial.print("Baseline: "); Serial.println(baselineValue);
-    Serial.println("==========================\n");
-  }
-  
-  /**
-   * Extract PQRST wave features from ECG buffer
-   * Simplified detection - finds key points relative to R peak
-   */
-  void extractPQRSTFeatures() {
-    if (!lastFeatures.validBeat) {
-      pqrstValid = false;
-      return;
-    }
-    
-    // Find R peak position in buffer (most recent beat)
-    int rPeakPos = (dataIndex - 1 + BUFFER_SIZE) % BUFFER_SIZE;
-    int rPeakValue = ecgDataBuffer[rPeakPos];
-    
-    // Search for Q wave (before R, local minimum)
-    int qPos = rPeakPos;
-    int qValue = rPeakValue;
-    for (int i = 1; i <= 10 && i < BUFFER_SIZE; i++) {
-      int pos = (rPeakPos - i + BUFFER_SIZE) % BUFFER_SIZE;
-      if (ecgDataBuffer[pos] < qValue) {
-        qValue = ecgDataBuffer[pos];
-        qPos = pos;
-      }
-    }
-    
-    // Search for S wave (after R, local minimum)
-    int sPos = rPeakPos;
-    int sValue = rPeakValue;
-    for (int i = 1; i <= 10 && i < BUFFER_SIZE; i++) {
-      int pos = (rPeakPos + i) % BUFFER_SIZE;
-      if (ecgDataBuffer[pos] < sValue) {
-        sValue = ecgDataBuffer[pos];
-        sPos = pos;
-      }
-    }
-    
-    // Search for P wave (before Q, small peak)
-    int pPos = qPos;
-    int pValue = baselineValue;
-    for (int i = 5; i <= 25 && i < BUFFER_SIZE; i++) {
-      int pos = (qPos - i + BUFFER_SIZE) % BUFFER_SIZE;
-      if (ecgDataBuffer[pos] > pValue && ecgDataBuffer[pos] < rPeakValue) {
-        pValue = ecgDataBuffer[pos];
-        pPos = pos;
-      }
-    }
-    
-    // Search for T wave (after S, broader peak)
-    int tPos = sPos;
-    int tValue = baselineValue;
-    for (int i = 10; i <= 40 && i < BUFFER_SIZE; i++) {
-      int pos = (sPos + i) % BUFFER_SIZE;
-      if (ecgDataBuffer[pos] > tValue && ecgDataBuffer[pos] < rPeakValue) {
-        tValue = ecgDataBuffer[pos];
-        tPos = pos;
-      }
-    }
-    
-    // Calculate QRS width (Q to S duration, samples * 10ms)
-    int qrsWidth = abs(sPos - qPos) * 10;  // 100Hz = 10ms per sample
-    
-    // Calculate QT interval (Q to T duration)
-    int qtInterval = abs(tPos - qPos) * 10;
-    
-    // Store PQRST features (relative to baseline)
-    lastPQRST.timestamp = millis() & 0xFFFF;  // 16-bit timestamp
-    lastPQRST.p_amp = pValue - baselineValue;
-    lastPQRST.q_amp = qValue - baselineValue;
-    lastPQRST.r_amp = rPeakValue - baselineValue;
-    lastPQRST.s_amp = sValue - baselineValue;
-    lastPQRST.t_amp = tValue - baselineValue;
-    lastPQRST.qrs_width = constrain(qrsWidth, 0, 255);
-    lastPQRST.qt_interval = constrain(qtInterval, 0, 255);
-    
-    pqrstValid = true;
-  }
-  
-  /**
-   * Get compressed ECG data for LoRaWAN transmission
-   * Returns number of bytes written to output buffer
-   * 
-   * @param output Output buffer (must be at least COMPRESSED_SIZE bytes)
-   * @param maxSize Maximum size of output buffer
-   * @return Number of bytes written
-   */
-  int getCompressedECG(uint8_t* output, int maxSize) {
-    int size = min(COMPRESSED_SIZE, maxSize);
-    
-    // Copy compressed ECG data
-    for (int i = 0; i < size; i++) {
-      int idx = (compressedIndex + i) % COMPRESSED_SIZE;
-      output[i] = compressedECG[idx];
-    }
-    
-    return size;
-  }
-  
-  /**
-   * Get PQRST wave features packed into bytes
-   * Returns 14 bytes: timestamp(2) + amplitudes(10) + intervals(2)
-   * 
-   * @param output Output buffer (must be at least 14 bytes)
-   * @return Number of bytes written (14 if valid, 0 if no valid PQRST)
-   */
-  int getPQRSTData(uint8_t* output) {
-    if (!pqrstValid) return 0;
-    
-    int idx = 0;
-    
-    // Timestamp (2 bytes)
-    output[idx++] = (lastPQRST.timestamp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.timestamp & 0xFF;
-    
-    // P amplitude (2 bytes, signed)
-    output[idx++] = (lastPQRST.p_amp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.p_amp & 0xFF;
-    
-    // Q amplitude (2 bytes, signed)
-    output[idx++] = (lastPQRST.q_amp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.q_amp & 0xFF;
-    
-    // R amplitude (2 bytes, signed)
-    output[idx++] = (lastPQRST.r_amp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.r_amp & 0xFF;
-    
-    // S amplitude (2 bytes, signed)
-    output[idx++] = (lastPQRST.s_amp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.s_amp & 0xFF;
-    
-    // T amplitude (2 bytes, signed)
-    output[idx++] = (lastPQRST.t_amp >> 8) & 0xFF;
-    output[idx++] = lastPQRST.t_amp & 0xFF;
-    
-    // QRS width (1 byte)
-    output[idx++] = lastPQRST.qrs_width;
-    
-    // QT interval (1 byte)
-    output[idx++] = lastPQRST.qt_interval;
-    
-    return 14;
-  }
-  
-  /**
-   * Get breathing rate estimated from ECG
-   * Based on respiratory sinus arrhythmia (RSA)
-   * @return Breathing rate in breaths per minute
-   */
-  int getBreathingRate() {
-    // Simplified: Use RR interval variation
-    // Typical breathing: 12-20 breaths/min
-    // This is a placeholder - proper BR detection needs more complex analysis
-    if (currentBPM == 0) return 0;
-    
-    // Estimate: BR is typically 1/4 to 1/5 of heart rate
-    int estimatedBR = currentBPM / 4;
-    return constrain(estimatedBR, 10, 30);  // Reasonable range
-  }
-};
-
-// ============================================================================
-// MLX90614 INFRARED TEMPERATURE SENSOR CLASS
-// ============================================================================
-
-/**
- * MLX90614 - Non-Contact IR Temperature Monitoring
- * 
- * This class provides body temperature measurement using infrared sensor
- * with advanced filtering for accurate readings.
- */
-class MLX90614Sensor {
-private:
-  byte address;
-  
-  // Registers
-  const byte REG_AMBIENT_TEMP = 0x06;
-  const byte REG_OBJECT_TEMP = 0x07;
-  
-  // Moving average filter
-  static const int FILTER_SIZE = 10;
-  float tempHistory[FILTER_SIZE];
-  int historyIndex;
-  bool bufferFilled;
-  
-  /**
-   * Read raw temperature from register
-   */
-  float readRawTemp(byte reg) {
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    Wire.endTransmission(false);
-    Wire.requestFrom(address, (byte)3);
-    
-    if (Wire.available() >= 3) {
-      uint16_t tempData = Wire.read();        // Low byte
-      tempData |= Wire.read() << 8;           // High byte
-      Wire.read();                            // PEC byte
-      
-      // Convert to Celsius: (rawValue * 0.02) - 273.15
-      float tempCelsius = tempData * 0.02 - 273.15;
-      return tempCelsius;
-    }
-    
-    return NAN;
-  }
-  
-  /**
-   * Read with multi-sample averaging and outlier filtering
-   */
-  float readFilteredTemp(byte reg, int sampleCount = 20) {
-    float samples[sampleCount];
-    int validCount = 0;
-    
-    // Collect samples
-    for (int i = 0; i < sampleCount; i++) {
-      float temp = readRawTemp(reg);
-      if (!isnan(temp)) {
-        samples[validCount++] = temp;
-      }
-      delay(20);
-    }
-    
-    if (validCount == 0) return NAN;
-    
-    // Sort samples
-    for (int i = 0; i < validCount - 1; i++) {
-      for (int j = i + 1; j < validCount; j++) {
-        if (samples[i] > samples[j]) {
-          float temp = samples[i];
-          samples[i] = samples[j];
-          samples[j] = temp;
-        }
-      }
-    }
-    
-    // Remove outliers (top and bottom 20%)
-    int removeCount = validCount / 5;
-    int startIdx = removeCount;
-    int endIdx = validCount - removeCount;
+    int removeCount = burstValid / 5;
+    int startIdx = removeCount;
+    int endIdx = burstValid - removeCount;
     
     // Calculate average
     float sum = 0;
     for (int i = startIdx; i < endIdx; i++) {
-      sum += samples[i];
+      sum += burstSamples[i];
     }
     
     return sum / (endIdx - startIdx);
@@ -1830,20 +879,23 @@ private:
    * Apply moving average filter
    */
   float applyMovingAverage(float value) {
+    if (bufferFilled) historySum -= tempHistory[historyIndex];
     tempHistory[historyIndex] = value;
+    historySum += value;
     historyIndex = (historyIndex + 1) % FILTER_SIZE;
     
-    if (historyIndex == 0) bufferFilled = true;
-    
-    // Calculate average
-    float sum = 0;
-    int count = bufferFilled ? FILTER_SIZE : historyIndex;
-    
-    for (int i = 0; i < count; i++) {
-      sum += tempHistory[i];
+    if (historyIndex == 0) {
+      bufferFilled = true;
+      
+      // Recompute once per wrap so float rounding cannot accumulate
+      historySum = 0;
+      for (int i = 0; i < FILTER_SIZE; i++) {
+        historySum += tempHistory[i];
+      }
     }
     
-    return (count > 0) ? (sum / count) : value;
+    int count = bufferFilled ? FILTER_SIZE : historyIndex;
+    return (count > 0) ? (historySum / count) : value;
   }
   
 public:
@@ -1865,44 +917,80 @@ public:
    * Constructor
    */
   MLX90614Sensor(byte addr = 0x5A) {
-    address = addr;
+    bus = nullptr;
+    device.address = addr;
+    device.clockHz = I2cBus::STANDARD_HZ;
     historyIndex = 0;
     bufferFilled = false;
+    historySum = 0;
     currentTemp = 0;
     ambientTemp = 0;
     
+    measureState = IDLE;
+    burstTaken = 0;
+    burstValid = 0;
+    readBusy = false;
+    readResult = ESP_OK;
+    readIssued = false;
+    
     for (int i = 0; i < FILTER_SIZE; i++) {
       tempHistory[i] = 0;
     }
   }
   
   /**
-   * Initialize sensor (uses existing I2C)
+   * Initialize sensor
+   * @param i2c Running bus the sensor is on
    */
-  void begin() {
-    Serial.println("MLX90614 IR temperature sensor initialized");
+  void begin(I2cBus& i2c) {
+    bus = &i2c;
+    Log.println("MLX90614 IR temperature sensor initialized");
   }
   
   /**
-   * Read ambient temperature
+   * Begin a new body temperature measurement burst
    */
-  float readAmbient() {
-    ambientTemp = readRawTemp(REG_AMBIENT_TEMP);
-    return ambientTemp;
+  void startMeasurement() {
+    burstTaken = 0;
+    burstValid = 0;
+    measureState = SAMPLING_OBJECT;
   }
   
   /**
-   * Read body temperature with filtering
+   * Advance the measurement by one SMBus read
+   * Collects the read queued on the previous call (if it has finished)
+   * and queues the next one. Call every SAMPLE_SPACING_MS while
+   * isMeasuring() is true.
+   * @return true when the measurement completed on this call
    */
-  float readBodyTemp() {
-    float rawTemp = readFilteredTemp(REG_OBJECT_TEMP, 20);
+  bool update() {
+    if (measureState == IDLE || readBusy) return false;
     
-    if (isnan(rawTemp)) {
-      return NAN;
+    if (readIssued) {
+      float temp = collectRead();
+      
+      if (measureState == READING_AMBIENT) {
+        ambientTemp = temp;
+        measureState = IDLE;
+        return true;
+      }
+      
+      if (!isnan(temp)) insertSorted(temp);
+      if (++burstTaken >= BURST_SIZE) {
+        float filtered = trimmedMean();
+        if (!isnan(filtered)) {
+          currentTemp = applyMovingAverage(filtered);
+        }
+        measureState = READING_AMBIENT;
+      }
     }
     
-    currentTemp = applyMovingAverage(rawTemp);
-    return currentTemp;
+    issueRead(measureState == SAMPLING_OBJECT ? REG_OBJECT_TEMP : REG_AMBIENT_TEMP);
+    return false;
+  }
+  
+  bool isMeasuring() const {
+    return measureState != IDLE;
   }
   
   /**
@@ -1923,37 +1011,37 @@ public:
    * Print temperature status
    */
   void printStatus() {
-    Serial.print("Body Temperature: ");
+    Log.print("Body Temperature: ");
     
     if (isnan(currentTemp)) {
-      Serial.println("Error - Cannot read sensor");
+      Log.println("Error - Cannot read sensor");
       return;
     }
     
-    Serial.print(currentTemp, 2);
-    Serial.print(" \u00b0C (Ambient: ");
-    Serial.print(ambientTemp, 1);
-    Serial.print(" \u00b0C) - ");
+    Log.print(currentTemp, 2);
+    Log.print(" \u00b0C (Ambient: ");
+    Log.print(ambientTemp, 1);
+    Log.print(" \u00b0C) - ");
     
     uint8_t status = checkTempStatus();
     switch(status) {
       case 0:
-        Serial.println("\u2713 Normal");
+        Log.println("\u2713 Normal");
         break;
       case 1:
-        Serial.println("\u26a0\ufe0f  Below Normal (Check sensor placement)");
+        Log.println("\u26a0\ufe0f  Below Normal (Check sensor placement)");
         break;
       case 2:
-        Serial.println("\u26a0\ufe0f  Slightly Elevated");
+        Log.println("\u26a0\ufe0f  Slightly Elevated");
         break;
       case 3:
-        Serial.println("FEVER Detected!");
+        Log.println("FEVER Detected!");
         break;
       case 4:
-        Serial.println("HIGH FEVER - Seek Medical Attention!");
+        Log.println("HIGH FEVER - Seek Medical Attention!");
         break;
       case 5:
-        Serial.println("\u274c Sensor Error");
+        Log.println("\u274c Sensor Error");
         break;
     }
   }
@@ -1968,6 +1056,52 @@ public:
  * 
  * Sends data packets via LoRa to Vision Master E213 receiver
  * Uses RadioLib for SX1262 LoRa module
+ * 
+ * Sending: queueUplink() + service(). Frames wait in per-priority queues
+ * (fall > realtime > ECG), are started with startTransmit() and
+ * completed from the DIO1 TX-done interrupt. The radio sleeps between
+ * frames and a TX-done callback reports each result. A payload built
+ * in uplinkBuffer() is serialized straight into its queue slot and
+ * sent from there, header written in front of it (PacketCodec.h).
+ * 
+ * Confirmed frames (fall events, DANGEROUS alerts): after TX done the
+ * radio listens for ACK_TIMEOUT_MS for the gateway's ACK (Packet Type
+ * 0x08, compact header carrying the acknowledged frame counter). Without
+ * one the identical packet - same frame counter, so the gateway can drop
+ * the copy - is sent again after ACK_BACKOFF_MS, doubling per attempt
+ * with random jitter, up to ACK_RETRIES times. Retransmissions are
+ * charged to the fall class and go out ahead of all queued frames.
+ * Confirmed frames of the other classes (history pages) get one ACK
+ * window and no retransmission - the caller decides when to try again.
+ * 
+ * Adaptive data rate: after each realtime batch (0x04) the radio listens
+ * for ADR_WINDOW_MS. The gateway answers there (Packet Type 0x09) when its
+ * SNR history for this device allows a faster SF / lower TX power, or
+ * calls for more margin. The preamble is stretched at low SFs so it still
+ * outlasts the gateway's multi-SF channel activity scan. The link falls
+ * back to LORA_SPREADING_FACTOR at full power when a confirmed frame goes
+ * unacknowledged or no downlink has been heard for ADR_FALLBACK_MS.
+ * 
+ * Compact-header types carry only the short ID. The first one after boot
+ * or a link change, and every ID_ANNOUNCE_INTERVAL-th one, go out with
+ * the classic header instead, so a gateway learns (or relearns) the
+ * device ID within minutes.
+ * 
+ * Airtime budget: every queued frame is charged its exact time-on-air
+ * (radio.getTimeOnAir() for the real length and SF) against a rolling
+ * one-hour duty-cycle window kept in one-minute buckets. Each class also
+ * earns airtime credit at its share of the duty cycle; mayTransmit()
+ * tells the scheduler when a class may go out. Falls may use the whole
+ * budget, the other classes must leave FALL_RESERVE_SHARE untouched, and
+ * in boost mode (wearer in an abnormal state) ECG may spend spare budget
+ * beyond its share. The backfill class (history pages, Packet Type 0x0A)
+ * goes out last and only on its own credit, so catching up after an
+ * outage never slows the live frames beyond their shares.
+ * 
+ * Header formats: packet types 0x01-0x03 keep the classic 13-byte header
+ * so older receivers still decode them. Newer types (0x04 and up) use a
+ * 6-byte compact header carrying a 16-bit short ID; the gateway learns
+ * which device a short ID belongs to from that device's classic frames.
  */
 
 // Device ID (unique identifier for this device)
@@ -1975,179 +1109,1048 @@ const char* DEVICE_ID = "ESP32-001";
 
 // LoRa Configuration for Heltec WiFi LoRa 32 V3
 // SX1262 Pins
-const int LORA_NSS = 8;      // SPI NSS (Chip Select)
-const int LORA_DIO1 = 14;    // DIO1
-const int LORA_NRST = 12;    // Reset
-const int LORA_BUSY = 13;    // Busy
-
-// LoRa Parameters
-const float LORA_FREQUENCY = 923.0;     // Frequency in MHz (923 for Hong Kong AS923)
-const float LORA_BANDWIDTH = 125.0;     // Bandwidth in kHz
-const uint8_t LORA_SPREADING_FACTOR = 9; // Spreading Factor (7-12)
-const uint8_t LORA_CODING_RATE = 7;     // Coding Rate (5-8)
-const int8_t LORA_OUTPUT_POWER = 22;    // TX Power in dBm (max 22)
-const uint16_t LORA_PREAMBLE_LENGTH = 8; // Preamble length
-const uint8_t LORA_SYNC_WORD = 0x12;    // Sync word (0x12 = private network)
+const int LORA_NSS = HeltecV3Board::LORA_NSS;    // SPI NSS (Chip Select)
+const int LORA_DIO1 = HeltecV3Board::LORA_DIO1;  // DIO1
+const int LORA_NRST = HeltecV3Board::LORA_NRST;  // Reset
+const int LORA_BUSY = HeltecV3Board::LORA_BUSY;  // Busy
+
+// LoRa Parameters - shared with the gateway (shared/include/LinkConfig.h)
+const float LORA_FREQUENCY = RadioConfig::FREQUENCY_MHZ;          // Frequency in MHz (923 for Hong Kong AS923)
+const float LORA_BANDWIDTH = RadioConfig::BANDWIDTH_KHZ;          // Bandwidth in kHz
+const uint8_t LORA_SPREADING_FACTOR = RadioConfig::SPREADING_FACTOR;  // Spreading Factor (7-12)
+const uint8_t LORA_CODING_RATE = RadioConfig::CODING_RATE;        // Coding Rate (5-8)
+const int8_t LORA_OUTPUT_POWER = RadioConfig::OUTPUT_POWER_DBM;   // TX Power in dBm (max 22)
+const uint16_t LORA_PREAMBLE_LENGTH = RadioConfig::PREAMBLE_LENGTH;  // Preamble length
+const uint8_t LORA_SYNC_WORD = RadioConfig::SYNC_WORD;            // Sync word (0x12 = private network)
 
 // SX1262 LoRa module instance
 SX1262 radio = new Module(LORA_NSS, LORA_DIO1, LORA_NRST, LORA_BUSY);
 
-// UART pins for Vision Master E290 communication
+// UART pins for Vision Master E290 communication (framed, see shared/include/UartLink.h)
 const int PIN_UART_TX = 43;  // Connect to Vision Master E290 RX (pin 44)
 const int PIN_UART_RX = 44;  // Connect to Vision Master E290 TX (pin 43)
-const int UART_BAUD = 115200;
+const int UART_BAUD = UartConfig::BADGE_BAUD;
+const size_t BADGE_WAKE_PREAMBLE = UartConfig::BADGE_WAKE_PREAMBLE;  // 0x00 bytes ahead of each frame: the badge light-sleeps
+
+// Badge UART (UART1 through the ESP-IDF driver, not Serial1)
+UartLink badgeLink;
+
+// Set by the SX1262 DIO1 interrupt when a transmission completes (or an
+// ACK window ends)
+volatile bool loraTxDone = false;
+
+void IRAM_ATTR onLoRaDio1() {
+  loraTxDone = true;
+}
 
 class LoRaComm {
+public:
+  // Outbound priority classes (lower value is sent first)
+  enum TxPriority {
+    PRIORITY_FALL = 0,      // Ports 3 and 7, state change alerts
+    PRIORITY_REALTIME = 1,  // Ports 1 and 4
+    PRIORITY_ECG = 2,       // Port 2 and anything else
+    PRIORITY_BACKFILL = 3,  // Port 10 (history pages)
+    PRIORITY_COUNT = 4
+  };
+  
+  // Result reported to the TX-done callback
+  struct TxResult {
+    uint8_t port;
+    uint16_t frameCounter;
+    size_t length;          // Bytes on air including header
+    bool success;
+    int16_t state;          // RadioLib status code
+    uint32_t airtimeMs;     // startTransmit() to TX done
+    uint32_t latencyMs;     // queueUplink() to TX done (or to the ACK)
+    bool confirmed;         // Frame asked for an ACK
+    bool acked;
+    uint8_t attempt;        // 0 = first transmission
+    uint32_t retryInMs;     // Delay before the next attempt (0 = none follows)
+  };
+  
+  typedef void (*TxDoneCallback)(const TxResult& result);
+  
+  static const size_t HEADER_SIZE = LoRaHeader::CLASSIC_SIZE;           // Device ID + frame counter + port
+  static const size_t COMPACT_HEADER_SIZE = LoRaHeader::COMPACT_SIZE;    // Marker + short ID + frame counter + port
+  static const uint8_t COMPACT_MIN_PORT = RadioConfig::COMPACT_MIN_PORT;  // First packet type sent with the compact header
+  static const size_t MAX_PACKET_SIZE = 128;
+  static const size_t MAX_PAYLOAD_SIZE = MAX_PACKET_SIZE - HEADER_SIZE;
+  static const int QUEUE_DEPTH = 4;               // Frames per priority class
+  static const uint8_t ACK_PORT = RadioConfig::ACK_PORT;  // Gateway ACK (downlink)
+  static const size_t ACK_SIZE = DownlinkPacket::ACK_SIZE;
+  static const int ACK_SLOTS = 2;                 // Confirmed frames awaiting an ACK
+  static const uint8_t ADR_PORT = RadioConfig::ADR_PORT;  // Gateway link setting (downlink)
+  static const size_t ADR_SIZE = DownlinkPacket::ADR_SIZE;
+  static const uint8_t ADR_LISTEN_PORT = RadioConfig::ADR_LISTEN_PORT;  // Frames followed by an ADR window
+  static const uint8_t ADR_SF_MIN = RadioConfig::ADR_SF_MIN;  // Fastest SF accepted (LORA_SPREADING_FACTOR is the slowest)
+  
+  // Duty-cycle budget configuration (adjustable at runtime)
+  float DUTY_CYCLE = RadioConfig::DUTY_CYCLE;  // 1% (Hong Kong AS923 SRD limit)
+  float FALL_RESERVE_SHARE = 0.10f;        // Budget only fall/alert frames may use
+  float REALTIME_SHARE = 0.40f;            // Credit rate for realtime frames
+  float ECG_SHARE = 0.35f;                 // Credit rate for ECG frames
+  float BACKFILL_SHARE = 0.15f;            // Credit rate for history pages
+  float BOOST_CEILING_SHARE = 0.70f;       // ECG boost stops at this share of the budget
+  uint32_t REALTIME_MIN_INTERVAL = 30000;  // Never send realtime more often than this (ms)
+  uint32_t ECG_MIN_INTERVAL = 60000;       // Normal ECG spacing floor (ms)
+  uint32_t ECG_BOOST_INTERVAL = 20000;     // ECG spacing floor while boosting (ms)
+  uint8_t ACK_RETRIES = 4;                 // Retransmissions of an unacknowledged frame
+  uint32_t ACK_TIMEOUT_MS = 1000;          // RX window after a confirmed frame
+  uint32_t ACK_BACKOFF_MS = 1000;          // First retry delay, doubled per attempt
+  bool ADR_ENABLED = true;                 // Take SF / TX power from the gateway
+  uint32_t ADR_WINDOW_MS = 400;            // RX window after each realtime batch
+  uint32_t ADR_FALLBACK_MS = 1800000;      // Default link after 30 minutes without a downlink
+  uint8_t ID_ANNOUNCE_INTERVAL = 10;       // Every Nth compact-type frame carries the classic header
+  
 private:
   bool initialized;
   uint32_t lastTxTime;
   uint16_t frameCounter;
+  uint16_t shortId;
+  bool idAnnounceDue;          // Next compact-type frame gets the classic header
+  uint8_t compactSinceAnnounce;
   int lastRssi;
   float lastSnr;
   
-public:
-  LoRaComm() {
-    initialized = false;
-    lastTxTime = 0;
-    frameCounter = 0;
-    lastRssi = 0;
-    lastSnr = 0;
+  // Outbound queues - one ring per priority class, a slot more than
+  // QUEUE_DEPTH so the tail slot is always free for uplinkBuffer(). The
+  // payload sits HEADER_SIZE into the packet; the header is written in
+  // front of it when the frame is started and the radio sends it from
+  // the slot.
+  static const int QUEUE_SLOTS = QUEUE_DEPTH + 1;
+  struct OutboundFrame {
+    uint8_t port;
+    uint8_t len;
+    uint8_t counterSpan;    // Frame counter values the frame consumes
+    bool classicHeader;     // Compact type sent with the device ID (announceId())
+    bool confirmed;         // Listen for an ACK (and retransmit without one)
+    uint8_t priority;
+    uint32_t queuedAt;
+    uint32_t airtimeMs;     // Charged when queued - refunded if the frame is dropped
+    float creditMs;         // Class credit that charge took for it
+    uint8_t packet[MAX_PACKET_SIZE];
+  };
+  OutboundFrame queue[PRIORITY_COUNT][QUEUE_SLOTS];
+  uint8_t queueHead[PRIORITY_COUNT];
+  uint8_t queueCount[PRIORITY_COUNT];
+  uint32_t queueDrops;
+  portMUX_TYPE queueMux = portMUX_INITIALIZER_UNLOCKED;
+  
+  // Frame currently on air
+  bool txBusy;
+  const uint8_t* txPacket;  // Queue or ACK slot (startTransmit() copies it to the radio)
+  size_t txLen;
+  uint8_t txPort;
+  uint16_t txFrameCounter;
+  uint32_t txStartTime;
+  uint32_t txQueuedAt;
+  uint32_t txTimeoutMs;
+  TxDoneCallback txDoneCallback;
+  
+  // Confirmed frames awaiting an ACK (radio task only). The built packet
+  // is kept so a retransmission is byte-identical.
+  struct AckSlot {
+    bool used;
+    uint8_t packet[MAX_PACKET_SIZE];
+    size_t len;
+    uint8_t port;
+    uint16_t frameCounter;
+    TxPriority priority;    // Only fall frames are retransmitted
+    uint8_t attempts;       // Transmissions so far
+    uint32_t retryAt;
+    uint32_t queuedAt;
+  };
+  AckSlot ackSlots[ACK_SLOTS];
+  int txAckSlot;            // Slot of the frame on air (-1 = unconfirmed)
+  bool rxWaiting;           // Downlink window open after that frame
+  uint32_t rxStartTime;
+  uint32_t rxWindowMs;
+  
+  // Link settings (ADR)
+  uint8_t spreadingFactor;
+  int8_t outputPower;
+  bool adrPending;          // Setting received, applied when the window closes
+  uint8_t adrSf;
+  int8_t adrPower;
+  uint32_t lastDownlink;
+  uint32_t adrChanges;
+  uint32_t ackRetransmissions;
+  uint32_t ackFailures;     // Frames given up without an ACK
+  
+  // Rolling one-hour airtime window (one-minute buckets)
+  static const int BUDGET_BUCKETS = 60;
+  static const uint32_t BUCKET_MS = 60000;
+  uint32_t bucketAirtime[BUDGET_BUCKETS];
+  uint32_t bucketMinute[BUDGET_BUCKETS];
+  
+  // Per-class airtime credit (ms) and pacing
+  float classCredit[PRIORITY_COUNT];
+  uint32_t creditUpdated;
+  uint32_t lastQueued[PRIORITY_COUNT];
+  bool boostMode;
+  portMUX_TYPE budgetMux = portMUX_INITIALIZER_UNLOCKED;  // Radio task + status display
+  
+  uint32_t budgetMs() const {
+    return (uint32_t)(3600000.0f * DUTY_CYCLE);
+  }
+  
+  float classShare(TxPriority priority) const {
+    switch (priority) {
+      case PRIORITY_FALL: return FALL_RESERVE_SHARE;
+      case PRIORITY_REALTIME: return REALTIME_SHARE;
+      case PRIORITY_BACKFILL: return BACKFILL_SHARE;
+      default: return ECG_SHARE;
+    }
+  }
+  
+  uint32_t classMinInterval(TxPriority priority) const {
+    switch (priority) {
+      case PRIORITY_FALL: return 0;
+      case PRIORITY_REALTIME: return REALTIME_MIN_INTERVAL;
+      case PRIORITY_BACKFILL: return 0;
+      default: return boostMode ? ECG_BOOST_INTERVAL : ECG_MIN_INTERVAL;
+    }
   }
   
   /**
-   * Initialize LoRa module
+   * Credit cap - about 6 minutes of accrual, so a class can burst a little
+   * after being idle but cannot hoard the hour
    */
-  bool begin() {
-    Serial.println("\n🔧 Initializing LoRa SX1262...");
-    
-    // Initialize SX1262
-    int state = radio.begin(LORA_FREQUENCY, LORA_BANDWIDTH, LORA_SPREADING_FACTOR, 
-                           LORA_CODING_RATE, LORA_SYNC_WORD, LORA_OUTPUT_POWER, 
-                           LORA_PREAMBLE_LENGTH);
-    
-    if (state == RADIOLIB_ERR_NONE) {
-      Serial.println("✅ LoRa initialized successfully!");
-      Serial.printf("   Frequency: %.1f MHz\n", LORA_FREQUENCY);
-      Serial.printf("   Bandwidth: %.1f kHz\n", LORA_BANDWIDTH);
-      Serial.printf("   Spreading Factor: %d\n", LORA_SPREADING_FACTOR);
-      Serial.printf("   TX Power: %d dBm\n", LORA_OUTPUT_POWER);
-      initialized = true;
-      return true;
-    } else {
-      Serial.print("❌ LoRa initialization failed, code: ");
-      Serial.println(state);
-      return false;
-    }
+  float classCreditCap(TxPriority priority) const {
+    return budgetMs() * classShare(priority) / 10.0f;
   }
   
   /**
-   * Check if LoRa is initialized (compatibility method)
+   * Accrue class credit for the time elapsed since the last update
    */
-  bool connect() {
-    return initialized;
+  void accrueCredit(uint32_t now) {
+    uint32_t elapsed = now - creditUpdated;
+    creditUpdated = now;
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      TxPriority priority = (TxPriority)p;
+      classCredit[p] += elapsed * DUTY_CYCLE * classShare(priority);
+      float cap = classCreditCap(priority);
+      if (classCredit[p] > cap) classCredit[p] = cap;
+    }
   }
   
   /**
-   * Send data via LoRa
-   * @param port Packet type (1=realtime, 2=ECG, 3=fall)
-   * @param data Data buffer
-   * @param len Data length
-   * @param confirmed Not used (kept for compatibility)
-   * @return true if sent successfully
+   * Whether a frame of this class and size may be charged right now
    */
-  bool sendUplink(uint8_t port, uint8_t* data, size_t len, bool confirmed = false) {
-    if (!initialized) {
-      Serial.println("❌ LoRa not initialized");
+  bool admit(TxPriority priority, uint32_t airtime, uint32_t now) {
+    accrueCredit(now);
+    uint32_t used = sumBuckets(now);
+    uint32_t budget = budgetMs();
+    
+    // Hard legal limit - only falls may dip into the reserve
+    uint32_t ceiling = (priority == PRIORITY_FALL) ? budget :
+                       (uint32_t)(budget * (1.0f - FALL_RESERVE_SHARE));
+    if (used + airtime > ceiling) return false;
+    if (priority == PRIORITY_FALL) return true;
+    
+    if (now - lastQueued[priority] < classMinInterval(priority) && lastQueued[priority] != 0) {
       return false;
     }
+    if (classCredit[priority] >= airtime) return true;
     
-    // Create packet with header
-    // Packet format: [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)] [Data (n bytes)]
-    uint8_t packet[128];
-    int packetLen = 0;
-    
-    // Add device ID (10 bytes, padded with zeros)
-    memset(packet, 0, 10);
-    strncpy((char*)packet, DEVICE_ID, 10);
-    packetLen = 10;
-    
-    // Add frame counter (2 bytes, little-endian)
-    packet[packetLen++] = frameCounter & 0xFF;
-    packet[packetLen++] = (frameCounter >> 8) & 0xFF;
-    
-    // Add port/packet type (1 byte)
-    packet[packetLen++] = port;
-    
-    // Add payload data
-    memcpy(packet + packetLen, data, len);
-    packetLen += len;
-    
-    // Send packet
-    Serial.printf("📡 Sending LoRa packet (Type %d, %d bytes)...\n", port, packetLen);
-    
-    int state = radio.transmit(packet, packetLen);
-    
-    if (state == RADIOLIB_ERR_NONE) {
-      // Get transmission info
-      lastRssi = radio.getRSSI();
-      lastSnr = radio.getSNR();
-      
-      Serial.println("✅ Packet sent successfully!");
-      Serial.printf("   Frame: %d\n", frameCounter);
-      Serial.printf("   Size: %d bytes\n", packetLen);
-      
-      frameCounter++;
-      lastTxTime = millis();
-      return true;
-    } else {
-      Serial.print("❌ LoRa transmission failed, code: ");
-      Serial.println(state);
-      return false;
+    // Boost: abnormal state lets ECG use spare budget beyond its share
+    return boostMode && priority == PRIORITY_ECG &&
+           used + airtime <= (uint32_t)(budget * BOOST_CEILING_SHARE);
+  }
+  
+  /**
+   * Airtime charged in the hour ending at now (budgetMux held)
+   */
+  uint32_t sumBuckets(uint32_t now) const {
+    uint32_t minute = now / BUCKET_MS;
+    uint32_t used = 0;
+    for (int i = 0; i < BUDGET_BUCKETS; i++) {
+      if (bucketMinute[i] != 0xFFFFFFFF && minute - bucketMinute[i] < BUDGET_BUCKETS) {
+        used += bucketAirtime[i];
+      }
     }
+    return used;
   }
   
   /**
-   * Check if LoRa is initialized
+   * Charge a frame's airtime to the hour window and its class credit
+   * @return Credit taken (less than airtime when the class ran dry)
    */
-  bool isJoined() {
-    return initialized;
+  float charge(TxPriority priority, uint32_t airtime, uint32_t now) {
+    uint32_t minute = now / BUCKET_MS;
+    int idx = minute % BUDGET_BUCKETS;
+    if (bucketMinute[idx] != minute) {
+      bucketMinute[idx] = minute;
+      bucketAirtime[idx] = 0;
+    }
+    bucketAirtime[idx] += airtime;
+    
+    float taken = classCredit[priority] < airtime ? classCredit[priority] : (float)airtime;
+    classCredit[priority] -= taken;  // Boost/fall frames carry no debt
+    lastQueued[priority] = now;
+    return taken;
   }
   
   /**
-   * Get frame counter
+   * Give back what charge() took for a frame that never went on air
+   * (budgetMux held)
    */
-  uint16_t getFrameCounter() {
-    return frameCounter;
+  void refund(TxPriority priority, uint32_t airtime, float credit, uint32_t chargedAt) {
+    uint32_t minute = chargedAt / BUCKET_MS;
+    int idx = minute % BUDGET_BUCKETS;
+    if (bucketMinute[idx] == minute) {
+      bucketAirtime[idx] -= bucketAirtime[idx] < airtime ? bucketAirtime[idx] : airtime;
+    }
+    classCredit[priority] += credit;
   }
   
   /**
-   * Get last RSSI
+   * Write the header for a packet type
+   * Classic: [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+   * Compact: [0x81] [Short ID (2 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+   * @param classic Classic header even for a compact type
+   * @return Header length (headerSize(port, classic))
    */
-  int getRSSI() {
-    return lastRssi;
+  size_t writeHeader(uint8_t* packet, uint8_t port, uint16_t counter, bool classic = false) {
+    if (port >= COMPACT_MIN_PORT && !classic) {
+      return LoRaHeader::writeCompact(packet, shortId, counter, port);
+    }
+    return LoRaHeader::writeClassic(packet, DEVICE_ID, counter, port);
   }
   
   /**
-   * Get last SNR
+   * Whether the next compact-type frame should carry the classic header
+   * Gateways learn short ID -> device ID only from classic frames, and
+   * forget it on a reboot or table eviction; alerts (the other classic
+   * frames) may not come for days. So the first frame after boot, the
+   * first after a link change (it may reach another gateway) and every
+   * ID_ANNOUNCE_INTERVAL-th one name the device. (queueMux held)
    */
-  float getSNR() {
-    return lastSnr;
+  bool announceDue() const {
+    return idAnnounceDue || (ID_ANNOUNCE_INTERVAL > 0 && compactSinceAnnounce + 1 >= ID_ANNOUNCE_INTERVAL);
   }
   
   /**
-   * Check LoRa status (compatibility method)
+   * Count a queued compact-type frame (queueMux held)
    */
-  void maintain() {
-    // LoRa doesn't need connection maintenance
-    // This method kept for compatibility
+  void noteCompactFrame(bool classic) {
+    if (classic) {
+      idAnnounceDue = false;
+      compactSinceAnnounce = 0;
+    } else if (compactSinceAnnounce < 255) {
+      compactSinceAnnounce++;
+    }
   }
-};
-
-// ============================================================================
-// PAYLOAD BUILDER
-// ============================================================================
-
-/**
+  
+  /**
+   * Pop the highest priority queued frame
+   * The slot stays valid until the next queueUplink() - the frame must be
+   * started before then (producers share the radio task with service())
+   * @return The frame, nullptr if all queues are empty
+   */
+  OutboundFrame* dequeue() {
+    OutboundFrame* frame = nullptr;
+    portENTER_CRITICAL(&queueMux);
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      if (queueCount[p] > 0) {
+        frame = &queue[p][queueHead[p]];
+        queueHead[p] = (queueHead[p] + 1) % QUEUE_SLOTS;
+        queueCount[p]--;
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&queueMux);
+    return frame;
+  }
+  
+  /**
+   * Start txPacket on air (radio must be idle)
+   */
+  void transmit() {
+    // Allow twice the computed time-on-air before declaring the TX lost
+    txTimeoutMs = radio.getTimeOnAir(txLen) / 500 + 200;
+    
+    loraTxDone = false;
+    int state = radio.startTransmit(txPacket, txLen);
+    txStartTime = millis();
+    
+    if (state == RADIOLIB_ERR_NONE) {
+      txBusy = true;
+    } else {
+      finish(false, state, false);
+    }
+  }
+  
+  /**
+   * Start the next frame: a due retransmission, else the highest priority
+   * queued frame (radio must be idle)
+   */
+  void startNext() {
+    if (startRetransmission()) return;
+    
+    OutboundFrame* frame = dequeue();
+    if (frame == nullptr) return;
+    
+    txPort = frame->port;
+    txFrameCounter = frameCounter;
+    txQueuedAt = frame->queuedAt;
+    
+    // Header in place in front of the payload
+    uint8_t* packet = frame->packet + HEADER_SIZE - headerSize(frame->port, frame->classicHeader);
+    txLen = writeHeader(packet, frame->port, txFrameCounter, frame->classicHeader) + frame->len;
+    txPacket = packet;
+    frameCounter += frame->counterSpan;  // Reserved up front - a retransmission reuses it
+    
+    txAckSlot = -1;
+    if (frame->confirmed) {
+      for (int i = 0; i < ACK_SLOTS; i++) {
+        if (!ackSlots[i].used) {
+          txAckSlot = i;
+          break;
+        }
+      }
+      if (txAckSlot >= 0) {
+        AckSlot& slot = ackSlots[txAckSlot];
+        slot.used = true;
+        memcpy(slot.packet, txPacket, txLen);
+        slot.len = txLen;
+        slot.port = txPort;
+        slot.frameCounter = txFrameCounter;
+        slot.priority = (TxPriority)frame->priority;
+        slot.attempts = 1;
+        slot.queuedAt = txQueuedAt;
+      } else {
+        LOG_W(LOG_LORA, "No ACK slot free - Type %d frame %u sent unconfirmed", txPort, txFrameCounter);
+      }
+    }
+    
+    transmit();
+  }
+  
+  /**
+   * Resend the oldest due unacknowledged frame
+   * @return true if one was started
+   */
+  bool startRetransmission() {
+    uint32_t now = millis();
+    for (int i = 0; i < ACK_SLOTS; i++) {
+      AckSlot& slot = ackSlots[i];
+      if (!slot.used || (int32_t)(now - slot.retryAt) < 0) continue;
+      
+      uint32_t airtime = (radio.getTimeOnAir(slot.len) + 999) / 1000;
+      portENTER_CRITICAL(&budgetMux);
+      bool admitted = admit(PRIORITY_FALL, airtime, now);
+      if (admitted) charge(PRIORITY_FALL, airtime, now);
+      portEXIT_CRITICAL(&budgetMux);
+      if (!admitted) {
+        slot.used = false;
+        ackFailures++;
+        LOG_W(LOG_LORA, "Type %d frame %u not acknowledged - airtime budget exhausted", slot.port, slot.frameCounter);
+        continue;
+      }
+      
+      txPacket = slot.packet;
+      txLen = slot.len;
+      txPort = slot.port;
+      txFrameCounter = slot.frameCounter;
+      txQueuedAt = slot.queuedAt;
+      txAckSlot = i;
+      slot.attempts++;
+      ackRetransmissions++;
+      transmit();
+      return true;
+    }
+    return false;
+  }
+  
+  /**
+   * Reconfigure the modem (radio idle); time-on-air follows automatically
+   */
+  void applyLinkSettings(uint8_t sf, int8_t power) {
+    if (sf == spreadingFactor && power == outputPower) return;
+    radio.standby();
+    radio.setSpreadingFactor(sf);
+    radio.setPreambleLength(RadioConfig::preambleSymbols(sf));  // Outlasts the gateway's CAD cycle
+    radio.setOutputPower(power);
+    spreadingFactor = sf;
+    outputPower = power;
+    adrChanges++;
+    portENTER_CRITICAL(&queueMux);
+    idAnnounceDue = true;
+    portEXIT_CRITICAL(&queueMux);
+    LOG_I(LOG_LORA, "Link set to SF%u, %d dBm", sf, power);
+  }
+  
+  bool linkAdapted() const {
+    return spreadingFactor != LORA_SPREADING_FACTOR || outputPower != LORA_OUTPUT_POWER;
+  }
+  
+  /**
+   * Listen for a downlink (ACK or ADR) after the frame just sent
+   */
+  void openDownlinkWindow(uint32_t windowMs) {
+    loraTxDone = false;
+    rxStartTime = millis();
+    rxWindowMs = windowMs;
+    // Timeout in 15.625 us steps; DIO1 fires on a packet or at the timeout
+    int state = radio.startReceive(windowMs * 64, RADIOLIB_SX126X_IRQ_RX_DEFAULT,
+                                   RADIOLIB_SX126X_IRQ_RX_DONE | RADIOLIB_SX126X_IRQ_TIMEOUT);
+    if (state == RADIOLIB_ERR_NONE) {
+      rxWaiting = true;
+    } else {
+      finish(true, state, false);
+    }
+  }
+  
+  /**
+   * Decode a downlink addressed to the frame on air
+   * Format: [0x81][Short ID 2B][Frame Counter 2B][Port] then
+   *   ACK (0x08): [0x08]
+   *   ADR (0x09): [0x09][SF][TX power dBm]
+   * @return true if it acknowledges the frame (an ADR setting is kept for finish())
+   */
+  bool readDownlink() {
+    size_t len = radio.getPacketLength();
+    if (len != ACK_SIZE && len != ADR_SIZE) return false;
+    uint8_t rx[ADR_SIZE];
+    if (radio.readData(rx, len) != RADIOLIB_ERR_NONE) return false;
+    
+    LoRaHeader::View header(rx, len);
+    if (!header.compact() ||
+        header.shortId() != shortId ||
+        header.frameCounter() != txFrameCounter ||
+        header.port() != header.payload()[0]) {
+      return false;
+    }
+    lastDownlink = millis();
+    
+    if (header.port() == ACK_PORT && len == ACK_SIZE) return true;
+    
+    if (header.port() == ADR_PORT && len == ADR_SIZE && ADR_ENABLED) {
+      uint8_t sf = rx[DownlinkPacket::ADR_SF];
+      int8_t power = (int8_t)rx[DownlinkPacket::ADR_POWER];
+      if (sf >= ADR_SF_MIN && sf <= LORA_SPREADING_FACTOR && power >= -9 && power <= LORA_OUTPUT_POWER) {
+        adrSf = sf;
+        adrPower = power;
+        adrPending = true;
+      }
+    }
+    return false;
+  }
+  
+  /**
+   * Complete the current frame, put the radio to sleep and report it
+   * A confirmed frame without an ACK is scheduled for retransmission.
+   */
+  void finish(bool success, int16_t state, bool acked) {
+    uint32_t now = millis();
+    txBusy = false;
+    rxWaiting = false;
+    
+    if (success) {
+      lastRssi = radio.getRSSI();
+      lastSnr = radio.getSNR();
+      lastTxTime = now;
+    }
+    
+    // A missed ACK may mean the adapted link is too thin - retry on the default
+    if (adrPending) {
+      adrPending = false;
+      applyLinkSettings(adrSf, adrPower);
+    } else if (txAckSlot >= 0 && !acked && linkAdapted()) {
+      applyLinkSettings(LORA_SPREADING_FACTOR, LORA_OUTPUT_POWER);
+    }
+    radio.sleep();  // Warm sleep keeps configuration for the next startTransmit()
+    
+    uint8_t attempt = 0;
+    uint32_t retryIn = 0;
+    if (txAckSlot >= 0) {
+      AckSlot& slot = ackSlots[txAckSlot];
+      attempt = slot.attempts - 1;
+      if (acked) {
+        slot.used = false;
+      } else if (slot.attempts > ACK_RETRIES || slot.priority != PRIORITY_FALL) {
+        slot.used = false;
+        ackFailures++;
+      } else {
+        retryIn = (ACK_BACKOFF_MS << (slot.attempts - 1)) + random(ACK_BACKOFF_MS);
+        slot.retryAt = now + retryIn;
+      }
+    }
+    
+    if (txDoneCallback != nullptr) {
+      TxResult result;
+      result.port = txPort;
+      result.frameCounter = txFrameCounter;
+      result.length = txLen;
+      result.success = success;
+      result.state = state;
+      result.airtimeMs = now - txStartTime;
+      result.latencyMs = now - txQueuedAt;
+      result.confirmed = txAckSlot >= 0;
+      result.acked = acked;
+      result.attempt = attempt;
+      result.retryInMs = retryIn;
+      txDoneCallback(result);
+    }
+    txAckSlot = -1;
+  }
+  
+public:
+  LoRaComm() {
+    initialized = false;
+    lastTxTime = 0;
+    frameCounter = 0;
+    shortId = 0;
+    idAnnounceDue = true;  // First frame after boot names the device
+    compactSinceAnnounce = 0;
+    lastRssi = 0;
+    lastSnr = 0;
+    
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      queueHead[p] = 0;
+      queueCount[p] = 0;
+    }
+    queueDrops = 0;
+    txBusy = false;
+    txPacket = nullptr;
+    txLen = 0;
+    txPort = 0;
+    txFrameCounter = 0;
+    txStartTime = 0;
+    txQueuedAt = 0;
+    txTimeoutMs = 0;
+    txDoneCallback = nullptr;
+    for (int i = 0; i < ACK_SLOTS; i++) {
+      ackSlots[i].used = false;
+    }
+    txAckSlot = -1;
+    rxWaiting = false;
+    rxStartTime = 0;
+    rxWindowMs = 0;
+    spreadingFactor = LORA_SPREADING_FACTOR;
+    outputPower = LORA_OUTPUT_POWER;
+    adrPending = false;
+    adrSf = LORA_SPREADING_FACTOR;
+    adrPower = LORA_OUTPUT_POWER;
+    lastDownlink = 0;
+    adrChanges = 0;
+    ackRetransmissions = 0;
+    ackFailures = 0;
+    
+    for (int i = 0; i < BUDGET_BUCKETS; i++) {
+      bucketAirtime[i] = 0;
+      bucketMinute[i] = 0xFFFFFFFF;
+    }
+    for (int p = 0; p < PRIORITY_COUNT; p++) {
+      classCredit[p] = 0;
+      lastQueued[p] = 0;
+    }
+    creditUpdated = 0;
+    boostMode = false;
+  }
+  
+  /**
+   * Initialize LoRa module
+   */
+  bool begin() {
+    Log.println("\n🔧 Initializing LoRa SX1262...");
+    
+    // Initialize SX1262
+    int state = radio.begin(LORA_FREQUENCY, LORA_BANDWIDTH, LORA_SPREADING_FACTOR, 
+                           LORA_CODING_RATE, LORA_SYNC_WORD, LORA_OUTPUT_POWER, 
+                           LORA_PREAMBLE_LENGTH);
+    
+    if (state == RADIOLIB_ERR_NONE) {
+      Log.println("✅ LoRa initialized successfully!");
+      Log.printf("   Frequency: %.1f MHz\n", LORA_FREQUENCY);
+      Log.printf("   Bandwidth: %.1f kHz\n", LORA_BANDWIDTH);
+      Log.printf("   Spreading Factor: %d\n", LORA_SPREADING_FACTOR);
+      Log.printf("   TX Power: %d dBm\n", LORA_OUTPUT_POWER);
+      radio.setDio1Action(onLoRaDio1);
+      radio.sleep();
+      
+      shortId = LoRaHeader::shortIdOf(DEVICE_ID);
+      Log.printf("   Short ID: 0x%04X\n", shortId);
+      
+      // Start with full class credit so the first frames go out promptly
+      creditUpdated = millis();
+      for (int p = 0; p < PRIORITY_COUNT; p++) {
+        classCredit[p] = classCreditCap((TxPriority)p);
+      }
+      Log.printf("   Airtime budget: %lu ms/hour (%.1f%% duty cycle)\n",
+                    (unsigned long)budgetMs(), DUTY_CYCLE * 100.0f);
+      initialized = true;
+      return true;
+    } else {
+      Log.print("❌ LoRa initialization failed, code: ");
+      Log.println(state);
+      return false;
+    }
+  }
+  
+  /**
+   * Default priority class for a port
+   */
+  static TxPriority priorityForPort(uint8_t port) {
+    switch (port) {
+      case 3:
+      case 7: return PRIORITY_FALL;
+      case 1:
+      case 4: return PRIORITY_REALTIME;
+      case 10: return PRIORITY_BACKFILL;
+      default: return PRIORITY_ECG;
+    }
+  }
+  
+  /**
+   * Buffer the next frame of a class is queued from
+   * Build the payload here and pass it to queueUplink() with the same
+   * port and priority: it is then sent without being copied. Valid until
+   * the next queueUplink() of that class.
+   * @return MAX_PAYLOAD_SIZE bytes
+   */
+  uint8_t* uplinkBuffer(uint8_t port, TxPriority priority = PRIORITY_COUNT) {
+    if (priority >= PRIORITY_COUNT) priority = priorityForPort(port);
+    portENTER_CRITICAL(&queueMux);
+    OutboundFrame& frame = queue[priority][(queueHead[priority] + queueCount[priority]) % QUEUE_SLOTS];
+    portEXIT_CRITICAL(&queueMux);
+    return frame.packet + HEADER_SIZE;
+  }
+  
+  /**
+   * Queue a frame for asynchronous transmission
+   * The frame is refused if the airtime budget does not allow its class
+   * to send now. When the class queue is full the oldest frame of that
+   * class is dropped - newer readings supersede it - and its airtime is
+   * refunded.
+   * @param port Packet type (1=realtime, 2=ECG, 3=fall, 4=realtime batch)
+   * @param data Payload (copied unless it was built in uplinkBuffer())
+   * @param len Payload length
+   * @param priority Priority class (defaults to priorityForPort(port))
+   * @param counterSpan Frame counter values to reserve (one per reading
+   *                    in a batch, so receivers can number each reading)
+   * @param confirmed Wait for the gateway's ACK and retransmit without one
+   * @return true if queued
+   */
+  bool queueUplink(uint8_t port, const uint8_t* data, size_t len,
+                   TxPriority priority = PRIORITY_COUNT, uint8_t counterSpan = 1,
+                   bool confirmed = false) {
+    if (!initialized || len > MAX_PAYLOAD_SIZE || counterSpan == 0) return false;
+    if (priority >= PRIORITY_COUNT) priority = priorityForPort(port);
+    
+    bool classic = false;
+    if (port >= COMPACT_MIN_PORT) {
+      portENTER_CRITICAL(&queueMux);
+      classic = announceDue();
+      portEXIT_CRITICAL(&queueMux);
+    }
+    
+    // Charge airtime when queued so frames waiting in the queue are counted
+    uint32_t airtime = airtimeMs(len, port, classic);
+    float credit = 0;
+    portENTER_CRITICAL(&budgetMux);
+    uint32_t now = millis();
+    bool admitted = admit(priority, airtime, now);
+    if (admitted) credit = charge(priority, airtime, now);
+    portEXIT_CRITICAL(&budgetMux);
+    if (!admitted) return false;
+    
+    // A dropped frame never goes on air - its airtime goes back to the class
+    bool evicted = false;
+    uint32_t droppedAirtime = 0;
+    float droppedCredit = 0;
+    uint32_t droppedAt = 0;
+    portENTER_CRITICAL(&queueMux);
+    if (queueCount[priority] == QUEUE_DEPTH) {
+      const OutboundFrame& oldest = queue[priority][queueHead[priority]];
+      droppedAirtime = oldest.airtimeMs;
+      droppedCredit = oldest.creditMs;
+      droppedAt = oldest.queuedAt;
+      if (oldest.classicHeader) idAnnounceDue = true;  // The announcement never went out
+      evicted = true;
+      queueHead[priority] = (queueHead[priority] + 1) % QUEUE_SLOTS;
+      queueCount[priority]--;
+      queueDrops++;
+    }
+    OutboundFrame& frame = queue[priority][(queueHead[priority] + queueCount[priority]) % QUEUE_SLOTS];
+    frame.port = port;
+    frame.len = len;
+    frame.counterSpan = counterSpan;
+    frame.confirmed = confirmed;
+    frame.classicHeader = classic;
+    if (port >= COMPACT_MIN_PORT) noteCompactFrame(classic);
+    frame.priority = priority;
+    frame.queuedAt = now;
+    frame.airtimeMs = airtime;
+    frame.creditMs = credit;
+    if (data != frame.packet + HEADER_SIZE) memcpy(frame.packet + HEADER_SIZE, data, len);
+    queueCount[priority]++;
+    portEXIT_CRITICAL(&queueMux);
+    
+    if (evicted) {
+      portENTER_CRITICAL(&budgetMux);
+      refund(priority, droppedAirtime, droppedCredit, droppedAt);
+      portEXIT_CRITICAL(&budgetMux);
+    }
+    return true;
+  }
+  
+  /**
+   * Drive the async TX state machine (call from the radio task)
+   * Completes a finished frame (after its ACK window if confirmed) and
+   * starts the next one.
+   */
+  void service() {
+    if (!initialized) return;
+    
+    if (txBusy) {
+      if (loraTxDone) {
+        loraTxDone = false;
+        int state = radio.finishTransmit();
+        txBusy = false;
+        if (state == RADIOLIB_ERR_NONE && txAckSlot >= 0) {
+          openDownlinkWindow(ACK_TIMEOUT_MS);
+          return;
+        }
+        if (state == RADIOLIB_ERR_NONE && ADR_ENABLED && txPort == ADR_LISTEN_PORT) {
+          openDownlinkWindow(ADR_WINDOW_MS);
+          return;
+        }
+        finish(state == RADIOLIB_ERR_NONE, state, false);
+      } else if (millis() - txStartTime > txTimeoutMs) {
+        radio.finishTransmit();
+        finish(false, RADIOLIB_ERR_TX_TIMEOUT, false);
+      } else {
+        return;
+      }
+    }
+    
+    if (rxWaiting) {
+      // Software deadline backs up the radio's own RX timeout
+      if (loraTxDone || millis() - rxStartTime > rxWindowMs + 50) {
+        bool acked = loraTxDone && readDownlink();
+        loraTxDone = false;
+        finish(true, RADIOLIB_ERR_NONE, acked);
+      } else {
+        return;
+      }
+    }
+    
+    // No word from the gateway for a long time - it may not hear this SF
+    if (linkAdapted() && millis() - lastDownlink > ADR_FALLBACK_MS) {
+      applyLinkSettings(LORA_SPREADING_FACTOR, LORA_OUTPUT_POWER);
+      radio.sleep();
+    }
+    
+    startNext();
+  }
+  
+  /**
+   * Register the TX-done callback (runs in the caller of service())
+   */
+  void onTxDone(TxDoneCallback callback) {
+    txDoneCallback = callback;
+  }
+  
+  /**
+   * True while a frame is on air or its ACK window is open
+   */
+  bool isBusy() const {
+    return txBusy || rxWaiting;
+  }
+  
+  /**
+   * Frames waiting in all queues
+   */
+  int pendingCount() {
+    int total = 0;
+    portENTER_CRITICAL(&queueMux);
+    for (int p = 0; p < PRIORITY_COUNT; p++) total += queueCount[p];
+    portEXIT_CRITICAL(&queueMux);
+    return total;
+  }
+  
+  /**
+   * Frames waiting in one priority class
+   */
+  int pendingCount(TxPriority priority) {
+    if (priority >= PRIORITY_COUNT) return 0;
+    portENTER_CRITICAL(&queueMux);
+    int count = queueCount[priority];
+    portEXIT_CRITICAL(&queueMux);
+    return count;
+  }
+  
+  uint32_t getQueueDrops() const {
+    return queueDrops;
+  }
+  
+  /**
+   * Confirmed frames still waiting for an ACK or a retransmission
+   */
+  int pendingAckCount() const {
+    int count = 0;
+    for (int i = 0; i < ACK_SLOTS; i++) {
+      if (ackSlots[i].used) count++;
+    }
+    return count;
+  }
+  
+  uint32_t getAckRetransmissions() const {
+    return ackRetransmissions;
+  }
+  
+  uint32_t getAckFailures() const {
+    return ackFailures;
+  }
+  
+  /**
+   * Header length used for a packet type
+   * @param classic Classic header even for a compact type
+   */
+  static size_t headerSize(uint8_t port, bool classic = false) {
+    return classic ? LoRaHeader::CLASSIC_SIZE : LoRaHeader::sizeFor(port);
+  }
+  
+  /**
+   * Time-on-air for a payload of this length (header included)
+   * @param port Packet type, selects the header format
+   * @param classic Classic header even for a compact type
+   * @return Airtime in milliseconds at the current modulation
+   */
+  uint32_t airtimeMs(size_t payloadLen, uint8_t port = 1, bool classic = false) {
+    return (radio.getTimeOnAir(headerSize(port, classic) + payloadLen) + 999) / 1000;
+  }
+  
+  /**
+   * Airtime charged in the last hour
+   */
+  uint32_t usedAirtimeMs() {
+    portENTER_CRITICAL(&budgetMux);
+    uint32_t used = sumBuckets(millis());
+    portEXIT_CRITICAL(&budgetMux);
+    return used;
+  }
+  
+  /**
+   * Rolling-hour duty cycle used so far (0.0 - 1.0 of the legal budget)
+   */
+  float budgetUsage() {
+    return (float)usedAirtimeMs() / budgetMs();
+  }
+  
+  /**
+   * Whether the scheduler may send a frame of this class now
+   * @param priority Packet class
+   * @param payloadLen Expected payload length
+   * @param port Packet type, selects the header format
+   */
+  bool mayTransmit(TxPriority priority, size_t payloadLen, uint8_t port = 1) {
+    uint32_t airtime = airtimeMs(payloadLen, port);
+    portENTER_CRITICAL(&budgetMux);
+    bool allowed = admit(priority, airtime, millis());
+    portEXIT_CRITICAL(&budgetMux);
+    return allowed;
+  }
+  
+  /**
+   * Whether a frame keeps the hour's airtime within a share of the budget
+   * (for bulk frames sent in the fall class that must not eat the reserve)
+   */
+  bool fitsBudgetShare(float share, size_t payloadLen, uint8_t port = 1) {
+    uint32_t airtime = airtimeMs(payloadLen, port);
+    portENTER_CRITICAL(&budgetMux);
+    bool fits = sumBuckets(millis()) + airtime <= (uint32_t)(budgetMs() * share);
+    portEXIT_CRITICAL(&budgetMux);
+    return fits;
+  }
+  
+  /**
+   * Estimated wait until a class may send (for status display)
+   * @return Milliseconds, 0 if it may send now
+   */
+  uint32_t msUntilAllowed(TxPriority priority, size_t payloadLen, uint8_t port = 1) {
+    uint32_t airtime = airtimeMs(payloadLen, port);
+    portENTER_CRITICAL(&budgetMux);
+    uint32_t now = millis();
+    uint32_t wait = 0;
+    if (admit(priority, airtime, now)) {
+      portEXIT_CRITICAL(&budgetMux);
+      return 0;
+    }
+    
+    uint32_t interval = classMinInterval(priority);
+    if (lastQueued[priority] != 0 && now - lastQueued[priority] < interval) {
+      wait = interval - (now - lastQueued[priority]);
+    }
+    float rate = DUTY_CYCLE * classShare(priority);
+    if (classCredit[priority] < airtime && rate > 0) {
+      uint32_t creditWait = (uint32_t)((airtime - classCredit[priority]) / rate);
+      if (creditWait > wait) wait = creditWait;
+    }
+    portEXIT_CRITICAL(&budgetMux);
+    return wait;
+  }
+  
+  /**
+   * Enable spending spare budget on extra ECG frames
+   */
+  void setBoost(bool enabled) {
+    boostMode = enabled;
+  }
+  
+  bool isBoosting() const {
+    return boostMode;
+  }
+  
+  uint8_t getSpreadingFactor() const {
+    return spreadingFactor;
+  }
+  
+  int8_t getOutputPower() const {
+    return outputPower;
+  }
+  
+  uint32_t getLinkChanges() const {
+    return adrChanges;
+  }
+  
+  /**
+   * millis() of the last downlink (ACK or ADR) addressed to us, 0 = none yet
+   */
+  uint32_t getLastDownlink() const {
+    return lastDownlink;
+  }
+  
+  /**
+   * Get frame counter
+   */
+  uint16_t getFrameCounter() {
+    return frameCounter;
+  }
+  
+  /**
+   * Get last RSSI
+   */
+  int getRSSI() {
+    return lastRssi;
+  }
+  
+  /**
+   * Get last SNR
+   */
+  float getSNR() {
+    return lastSnr;
+  }
+};
+
+// ============================================================================
+// PAYLOAD BUILDER
+// ============================================================================
+
+/**
  * Build payloads for different data types
  * Same format as LoRaWAN version - binary packed data
  */
@@ -2160,14 +2163,14 @@ public:
    * Format:
    * [0] Packet type: 0x01
    * [1] Heart rate (BPM): uint8
-   * [2] Body temperature (-20 to 80°C mapped to 0-255): int8
-   * [3] Ambient temperature (-20 to 80°C mapped to 0-255): int8
+   * [2] Body temperature (-20 to 80°C mapped to 0-255): uint8
+   * [3] Ambient temperature (-20 to 80°C mapped to 0-255): uint8
    * [4] Noise level (dB): uint8
    * [5] Fall state: uint8 (0=Normal, 1=Warning, 2=Fall, 3=Dangerous, 4=Recovery)
    * [6] Alert flags: uint8 (bit0=HR abnormal, bit1=Temp abnormal, bit2=Fall, bit3=Noise)
    * [7-8] RSSI: int16
    * [9] SNR: int8
-   * Total: 10 bytes
+   * Total: 10 bytes (RealtimePacket)
    */
   static int buildRealtimePayload(uint8_t* buffer,
                                    int bpm,
@@ -2179,31 +2182,159 @@ public:
                                    bool tempAbnormal,
                                    bool fallAlert,
                                    bool noiseAlert) {
-    int idx = 0;
+    return RealtimePacket::write(buffer,
+                                 constrain(bpm, 0, 255),
+                                 TempCode::encode(bodyTemp),
+                                 TempCode::encode(ambientTemp),
+                                 constrain((int)noisedB, 0, 255),
+                                 fallState,
+                                 alertFlags(hrAbnormal, tempAbnormal, fallAlert, noiseAlert));
+  }
+  
+  /**
+   * One realtime reading, already encoded as in the 0x01 payload
+   */
+  struct RealtimeReading {
+    uint32_t timestamp;   // millis() when the reading was taken
+    uint8_t bpm;
+    uint8_t bodyTemp;     // TempCode
+    uint8_t ambientTemp;  // TempCode
+    uint8_t noise;
+    uint8_t status;       // Fall state (high nibble) | alert flags (low nibble)
+  };
+  
+  // Readings per batch - worst case payload stays within one LoRa frame
+  static const int REALTIME_BATCH_MAX = RealtimeBatchPacket::MAX_READINGS;
+  
+  /**
+   * Encode a realtime reading (same fields and flags as buildRealtimePayload)
+   */
+  static RealtimeReading makeRealtimeReading(uint32_t timestamp,
+                                             int bpm,
+                                             float bodyTemp,
+                                             float ambientTemp,
+                                             float noisedB,
+                                             uint8_t fallState,
+                                             bool hrAbnormal,
+                                             bool tempAbnormal,
+                                             bool fallAlert,
+                                             bool noiseAlert) {
+    RealtimeReading reading;
+    reading.timestamp = timestamp;
+    reading.bpm = constrain(bpm, 0, 255);
+    reading.bodyTemp = TempCode::encode(bodyTemp);
+    reading.ambientTemp = TempCode::encode(ambientTemp);
+    reading.noise = constrain((int)noisedB, 0, 255);
+    reading.status = (uint8_t)((fallState & 0x0F) << 4) |
+                     alertFlags(hrAbnormal, tempAbnormal, fallAlert, noiseAlert);
+    return reading;
+  }
+  
+  /**
+   * Build batched realtime payload (Packet Type 0x04)
+   * Several readings in one frame, each stored as deltas from the one before
+   * 
+   * Format:
+   * [0] Packet type: 0x04
+   * [1] Reading count N (1-10)
+   * [2-5] Timestamp of the first reading (ms since boot): uint32
+   * [6-10] First reading: HR, body temp, ambient temp, noise, status
+   * Then for each further reading:
+   *   [dt] Seconds since the previous reading: uint8 (saturates at 255)
+   *   [mask] Changed fields: bit0=HR, bit1=body temp, bit2=ambient temp,
+   *          bit3=noise, bit4=status
+   *   For each set bit 0-3: int8 delta, or 0x80 followed by the absolute value
+   *   For bit 4: status byte
+   * Status byte: fall state (high nibble) | alert flags (low nibble, as 0x01)
+   * Size: 11 bytes for one reading, usually 2-5 bytes per further reading
+   */
+  static int buildRealtimeBatchPayload(uint8_t* buffer,
+                                        const RealtimeReading* readings,
+                                        int count) {
+    count = constrain(count, 0, REALTIME_BATCH_MAX);
+    if (count == 0) return 0;
     
-    buffer[idx++] = 0x01;  // Packet type
-    buffer[idx++] = constrain(bpm, 0, 255);
-    buffer[idx++] = tempToInt8(bodyTemp);
-    buffer[idx++] = tempToInt8(ambientTemp);
-    buffer[idx++] = constrain((int)noisedB, 0, 255);
-    buffer[idx++] = fallState;
+    int idx = 0;
+    buffer[idx++] = RealtimeBatchPacket::TYPE;
+    buffer[idx++] = (uint8_t)count;
+    ByteOrder::putU32(&buffer[idx], readings[0].timestamp);
+    idx += 4;
     
-    // Alert flags
-    uint8_t flags = 0;
-    if (hrAbnormal) flags |= 0x01;
-    if (tempAbnormal) flags |= 0x02;
-    if (fallAlert) flags |= 0x04;
-    if (noiseAlert) flags |= 0x08;
-    buffer[idx++] = flags;
+    buffer[idx++] = readings[0].bpm;
+    buffer[idx++] = readings[0].bodyTemp;
+    buffer[idx++] = readings[0].ambientTemp;
+    buffer[idx++] = readings[0].noise;
+    buffer[idx++] = readings[0].status;
     
-    // Placeholder for RSSI/SNR (filled by radio)
-    buffer[idx++] = 0;
-    buffer[idx++] = 0;
-    buffer[idx++] = 0;
+    for (int i = 1; i < count; i++) {
+      const RealtimeReading& prev = readings[i - 1];
+      const RealtimeReading& cur = readings[i];
+      
+      uint32_t dt = (cur.timestamp - prev.timestamp + 500) / 1000;
+      buffer[idx++] = (uint8_t)min(dt, (uint32_t)255);
+      
+      const uint8_t prevFields[4] = {prev.bpm, prev.bodyTemp, prev.ambientTemp, prev.noise};
+      const uint8_t curFields[4] = {cur.bpm, cur.bodyTemp, cur.ambientTemp, cur.noise};
+      idx += encodeChanges(&buffer[idx], prevFields, curFields, prev.status, cur.status);
+    }
     
     return idx;
   }
   
+  /**
+   * Build a vitals history page (Packet Type 0x0A)
+   * Consecutive HistoryLog records, oldest first, encoded like the 0x04
+   * batch. The gateway ACKs the page and the wearable then releases the
+   * records; a page that was not acknowledged is sent again later, so the
+   * backend drops records it already has by (log ID, sequence).
+   * 
+   * Format:
+   * [0] Packet type: 0x0A
+   * [1-2] Log ID (random per boot, keeps sequences apart): uint16
+   * [3-6] Sequence of the first record: uint32
+   * [7-10] Age of the first record when the page was built (s): uint32
+   * [11] Record count N
+   * [12-16] First record: HR, body temp, ambient temp, noise, status
+   * Then for each further record:
+   *   [dt] Seconds since the previous record: uint8 (a longer gap ends the page)
+   *   [mask] + changed fields, as in the 0x04 batch
+   * Status byte: 0x04 status | 0x80 for a fall event record (HR is then
+   * the value at the event, otherwise the minute's average; noise is the peak)
+   * Size: 17 bytes for one record, usually 2-5 bytes per further record
+   * @param count Records used (out)
+   * @return Payload length, 0 if there was no record
+   */
+  static int buildHistoryPayload(uint8_t* buffer, size_t maxLen, uint16_t logId,
+                                 uint32_t firstSeq, uint32_t nowS,
+                                 const HistoryLog::Record* records, int available,
+                                 int& count) {
+    count = 0;
+    if (available <= 0 || maxLen < HistoryPagePacket::HEADER_SIZE) return 0;
+    
+    const HistoryLog::Record& first = records[0];
+    size_t idx = HistoryPagePacket::writeHeader(buffer, logId, firstSeq, nowS - first.time,
+                                                first.bpm, first.bodyTemp, first.ambientTemp,
+                                                first.noise, first.status);
+    count = 1;
+    
+    while (count < available && count < HistoryPagePacket::MAX_RECORDS &&
+           idx + HistoryPagePacket::RECORD_MAX_SIZE <= maxLen) {
+      const HistoryLog::Record& prev = records[count - 1];
+      const HistoryLog::Record& cur = records[count];
+      uint32_t dt = cur.time - prev.time;
+      if (dt > 255) break;
+      buffer[idx++] = (uint8_t)dt;
+      
+      const uint8_t prevFields[4] = {prev.bpm, prev.bodyTemp, prev.ambientTemp, prev.noise};
+      const uint8_t curFields[4] = {cur.bpm, cur.bodyTemp, cur.ambientTemp, cur.noise};
+      idx += encodeChanges(&buffer[idx], prevFields, curFields, prev.status, cur.status);
+      count++;
+    }
+    HistoryPagePacket::setCount(buffer, (uint8_t)count);
+    
+    return (int)idx;
+  }
+  
   /**
    * Build ECG data payload (Packet Type 0x02)
    * Sent on heartbeat or abnormal condition
@@ -2219,25 +2350,43 @@ public:
                              int ecgLen,
                              uint8_t* pqrst,
                              int pqrstLen) {
-    int idx = 0;
-    
-    buffer[idx++] = 0x02;  // Packet type
-    
-    // Copy compressed ECG
-    memcpy(&buffer[idx], compressedECG, min(ecgLen, 50));
-    idx += 50;
-    
-    // Copy PQRST features
-    if (pqrstLen > 0) {
-      memcpy(&buffer[idx], pqrst, min(pqrstLen, 14));
-      idx += 14;
-    } else {
-      // Fill with zeros if no PQRST data
-      memset(&buffer[idx], 0, 14);
-      idx += 14;
-    }
-    
-    return idx;
+    buffer[0] = EcgPacket::TYPE_DELTA;
+    memcpy(&buffer[EcgPacket::SAMPLES], compressedECG, min(ecgLen, (int)EcgPacket::SAMPLES_SIZE));
+    writePqrst(buffer, pqrst, pqrstLen);
+    return EcgPacket::SIZE;
+  }
+  
+  // Rice-coded ECG window (see EcgCodec)
+  static const int RICE_ECG_CODE_BYTES = EcgPacket::SAMPLES_SIZE - 4;
+  static const int RICE_ECG_SAMPLES = 93;  // 1.86 seconds at 50Hz
+  
+  /**
+   * Build Rice-coded ECG payload (Packet Type 0x05)
+   * Same size and PQRST layout as 0x02, twice the sample rate and no
+   * clipping (see EcgCodec)
+   * 
+   * Format:
+   * [0] Packet type: 0x05
+   * [1-2] Keyframe: first sample (12-bit): uint16
+   * [3] Quantiser step (1 = lossless): uint8
+   * [4] Sample count including the keyframe (up to 93, 50Hz): uint8
+   * [5-50] Rice-coded residuals, MSB first, zero padded
+   * [51-64] PQRST features (timestamp + 5 amplitudes + 2 intervals)
+   * Total: 65 bytes
+   */
+  static int buildECGRicePayload(uint8_t* buffer,
+                                 const uint16_t* samples,
+                                 int sampleCount,
+                                 uint8_t* pqrst,
+                                 int pqrstLen) {
+    buffer[0] = EcgPacket::TYPE_RICE;
+    EcgCodec::Block block = EcgCodec::encode(samples, min(sampleCount, RICE_ECG_SAMPLES),
+                                             &buffer[5], RICE_ECG_CODE_BYTES);
+    ByteOrder::putU16(&buffer[1], block.keyframe);
+    buffer[3] = block.step;
+    buffer[4] = block.count;
+    writePqrst(buffer, pqrst, pqrstLen);
+    return EcgPacket::SIZE;
   }
   
   /**
@@ -2255,7 +2404,7 @@ public:
    * [25] Impact counter: uint8
    * [26] Warning counter: uint8
    * [27] Heart rate: uint8
-   * [28] Body temperature: int8
+   * [28] Body temperature (as in 0x01): uint8
    * [29-32] Accel X: float32
    * [33-36] Accel Y: float32
    * [37-40] Accel Z: float32
@@ -2277,57 +2426,148 @@ public:
                                     float accelY,
                                     float accelZ,
                                     float movementVar) {
-    int idx = 0;
-    
-    buffer[idx++] = 0x03;  // Packet type
-    
-    // Timestamp
-    memcpy(&buffer[idx], &timestamp, 4);
-    idx += 4;
+    buffer[0] = FallEventPacket::TYPE;
+    ByteOrder::putU32(&buffer[FallEventPacket::TIMESTAMP], timestamp);
     
     // Fall metrics
-    memcpy(&buffer[idx], &jerk, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &svm, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &angularVel, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &pitch, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &roll, 4);
-    idx += 4;
+    ByteOrder::putF32(&buffer[FallEventPacket::JERK], jerk);
+    ByteOrder::putF32(&buffer[FallEventPacket::SVM], svm);
+    ByteOrder::putF32(&buffer[FallEventPacket::ANGULAR_VELOCITY], angularVel);
+    ByteOrder::putF32(&buffer[FallEventPacket::PITCH], pitch);
+    ByteOrder::putF32(&buffer[FallEventPacket::ROLL], roll);
     
     // Counters
-    buffer[idx++] = impactCount;
-    buffer[idx++] = warningCount;
+    buffer[FallEventPacket::IMPACT_COUNT] = impactCount;
+    buffer[FallEventPacket::WARNING_COUNT] = warningCount;
     
     // Vital signs
-    buffer[idx++] = constrain(bpm, 0, 255);
-    buffer[idx++] = tempToInt8(bodyTemp);
+    buffer[FallEventPacket::HEART_RATE] = constrain(bpm, 0, 255);
+    buffer[FallEventPacket::BODY_TEMP] = TempCode::encode(bodyTemp);
     
     // Acceleration data
-    memcpy(&buffer[idx], &accelX, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &accelY, 4);
-    idx += 4;
-    memcpy(&buffer[idx], &accelZ, 4);
-    idx += 4;
+    ByteOrder::putF32(&buffer[FallEventPacket::ACCEL_X], accelX);
+    ByteOrder::putF32(&buffer[FallEventPacket::ACCEL_Y], accelY);
+    ByteOrder::putF32(&buffer[FallEventPacket::ACCEL_Z], accelZ);
     
     // Movement variance
-    memcpy(&buffer[idx], &movementVar, 4);
-    idx += 4;
+    ByteOrder::putF32(&buffer[FallEventPacket::MOVEMENT_VARIANCE], movementVar);
     
-    return idx;
+    return FallEventPacket::SIZE;
+  }
+  
+  /**
+   * Build fall waveform fragment payload (Packet Type 0x07)
+   * One Rice-coded block of one IMU axis from a FallCapture window; the
+   * fragments of a window share its ID and follow the 0x03 alert
+   * 
+   * Format:
+   * [0] Packet type: 0x07
+   * [1] Window ID (increments per captured fall): uint8
+   * [2] Fragment index: uint8
+   * [3] Fragment count: uint8
+   * [4] Channel (0-2 accel X/Y/Z, 3-5 gyro X/Y/Z): uint8
+   * [5-6] First sample of the block: uint16
+   * [7-8] Window length (samples per channel): uint16
+   * [9-10] Trigger index (first sample after confirmation): uint16
+   * [11] Sample rate (Hz): uint8
+   * [12-13] Keyframe: first sample (12-bit, counts / 16 + 2048): uint16
+   * [14] Quantiser step (1 = lossless): uint8
+   * [15] Sample count including the keyframe: uint8
+   * [16-111] Rice-coded residuals, MSB first, zero padded
+   * Total: 112 bytes
+   */
+  static int buildFallWaveformPayload(uint8_t* buffer, const FallCapture& capture,
+                                      int fragmentIndex, uint8_t sampleRateHz) {
+    const FallCapture::Fragment& fragment = capture.fragment(fragmentIndex);
+    return (int)FallWaveformPacket::write(buffer, capture.windowId(), (uint8_t)fragmentIndex,
+                                          (uint8_t)capture.getFragmentCount(), fragment.channel,
+                                          fragment.start, capture.windowLength(), capture.triggerIndex(),
+                                          sampleRateHz, fragment.block.keyframe, fragment.block.step,
+                                          fragment.block.count, fragment.code);
+  }
+  
+  /**
+   * Build diagnostics payload (Packet Type 0x06)
+   * Sent rarely (see DIAGNOSTICS_INTERVAL_MS), lowest priority
+   * 
+   * Format:
+   * [0] Packet type: 0x06
+   * [1-4] Statistics window (s): uint32
+   * [5] Stage count N: uint8
+   * Then for each stage (in ProfileStage order):
+   *   [avg] Average duration (us): uint16
+   *   [p99] 99th percentile duration (us): uint16
+   *   [max] Maximum duration (us): uint16
+   *   [misses] Deadline misses: uint16
+   * All durations and counters saturate at 65535
+   * Total: 6 + 8N bytes (62 bytes for 7 stages)
+   */
+  static int buildDiagnosticsPayload(uint8_t* buffer, Profiler& profiler, uint8_t stageCount) {
+    size_t len = DiagnosticsPacket::writeHeader(buffer, profiler.windowSeconds(), stageCount);
+    
+    for (uint8_t id = 0; id < stageCount; id++) {
+      Profiler::Summary s = profiler.summary(id);
+      DiagnosticsPacket::writeStage(buffer, id, saturate16(s.avgUs), saturate16(s.p99Us),
+                                    saturate16(s.maxUs), saturate16(s.misses));
+    }
+    
+    return (int)len;
   }
   
 private:
   /**
-   * Map temperature (-20°C to 80°C) to int8 (0-255)
+   * Change mask and field deltas of one reading against the one before
+   * (0x04 / 0x0A encoding: int8 delta, or 0x80 then the absolute value)
+   * @return Bytes written
+   */
+  static int encodeChanges(uint8_t* buffer, const uint8_t prevFields[4], const uint8_t curFields[4],
+                           uint8_t prevStatus, uint8_t curStatus) {
+    int idx = 1;
+    uint8_t mask = 0;
+    for (int f = 0; f < 4; f++) {
+      int delta = (int)curFields[f] - (int)prevFields[f];
+      if (delta == 0) continue;
+      mask |= (1 << f);
+      if (delta >= -127 && delta <= 127) {
+        buffer[idx++] = (uint8_t)(int8_t)delta;
+      } else {
+        buffer[idx++] = 0x80;  // Escape: absolute value follows
+        buffer[idx++] = curFields[f];
+      }
+    }
+    if (curStatus != prevStatus) {
+      mask |= 0x10;
+      buffer[idx++] = curStatus;
+    }
+    buffer[0] = mask;
+    return idx;
+  }
+  
+  static uint16_t saturate16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+  }
+  
+  /**
+   * Alert flags byte (0x01 payload, low nibble of the batch status)
+   */
+  static uint8_t alertFlags(bool hrAbnormal, bool tempAbnormal, bool fallAlert, bool noiseAlert) {
+    uint8_t flags = 0;
+    if (hrAbnormal) flags |= RealtimePacket::FLAG_HR;
+    if (tempAbnormal) flags |= RealtimePacket::FLAG_TEMP;
+    if (fallAlert) flags |= RealtimePacket::FLAG_FALL;
+    if (noiseAlert) flags |= RealtimePacket::FLAG_NOISE;
+    return flags;
+  }
+  
+  /**
+   * PQRST block of an ECG payload (zeros when no beat was measured)
    */
-  static int8_t tempToInt8(float temp) {
-    // Map -20°C to 80°C -> 0 to 255 range
-    int mapped = (int)((temp + 20.0) / 100.0 * 255.0);
-    return constrain(mapped, 0, 255);
+  static void writePqrst(uint8_t* buffer, const uint8_t* pqrst, int pqrstLen) {
+    if (pqrstLen > 0) {
+      memcpy(&buffer[EcgPacket::PQRST], pqrst, min(pqrstLen, (int)EcgPacket::PQRST_SIZE));
+    } else {
+      memset(&buffer[EcgPacket::PQRST], 0, EcgPacket::PQRST_SIZE);
+    }
   }
 };
 
@@ -2337,17 +2577,20 @@ private:
 
 /**
  * Send realtime data packet to Vision Master E290 via UART
- * Uses same packet format as LoRa for consistency
+ * Uses same payload as LoRa for consistency, in a UartFrame::REALTIME frame.
+ * The frame is queued on the driver's TX buffer; the radio task does not
+ * wait for it to go out.
  */
 void sendUARTPacket(uint8_t* payload, int len) {
   if (len > 0 && len <= 255) {
-    // Send packet via UART (Serial1)
-    Serial1.write(payload, len);
-    Serial1.flush();
+    if (!badgeLink.send(UartFrame::REALTIME, payload, len)) {
+      Log.println("❌ Badge UART frame not sent");
+      return;
+    }
     
-    Serial.println("📤 Sent to Vision Master E290 via UART");
-    Serial.print("   Bytes: ");
-    Serial.println(len);
+    Log.println("📤 Sent to Vision Master E290 via UART");
+    Log.print("   Bytes: ");
+    Log.println(len);
   }
 }
 
@@ -2358,17 +2601,22 @@ void sendUARTPacket(uint8_t* payload, int len) {
 // I2C Pin Configuration for ESP32
 const int PIN_SDA = 48;        // I2C Data line
 const int PIN_SCL = 47;        // I2C Clock line
-const int I2C_FREQUENCY = 100000;  // I2C clock speed (100kHz - standard mode)
+const int PIN_MPU_INT = 7;     // MPU6050 INT (data ready) - GPIO 7
+// I2C clock is per device (I2cBus::Device): MPU6050 400 kHz, MLX90614 100 kHz
 
 // MAX4466 Microphone Configuration
 const int PIN_MIC = 3;         // GPIO 3 (ADC1_CH2) for MAX4466
 const int MIC_SAMPLE_WINDOW = 50;  // Sample window in ms
+const uint32_t MIC_LEQ_WINDOW_MS = 60000;  // Leq / Lmax averaging window
 
 // AD8232 ECG Configuration
 const int PIN_ECG = 1;         // GPIO 1 (ADC1_CH0) for ECG signal
 const int PIN_LO_PLUS = 9;    // GPIO 9 for LO+ lead-off detection
 const int PIN_LO_MINUS = 10;   // GPIO 10 for LO- lead-off detection
-const int ECG_SAMPLE_INTERVAL = 10;  // 100 Hz sampling
+const int ECG_SAMPLE_RATE_HZ = 100;  // 100 Hz sampling (hardware timed)
+static_assert(ECG_SAMPLE_RATE_HZ == QrsDetector::SAMPLE_RATE_HZ,
+              "The QRS detector's filters and search windows are built for its own sample rate");
+static_assert(AD8232::ADC_MAX == EcgCodec::SAMPLE_MAX, "ECG codec and ADC resolution disagree");
 
 // Timing Configuration
 const int SERIAL_BAUD_RATE = 115200;  // Serial communication speed
@@ -2378,37 +2626,213 @@ const int READ_INTERVAL_MS = 500;     // Sensor reading interval
 // Global Objects
 // ============================================================================
 
+LogStream Log;             // Non-blocking serial log (drained by the log task)
+Profiler profiler;         // Hot-path latency histograms (report with 'p' on Serial)
+I2cBus i2cBus;             // Shared I2C master (MPU6050 + MLX90614)
 MPU6050 mpu;              // MPU6050 sensor object
 FallDetector fallDetector; // Fall detection algorithm instance
+FallCapture fallCapture;   // IMU window around a confirmed fall (Packet Type 0x07)
+HistoryLog historyLog;     // Vitals summaries awaiting the gateway's ACK (Packet Type 0x0A)
+PowerManager powerManager; // ACTIVE / QUIET mode from IMU activity
 MAX4466 microphone(PIN_MIC); // MAX4466 microphone object
 AD8232 ecgMonitor(PIN_ECG, PIN_LO_PLUS, PIN_LO_MINUS); // AD8232 ECG monitor
 MLX90614Sensor tempSensor; // MLX90614 temperature sensor
 LoRaComm loraComm;        // LoRa communication object
+EcgAcquisition ecgAcquisition; // ECG sampler feeding ecgMonitor
+AdcStream adcStream;      // Continuous ADC1 capture for microphone + ECG
+
+// Continuous ADC rate per channel (ECG is averaged down to ECG_SAMPLE_RATE_HZ)
+const uint32_t ADC_CHANNEL_RATE_HZ = 10000;
+
+// Temperature sampling timing
+const int TEMP_SAMPLE_INTERVAL = 5000;  // Read temperature every 5 seconds
+
+// LoRa transmission pacing - LoRaComm's airtime budget decides when each
+// packet class may go out (1% duty cycle over a rolling hour, Hong Kong AS923)
+const size_t REALTIME_PAYLOAD_SIZE = RealtimePacket::SIZE;  // buildRealtimePayload()
+const size_t ECG_PAYLOAD_SIZE = EcgPacket::SIZE;            // buildECGPayload() / buildECGRicePayload(), 14 PQRST bytes
+static_assert(ECG_PAYLOAD_SIZE <= LoRaComm::MAX_PAYLOAD_SIZE, "ECG payload does not fit one frame");
+
+// ECG codec (build flag): ECG_CODEC_DELTA sends the legacy 8-bit delta frame
+// (Type 0x02, 25Hz), ECG_CODEC_RICE the Rice-coded frame (Type 0x05, 50Hz)
+#define ECG_CODEC_DELTA 2
+#define ECG_CODEC_RICE 5
+#ifndef ECG_CODEC
+#define ECG_CODEC ECG_CODEC_RICE
+#endif
+const uint8_t ECG_PORT = ECG_CODEC;
+
+// Realtime readings are taken on a fixed cadence and sent in 0x04 batches
+// whenever the budget allows, so more readings reach the gateway per
+// second of airtime than with one 0x01 frame per reading
+const uint32_t REALTIME_SAMPLE_INTERVAL = 10000;  // ms between readings
+const size_t REALTIME_BATCH_PAYLOAD_SIZE = 35;    // Typical 0x04 payload with 10 readings
+
+// Latency diagnostics (Packet Type 0x06) - one frame per interval at the
+// lowest priority; 0 disables the uplink (the Serial report stays available)
+#ifndef DIAGNOSTICS_INTERVAL_MS
+#define DIAGNOSTICS_INTERVAL_MS 1800000UL  // 30 minutes
+#endif
+
+// ============================================================================
+// Task Configuration
+// ============================================================================
+// Sensor tasks run on the application core; the radio task owns the other
+// core so a blocking LoRa transmission (up to ~1.1s at SF9) can never delay
+// fall detection. Priorities and cores can be overridden with build flags.
+
+#ifndef SENSOR_CORE
+#define SENSOR_CORE 1
+#endif
+#ifndef RADIO_CORE
+#define RADIO_CORE 0
+#endif
+
+#ifndef I2C_TASK_PRIORITY
+#define I2C_TASK_PRIORITY 6    // Bus task - serves the IMU, blocked on the driver during transfers
+#endif
+#ifndef IMU_TASK_PRIORITY
+#define IMU_TASK_PRIORITY 5    // Highest - bounded fall detection latency
+#endif
+#ifndef ECG_TASK_PRIORITY
+#define ECG_TASK_PRIORITY 4
+#endif
+#ifndef RADIO_TASK_PRIORITY
+#define RADIO_TASK_PRIORITY 3
+#endif
+#ifndef ADC_TASK_PRIORITY
+#define ADC_TASK_PRIORITY 4    // DMA reader feeding microphone + ECG
+#endif
+#ifndef MIC_TASK_PRIORITY
+#define MIC_TASK_PRIORITY 2
+#endif
+#ifndef TEMP_TASK_PRIORITY
+#define TEMP_TASK_PRIORITY 1
+#endif
+#ifndef LOG_TASK_PRIORITY
+#define LOG_TASK_PRIORITY 1    // Serial drain, radio core - never competes with sensing
+#endif
+
+const size_t LOG_BUFFER_SIZE = 8192;                // Serial log ring (text beyond this is dropped)
+
+const uint16_t IMU_SAMPLE_RATE_HZ = 100;            // MPU6050 FIFO output rate (100-200 Hz)
+static_assert(IMU_SAMPLE_RATE_HZ >= 4 && IMU_SAMPLE_RATE_HZ <= 1000 && 1000 % IMU_SAMPLE_RATE_HZ == 0,
+              "SMPLRT_DIV divides the 1 kHz gyro output by a whole number");
+const uint32_t IMU_FIFO_BATCH = 5;                  // Drain FIFO every 5 samples (50ms at 100 Hz)
+const int IMU_BATCH_MAX = 40;                       // Samples processed per drain pass
+const unsigned long IMU_INT_TIMEOUT_MS = 100;       // Drain anyway if an INT edge was missed
+const unsigned long ECG_DRAIN_INTERVAL_MS = 20;     // Drain ECG ring every 20ms
+const unsigned long MIC_IDLE_MS = 50;               // Sound level poll interval
+const unsigned long RADIO_POLL_INTERVAL_MS = 100;   // Radio task wake-up for scheduled packets
+const unsigned long RADIO_BUSY_POLL_MS = 5;         // TX-done poll while a frame is on air
+const int FALL_QUEUE_LENGTH = 16;                   // Pending fall state notices
+
+// Fall waveform capture (Packet Type 0x07): window around the confirmation,
+// sent after the alert while the hour's airtime stays under the ceiling
+const uint32_t FALL_CAPTURE_PRE_MS = 2000;
+const uint32_t FALL_CAPTURE_POST_MS = 3000;
+const float FALL_WAVEFORM_CEILING_SHARE = 0.60f;   // Of the hourly airtime budget
+const uint32_t FALL_WAVEFORM_MAX_AGE_MS = 900000;  // Abandon unsent fragments after 15 minutes
+static_assert(FallCapture::CODE_BYTES == FallWaveformPacket::CODE_SIZE, "Fragment code does not fill a 0x07 payload");
+
+// Vitals history (HistoryLog.h, Packet Type 0x0A): minute summaries and fall
+// events kept until the gateway ACKs them. A page goes out once it is full
+// or its oldest record is HISTORY_FLUSH_S old; after an outage the backlog
+// is sent page after page on the backfill share of the airtime budget.
+const uint8_t HISTORY_PORT = RadioConfig::HISTORY_PORT;
+static_assert(HISTORY_PORT == HistoryPagePacket::TYPE && HistoryLog::EVENT_FLAG == HistoryPagePacket::EVENT_FLAG,
+              "History log and page layout disagree");
+const uint32_t HISTORY_INTERVAL_S = 60;             // One summary record per minute
+const uint32_t HISTORY_RECORDS_PSRAM = 10080;       // 7 days with PSRAM (12 bytes each)
+const uint32_t HISTORY_RECORDS_HEAP = 1440;         // 24 hours otherwise
+const uint32_t HISTORY_FLUSH_S = 1800;              // Longest a record waits for a full page
+const uint32_t HISTORY_RETRY_MS = 30000;            // After an unacknowledged page, doubled per miss
+const uint32_t HISTORY_RETRY_MAX_MS = 600000;       // Probe interval while out of range
+
+// A FIFO drain later than two batch periods counts as an IMU deadline miss
+const uint32_t IMU_DRAIN_DEADLINE_US = 2 * IMU_FIFO_BATCH * 1000000UL / IMU_SAMPLE_RATE_HZ;
+
+// Power modes (PowerManager.h): QUIET once the wearer has been still for
+// POWER_QUIET_AFTER_MS. QUIET lowers the IMU output rate, drops the
+// per-batch wake-ups, stretches the poll intervals and lowers the CPU clock;
+// the IMU task switches all of them back before it evaluates the samples
+// that follow a wake-up. 0 keeps the wearable ACTIVE.
+#ifndef POWER_QUIET_AFTER_MS
+#define POWER_QUIET_AFTER_MS 30000UL
+#endif
+// QUIET_LIGHT_SLEEP: the IMU task light-sleeps between QUIET drains while
+// nothing needs the clocks - ADC stream paused (ECG leads off for
+// ADC_PAUSE_AFTER_MS), radio idle with nothing queued, I2C bus idle
+#ifndef QUIET_LIGHT_SLEEP
+#define QUIET_LIGHT_SLEEP 1
+#endif
+const uint16_t IMU_MOTION_THRESHOLD_MG = 40;        // Motion interrupt wakes QUIET
+const uint8_t IMU_MOTION_DURATION_MS = 2;
+const uint16_t QUIET_IMU_SAMPLE_RATE_HZ = 25;       // FIFO rate while QUIET
+static_assert(QUIET_IMU_SAMPLE_RATE_HZ >= 4 && QUIET_IMU_SAMPLE_RATE_HZ <= IMU_SAMPLE_RATE_HZ &&
+              1000 % QUIET_IMU_SAMPLE_RATE_HZ == 0,
+              "QUIET rate must be a whole divider of the 1 kHz gyro output, at most the ACTIVE rate");
+const unsigned long QUIET_IMU_DRAIN_MS = 1000;      // FIFO holds 85 samples (3.4s) at 25 Hz
+const unsigned long ADC_PAUSE_AFTER_MS = 60000;     // Leads off this long while QUIET pauses the ADC stream
+const unsigned long QUIET_ECG_DRAIN_MS = 200;       // ECG ring holds 5s
+const unsigned long QUIET_MIC_IDLE_MS = 500;
+const unsigned long QUIET_RADIO_POLL_MS = 500;      // Fall notices still wake the radio task at once
+const unsigned long QUIET_REPORT_INTERVAL_MS = 5000;
+const uint32_t ACTIVE_CPU_MHZ = 240;
+const uint32_t QUIET_CPU_MHZ = 80;                  // Lowest clock that keeps APB (I2C, SPI, ADC, UART) at 80 MHz
+const uint32_t QUIET_DRAIN_DEADLINE_US = 2 * QUIET_IMU_DRAIN_MS * 1000UL;
+
+/**
+ * Profiled stages (ids into profiler, also the 0x06 payload order)
+ */
+enum ProfileStage : uint8_t {
+  PROF_IMU_READ,     // MPU6050 FIFO burst read + magnitude kernel; misses = late drains + FIFO overflows
+  PROF_FALL_DETECT,  // FallDetector::update() per sample
+  PROF_ECG,          // ECG ring drain + beat detection; misses = dropped samples
+  PROF_MIC,          // Sound level pickup
+  PROF_TEMP,         // One MLX90614 measurement step
+  PROF_RADIO,        // Radio task pass (excluding the queue wait)
+  PROF_LOOP,         // loop() status pass (excluding the delay)
+  PROF_STAGE_COUNT
+};
+
+/**
+ * Latest readings shared between tasks (guarded by telemetryMux)
+ */
+struct Telemetry {
+  MPU6050::SensorData imu;
+  FallDetector::FallEvent fall;
+  float soundLevel;
+  float maxNoisedB;                 // Maximum noise level between transmissions
+  unsigned long maxNoiseTimestamp;  // When max noise occurred
+};
+
+/**
+ * Fall state change posted from the IMU task to the radio task
+ */
+struct FallNotice {
+  FallDetector::FallEvent event;
+  MPU6050::SensorData imu;          // Sample that produced the event
+};
 
-// ECG sampling timing
-unsigned long lastECGSampleTime = 0;
-// Temperature sampling timing
-unsigned long lastTempSampleTime = 0;
-const int TEMP_SAMPLE_INTERVAL = 5000;  // Read temperature every 5 seconds
+Telemetry telemetry = {};
+portMUX_TYPE telemetryMux = portMUX_INITIALIZER_UNLOCKED;
+QueueHandle_t fallQueue = nullptr;       // IMU task → radio task
+SemaphoreHandle_t ecgMutex = nullptr;    // Guards ecgMonitor buffers
+TaskHandle_t imuTaskHandle = nullptr;    // Notified by the MPU6050 data-ready interrupt
+TaskHandle_t loopTaskHandle = nullptr;   // Notified by the IMU task on a power mode change
+
+// History page waiting for its ACK (radio task: sendHistoryPage() / onUplinkDone())
+struct {
+  uint16_t logId;       // Random per boot - sequences restart with the log
+  uint32_t firstSeq;
+  int count;            // 0 = no page on air
+  uint32_t retryMs;     // Current back-off after unacknowledged pages
+  uint32_t missedAt;    // millis() of the last unacknowledged page
+} historyPage = {0, 0, 0, 0, 0};
 
-// LoRa transmission timing - Optimized for Hong Kong regulations (1% duty cycle)
-// Air time calculations (SF9, BW125kHz):
-//   Realtime (23B): ~353ms → Min interval 35.3s (1% duty cycle)
-//   ECG (65B): ~1119ms → Min interval 111.9s (1% duty cycle)
-// Using 10% safety margin for compliance
-unsigned long lastRealtimeTxTime = 0;
-unsigned long lastECGTxTime = 0;  // Track ECG transmission time globally
-const unsigned long REALTIME_TX_INTERVAL = 38860;   // Send realtime data every 38.9s (optimized)
-const unsigned long ECG_TX_INTERVAL = 123115;       // Send ECG data every 123.1s (2.05 minutes, optimized)
-bool fallEventTriggered = false;
-
-// State change tracking for immediate notifications
-FallDetector::FallState previousFallState = FallDetector::NORMAL;
-bool stateChangeNotified = false;
-
-// Maximum noise tracking
-float maxNoisedB = 0.0;  // Track maximum noise level between transmissions
-unsigned long maxNoiseTimestamp = 0;  // When max noise occurred
+void startTasks();  // Defined with the task functions below setup()
+void onUplinkDone(const LoRaComm::TxResult& result);
 
 // Helper function to format time remaining
 String formatTimeRemaining(unsigned long milliseconds) {
@@ -2432,30 +2856,27 @@ String formatTimeRemaining(unsigned long milliseconds) {
  * Useful for debugging connection issues
  */
 void scanI2CBus() {
-  Serial.println("Scanning I2C bus...");
+  Log.println("Scanning I2C bus...");
   
   int devicesFound = 0;
   
   for (uint8_t address = 1; address < 127; address++) {
-    Wire.beginTransmission(address);
-    uint8_t error = Wire.endTransmission();
-    
-    if (error == 0) {
-      Serial.print("  Device found at address 0x");
-      if (address < 16) Serial.print("0");
-      Serial.println(address, HEX);
+    if (i2cBus.probe(address)) {
+      Log.print("  Device found at address 0x");
+      if (address < 16) Log.print("0");
+      Log.println(address, HEX);
       devicesFound++;
     }
   }
   
   if (devicesFound == 0) {
-    Serial.println("  No I2C devices found!");
+    Log.println("  No I2C devices found!");
   } else {
-    Serial.print("  Total devices found: ");
-    Serial.println(devicesFound);
+    Log.print("  Total devices found: ");
+    Log.println(devicesFound);
   }
   
-  Serial.println();
+  Log.println();
 }
 
 // ============================================================================
@@ -2463,83 +2884,117 @@ void scanI2CBus() {
 // ============================================================================
 
 void setup() {
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+
   // Initialize serial communication
   Serial.begin(SERIAL_BAUD_RATE);
   delay(100);
   
+  // All logging goes through the ring buffer from here on
+  if (!Log.begin(Serial, LOG_BUFFER_SIZE, LOG_TASK_PRIORITY, RADIO_CORE)) {
+    Serial.println("Log buffer unavailable - logging synchronously");
+  }
+  
   // Print header
-  Serial.println("\n========================================");
-  Serial.println(" Comprehensive Health Monitoring");
-  Serial.println("   Fall + ECG + Temp + Noise");
-  Serial.println("========================================\n");
+  Log.println("\n========================================");
+  Log.println(" Comprehensive Health Monitoring");
+  Log.println("   Fall + ECG + Temp + Noise");
+  Log.println("========================================\n");
   
   // Initialize I2C with custom pins
-  Wire.begin(PIN_SDA, PIN_SCL);
-  Wire.setClock(I2C_FREQUENCY);
+  if (!i2cBus.begin(PIN_SDA, PIN_SCL, I2C_TASK_PRIORITY, SENSOR_CORE)) {
+    Log.println("ERROR: I2C driver unavailable!");
+    while (1) {
+      delay(1000);  // Halt program
+    }
+  }
   delay(100);
   
-  Serial.print("I2C initialized: SDA=GPIO");
-  Serial.print(PIN_SDA);
-  Serial.print(", SCL=GPIO");
-  Serial.print(PIN_SCL);
-  Serial.print(", Frequency=");
-  Serial.print(I2C_FREQUENCY / 1000);
-  Serial.println("kHz\n");
+  Log.print("I2C initialized: SDA=GPIO");
+  Log.print(PIN_SDA);
+  Log.print(", SCL=GPIO");
+  Log.print(PIN_SCL);
+  Log.print(", MPU6050 ");
+  Log.print(I2cBus::FAST_HZ / 1000);
+  Log.print("kHz, MLX90614 ");
+  Log.print(I2cBus::STANDARD_HZ / 1000);
+  Log.println("kHz\n");
   
   // Scan I2C bus for debugging
   scanI2CBus();
   
   // Initialize MPU6050 sensor
-  Serial.println("Initializing MPU6050...");
-  if (!mpu.begin()) {
-    Serial.println("ERROR: MPU6050 initialization failed!");
-    Serial.println("Please check your wiring and connections.");
+  Log.println("Initializing MPU6050...");
+  if (!mpu.begin(i2cBus)) {
+    Log.println("ERROR: MPU6050 initialization failed!");
+    Log.println("Please check your wiring and connections.");
     while (1) {
       delay(1000);  // Halt program
     }
   }
   
-  Serial.println("\nSensor ready! Starting measurements...\n");
+  Log.println("\nSensor ready! Starting measurements...\n");
   delay(500);
   
   // ========================================
   // Temperature Sensor Initialization
   // ========================================
   
-  Serial.println("Initializing MLX90614 IR temperature sensor...");
-  tempSensor.begin();
-  Serial.println("Temperature sensor ready!\n");
+  Log.println("Initializing MLX90614 IR temperature sensor...");
+  tempSensor.begin(i2cBus);
+  Log.println("Temperature sensor ready!\n");
   
-  Serial.println("Body Temperature Guidelines:");
-  Serial.println("  35.5-37.0\u00b0C: Normal underarm range");
-  Serial.println("  37.5-38.0\u00b0C: Slightly elevated");
-  Serial.println("  > 38.0\u00b0C: Fever detected\n");
+  Log.println("Body Temperature Guidelines:");
+  Log.println("  35.5-37.0\u00b0C: Normal underarm range");
+  Log.println("  37.5-38.0\u00b0C: Slightly elevated");
+  Log.println("  > 38.0\u00b0C: Fever detected\n");
   
   // ========================================
   // ECG Monitor Initialization
   // ========================================
   
-  Serial.println("Initializing AD8232 ECG monitor...");
+  Log.println("Initializing AD8232 ECG monitor...");
   ecgMonitor.begin();
-  Serial.println("ECG monitor ready!\n");
   
-  Serial.println("Heart Rate Guidelines:");
-  Serial.println("  50-120 BPM: Normal range");
-  Serial.println("  < 50 BPM: Bradycardia (too slow)");
-  Serial.println("  > 120 BPM: Tachycardia (too fast)\n");
+  // ECG is captured by the continuous ADC stream (started with the microphone)
+  ecgAcquisition.beginStreamed(PIN_LO_PLUS, PIN_LO_MINUS, ECG_SAMPLE_RATE_HZ, ADC_CHANNEL_RATE_HZ);
+  adcStream.addChannel(PIN_ECG, EcgAcquisition::adcSink, &ecgAcquisition);
+  Log.println("ECG monitor ready!\n");
+  
+  Log.println("Heart Rate Guidelines:");
+  Log.println("  50-120 BPM: Normal range");
+  Log.println("  < 50 BPM: Bradycardia (too slow)");
+  Log.println("  > 120 BPM: Tachycardia (too fast)\n");
   
   // ========================================
   // Microphone Initialization
   // ========================================
   
-  Serial.println("Initializing MAX4466 microphone...");
+  Log.println("Initializing MAX4466 microphone...");
   microphone.begin();
-  Serial.println("Microphone ready!\n");
+  microphone.beginStreaming(ADC_CHANNEL_RATE_HZ, MIC_SAMPLE_WINDOW, MIC_LEQ_WINDOW_MS);
+  adcStream.addChannel(PIN_MIC, MAX4466::adcSink, &microphone);
+  
+  // Start DMA capture of both analog inputs
+  if (adcStream.begin(ADC_CHANNEL_RATE_HZ, ADC_TASK_PRIORITY, SENSOR_CORE)) {
+    Log.print("ADC DMA stream started: ");
+    Log.print(adcStream.getSampleRate());
+    Log.println(" Hz per channel (mic + ECG)");
+  } else {
+    // Fall back to timer-driven ECG sampling and polled microphone windows
+    Log.println("ERROR: ADC DMA stream failed to start, using polled ADC");
+    microphone.endStreaming();
+    ecgAcquisition.stop();
+    if (!ecgAcquisition.begin(PIN_ECG, PIN_LO_PLUS, PIN_LO_MINUS, ECG_SAMPLE_RATE_HZ)) {
+      Log.println("ERROR: ECG acquisition timer failed to start!");
+    }
+  }
+  Log.println("Microphone ready!\n");
   
-  Serial.println("Noise Level Guidelines:");
-  Serial.println("  < 85 dB: Safe");
-  Serial.println("  85-100 dB: Risk with prolonged exposure");
-  Serial.println("  > 100 dB: Risk of immediate hearing damage\n");
+  Log.println("Noise Level Guidelines:");
+  Log.println("  < 85 dB: Safe");
+  Log.println("  85-100 dB: Risk with prolonged exposure");
+  Log.println("  > 100 dB: Risk of immediate hearing damage\n");
   
   // ========================================
   // Fall Detector Initialization
@@ -2550,7 +3005,7 @@ void setup() {
   fallDetector.setSensitivityProfile(2); // Default: Balanced
   
   // Calibration phase - collect baseline posture data
-  Serial.println("Starting calibration... Please keep device still in normal position.");
+  Log.println("Starting calibration... Please keep device still in normal position.");
   delay(2000);
   
   float total_pitch = 0;
@@ -2569,814 +3024,1514 @@ void setup() {
     
     delay(50);
   }
-  
-  float avg_pitch = total_pitch / CALIBRATION_SAMPLES;
-  float avg_roll = total_roll / CALIBRATION_SAMPLES;
-  
-  fallDetector.calibrate(avg_pitch, avg_roll);
-  
-  Serial.println("========================================");
-  Serial.println("  System Initialization Complete!");
-  Serial.println("========================================");
-  Serial.println("✓ MPU6050 Fall Detection: Active");
-  Serial.println("✓ AD8232 ECG Monitoring: Active");
-  Serial.println("✓ MLX90614 Temperature: Active");
-  Serial.println("✓ MAX4466 Noise Monitoring: Active");
-  Serial.println("========================================\n");
-  
-  // ========================================
-  // LoRa Initialization
-  // ========================================
-  
-  Serial.println("Initializing LoRa...");
-  if (!loraComm.begin()) {
-    Serial.println("ERROR: LoRa initialization failed!");
-    Serial.println("System halted. Check wiring and restart.");
-    while(1) delay(1000);  // Halt - LoRa is critical
+  
+  float avg_pitch = total_pitch / CALIBRATION_SAMPLES;
+  float avg_roll = total_roll / CALIBRATION_SAMPLES;
+  
+  fallDetector.calibrate(avg_pitch, avg_roll);
+  
+  // Switch the MPU6050 to fixed-rate FIFO sampling for fall detection
+  if (mpu.beginFIFO(IMU_SAMPLE_RATE_HZ)) {
+    Log.print("MPU6050 FIFO sampling: ");
+    Log.print(mpu.getFIFORate());
+    Log.println(" Hz (data-ready interrupt)");
+    fallDetector.setSampleRate(mpu.getFIFORate());
+    fallCapture.begin(FALL_CAPTURE_PRE_MS * mpu.getFIFORate() / 1000,
+                      FALL_CAPTURE_POST_MS * mpu.getFIFORate() / 1000);
+    mpu.enableMotionWake(IMU_MOTION_THRESHOLD_MG, IMU_MOTION_DURATION_MS);
+    powerManager.begin(POWER_QUIET_AFTER_MS);
+  } else {
+    Log.println("ERROR: MPU6050 FIFO configuration failed!");
+  }
+  
+  Log.println("========================================");
+  Log.println("  System Initialization Complete!");
+  Log.println("========================================");
+  Log.println("✓ MPU6050 Fall Detection: Active");
+  Log.println("✓ AD8232 ECG Monitoring: Active");
+  Log.println("✓ MLX90614 Temperature: Active");
+  Log.println("✓ MAX4466 Noise Monitoring: Active");
+  Log.println("========================================\n");
+  
+  // ========================================
+  // LoRa Initialization
+  // ========================================
+  
+  Log.println("Initializing LoRa...");
+  if (!loraComm.begin()) {
+    Log.println("ERROR: LoRa initialization failed!");
+    Log.println("System halted. Check wiring and restart.");
+    while(1) delay(1000);  // Halt - LoRa is critical
+  } else {
+    Log.println("✅ LoRa initialized successfully!");
+    loraComm.onTxDone(onUplinkDone);
+    
+    // Vitals history ring, in PSRAM when the module has it
+    uint32_t historyRecords = psramFound() ? HISTORY_RECORDS_PSRAM : HISTORY_RECORDS_HEAP;
+    size_t historyBytes = historyRecords * sizeof(HistoryLog::Record);
+    HistoryLog::Record* historyStorage = (HistoryLog::Record*)(psramFound() ? ps_malloc(historyBytes) : malloc(historyBytes));
+    historyLog.begin(historyStorage, historyRecords, HISTORY_INTERVAL_S);
+    historyPage.logId = (uint16_t)esp_random();
+    if (historyStorage != nullptr) {
+      Log.printf("📚 Vitals history: %lu records (%lu h of minute summaries, %s), log ID 0x%04X\n",
+                 (unsigned long)historyRecords, (unsigned long)(historyRecords * HISTORY_INTERVAL_S / 3600),
+                 psramFound() ? "PSRAM" : "heap", historyPage.logId);
+    } else {
+      Log.println("ERROR: No memory for the vitals history - backfill disabled");
+    }
+    Log.println("\n========================================");
+    Log.println("  LORA READY");
+    Log.println("========================================");
+    Log.println("Frequency: 923 MHz (Hong Kong AS923)");
+    Log.println("Spreading Factor: 9");
+    Log.println("Bandwidth: 125 kHz");
+    Log.println("========================================\n");
+  }
+  
+  Log.println("\n========================================");
+  Log.println("  ALL SYSTEMS READY");
+  Log.println("========================================");
+  
+  // ========================================
+  // UART Initialization for Vision Master E290
+  // ========================================
+  
+  Log.println("\nInitializing UART for Vision Master E290...");
+  if (!badgeLink.begin(UART_NUM_1, PIN_UART_TX, PIN_UART_RX, UART_BAUD)) {
+    Log.println("❌ Badge UART driver failed to start");
+  }
+  badgeLink.setWakePreamble(BADGE_WAKE_PREAMBLE);
+  Log.print("UART configured: TX=");
+  Log.print(PIN_UART_TX);
+  Log.print(", RX=");
+  Log.print(PIN_UART_RX);
+  Log.print(", Baud=");
+  Log.println(UART_BAUD);
+  Log.println("✅ UART ready for staff badge communication!");
+  Log.println("========================================\n");
+  
+  Log.println("\n📡 TRANSMISSION SCHEDULE (Optimized for HK Regulations):");
+  Log.println("  ┌─────────────────────────────────────────┐");
+  Log.print("  │ Realtime Batch:    ");
+  Log.print(loraComm.airtimeMs(REALTIME_BATCH_PAYLOAD_SIZE, 4));
+  Log.println(" ms on air, budgeted │");
+  Log.print("  │ ECG Data:          ");
+  Log.print(loraComm.airtimeMs(ECG_PAYLOAD_SIZE, ECG_PORT));
+  Log.println(" ms on air, budgeted│");
+  Log.println("  │ Fall Events:       Immediate            │");
+  Log.println("  │                                         │");
+  Log.println("  │ Note: 1% duty cycle, rolling 1h budget  │");
+  Log.println("  │       Extra ECG when state is abnormal  │");
+  Log.println("  └─────────────────────────────────────────┘");
+  Log.println();
+  
+  // Latency probes (stage names follow ProfileStage)
+  profiler.defineStage(PROF_IMU_READ, "imu_read");
+  profiler.defineStage(PROF_FALL_DETECT, "fall_detect");
+  profiler.defineStage(PROF_ECG, "ecg");
+  profiler.defineStage(PROF_MIC, "mic");
+  profiler.defineStage(PROF_TEMP, "temp");
+  profiler.defineStage(PROF_RADIO, "radio");
+  profiler.defineStage(PROF_LOOP, "loop");
+  profiler.reset();
+  Log.println("Serial commands: 'p' latency profile, 'r' reset profile");
+  
+  // Hand sensing and transmission over to the FreeRTOS tasks
+  startTasks();
+  
+  Log.println("Starting monitoring loop...\n");
+}
+
+// ============================================================================
+// Subsystem Tasks
+// ============================================================================
+
+/**
+ * MPU6050 interrupt (data ready, or motion while QUIET) - wakes the IMU task
+ */
+void IRAM_ATTR onImuDataReady() {
+  BaseType_t woken = pdFALSE;
+  if (imuTaskHandle != nullptr) {
+    vTaskNotifyGiveFromISR(imuTaskHandle, &woken);
+  }
+  if (woken) portYIELD_FROM_ISR();
+}
+
+/**
+ * Switch the CPU clock, IMU rate and IMU interrupt for a power mode (IMU
+ * task, right after a drain so no queued sample is left at the old rate)
+ * Both clocks keep APB at 80 MHz, so the switch does not touch the
+ * peripherals and going ACTIVE takes effect before the next drain. The
+ * fall detector and the capture window follow the new IMU rate.
+ */
+void applyPowerMode(PowerManager::Mode mode) {
+  bool active = mode == PowerManager::ACTIVE;
+  setCpuFrequencyMhz(active ? ACTIVE_CPU_MHZ : QUIET_CPU_MHZ);
+  if (mpu.setFIFORate(active ? IMU_SAMPLE_RATE_HZ : QUIET_IMU_SAMPLE_RATE_HZ)) {
+    fallDetector.setSampleRate(mpu.getFIFORate());
+    fallCapture.restart();
+  }
+  mpu.setDataReadyInterrupt(active);  // QUIET: INT on motion only
+  if (loopTaskHandle != nullptr) xTaskNotifyGive(loopTaskHandle);
+  LOG_I(LOG_SYS, "Power mode: %s (%u Hz IMU)", active ? "ACTIVE" : "QUIET", mpu.getFIFORate());
+}
+
+/**
+ * Pause the ADC stream while QUIET with the ECG leads off, resume it
+ * otherwise (IMU task, after each drain)
+ * The leads are read on their LO+/LO- pins, which work without the ADC.
+ * The microphone level is not updated while the stream is paused.
+ */
+void serviceAdcPause(bool quiet) {
+  static uint32_t leadsOffSince = 0;
+  if (!adcStream.isRunning()) return;
+
+  bool leadsOff = digitalRead(PIN_LO_PLUS) == HIGH || digitalRead(PIN_LO_MINUS) == HIGH;
+  uint32_t now = millis();
+  if (!leadsOff || !quiet) {
+    leadsOffSince = 0;
+    if (adcStream.isPaused()) {
+      ecgAcquisition.resync();
+      if (adcStream.resume()) LOG_I(LOG_SYS, "ADC stream resumed");
+    }
+    return;
+  }
+
+  if (leadsOffSince == 0) leadsOffSince = now;
+  if (!adcStream.isPaused() && now - leadsOffSince >= ADC_PAUSE_AFTER_MS && adcStream.pause()) {
+    LOG_I(LOG_SYS, "ADC stream paused (QUIET, leads off)");
+  }
+}
+
+/**
+ * Whether the IMU task may light-sleep until its next QUIET drain
+ * Light sleep stops the APB clock: not while the ADC stream holds its APB
+ * lock, a frame is on air or queued, or an I2C transfer is under way.
+ */
+bool lightSleepAllowed() {
+#if QUIET_LIGHT_SLEEP
+  return adcStream.isRunning() && adcStream.isPaused() &&
+         !loraComm.isBusy() && loraComm.pendingCount() == 0 && i2cBus.isIdle();
+#else
+  return false;
+#endif
+}
+
+/**
+ * Light-sleep until the MPU6050 motion interrupt or for ms (IMU task)
+ * Works like waiting for the task notification: returns the number of
+ * interrupts seen, 0 on the timer. The INT pin is a level wake source
+ * only while asleep and goes back to its rising-edge interrupt after.
+ */
+uint32_t lightSleepForImu(unsigned long ms) {
+  badgeLink.flush(pdMS_TO_TICKS(10));  // The UART clock stops while asleep
+  if (digitalRead(PIN_MPU_INT) == HIGH) return ulTaskNotifyTake(pdTRUE, 0) + 1;  // Latched motion
+
+  gpio_num_t pin = (gpio_num_t)PIN_MPU_INT;
+  gpio_intr_disable(pin);
+  gpio_wakeup_enable(pin, GPIO_INTR_HIGH_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+
+  esp_light_sleep_start();
+
+  gpio_wakeup_disable(pin);
+  gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);
+  gpio_intr_enable(pin);
+
+  uint32_t notified = ulTaskNotifyTake(pdTRUE, 0);
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO && notified == 0) notified = 1;
+  return notified;
+}
+
+/**
+ * IMU / fall detection task (highest priority, sensor core)
+ * Sleeps until the MPU6050 has queued IMU_FIFO_BATCH samples, drains the
+ * FIFO in burst reads and feeds every timestamped sample to the fall
+ * detector. State changes are posted to the radio task without ever
+ * blocking, so detection latency is bounded by one batch period.
+ *
+ * While QUIET the IMU runs at QUIET_IMU_SAMPLE_RATE_HZ with the data-ready
+ * interrupt off: the task drains every QUIET_IMU_DRAIN_MS (in light sleep
+ * when lightSleepAllowed()), and a motion interrupt drains at once and
+ * returns to ACTIVE before the queued samples reach the detector. The full
+ * rate applies from the end of that drain.
+ */
+void imuTask(void* param) {
+  static MPU6050::TimedSample batch[IMU_BATCH_MAX];
+  static FallMath::MotionSquares squares[IMU_BATCH_MAX];
+  FallDetector::FallState previousState = FallDetector::NORMAL;
+  PowerManager::Mode mode = PowerManager::ACTIVE;
+  uint32_t pendingSamples = 0;
+  int64_t lastDrainUs = esp_timer_get_time();
+  uint32_t lastOverflows = 0;
+
+  for (;;) {
+    bool quiet = mode == PowerManager::QUIET;
+    uint32_t notified = quiet && lightSleepAllowed()
+      ? lightSleepForImu(QUIET_IMU_DRAIN_MS)
+      : ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(quiet ? QUIET_IMU_DRAIN_MS : IMU_INT_TIMEOUT_MS));
+    if (notified > 0 && quiet) {
+      // Motion interrupt - full rate before the queued samples are evaluated
+      powerManager.wake(esp_timer_get_time());
+    } else if (notified > 0) {
+      pendingSamples += notified;
+      if (pendingSamples < IMU_FIFO_BATCH) continue;
+    }
+    pendingSamples = 0;
+
+    // Deadline misses: late drains and samples lost to FIFO overflow
+    int64_t now = esp_timer_get_time();
+    if (now - lastDrainUs > (quiet ? QUIET_DRAIN_DEADLINE_US : IMU_DRAIN_DEADLINE_US)) profiler.miss(PROF_IMU_READ);
+    lastDrainUs = now;
+    uint32_t overflows = mpu.getFIFOOverflows();
+    profiler.miss(PROF_IMU_READ, overflows - lastOverflows);
+    lastOverflows = overflows;
+
+    for (;;) {
+      int count;
+      {
+        PROFILE_SCOPE(profiler, PROF_IMU_READ);
+        count = mpu.readFIFOBatch(batch, IMU_BATCH_MAX);
+        FallMath::motionSquares(batch, count, squares);  // Whole batch, integer kernel
+      }
+      if (count <= 0) break;
+
+      for (int i = 0; i < count; i++) {
+        FallDetector::FallState state;
+        {
+          PROFILE_SCOPE(profiler, PROF_FALL_DETECT);
+          state = fallDetector.update(batch[i].data, squares[i], batch[i].timestamp_us);
+        }
+        powerManager.update(squares[i], state, batch[i].timestamp_us);
+
+        // The confirming sample opens the post-trigger part of the window
+        if (fallDetector.isFallConfirmed()) fallCapture.trigger();
+        fallCapture.record(batch[i]);
+
+        if (state != previousState || fallDetector.isFallConfirmed()) {
+          FallNotice notice;
+          notice.event = fallDetector.getLatestEvent();
+          notice.imu = batch[i].data;
+          xQueueSend(fallQueue, &notice, 0);  // Drop rather than stall detection
+          previousState = state;
+        }
+      }
+
+      FallDetector::FallEvent event = fallDetector.getLatestEvent();
+      portENTER_CRITICAL(&telemetryMux);
+      telemetry.imu = batch[count - 1].data;
+      telemetry.fall = event;
+      portEXIT_CRITICAL(&telemetryMux);
+
+      if (count < IMU_BATCH_MAX) break;
+    }
+
+    if (powerManager.getMode() != mode) {
+      mode = powerManager.getMode();
+      applyPowerMode(mode);
+      // Data-ready pulses from before the switch must not count as motion
+      if (mode == PowerManager::QUIET) ulTaskNotifyTake(pdTRUE, 0);
+    }
+    serviceAdcPause(mode == PowerManager::QUIET);
+  }
+}
+
+/**
+ * ECG task - drains the acquisition ring into the AD8232 processing chain
+ */
+void ecgTask(void* param) {
+  uint32_t lastDropped = 0;
+
+  for (;;) {
+    EcgAcquisition::Sample ecgSample;
+
+    xSemaphoreTake(ecgMutex, portMAX_DELAY);
+    {
+      PROFILE_SCOPE(profiler, PROF_ECG);
+      while (ecgAcquisition.read(ecgSample)) {
+        unsigned long sampleTime = ecgAcquisition.sampleTimeMs(ecgSample);
+        // Beat detection and PQRST delineation run per sample inside the monitor
+        ecgMonitor.processSample(ecgSample.value, ecgSample.leadsOff, sampleTime);
+      }
+    }
+    xSemaphoreGive(ecgMutex);
+
+    // Report samples lost because processing fell behind the acquisition ring
+    uint32_t dropped = ecgAcquisition.getDroppedCount();
+    if (dropped != lastDropped) {
+      profiler.miss(PROF_ECG, dropped - lastDropped);
+      LOG_W(LOG_ECG, "ECG ring overflow: %lu samples dropped", (unsigned long)(dropped - lastDropped));
+      lastDropped = dropped;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(powerManager.isQuiet() ? QUIET_ECG_DRAIN_MS : ECG_DRAIN_INTERVAL_MS));
+  }
+}
+
+/**
+ * Temperature task (lowest priority)
+ * Steps the MLX90614 measurement one SMBus read at a time. Reads are
+ * queued on the I2C bus behind IMU transfers and finish in the bus task,
+ * so neither this task nor the IMU task waits on the other.
+ */
+void tempTask(void* param) {
+  TickType_t lastWake = xTaskGetTickCount();
+
+  for (;;) {
+    tempSensor.startMeasurement();
+    for (;;) {
+      bool done;
+      {
+        PROFILE_SCOPE(profiler, PROF_TEMP);
+        done = tempSensor.update();
+      }
+      if (done) break;
+      vTaskDelay(pdMS_TO_TICKS(MLX90614Sensor::SAMPLE_SPACING_MS));
+    }
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TEMP_SAMPLE_INTERVAL));
+  }
+}
+
+/**
+ * Microphone task - picks up the latest sound level from the streaming
+ * meter and tracks the maximum between realtime transmissions
+ */
+void micTask(void* param) {
+  for (;;) {
+    float level;
+    {
+      PROFILE_SCOPE(profiler, PROF_MIC);
+      level = microphone.readSoundLevel(MIC_SAMPLE_WINDOW);
+    }
+
+    portENTER_CRITICAL(&telemetryMux);
+    telemetry.soundLevel = level;
+    if (level > telemetry.maxNoisedB) {
+      telemetry.maxNoisedB = level;
+      telemetry.maxNoiseTimestamp = millis();
+    }
+    portEXIT_CRITICAL(&telemetryMux);
+
+    vTaskDelay(pdMS_TO_TICKS(powerManager.isQuiet() ? QUIET_MIC_IDLE_MS : MIC_IDLE_MS));
+  }
+}
+
+/**
+ * Take a consistent copy of the shared readings
+ */
+Telemetry getTelemetry() {
+  Telemetry snapshot;
+  portENTER_CRITICAL(&telemetryMux);
+  snapshot = telemetry;
+  portEXIT_CRITICAL(&telemetryMux);
+  return snapshot;
+}
+
+/**
+ * Clear max noise tracking after it has been reported
+ */
+void resetMaxNoise() {
+  portENTER_CRITICAL(&telemetryMux);
+  telemetry.maxNoisedB = 0.0;
+  telemetry.maxNoiseTimestamp = 0;
+  portEXIT_CRITICAL(&telemetryMux);
+}
+
+// ============================================================================
+// Radio Task - LoRa and UART Transmission
+// ============================================================================
+
+/**
+ * Print the emergency banner for a newly confirmed fall
+ */
+void printFallAlert(const FallDetector::FallEvent& fall_event) {
+  Log.println("\n!!! FALL CONFIRMED !!!");
+  Log.println("!!! EMERGENCY ALERT TRIGGERED !!!");
+  Log.print("!!! Timestamp: ");
+  Log.print(fall_event.timestamp);
+  Log.println(" ms !!!");
+  Log.println("!!! Monitoring for movement... !!!");
+
+  // Include vital signs in emergency alert
+  int bpm = ecgMonitor.getBPM();
+  if (bpm > 0) {
+    Log.print("!!! Heart Rate: ");
+    Log.print(bpm);
+    Log.println(" BPM !!!");
+  }
+
+  float bodyTemp = tempSensor.currentTemp;
+  if (!isnan(bodyTemp)) {
+    Log.print("!!! Body Temperature: ");
+    Log.print(bodyTemp, 1);
+    Log.println(" °C !!!");
+  }
+  Log.println();
+
+  // Here you can add:
+  // - Send emergency SMS/notification
+  // - Activate buzzer/LED
+  // - Log event to SD card
+  // - Send data to cloud/server
+}
+
+/**
+ * Send immediate realtime packet on critical state change
+ */
+void sendStateChangePacket(const FallDetector::FallEvent& fall_event) {
+  Log.println("\n📡 Sending immediate realtime packet (State Change Alert)...");
+
+  Telemetry snapshot = getTelemetry();
+  uint8_t* payload = loraComm.uplinkBuffer(1, LoRaComm::PRIORITY_FALL);
+
+  // Check alert conditions
+  uint8_t hrStatus = ecgMonitor.checkHeartRate();
+  uint8_t tempStatus = tempSensor.checkTempStatus();
+  bool hrAbnormal = (hrStatus != 0);
+  bool tempAbnormal = (tempStatus >= 3);
+  bool fallAlert = (fall_event.state >= FallDetector::FALL_DETECTED);
+  bool noiseAlert = (snapshot.maxNoisedB >= 80.0);  // Noise alert threshold
+
+  // Use current or max noise level
+  float noiseToSend = (snapshot.maxNoisedB > 0) ? snapshot.maxNoisedB : snapshot.soundLevel;
+
+  int len = PayloadBuilder::buildRealtimePayload(
+    payload,
+    ecgMonitor.getBPM(),
+    tempSensor.currentTemp,
+    tempSensor.ambientTemp,
+    noiseToSend,
+    (uint8_t)fall_event.state,
+    hrAbnormal,
+    tempAbnormal,
+    fallAlert,
+    noiseAlert
+  );
+
+  // State change alerts share the fall priority class so they jump queued ECG frames;
+  // the gateway acknowledges DANGEROUS alerts
+  bool confirmed = fall_event.state == FallDetector::DANGEROUS;
+  bool success = loraComm.queueUplink(1, payload, len, LoRaComm::PRIORITY_FALL, 1, confirmed);
+
+  if (success) {
+    Log.println("✅ Immediate packet queued!");
+    Log.print("State: ");
+    if (fall_event.state == FallDetector::DANGEROUS) {
+      Log.println("UNCONSCIOUS");
+    } else {
+      Log.println("RECOVERED");
+    }
+    Log.print("BPM: ");
+    Log.print(ecgMonitor.getBPM());
+    Log.print("  Temp: ");
+    Log.print(tempSensor.currentTemp, 1);
+    Log.print("°C  Noise: ");
+    Log.print(noiseToSend, 1);
+    Log.println("dB");
+
+    // Send same packet to Vision Master E290 via UART for badge display
+    sendUARTPacket(payload, len);
+  } else {
+    Log.println("❌ Failed to queue immediate packet");
+  }
+
+  Log.println();
+}
+
+/**
+ * Send fall event (Packet Type 0x03)
+ * @return true if the packet was queued for transmission
+ */
+bool sendFallEventPacket(const FallNotice& notice) {
+  const FallDetector::FallEvent& fall_event = notice.event;
+  const MPU6050::SensorData& data = notice.imu;
+
+  if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_DEBUG)) {
+    Log.println("\n╔══════════════════════════════════════════════════════════╗");
+    Log.println("║        📡 FALL EVENT TRANSMISSION (Type 0x03)          ║");
+    Log.println("╚══════════════════════════════════════════════════════════╝");
+  }
+
+  uint8_t* payload = loraComm.uplinkBuffer(3, LoRaComm::PRIORITY_FALL);
+  int bpm = ecgMonitor.getBPM();
+  float bodyTemp = tempSensor.currentTemp;
+
+  int len = PayloadBuilder::buildFallEventPayload(
+    payload,
+    fall_event.timestamp,
+    fall_event.jerk_magnitude,
+    fall_event.svm_value,
+    fall_event.angular_velocity,
+    fall_event.pitch_angle,
+    fall_event.roll_angle,
+    0,  // impact count (not tracked)
+    0,  // warning count (not tracked)
+    bpm > 0 ? bpm : 0,
+    !isnan(bodyTemp) ? bodyTemp : 0.0f,
+    data.accelX,
+    data.accelY,
+    data.accelZ,
+    fall_event.movement_variance
+  );
+
+  // Display packet contents
+  if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_DEBUG)) {
+    Log.println("\n📦 PACKET CONTENTS:");
+    Log.println("  ┌─────────────────────────────────────────┐");
+    Log.print("  │ Packet Type:       0x");
+    Log.print(payload[0], HEX);
+    Log.println(" (Fall Event)        │");
+    Log.print("  │ Packet Size:       ");
+    Log.print(len);
+    Log.println(" bytes                   │");
+    Log.print("  │ Timestamp:         ");
+    Log.print(fall_event.timestamp);
+    Log.println(" ms                │");
+    Log.println("  ├─────────────────────────────────────────┤");
+    Log.print("  │ Jerk Magnitude:    ");
+    Log.print(fall_event.jerk_magnitude, 0);
+    Log.println(" m/s³        │");
+    Log.print("  │ SVM Value:         ");
+    Log.print(fall_event.svm_value, 2);
+    Log.println(" g                 │");
+    Log.print("  │ Angular Velocity:  ");
+    Log.print(fall_event.angular_velocity, 1);
+    Log.println(" °/s           │");
+    Log.print("  │ Pitch Angle:       ");
+    Log.print(fall_event.pitch_angle, 1);
+    Log.println("°                  │");
+    Log.print("  │ Roll Angle:        ");
+    Log.print(fall_event.roll_angle, 1);
+    Log.println("°                  │");
+    Log.println("  ├─────────────────────────────────────────┤");
+    Log.print("  │ Heart Rate:        ");
+    Log.print(bpm);
+    Log.println(" BPM                   │");
+    Log.print("  │ Body Temp:         ");
+    Log.print(bodyTemp, 1);
+    Log.println(" °C                │");
+    Log.print("  │ Movement Variance: ");
+    Log.print(fall_event.movement_variance, 4);
+    Log.println("         │");
+    Log.println("  └─────────────────────────────────────────┘");
+
+    // Display raw hex data (first 20 bytes)
+    Log.print("\n  📋 Hex Data (first 20 bytes): ");
+    for (int i = 0; i < min(20, len); i++) {
+      if (payload[i] < 0x10) Log.print("0");
+      Log.print(payload[i], HEX);
+      Log.print(" ");
+    }
+    if (len > 20) Log.print("...");
+    Log.println();
+
+    Log.println("\n📡 TRANSMISSION STATUS:");
+    Log.print("  → Queueing for LoRa (priority: fall)...");
+  }
+
+  bool success = loraComm.queueUplink(3, payload, len, LoRaComm::PRIORITY_FALL, 1, true);
+
+  if (success) {
+    LOG_I(LOG_LORA, "Fall event queued (%d bytes, %u frames waiting)", len, (unsigned)loraComm.pendingCount());
+  } else {
+    LOG_W(LOG_LORA, "Fall event queue failed - will retry on next cycle");
+  }
+
+  return success;
+}
+
+/**
+ * Take one realtime reading for the next batch
+ * Noise is the maximum since the previous reading, so no peak is lost
+ * between readings.
+ */
+PayloadBuilder::RealtimeReading takeRealtimeReading() {
+  Telemetry snapshot = getTelemetry();
+  const FallDetector::FallEvent& fall_event = snapshot.fall;
+  float soundLevel = snapshot.soundLevel;
+
+  int bpm = ecgMonitor.getBPM();
+  float bodyTemp = tempSensor.currentTemp;
+  float ambientTemp = tempSensor.ambientTemp;
+
+  // Check for abnormal conditions
+  uint8_t hrStatus = ecgMonitor.checkHeartRate();
+  uint8_t tempStatus = tempSensor.checkTempStatus();
+  bool hrAbnormal = (hrStatus == 1 || hrStatus == 2);
+  bool tempAbnormal = (tempStatus == 3 || tempStatus == 4);
+  bool fallAlert = (fall_event.state == FallDetector::FALL_DETECTED ||
+                    fall_event.state == FallDetector::DANGEROUS);
+
+  // Use max noise level if available, otherwise use current
+  float noiseToSend = (snapshot.maxNoisedB > 0) ? snapshot.maxNoisedB : soundLevel;
+  bool noiseAlertMax = (noiseToSend > 100.0f);
+  resetMaxNoise();
+
+  return PayloadBuilder::makeRealtimeReading(
+    millis(),
+    bpm > 0 ? bpm : 0,
+    !isnan(bodyTemp) ? bodyTemp : 0.0f,
+    !isnan(ambientTemp) ? ambientTemp : 0.0f,
+    noiseToSend,
+    fall_event.state,
+    hrAbnormal,
+    tempAbnormal,
+    fallAlert,
+    noiseAlertMax
+  );
+}
+
+/**
+ * Send batched real-time monitoring data (Packet Type 0x04)
+ * @return true if the batch was queued (the caller then starts a new one)
+ */
+bool sendRealtimeBatchPacket(const PayloadBuilder::RealtimeReading* readings, int count) {
+  uint8_t* payload = loraComm.uplinkBuffer(4, LoRaComm::PRIORITY_REALTIME);
+  int len = PayloadBuilder::buildRealtimeBatchPayload(payload, readings, count);
+  if (len == 0 || !loraComm.mayTransmit(LoRaComm::PRIORITY_REALTIME, len, 4)) {
+    return false;
+  }
+
+  if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_DEBUG)) {
+    Log.println("\n╔══════════════════════════════════════════════════════════╗");
+    Log.println("║  📡 REALTIME MONITORING TRANSMISSION (Type 0x04 batch) ║");
+    Log.println("║               Paced by airtime budget                  ║");
+    Log.println("╚══════════════════════════════════════════════════════════╝");
+
+    Log.println("\n📦 PACKET CONTENTS:");
+    Log.printf("  Readings: %d, Payload: %d bytes (%d bytes as 0x01 frames)\n",
+                  count, len, count * (int)(LoRaComm::HEADER_SIZE + REALTIME_PAYLOAD_SIZE));
+    Log.println("  ┌───────┬─────┬────────┬─────────┬───────┬────────┐");
+    Log.println("  │  Age  │ BPM │ Body°C │ Ambient │ Noise │ Status │");
+    Log.println("  ├───────┼─────┼────────┼─────────┼───────┼────────┤");
+    uint32_t now = millis();
+    for (int i = 0; i < count; i++) {
+      const PayloadBuilder::RealtimeReading& r = readings[i];
+      Log.printf("  │ %4lus │ %3u │ %6.1f │ %7.1f │ %5u │  0x%02X  │\n",
+                    (unsigned long)((now - r.timestamp) / 1000), r.bpm,
+                    TempCode::decode(r.bodyTemp),
+                    TempCode::decode(r.ambientTemp),
+                    r.noise, r.status);
+    }
+    Log.println("  └───────┴─────┴────────┴─────────┴───────┴────────┘");
+
+    // Display raw hex data
+    Log.print("\n  📋 Hex Data: ");
+    for (int i = 0; i < len; i++) {
+      if (payload[i] < 0x10) Log.print("0");
+      Log.print(payload[i], HEX);
+      Log.print(" ");
+    }
+    Log.println();
+
+    Log.println("\n📡 TRANSMISSION STATUS:");
+    Log.print("  → Queueing for LoRa (priority: realtime)...");
+  }
+
+  // One frame counter value per reading so receivers can number them
+  bool success = loraComm.queueUplink(4, payload, len, LoRaComm::PRIORITY_REALTIME, (uint8_t)count);
+
+  if (success) {
+    LOG_I(LOG_LORA, "Realtime batch queued (%d readings, %d bytes, airtime %.1f%%)",
+          count, len, loraComm.budgetUsage() * 100.0f);
+  } else {
+    LOG_W(LOG_LORA, "Realtime batch queue failed - will retry on next cycle");
+  }
+  return success;
+}
+
+/**
+ * Send ECG data (Packet Type 0x02 or 0x05, see ECG_CODEC) when heart rate is stable
+ */
+void sendECGPacket() {
+  int bpm = ecgMonitor.getBPM();
+  // Only send when heart rate in reasonable range, or any detected rhythm while boosting
+  bool inRange = (bpm > 40 && bpm < 150);
+  if (!inRange && !(loraComm.isBoosting() && bpm > 0)) return;
+
+  if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_DEBUG)) {
+    Log.println("\n╔══════════════════════════════════════════════════════════╗");
+    Log.printf("║         📡 ECG DATA TRANSMISSION (Type 0x%02X)           ║\n", ECG_PORT);
+    Log.println("║     Paced by airtime budget (boosted when abnormal)    ║");
+    Log.println("╚══════════════════════════════════════════════════════════╝");
+  }
+
+  uint8_t* payload = loraComm.uplinkBuffer(ECG_PORT);
+  uint8_t pqrst[EcgPacket::PQRST_SIZE];
+
+#if ECG_CODEC == ECG_CODEC_RICE
+  uint16_t window[PayloadBuilder::RICE_ECG_SAMPLES];
+
+  // Copy a consistent window while the ECG task is not writing
+  xSemaphoreTake(ecgMutex, portMAX_DELAY);
+  int windowLen = ecgMonitor.getECGWindow(window, PayloadBuilder::RICE_ECG_SAMPLES);
+  int pqrstLen = ecgMonitor.getPQRSTData(pqrst);
+  xSemaphoreGive(ecgMutex);
+
+  int len = PayloadBuilder::buildECGRicePayload(
+    payload,
+    window,
+    windowLen,
+    pqrst,
+    pqrstLen
+  );
+  uint8_t* compressedECG = &payload[5];
+  int ecgLen = PayloadBuilder::RICE_ECG_CODE_BYTES;
+#else
+  uint8_t compressedECG[50];
+
+  // Copy a consistent window while the ECG task is not writing
+  xSemaphoreTake(ecgMutex, portMAX_DELAY);
+  int ecgLen = ecgMonitor.getCompressedECG(compressedECG, 50);
+  int pqrstLen = ecgMonitor.getPQRSTData(pqrst);
+  xSemaphoreGive(ecgMutex);
+
+  int len = PayloadBuilder::buildECGPayload(
+    payload,
+    compressedECG,
+    ecgLen,
+    pqrst,
+    pqrstLen
+  );
+#endif
+
+  // Display packet contents
+  if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_DEBUG)) {
+    Log.println("\n📦 PACKET CONTENTS:");
+    Log.println("  ┌─────────────────────────────────────────┐");
+    Log.print("  │ Packet Type:       0x");
+    Log.print(payload[0], HEX);
+    Log.println(" (ECG Data)          │");
+    Log.print("  │ Packet Size:       ");
+    Log.print(len);
+    Log.println(" bytes                   │");
+    Log.print("  │ Current BPM:       ");
+    Log.print(bpm);
+    Log.println(" BPM                   │");
+    Log.println("  ├─────────────────────────────────────────┤");
+    Log.print("  │ Compressed ECG:    ");
+    Log.print(ecgLen);
+#if ECG_CODEC == ECG_CODEC_RICE
+    Log.println(" bytes (50Hz)        │");
+#else
+    Log.println(" bytes (25Hz)        │");
+#endif
+    Log.print("  │ PQRST Features:    ");
+    Log.print(pqrstLen);
+    Log.println(" bytes              │");
+#if ECG_CODEC == ECG_CODEC_RICE
+    Log.print("  │ Compression:       100Hz → 50Hz       │");
+    Log.println();
+    Log.print("  │ Encoding:          adaptive Rice delta │");
+    Log.println();
+#else
+    Log.print("  │ Compression:       100Hz → 25Hz       │");
+    Log.println();
+    Log.print("  │ Encoding:          8-bit differential  │");
+    Log.println();
+#endif
+    Log.println("  └─────────────────────────────────────────┘");
+
+    // Display compressed ECG sample (first 10 bytes)
+    Log.print("\n  📋 Compressed ECG (first 10 bytes): ");
+    for (int i = 0; i < min(10, ecgLen); i++) {
+      if (compressedECG[i] < 0x10) Log.print("0");
+      Log.print(compressedECG[i], HEX);
+      Log.print(" ");
+    }
+    if (ecgLen > 10) Log.print("...");
+    Log.println();
+
+    if (pqrstLen > 0) {
+      Log.print("  📋 PQRST Features: ");
+      for (int i = 0; i < min(14, pqrstLen); i++) {
+        if (pqrst[i] < 0x10) Log.print("0");
+        Log.print(pqrst[i], HEX);
+        Log.print(" ");
+      }
+      Log.println();
+    }
+
+    Log.println("\n📡 TRANSMISSION STATUS:");
+    Log.print("  → Queueing for LoRa (priority: ECG)...");
+  }
+
+  bool success = loraComm.queueUplink(ECG_PORT, payload, len);
+
+  if (success) {
+    LOG_I(LOG_LORA, "ECG packet queued (type 0x%02X, %d bytes, airtime %.1f%%)",
+          ECG_PORT, len, loraComm.budgetUsage() * 100.0f);
+  } else {
+    LOG_W(LOG_LORA, "ECG packet queue failed - will retry on next cycle");
+  }
+}
+
+/**
+ * Send the next fragment of a captured fall window (Packet Type 0x07)
+ * Fragments go out one at a time in the fall class, behind any queued
+ * alert, and only while the hour's airtime stays under
+ * FALL_WAVEFORM_CEILING_SHARE so the fall reserve stays free for alerts.
+ */
+void sendFallWaveformFragment() {
+  static int nextFragment = -1;  // -1 until the waiting window is encoded
+  static uint32_t windowReadyAt = 0;
+
+  if (!fallCapture.ready()) return;
+
+  if (nextFragment < 0) {
+    int count = fallCapture.encode();
+    nextFragment = 0;
+    windowReadyAt = millis();
+    LOG_I(LOG_FALL, "Fall window %u: %u samples, %d fragments",
+          fallCapture.windowId(), fallCapture.windowLength(), count);
+  }
+
+  if (millis() - windowReadyAt > FALL_WAVEFORM_MAX_AGE_MS) {
+    LOG_W(LOG_LORA, "Fall window %u abandoned after %d/%d fragments",
+          fallCapture.windowId(), nextFragment, fallCapture.getFragmentCount());
+    fallCapture.release();
+    nextFragment = -1;
+    return;
+  }
+
+  if (nextFragment < fallCapture.getFragmentCount()) {
+    // Never displace an alert, or one still waiting for its ACK
+    if (loraComm.pendingCount(LoRaComm::PRIORITY_FALL) > 0 || loraComm.pendingAckCount() > 0) return;
+
+    uint8_t* payload = loraComm.uplinkBuffer(FallWaveformPacket::TYPE, LoRaComm::PRIORITY_FALL);
+    int len = PayloadBuilder::buildFallWaveformPayload(payload, fallCapture, nextFragment,
+                                                       (uint8_t)IMU_SAMPLE_RATE_HZ);
+    if (!loraComm.fitsBudgetShare(FALL_WAVEFORM_CEILING_SHARE, len, FallWaveformPacket::TYPE) ||
+        !loraComm.queueUplink(FallWaveformPacket::TYPE, payload, len, LoRaComm::PRIORITY_FALL)) {
+      return;
+    }
+    nextFragment++;
+  }
+
+  if (nextFragment >= fallCapture.getFragmentCount()) {
+    LOG_I(LOG_LORA, "Fall window %u queued (%d fragments)",
+          fallCapture.windowId(), fallCapture.getFragmentCount());
+    fallCapture.release();
+    nextFragment = -1;
+  }
+}
+
+/**
+ * Send the latency diagnostics (Packet Type 0x06) when the airtime budget allows
+ * @return true if the frame was queued
+ */
+bool sendDiagnosticsPacket() {
+  uint8_t* payload = loraComm.uplinkBuffer(DiagnosticsPacket::TYPE);
+  int len = PayloadBuilder::buildDiagnosticsPayload(payload, profiler, PROF_STAGE_COUNT);
+  if (!loraComm.mayTransmit(LoRaComm::PRIORITY_ECG, len, DiagnosticsPacket::TYPE)) {
+    return false;
+  }
+
+  bool success = loraComm.queueUplink(DiagnosticsPacket::TYPE, payload, len);
+  if (success) {
+    LOG_I(LOG_LORA, "Diagnostics queued (%d bytes, %lu s window)",
+          len, (unsigned long)profiler.windowSeconds());
+  }
+  return success;
+}
+
+/**
+ * Record a confirmed fall in the vitals history with the vitals at that moment
+ */
+void recordFallEvent(const FallDetector::FallEvent& fall_event) {
+  int bpm = ecgMonitor.getBPM();
+  float bodyTemp = tempSensor.currentTemp;
+  float ambientTemp = tempSensor.ambientTemp;
+  uint8_t hrStatus = ecgMonitor.checkHeartRate();
+  uint8_t tempStatus = tempSensor.checkTempStatus();
+  float soundLevel = getTelemetry().soundLevel;
+
+  PayloadBuilder::RealtimeReading r = PayloadBuilder::makeRealtimeReading(
+    millis(),
+    bpm > 0 ? bpm : 0,
+    !isnan(bodyTemp) ? bodyTemp : 0.0f,
+    !isnan(ambientTemp) ? ambientTemp : 0.0f,
+    soundLevel,
+    fall_event.state,
+    hrStatus == 1 || hrStatus == 2,
+    tempStatus == 3 || tempStatus == 4,
+    true,
+    soundLevel > 100.0f
+  );
+  historyLog.addEvent(r.timestamp, r.bpm, r.bodyTemp, r.ambientTemp, r.noise, r.status);
+}
+
+/**
+ * Send the next vitals history page (Packet Type 0x0A)
+ * One page is on air at a time, confirmed by the gateway, and its records
+ * are released when the ACK comes back. In range that is one full page
+ * every half hour or so. After an outage the backlog goes out page after
+ * page - behind the live frames, on the backfill share of the airtime
+ * budget - until it has caught up. An unacknowledged page backs off from
+ * HISTORY_RETRY_MS to HISTORY_RETRY_MAX_MS; any downlink heard since then
+ * shows the link is back and ends the wait.
+ */
+void sendHistoryPage() {
+  if (historyPage.count > 0 || historyLog.pending() == 0) return;
+
+  // Never take an ACK slot a fall alert may need
+  if (loraComm.pendingCount(LoRaComm::PRIORITY_FALL) > 0 || loraComm.pendingAckCount() > 0) return;
+
+  if (historyPage.retryMs > 0 && millis() - historyPage.missedAt < historyPage.retryMs &&
+      (int32_t)(loraComm.getLastDownlink() - historyPage.missedAt) <= 0) {
+    return;
+  }
+
+  // Records one page can hold at most (two bytes for each unchanged one)
+  const int PAGE_MAX = (LoRaComm::MAX_PAYLOAD_SIZE - HistoryPagePacket::HEADER_SIZE) / 2 + 1;
+  HistoryLog::Record records[PAGE_MAX];
+  uint32_t firstSeq = historyLog.oldest();
+  int available = historyLog.peek(firstSeq, records, PAGE_MAX);
+
+  uint8_t* payload = loraComm.uplinkBuffer(HISTORY_PORT, LoRaComm::PRIORITY_BACKFILL);
+  uint32_t nowS = millis() / 1000;
+  int count = 0;
+  int len = PayloadBuilder::buildHistoryPayload(payload, LoRaComm::MAX_PAYLOAD_SIZE, historyPage.logId,
+                                                firstSeq, nowS, records, available, count);
+  if (len == 0) return;
+
+  // Let a page fill up unless its oldest record has waited long enough
+  bool full = (uint32_t)count < historyLog.pending() ||
+              len + HistoryPagePacket::RECORD_MAX_SIZE > LoRaComm::MAX_PAYLOAD_SIZE;
+  if (!full && nowS - records[0].time < HISTORY_FLUSH_S) return;
+
+  if (!loraComm.mayTransmit(LoRaComm::PRIORITY_BACKFILL, len, HISTORY_PORT) ||
+      !loraComm.queueUplink(HISTORY_PORT, payload, len, LoRaComm::PRIORITY_BACKFILL, 1, true)) {
+    return;
+  }
+  historyPage.firstSeq = firstSeq;
+  historyPage.count = count;
+  LOG_I(LOG_LORA, "History page queued (%d records from #%lu, %d bytes, %lu waiting)",
+        count, (unsigned long)firstSeq, len, (unsigned long)historyLog.pending());
+}
+
+/**
+ * Settle the history page on air once its ACK window has closed
+ * @return true if the result was for a history page
+ */
+bool onHistoryPageDone(const LoRaComm::TxResult& result) {
+  if (result.port != HISTORY_PORT || historyPage.count == 0) return false;
+
+  if (result.acked) {
+    historyLog.acknowledge(historyPage.firstSeq + historyPage.count);
+    historyPage.retryMs = 0;
+    LOG_I(LOG_LORA, "History page acknowledged: %d records (%lu ms after queueing, %lu waiting)",
+          historyPage.count, (unsigned long)result.latencyMs, (unsigned long)historyLog.pending());
   } else {
-    Serial.println("✅ LoRa initialized successfully!");
-    Serial.println("\n========================================");
-    Serial.println("  LORA READY");
-    Serial.println("========================================");
-    Serial.println("Frequency: 923 MHz (Hong Kong AS923)");
-    Serial.println("Spreading Factor: 9");
-    Serial.println("Bandwidth: 125 kHz");
-    Serial.println("========================================\n");
+    historyPage.retryMs = historyPage.retryMs == 0 ? HISTORY_RETRY_MS :
+                          min(historyPage.retryMs * 2, HISTORY_RETRY_MAX_MS);
+    historyPage.missedAt = millis();
+    LOG_W(LOG_LORA, "History page not acknowledged - next try in %lu s (%lu records waiting)",
+          (unsigned long)(historyPage.retryMs / 1000), (unsigned long)historyLog.pending());
   }
-  
-  Serial.println("\n========================================");
-  Serial.println("  ALL SYSTEMS READY");
-  Serial.println("========================================");
-  
-  // ========================================
-  // UART Initialization for Vision Master E290
-  // ========================================
-  
-  Serial.println("\nInitializing UART for Vision Master E290...");
-  Serial1.begin(UART_BAUD, SERIAL_8N1, PIN_UART_RX, PIN_UART_TX);
-  Serial.print("UART configured: TX=");
-  Serial.print(PIN_UART_TX);
-  Serial.print(", RX=");
-  Serial.print(PIN_UART_RX);
-  Serial.print(", Baud=");
-  Serial.println(UART_BAUD);
-  Serial.println("✅ UART ready for staff badge communication!");
-  Serial.println("========================================\n");
-  
-  Serial.println("\n📡 TRANSMISSION SCHEDULE (Optimized for HK Regulations):");
-  Serial.println("  ┌─────────────────────────────────────────┐");
-  Serial.print("  │ Realtime Data:     Every ");
-  Serial.print(REALTIME_TX_INTERVAL / 1000);
-  Serial.println("s (~39s)   │");
-  Serial.print("  │ ECG Data:          Every ");
-  Serial.print(ECG_TX_INTERVAL / 1000);
-  Serial.println("s (~2min)  │");
-  Serial.println("  │ Fall Events:       Immediate            │");
-  Serial.println("  │                                         │");
-  Serial.println("  │ Note: 1% duty cycle compliance          │");
-  Serial.println("  │       SF9, BW125kHz air time optimized  │");
-  Serial.println("  └─────────────────────────────────────────┘");
-  Serial.println();
-  
-  Serial.println("Starting monitoring loop...\n");
+  historyPage.count = 0;
+  return true;
 }
 
-// ============================================================================
-// Arduino Main Loop
-// ============================================================================
+/**
+ * TX-done callback - reports the on-air result of each queued frame
+ */
+void onUplinkDone(const LoRaComm::TxResult& result) {
+  if (onHistoryPageDone(result)) return;
 
-void loop() {
-  unsigned long currentTime = millis();
-  
-  // Display next transmission countdown (every 10 seconds)
-  static unsigned long lastCountdownDisplay = 0;
-  if (currentTime - lastCountdownDisplay >= 10000) {
-    unsigned long realtimeRemaining = (lastRealtimeTxTime + REALTIME_TX_INTERVAL > currentTime) ? 
-                                      (lastRealtimeTxTime + REALTIME_TX_INTERVAL - currentTime) : 0;
-    unsigned long ecgRemaining = (lastECGTxTime + ECG_TX_INTERVAL > currentTime) ? 
-                                 (lastECGTxTime + ECG_TX_INTERVAL - currentTime) : 0;
-    
-    Serial.println("\n⏰ TRANSMISSION COUNTDOWN:");
-    Serial.print("  Realtime (1min):  ");
-    if (realtimeRemaining > 0) {
-      Serial.println(formatTimeRemaining(realtimeRemaining));
-    } else {
-      Serial.println("Ready to send!");
+  if (result.confirmed && result.acked) {
+    LOG_I(LOG_LORA, "TX acknowledged: Type %d, frame %u, attempt %u (%lu ms after queueing)",
+          result.port, result.frameCounter, result.attempt + 1, (unsigned long)result.latencyMs);
+  } else if (result.confirmed && result.retryInMs > 0) {
+    LOG_W(LOG_LORA, "No ACK for Type %d frame %u (attempt %u) - retrying in %lu ms",
+          result.port, result.frameCounter, result.attempt + 1, (unsigned long)result.retryInMs);
+  } else if (result.confirmed) {
+    LOG_E(LOG_LORA, "Type %d frame %u never acknowledged after %u attempts",
+          result.port, result.frameCounter, result.attempt + 1);
+  } else if (result.success) {
+    LOG_I(LOG_LORA, "TX done: Type %d, frame %u, %u bytes, %lu ms on air (%lu ms after queueing)",
+          result.port, result.frameCounter, (unsigned)result.length,
+          (unsigned long)result.airtimeMs, (unsigned long)result.latencyMs);
+  } else {
+    LOG_W(LOG_LORA, "TX failed: Type %d, frame %u, code %d",
+          result.port, result.frameCounter, result.state);
+  }
+}
+
+/**
+ * Radio task (protocol core)
+ * Owns the SX1262 and the badge UART. Packets are queued by priority and
+ * sent asynchronously; while a frame is on air the task polls for TX done
+ * at a short interval so the next frame (e.g. a fall) starts promptly.
+ */
+void radioTask(void* param) {
+  FallDetector::FallState previousFallState = FallDetector::NORMAL;
+  bool fallEventTriggered = false;
+  bool fallPending = false;
+  FallNotice pendingFall;
+  PayloadBuilder::RealtimeReading realtimeBatch[PayloadBuilder::REALTIME_BATCH_MAX];
+  int realtimeBatchCount = 0;
+  uint32_t lastRealtimeReading = 0;
+  uint32_t lastDiagnostics = millis();
+
+  for (;;) {
+    // Wait for a fall state notice, waking periodically for scheduled packets
+    FallNotice notice;
+    TickType_t wait = (loraComm.isBusy() || loraComm.pendingCount() > 0) ? pdMS_TO_TICKS(RADIO_BUSY_POLL_MS) :
+                      pdMS_TO_TICKS(powerManager.isQuiet() ? QUIET_RADIO_POLL_MS : RADIO_POLL_INTERVAL_MS);
+    bool received = xQueueReceive(fallQueue, &notice, wait) == pdTRUE;
+    PROFILE_SCOPE(profiler, PROF_RADIO);
+
+    if (received) {
+      const FallDetector::FallEvent& fall_event = notice.event;
+      bool stateChangeNotified = false;
+
+      if (fall_event.confirmed) {
+        printFallAlert(fall_event);
+      }
+
+      // Send immediate realtime packet if state changed to DANGEROUS or returned to NORMAL
+      if (fall_event.state != previousFallState) {
+        if (fall_event.state == FallDetector::FALL_DETECTED) {
+          Log.println("\n╔═══════════════════════════════════════════════════════════╗");
+          Log.println("║  ⚠️  STATE CHANGE: FALL DETECTED - SENDING IMMEDIATE ALERT ║");
+          Log.println("╚═══════════════════════════════════════════════════════════╝");
+          stateChangeNotified = true;
+        } else if (fall_event.state == FallDetector::DANGEROUS) {
+          Log.println("\n╔═══════════════════════════════════════════════════════════╗");
+          Log.println("║  🚨 STATE CHANGE: UNCONSCIOUS - SENDING IMMEDIATE ALERT  ║");
+          Log.println("╚═══════════════════════════════════════════════════════════╝");
+          stateChangeNotified = true;
+        } else if ((previousFallState == FallDetector::FALL_DETECTED || previousFallState == FallDetector::DANGEROUS) && fall_event.state == FallDetector::NORMAL) {
+          Log.println("\n╔═══════════════════════════════════════════════════════════╗");
+          Log.println("║  ✅ STATE CHANGE: RECOVERED - SENDING IMMEDIATE UPDATE   ║");
+          Log.println("╚═══════════════════════════════════════════════════════════╝");
+          stateChangeNotified = true;
+        }
+        previousFallState = fall_event.state;
+      }
+
+      if (stateChangeNotified) {
+        sendStateChangePacket(fall_event);
+      }
+
+      // Queue fall event transmission until it succeeds
+      if (fall_event.confirmed && !fallEventTriggered) {
+        if (!fallPending) recordFallEvent(fall_event);
+        pendingFall = notice;
+        fallPending = true;
+      }
+
+      // Reset fall event flag when recovery state reached
+      if (fall_event.state == FallDetector::NORMAL ||
+          fall_event.state == FallDetector::RECOVERY) {
+        fallEventTriggered = false;
+        fallPending = false;
+      }
     }
-    Serial.print("  ECG (5.1min):     ");
-    if (ecgRemaining > 0) {
-      Serial.println(formatTimeRemaining(ecgRemaining));
-    } else {
-      Serial.println("Ready to send!");
+
+    // Send fall event immediately (Packet Type 0x03)
+    if (fallPending && sendFallEventPacket(pendingFall)) {
+      fallEventTriggered = true;
+      fallPending = false;
     }
-    Serial.println();
-    lastCountdownDisplay = currentTime;
-  }
-  
-  // Read ECG data at 100 Hz
-  if (currentTime - lastECGSampleTime >= ECG_SAMPLE_INTERVAL) {
-    int ecgValue = ecgMonitor.readECG();
-    
-    // Extract PQRST features when new heartbeat detected
-    if (ecgMonitor.currentBPM > 0 && ecgValue > 0) {
-      static unsigned long lastPQRSTExtraction = 0;
-      if (currentTime - lastPQRSTExtraction > 1000) {  // Extract every second
-        ecgMonitor.extractPQRSTFeatures();
-        lastPQRSTExtraction = currentTime;
+
+    // Then the captured waveform around it (Packet Type 0x07)
+    if (!fallPending) {
+      sendFallWaveformFragment();
+    }
+
+    // Spend spare airtime on extra ECG while the wearer is in an abnormal state
+    FallDetector::FallState fallState = getTelemetry().fall.state;
+    bool abnormal = ecgMonitor.checkHeartRate() != 0 ||
+                    tempSensor.checkTempStatus() >= 3 ||
+                    fallState == FallDetector::FALL_DETECTED ||
+                    fallState == FallDetector::DANGEROUS;
+    loraComm.setBoost(abnormal);
+
+    // Collect realtime readings; a full batch drops its oldest reading
+    if (lastRealtimeReading == 0 || millis() - lastRealtimeReading >= REALTIME_SAMPLE_INTERVAL) {
+      if (realtimeBatchCount == PayloadBuilder::REALTIME_BATCH_MAX) {
+        memmove(&realtimeBatch[0], &realtimeBatch[1],
+                sizeof(realtimeBatch[0]) * (PayloadBuilder::REALTIME_BATCH_MAX - 1));
+        realtimeBatchCount--;
       }
+      PayloadBuilder::RealtimeReading reading = takeRealtimeReading();
+      realtimeBatch[realtimeBatchCount++] = reading;
+      historyLog.addReading(reading.timestamp, reading.bpm, reading.bodyTemp,
+                            reading.ambientTemp, reading.noise, reading.status);
+      lastRealtimeReading = millis();
+    }
+
+    // Send the batch when the airtime budget allows (Packet Type 0x04)
+    if (sendRealtimeBatchPacket(realtimeBatch, realtimeBatchCount)) {
+      realtimeBatchCount = 0;
+    }
+
+    // Send ECG data when the airtime budget allows (Packet Type 0x02 or 0x05)
+    if (loraComm.mayTransmit(LoRaComm::PRIORITY_ECG, ECG_PAYLOAD_SIZE, ECG_PORT)) {
+      sendECGPacket();
+    }
+
+    // Send latency diagnostics when due (Packet Type 0x06)
+    if (DIAGNOSTICS_INTERVAL_MS > 0 && millis() - lastDiagnostics >= DIAGNOSTICS_INTERVAL_MS &&
+        sendDiagnosticsPacket()) {
+      lastDiagnostics = millis();
     }
     
-    lastECGSampleTime = currentTime;
-  }
-  
-  // Read temperature every 5 seconds
-  if (currentTime - lastTempSampleTime >= TEMP_SAMPLE_INTERVAL) {
-    tempSensor.readAmbient();
-    tempSensor.readBodyTemp();
-    lastTempSampleTime = currentTime;
-  }
-  
-  // Read sensor data
-  MPU6050::SensorData data = mpu.readSensorData();
-  
-  // Perform fall detection
-  FallDetector::FallEvent fall_event = fallDetector.detectFall(data);
-  
-  // Read noise level
-  float soundLevel = microphone.readSoundLevel(MIC_SAMPLE_WINDOW);
-  
-  // Track maximum noise level between transmissions
-  if (soundLevel > maxNoisedB) {
-    maxNoisedB = soundLevel;
-    maxNoiseTimestamp = currentTime;
+    // Upload the vitals history on the backfill share (Packet Type 0x0A)
+    sendHistoryPage();
+
+    // Complete the frame on air and start the next queued one
+    loraComm.service();
   }
-  
+}
+
+/**
+ * Create queues and start all subsystem tasks
+ */
+void startTasks() {
+  fallQueue = xQueueCreate(FALL_QUEUE_LENGTH, sizeof(FallNotice));
+  ecgMutex = xSemaphoreCreateMutex();
+
+  xTaskCreatePinnedToCore(imuTask, "imu", 4096, nullptr, IMU_TASK_PRIORITY, &imuTaskHandle, SENSOR_CORE);
+  xTaskCreatePinnedToCore(ecgTask, "ecg", 4096, nullptr, ECG_TASK_PRIORITY, nullptr, SENSOR_CORE);
+  xTaskCreatePinnedToCore(micTask, "mic", 3072, nullptr, MIC_TASK_PRIORITY, nullptr, SENSOR_CORE);
+  xTaskCreatePinnedToCore(tempTask, "temp", 3072, nullptr, TEMP_TASK_PRIORITY, nullptr, SENSOR_CORE);
+  xTaskCreatePinnedToCore(radioTask, "radio", 8192, nullptr, RADIO_TASK_PRIORITY, nullptr, RADIO_CORE);
+
+  // Data-ready interrupt drives the IMU task from here on
+  pinMode(PIN_MPU_INT, INPUT);
+  attachInterrupt(digitalPinToInterrupt(PIN_MPU_INT), onImuDataReady, RISING);
+
+  Log.println("🧵 Tasks started:");
+  Log.printf("   i2c   prio %d  core %d\n", I2C_TASK_PRIORITY, SENSOR_CORE);
+  Log.printf("   imu   prio %d  core %d  (%u Hz FIFO, INT GPIO%d)\n", IMU_TASK_PRIORITY, SENSOR_CORE, mpu.getFIFORate(), PIN_MPU_INT);
+  Log.printf("   ecg   prio %d  core %d\n", ECG_TASK_PRIORITY, SENSOR_CORE);
+  Log.printf("   mic   prio %d  core %d\n", MIC_TASK_PRIORITY, SENSOR_CORE);
+  Log.printf("   temp  prio %d  core %d\n", TEMP_TASK_PRIORITY, SENSOR_CORE);
+  Log.printf("   radio prio %d  core %d\n\n", RADIO_TASK_PRIORITY, RADIO_CORE);
+}
+
+// ============================================================================
+// Arduino Main Loop
+// ============================================================================
+
+/**
+ * Print the periodic status report from a telemetry snapshot
+ */
+void printStatusReport(const Telemetry& snapshot, unsigned long currentTime) {
+  const MPU6050::SensorData& data = snapshot.imu;
+  const FallDetector::FallEvent& fall_event = snapshot.fall;
+  float soundLevel = snapshot.soundLevel;
+
   // Display sensor data
-  mpu.printData(data);
-  
+  if (LOG_ENABLED(LOG_IMU, LOG_LEVEL_DEBUG)) {
+    mpu.printData(data);
+  }
+
   // Display body temperature monitoring
-  Serial.println("--- Body Temperature Monitoring ---");
-  tempSensor.printStatus();
-  
+  if (LOG_ENABLED(LOG_TEMP, LOG_LEVEL_INFO)) {
+    Log.println("--- Body Temperature Monitoring ---");
+    tempSensor.printStatus();
+  }
+
   // Display ECG/Heart rate monitoring
-  Serial.println("--- Heart Rate Monitoring ---");
-  ecgMonitor.printStatus();
-  
+  if (LOG_ENABLED(LOG_ECG, LOG_LEVEL_INFO)) {
+    Log.println("--- Heart Rate Monitoring ---");
+    ecgMonitor.printStatus();
+  }
+
   // Display ECG compression info (every 5 seconds)
   static unsigned long lastCompressionInfo = 0;
-  if (currentTime - lastCompressionInfo > 5000) {
-    Serial.println("--- ECG Data Compression Status ---");
-    
+  if (LOG_ENABLED(LOG_ECG, LOG_LEVEL_DEBUG) && currentTime - lastCompressionInfo > 5000) {
+    Log.println("--- ECG Data Compression Status ---");
+
     // Show compressed ECG size
     uint8_t tempBuffer[50];
+    xSemaphoreTake(ecgMutex, portMAX_DELAY);
     int compressedSize = ecgMonitor.getCompressedECG(tempBuffer, 50);
-    Serial.print("Compressed ECG: ");
-    Serial.print(compressedSize);
-    Serial.println(" bytes (25Hz, 8-bit differential)");
-    
-    // Show PQRST data size
     int pqrstSize = ecgMonitor.getPQRSTData(tempBuffer);
+    xSemaphoreGive(ecgMutex);
+    Log.print("Compressed ECG: ");
+    Log.print(compressedSize);
+    Log.println(" bytes (25Hz, 8-bit differential)");
+
+    // Show PQRST data size
     if (pqrstSize > 0) {
-      Serial.print("PQRST Features: ");
-      Serial.print(pqrstSize);
-      Serial.println(" bytes");
-      Serial.println("  P/Q/R/S/T amplitudes + QRS width + QT interval");
+      Log.print("PQRST Features: ");
+      Log.print(pqrstSize);
+      Log.println(" bytes");
+      Log.println("  P/Q/R/S/T amplitudes + QRS width + QT interval");
     }
-    
+
     // Show breathing rate
     int br = ecgMonitor.getBreathingRate();
     if (br > 0) {
-      Serial.print("Estimated Breathing Rate: ");
-      Serial.print(br);
-      Serial.println(" breaths/min");
+      Log.print("Estimated Breathing Rate: ");
+      Log.print(br);
+      Log.println(" breaths/min");
     }
-    
-    Serial.println();
+
+    Log.println();
     lastCompressionInfo = currentTime;
   }
-  
+
   // Display noise monitoring
-  Serial.println("--- Environmental Noise Monitoring ---");
-  microphone.printStatus(soundLevel);
-  if (maxNoisedB > 0) {
-    Serial.print("Max Noise Since Last Tx: ");
-    Serial.print(maxNoisedB, 1);
-    Serial.print(" dB (at ");
-    Serial.print(formatTimeRemaining(currentTime - maxNoiseTimestamp));
-    Serial.println(" ago)");
+  if (LOG_ENABLED(LOG_MIC, LOG_LEVEL_INFO)) {
+    Log.println("--- Environmental Noise Monitoring ---");
+    microphone.printStatus(soundLevel);
+    if (microphone.isStreaming()) {
+      MAX4466::SoundStats sound = microphone.getSoundStats();
+      Log.print("Leq (1 min): ");
+      Log.print(sound.leqDB, 1);
+      Log.print(" dB  |  Lmax: ");
+      Log.print(sound.lmaxDB, 1);
+      Log.print(" dB  |  RMS: ");
+      Log.print(sound.rms, 1);
+      Log.println(" counts");
+    }
+    if (snapshot.maxNoisedB > 0) {
+      Log.print("Max Noise Since Last Tx: ");
+      Log.print(snapshot.maxNoisedB, 1);
+      Log.print(" dB (at ");
+      Log.print(formatTimeRemaining(currentTime - snapshot.maxNoiseTimestamp));
+      Log.println(" ago)");
+    }
   }
-  
+
   // Display fall detection status
-  Serial.println("--- Fall Detection Status ---");
-  
-  // Show current state
-  Serial.print("State: ");
-  switch(fall_event.state) {
-    case FallDetector::NORMAL:
-      Serial.println("NORMAL");
-      break;
-    case FallDetector::WARNING:
-      Serial.print("WARNING (Impact Count: ");
-      Serial.print("...)");
-      Serial.println();
-      break;
-    case FallDetector::FALL_DETECTED:
-      Serial.println("*** FALL DETECTED ***");
-      break;
-    case FallDetector::DANGEROUS:
-      Serial.println("*** DANGEROUS - IMMOBILE/UNCONSCIOUS ***");
-      break;
-    case FallDetector::RECOVERY:
-      Serial.println("RECOVERY");
-      break;
-  }
-  
-  // Show detection metrics
-  Serial.print("Jerk: ");
-  Serial.print(fall_event.jerk_magnitude, 0);
-  Serial.print(" m/s³  |  SVM: ");
-  Serial.print(fall_event.svm_value, 2);
-  Serial.print(" g  |  Angular Vel: ");
-  Serial.print(fall_event.angular_velocity, 1);
-  Serial.println(" °/s");
-  
-  if (fallDetector.isCalibrated()) {
-    Serial.print("Pitch: ");
-    Serial.print(fall_event.pitch_angle, 1);
-    Serial.print("°  |  Roll: ");
-    Serial.print(fall_event.roll_angle, 1);
-    Serial.println("°");
-  }
-  
-  // Show post-fall movement monitoring
-  if (fall_event.state == FallDetector::FALL_DETECTED || 
-      fall_event.state == FallDetector::DANGEROUS ||
-      fall_event.state == FallDetector::RECOVERY) {
-    Serial.println("--- Post-Fall Movement Analysis ---");
-    Serial.print("Movement Variance: ");
-    Serial.print(fall_event.movement_variance, 4);
-    Serial.print(" (m/s²)²  |  StdDev: ");
-    Serial.print(fall_event.movement_stddev, 3);
-    Serial.println(" m/s²");
-    
-    Serial.print("Immobile: ");
-    Serial.print(fall_event.is_immobile ? "YES" : "NO");
-    if (fall_event.is_immobile) {
-      Serial.print("  |  Duration: ");
-      Serial.print(fall_event.immobile_duration / 1000.0f, 1);
-      Serial.print(" seconds");
-    }
-    Serial.println();
-  }
-  
-  // Alert if fall confirmed
-  if (fall_event.confirmed) {
-    Serial.println("\n!!! FALL CONFIRMED !!!");
-    Serial.println("!!! EMERGENCY ALERT TRIGGERED !!!");
-    Serial.print("!!! Timestamp: ");
-    Serial.print(fall_event.timestamp);
-    Serial.println(" ms !!!");
-    Serial.println("!!! Monitoring for movement... !!!");
-    
-    // Include vital signs in emergency alert
-    int bpm = ecgMonitor.getBPM();
-    if (bpm > 0) {
-      Serial.print("!!! Heart Rate: ");
-      Serial.print(bpm);
-      Serial.println(" BPM !!!");
-    }
-    
-    float bodyTemp = tempSensor.currentTemp;
-    if (!isnan(bodyTemp)) {
-      Serial.print("!!! Body Temperature: ");
-      Serial.print(bodyTemp, 1);
-      Serial.println(" \u00b0C !!!");
-    }
-    Serial.println();
-    
-    // Here you can add:
-    // - Send emergency SMS/notification
-    // - Activate buzzer/LED
-    // - Log event to SD card
-    // - Send data to cloud/server
-  }
-  
-  // Critical alert if person is immobile/unconscious
-  if (fall_event.state == FallDetector::DANGEROUS) {
-    Serial.println("\n╔═══════════════════════════════════════╗");
-    Serial.println("║  ⚠️  CRITICAL: NO MOVEMENT DETECTED  ⚠️  ║");
-    Serial.println("║  POSSIBLE UNCONSCIOUSNESS/INJURY     ║");
-    Serial.println("╚═══════════════════════════════════════╝");
-    Serial.print("Immobile for: ");
-    Serial.print(fall_event.immobile_duration / 1000.0f, 1);
-    Serial.println(" seconds");
-    Serial.print("Movement Variance: ");
-    Serial.println(fall_event.movement_variance, 4);
-    
-    // Include all vital signs
-    int bpm = ecgMonitor.getBPM();
-    uint8_t hrStatus = ecgMonitor.checkHeartRate();
-    Serial.print("Heart Rate: ");
-    if (bpm > 0) {
-      Serial.print(bpm);
-      Serial.print(" BPM");
-      if (hrStatus == 1) Serial.println(" - ABNORMALLY LOW!");
-      else if (hrStatus == 2) Serial.println(" - ABNORMALLY HIGH!");
-      else Serial.println();
-    } else {
-      Serial.println("NO SIGNAL");
+  if (LOG_ENABLED(LOG_FALL, LOG_LEVEL_INFO)) {
+    Log.println("--- Fall Detection Status ---");
+
+    // Show current state
+    Log.print("State: ");
+    switch(fall_event.state) {
+      case FallDetector::NORMAL:
+        Log.println("NORMAL");
+        break;
+      case FallDetector::WARNING:
+        Log.print("WARNING (Impact Count: ");
+        Log.print("...)");
+        Log.println();
+        break;
+      case FallDetector::FALL_DETECTED:
+        Log.println("*** FALL DETECTED ***");
+        break;
+      case FallDetector::DANGEROUS:
+        Log.println("*** DANGEROUS - IMMOBILE/UNCONSCIOUS ***");
+        break;
+      case FallDetector::RECOVERY:
+        Log.println("RECOVERY");
+        break;
     }
-    
-    float bodyTemp = tempSensor.currentTemp;
-    Serial.print("Body Temperature: ");
-    if (!isnan(bodyTemp)) {
-      Serial.print(bodyTemp, 1);
-      Serial.print(" \u00b0C");
-      uint8_t tempStatus = tempSensor.checkTempStatus();
-      if (tempStatus == 3 || tempStatus == 4) Serial.println(" - FEVER!");
-      else Serial.println();
-    } else {
-      Serial.println("NO READING");
+
+    // Show detection metrics
+    Log.print("Jerk: ");
+    Log.print(fall_event.jerk_magnitude, 0);
+    Log.print(" m/s³  |  SVM: ");
+    Log.print(fall_event.svm_value, 2);
+    Log.print(" g  |  Angular Vel: ");
+    Log.print(fall_event.angular_velocity, 1);
+    Log.println(" °/s");
+
+    if (fallDetector.isCalibrated()) {
+      Log.print("Pitch: ");
+      Log.print(fall_event.pitch_angle, 1);
+      Log.print("°  |  Roll: ");
+      Log.print(fall_event.roll_angle, 1);
+      Log.println("°");
     }
-    
-    Serial.println("IMMEDIATE EMERGENCY RESPONSE REQUIRED!\n");
-    
-    // Here you can add:
-    // - Send URGENT emergency notification
-    // - Activate high-priority alarm
-    // - Automatically call emergency services
-    // - Send GPS location to emergency contacts
-    // - Activate strobe lights for visibility
-  }
-  
-  // Alert for abnormal heart rate
-  uint8_t hrStatus = ecgMonitor.checkHeartRate();
-  if (hrStatus == 1) {
-    Serial.println("\n⚠️  HEART RATE ALERT: BRADYCARDIA (Too Slow!) ⚠️");
-    Serial.print("Current BPM: ");
-    Serial.println(ecgMonitor.getBPM());
-  } else if (hrStatus == 2) {
-    Serial.println("\n⚠️  HEART RATE ALERT: TACHYCARDIA (Too Fast!) ⚠️");
-    Serial.print("Current BPM: ");
-    Serial.println(ecgMonitor.getBPM());
-  }
-  
-  // Alert for abnormal body temperature
-  uint8_t tempStatus = tempSensor.checkTempStatus();
-  if (tempStatus == 3) {
-    Serial.println("\n🌡️  TEMPERATURE ALERT: FEVER DETECTED! 🌡️");
-    Serial.print("Current Temperature: ");
-    Serial.print(tempSensor.currentTemp, 1);
-    Serial.println(" °C");
-  } else if (tempStatus == 4) {
-    Serial.println("\n🔥 CRITICAL TEMPERATURE ALERT: HIGH FEVER! 🔥");
-    Serial.print("Current Temperature: ");
-    Serial.print(tempSensor.currentTemp, 1);
-    Serial.println(" °C");
-    Serial.println("SEEK MEDICAL ATTENTION IMMEDIATELY!");
-  }
-  
-  Serial.println();
-  
-  // ========================================
-  // Check for critical state changes
-  // ========================================
-  // Send immediate realtime packet if state changed to DANGEROUS or returned to NORMAL
-  if (fall_event.state != previousFallState) {
-    if (fall_event.state == FallDetector::FALL_DETECTED) {
-      Serial.println("\n╔═══════════════════════════════════════════════════════════╗");
-      Serial.println("║  ⚠️  STATE CHANGE: FALL DETECTED - SENDING IMMEDIATE ALERT ║");
-      Serial.println("╚═══════════════════════════════════════════════════════════╝");
-      stateChangeNotified = true;
-    } else if (fall_event.state == FallDetector::DANGEROUS) {
-      Serial.println("\n╔═══════════════════════════════════════════════════════════╗");
-      Serial.println("║  🚨 STATE CHANGE: UNCONSCIOUS - SENDING IMMEDIATE ALERT  ║");
-      Serial.println("╚═══════════════════════════════════════════════════════════╝");
-      stateChangeNotified = true;
-    } else if ((previousFallState == FallDetector::FALL_DETECTED || previousFallState == FallDetector::DANGEROUS) && fall_event.state == FallDetector::NORMAL) {
-      Serial.println("\n╔═══════════════════════════════════════════════════════════╗");
-      Serial.println("║  ✅ STATE CHANGE: RECOVERED - SENDING IMMEDIATE UPDATE   ║");
-      Serial.println("╚═══════════════════════════════════════════════════════════╝");
-      stateChangeNotified = true;
-    }
-    previousFallState = fall_event.state;
-  }
-  
-  // Send immediate realtime packet on critical state change
-  if (stateChangeNotified) {
-    Serial.println("\n📡 Sending immediate realtime packet (State Change Alert)...");
-    
-    uint8_t payload[10];
-    
-    // Check alert conditions
-    uint8_t hrStatus = ecgMonitor.checkHeartRate();
-    uint8_t tempStatus = tempSensor.checkTempStatus();
-    bool hrAbnormal = (hrStatus != 0);
-    bool tempAbnormal = (tempStatus >= 3);
-    bool fallAlert = (fall_event.state >= FallDetector::FALL_DETECTED);
-    bool noiseAlert = (maxNoisedB >= 80.0);  // Noise alert threshold
-    
-    // Use current or max noise level
-    float noiseToSend = (maxNoisedB > 0) ? maxNoisedB : soundLevel;
-    
-    int len = PayloadBuilder::buildRealtimePayload(
-      payload,
-      ecgMonitor.getBPM(),
-      tempSensor.currentTemp,
-      tempSensor.ambientTemp,
-      noiseToSend,
-      (uint8_t)fall_event.state,
-      hrAbnormal,
-      tempAbnormal,
-      fallAlert,
-      noiseAlert
-    );
-    
-    bool success = loraComm.sendUplink(1, payload, len);
-    
-    if (success) {
-      Serial.println("✅ Immediate packet sent successfully!");
-      Serial.print("State: ");
-      if (fall_event.state == FallDetector::DANGEROUS) {
-        Serial.println("UNCONSCIOUS");
-      } else {
-        Serial.println("RECOVERED");
+
+    // Show post-fall movement monitoring
+    if (fall_event.state == FallDetector::FALL_DETECTED ||
+        fall_event.state == FallDetector::DANGEROUS ||
+        fall_event.state == FallDetector::RECOVERY) {
+      Log.println("--- Post-Fall Movement Analysis ---");
+      Log.print("Movement Variance: ");
+      Log.print(fall_event.movement_variance, 4);
+      Log.print(" (m/s²)²  |  StdDev: ");
+      Log.print(fall_event.movement_stddev, 3);
+      Log.println(" m/s²");
+
+      Log.print("Immobile: ");
+      Log.print(fall_event.is_immobile ? "YES" : "NO");
+      if (fall_event.is_immobile) {
+        Log.print("  |  Duration: ");
+        Log.print(fall_event.immobile_duration / 1000.0f, 1);
+        Log.print(" seconds");
       }
-      Serial.print("BPM: ");
-      Serial.print(ecgMonitor.getBPM());
-      Serial.print("  Temp: ");
-      Serial.print(tempSensor.currentTemp, 1);
-      Serial.print("°C  Noise: ");
-      Serial.print(noiseToSend, 1);
-      Serial.println("dB");
-      
-      // Send same packet to Vision Master E290 via UART for badge display
-      sendUARTPacket(payload, len);
-    } else {
-      Serial.println("❌ Failed to send immediate packet");
+      Log.println();
     }
-    
-    stateChangeNotified = false;  // Reset flag
-    Serial.println();
   }
-  
-  // ========================================
-  // WiFi Data Transmission
-  // ========================================
-  
-  // LoRa doesn't need connection maintenance
-  // loraComm.maintain();
-  
-  // LoRa is always ready (no join procedure needed)
-  // Proceed directly to sensor monitoring and transmission
-    // Send fall event immediately (Packet Type 0x03)
-    if (fall_event.confirmed && !fallEventTriggered) {
-      Serial.println("\n╔══════════════════════════════════════════════════════════╗");
-      Serial.println("║        📡 FALL EVENT TRANSMISSION (Type 0x03)          ║");
-      Serial.println("╚══════════════════════════════════════════════════════════╝");
-      
-      uint8_t payload[50];
+
+  // Critical alert if person is immobile/unconscious
+  if (LOG_ENABLED(LOG_FALL, LOG_LEVEL_WARN)) {
+    if (fall_event.state == FallDetector::DANGEROUS) {
+      Log.println("\n╔═══════════════════════════════════════╗");
+      Log.println("║  ⚠️  CRITICAL: NO MOVEMENT DETECTED  ⚠️  ║");
+      Log.println("║  POSSIBLE UNCONSCIOUSNESS/INJURY     ║");
+      Log.println("╚═══════════════════════════════════════╝");
+      Log.print("Immobile for: ");
+      Log.print(fall_event.immobile_duration / 1000.0f, 1);
+      Log.println(" seconds");
+      Log.print("Movement Variance: ");
+      Log.println(fall_event.movement_variance, 4);
+
+      // Include all vital signs
       int bpm = ecgMonitor.getBPM();
-      float bodyTemp = tempSensor.currentTemp;
-      
-      int len = PayloadBuilder::buildFallEventPayload(
-        payload,
-        fall_event.timestamp,
-        fall_event.jerk_magnitude,
-        fall_event.svm_value,
-        fall_event.angular_velocity,
-        fall_event.pitch_angle,
-        fall_event.roll_angle,
-        0,  // impact count (not tracked)
-        0,  // warning count (not tracked)
-        bpm > 0 ? bpm : 0,
-        !isnan(bodyTemp) ? bodyTemp : 0.0f,
-        data.accelX,
-        data.accelY,
-        data.accelZ,
-        fall_event.movement_variance
-      );
-      
-      // Display packet contents
-      Serial.println("\n📦 PACKET CONTENTS:");
-      Serial.println("  ┌─────────────────────────────────────────┐");
-      Serial.print("  │ Packet Type:       0x");
-      Serial.print(payload[0], HEX);
-      Serial.println(" (Fall Event)        │");
-      Serial.print("  │ Packet Size:       ");
-      Serial.print(len);
-      Serial.println(" bytes                   │");
-      Serial.print("  │ Timestamp:         ");
-      Serial.print(fall_event.timestamp);
-      Serial.println(" ms                │");
-      Serial.println("  ├─────────────────────────────────────────┤");
-      Serial.print("  │ Jerk Magnitude:    ");
-      Serial.print(fall_event.jerk_magnitude, 0);
-      Serial.println(" m/s³        │");
-      Serial.print("  │ SVM Value:         ");
-      Serial.print(fall_event.svm_value, 2);
-      Serial.println(" g                 │");
-      Serial.print("  │ Angular Velocity:  ");
-      Serial.print(fall_event.angular_velocity, 1);
-      Serial.println(" °/s           │");
-      Serial.print("  │ Pitch Angle:       ");
-      Serial.print(fall_event.pitch_angle, 1);
-      Serial.println("°                  │");
-      Serial.print("  │ Roll Angle:        ");
-      Serial.print(fall_event.roll_angle, 1);
-      Serial.println("°                  │");
-      Serial.println("  ├─────────────────────────────────────────┤");
-      Serial.print("  │ Heart Rate:        ");
-      Serial.print(bpm);
-      Serial.println(" BPM                   │");
-      Serial.print("  │ Body Temp:         ");
-      Serial.print(bodyTemp, 1);
-      Serial.println(" °C                │");
-      Serial.print("  │ Movement Variance: ");
-      Serial.print(fall_event.movement_variance, 4);
-      Serial.println("         │");
-      Serial.println("  └─────────────────────────────────────────┘");
-      
-      // Display raw hex data (first 20 bytes)
-      Serial.print("\n  📋 Hex Data (first 20 bytes): ");
-      for (int i = 0; i < min(20, len); i++) {
-        if (payload[i] < 0x10) Serial.print("0");
-        Serial.print(payload[i], HEX);
-        Serial.print(" ");
+      uint8_t hrStatus = ecgMonitor.checkHeartRate();
+      Log.print("Heart Rate: ");
+      if (bpm > 0) {
+        Log.print(bpm);
+        Log.print(" BPM");
+        if (hrStatus == 1) Log.println(" - ABNORMALLY LOW!");
+        else if (hrStatus == 2) Log.println(" - ABNORMALLY HIGH!");
+        else Log.println();
+      } else {
+        Log.println("NO SIGNAL");
       }
-      if (len > 20) Serial.print("...");
-      Serial.println();
-      
-      Serial.println("\n📡 TRANSMISSION STATUS:");
-      Serial.print("  → Sending via LoRa...");
-      
-      unsigned long txStart = millis();
-      bool success = loraComm.sendUplink(3, payload, len, true);
-      unsigned long txDuration = millis() - txStart;
-      
-      if (success) {
-        Serial.println("\n  ✅ SUCCESS!");
-        Serial.print("  ⏱️  Transmission time: ");
-        Serial.print(txDuration);
-        Serial.println(" ms");
-        Serial.print("  📊 Frame counter: ");
-        Serial.println(loraComm.getFrameCounter());
-        Serial.print("  📶 LoRa RSSI: ");
-        Serial.print(loraComm.getRSSI());
-        Serial.println(" dBm");
-        Serial.println("  ℹ️  Fall events are sent immediately when detected");
-        fallEventTriggered = true;
+
+      float bodyTemp = tempSensor.currentTemp;
+      Log.print("Body Temperature: ");
+      if (!isnan(bodyTemp)) {
+        Log.print(bodyTemp, 1);
+        Log.print(" °C");
+        uint8_t tempStatus = tempSensor.checkTempStatus();
+        if (tempStatus == 3 || tempStatus == 4) Log.println(" - FEVER!");
+        else Log.println();
       } else {
-        Serial.println("\n  ❌ FAILED!");
-        Serial.print("  ⏱️  Attempt duration: ");
-        Serial.print(txDuration);
-        Serial.println(" ms");
-        Serial.println("  ⚠️  Will retry on next cycle");
+        Log.println("NO READING");
       }
-      Serial.println("╚══════════════════════════════════════════════════════════╝\n");
+
+      Log.println("IMMEDIATE EMERGENCY RESPONSE REQUIRED!\n");
+
+      // Here you can add:
+      // - Send URGENT emergency notification
+      // - Activate high-priority alarm
+      // - Automatically call emergency services
+      // - Send GPS location to emergency contacts
+      // - Activate strobe lights for visibility
     }
-    
-    // Reset fall event flag when recovery state reached
-    if (fall_event.state == FallDetector::NORMAL || 
-        fall_event.state == FallDetector::RECOVERY) {
-      fallEventTriggered = false;
+  }
+
+  // Alert for abnormal heart rate
+  if (LOG_ENABLED(LOG_ECG, LOG_LEVEL_WARN)) {
+    uint8_t hrStatus = ecgMonitor.checkHeartRate();
+    if (hrStatus == 1) {
+      Log.println("\n⚠️  HEART RATE ALERT: BRADYCARDIA (Too Slow!) ⚠️");
+      Log.print("Current BPM: ");
+      Log.println(ecgMonitor.getBPM());
+    } else if (hrStatus == 2) {
+      Log.println("\n⚠️  HEART RATE ALERT: TACHYCARDIA (Too Fast!) ⚠️");
+      Log.print("Current BPM: ");
+      Log.println(ecgMonitor.getBPM());
     }
-    
-    // Send real-time monitoring data every 1 minute (Packet Type 0x01)
-    if (currentTime - lastRealtimeTxTime >= REALTIME_TX_INTERVAL) {
-      Serial.println("\n╔══════════════════════════════════════════════════════════╗");
-      Serial.println("║     📡 REALTIME MONITORING TRANSMISSION (Type 0x01)    ║");
-      Serial.println("║                    Every 1 minute                       ║");
-      Serial.println("╚══════════════════════════════════════════════════════════╝");
-      
-      uint8_t payload[20];
-      int bpm = ecgMonitor.getBPM();
-      float bodyTemp = tempSensor.currentTemp;
-      float ambientTemp = tempSensor.ambientTemp;
-      
-      // Check for abnormal conditions
-      uint8_t hrStatus = ecgMonitor.checkHeartRate();
-      uint8_t tempStatus = tempSensor.checkTempStatus();
-      bool hrAbnormal = (hrStatus == 1 || hrStatus == 2);
-      bool tempAbnormal = (tempStatus == 3 || tempStatus == 4);
-      bool fallAlert = (fall_event.state == FallDetector::FALL_DETECTED || 
-                        fall_event.state == FallDetector::DANGEROUS);
-      bool noiseAlert = (soundLevel > 100.0f);
-      
-      // Use max noise level if available, otherwise use current
-      float noiseToSend = (maxNoisedB > 0) ? maxNoisedB : soundLevel;
-      bool noiseAlertMax = (noiseToSend > 100.0f);
-      
-      int len = PayloadBuilder::buildRealtimePayload(
-        payload,
-        bpm > 0 ? bpm : 0,
-        !isnan(bodyTemp) ? bodyTemp : 0.0f,
-        !isnan(ambientTemp) ? ambientTemp : 0.0f,
-        noiseToSend,
-        fall_event.state,
-        hrAbnormal,
-        tempAbnormal,
-        fallAlert,
-        noiseAlertMax
-      );
-      
-      // Display packet contents
-      Serial.println("\n📦 PACKET CONTENTS:");
-      Serial.println("  ┌─────────────────────────────────────────┐");
-      Serial.print("  │ Packet Type:       0x");
-      Serial.print(payload[0], HEX);
-      Serial.println(" (Realtime)          │");
-      Serial.print("  │ Packet Size:       ");
-      Serial.print(len);
-      Serial.println(" bytes                    │");
-      Serial.println("  ├─────────────────────────────────────────┤");
-      Serial.print("  │ Heart Rate:        ");
-      Serial.print(bpm);
-      Serial.print(" BPM");
-      Serial.println(hrAbnormal ? " ⚠️ " : "    " + String("│"));
-      Serial.print("  │ Body Temp:         ");
-      Serial.print(bodyTemp, 1);
-      Serial.print(" °C");
-      Serial.println(tempAbnormal ? " ⚠️" : "   " + String("│"));
-      Serial.print("  │ Ambient Temp:      ");
-      Serial.print(ambientTemp, 1);
-      Serial.println(" °C            │");
-      Serial.print("  │ Noise Level (Max): ");
-      Serial.print(noiseToSend, 0);
-      Serial.print(" dB");
-      Serial.println(noiseAlertMax ? " ⚠️" : "   " + String("│"));
-      Serial.print("  │ Fall State:        ");
-      switch(fall_event.state) {
-        case FallDetector::NORMAL: Serial.println("Normal             │"); break;
-        case FallDetector::WARNING: Serial.println("Warning ⚠️         │"); break;
-        case FallDetector::FALL_DETECTED: Serial.println("Fall Detected 🚨   │"); break;
-        case FallDetector::DANGEROUS: Serial.println("Dangerous! 🆘      │"); break;
-        case FallDetector::RECOVERY: Serial.println("Recovery           │"); break;
-      }
-      Serial.println("  ├─────────────────────────────────────────┤");
-      Serial.print("  │ Alert Flags:       0b");
-      uint8_t flags = payload[6];
-      for (int i = 7; i >= 0; i--) {
-        Serial.print((flags >> i) & 1);
-      }
-      Serial.println("       │");
-      Serial.print("  │   HR Alert:        ");
-      Serial.println((flags & 0x01) ? "YES ⚠️             │" : "No                 │");
-      Serial.print("  │   Temp Alert:      ");
-      Serial.println((flags & 0x02) ? "YES ⚠️             │" : "No                 │");
-      Serial.print("  │   Fall Alert:      ");
-      Serial.println((flags & 0x04) ? "YES 🚨             │" : "No                 │");
-      Serial.print("  │   Noise Alert:     ");
-      Serial.println((flags & 0x08) ? "YES ⚠️             │" : "No                 │");
-      Serial.println("  └─────────────────────────────────────────┘");
-      
-      // Display raw hex data
-      Serial.print("\n  📋 Hex Data: ");
-      for (int i = 0; i < len; i++) {
-        if (payload[i] < 0x10) Serial.print("0");
-        Serial.print(payload[i], HEX);
-        Serial.print(" ");
-      }
-      Serial.println();
-      
-      Serial.println("\n📡 TRANSMISSION STATUS:");
-      Serial.print("  → Sending via LoRa...");
-      
-      unsigned long txStart = millis();
-      bool success = loraComm.sendUplink(1, payload, len, false);
-      unsigned long txDuration = millis() - txStart;
-      
-      if (success) {
-        Serial.println("\n  ✅ SUCCESS!");
-        Serial.print("  ⏱️  Transmission time: ");
-        Serial.print(txDuration);
-        Serial.println(" ms");
-        Serial.print("  📊 Frame counter: ");
-        Serial.println(loraComm.getFrameCounter());
-        Serial.print("  📶 LoRa RSSI: ");
-        Serial.print(loraComm.getRSSI());
-        Serial.println(" dBm");
-        Serial.print("  🕒 Next transmission: ");
-        Serial.println(formatTimeRemaining(REALTIME_TX_INTERVAL));
-        lastRealtimeTxTime = currentTime;
-        
-        // Reset max noise tracking after successful transmission
-        maxNoisedB = 0.0;
-        maxNoiseTimestamp = 0;
+  }
+
+  // Alert for abnormal body temperature
+  if (LOG_ENABLED(LOG_TEMP, LOG_LEVEL_WARN)) {
+    uint8_t tempStatus = tempSensor.checkTempStatus();
+    if (tempStatus == 3) {
+      Log.println("\n🌡️  TEMPERATURE ALERT: FEVER DETECTED! 🌡️");
+      Log.print("Current Temperature: ");
+      Log.print(tempSensor.currentTemp, 1);
+      Log.println(" °C");
+    } else if (tempStatus == 4) {
+      Log.println("\n🔥 CRITICAL TEMPERATURE ALERT: HIGH FEVER! 🔥");
+      Log.print("Current Temperature: ");
+      Log.print(tempSensor.currentTemp, 1);
+      Log.println(" °C");
+      Log.println("SEEK MEDICAL ATTENTION IMMEDIATELY!");
+    }
+  }
+
+  Log.println();
+}
+
+/**
+ * Serial console commands
+ *   p - print the latency profile and loss counters
+ *   r - reset the profile
+ */
+void handleSerialCommands() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c == 'p') {
+      profiler.report(Log);
+      Log.printf("  IMU FIFO overflows: %lu, ECG samples dropped: %lu, log bytes dropped: %lu\n",
+                 (unsigned long)mpu.getFIFOOverflows(),
+                 (unsigned long)ecgAcquisition.getDroppedCount(),
+                 (unsigned long)Log.droppedBytes());
+      Log.printf("  I2C: %lu requests in %lu transactions, %lu errors\n",
+                 (unsigned long)i2cBus.getRequestCount(),
+                 (unsigned long)i2cBus.getLinkCount(),
+                 (unsigned long)i2cBus.getErrorCount());
+      Log.printf("  Link: SF%u, %d dBm, %lu changes\n", loraComm.getSpreadingFactor(),
+                 loraComm.getOutputPower(), (unsigned long)loraComm.getLinkChanges());
+      Log.printf("  Alert retransmissions: %lu, unacknowledged: %lu\n",
+                 (unsigned long)loraComm.getAckRetransmissions(),
+                 (unsigned long)loraComm.getAckFailures());
+      Log.printf("  Fall windows captured: %lu, dropped: %lu\n",
+                 (unsigned long)fallCapture.getTriggerCount(),
+                 (unsigned long)fallCapture.getDroppedCount());
+      Log.printf("  History records: %lu logged, %lu waiting, %lu overwritten unsent\n",
+                 (unsigned long)historyLog.getRecordCount(),
+                 (unsigned long)historyLog.pending(),
+                 (unsigned long)historyLog.getDroppedCount());
+      Log.printf("  Power mode: %s, %lu s quiet since boot, %lu wake-ups\n",
+                 powerManager.isQuiet() ? "QUIET" : "ACTIVE",
+                 (unsigned long)(powerManager.quietTimeUs(esp_timer_get_time()) / 1000000),
+                 (unsigned long)powerManager.getWakeCount());
+    } else if (c == 'r') {
+      profiler.reset();
+      Log.println("Profile reset");
+    }
+  }
+}
+
+/**
+ * loop() only reports status; sensing and transmission run in their own tasks
+ */
+void loop() {
+  handleSerialCommands();
+
+  {
+    PROFILE_SCOPE(profiler, PROF_LOOP);
+    unsigned long currentTime = millis();
+
+    // Display next transmission countdown (every 10 seconds)
+    static unsigned long lastCountdownDisplay = 0;
+    if (LOG_ENABLED(LOG_LORA, LOG_LEVEL_INFO) && currentTime - lastCountdownDisplay >= 10000) {
+      unsigned long realtimeRemaining = loraComm.msUntilAllowed(LoRaComm::PRIORITY_REALTIME, REALTIME_BATCH_PAYLOAD_SIZE, 4);
+      unsigned long ecgRemaining = loraComm.msUntilAllowed(LoRaComm::PRIORITY_ECG, ECG_PAYLOAD_SIZE, ECG_PORT);
+
+      Log.println("\n⏰ TRANSMISSION COUNTDOWN:");
+      Log.print("  Airtime used (1h): ");
+      Log.print(loraComm.budgetUsage() * 100.0f, 1);
+      Log.println(loraComm.isBoosting() ? "% (ECG boost)" : "%");
+      Log.print("  Realtime:         ");
+      if (realtimeRemaining > 0) {
+        Log.println(formatTimeRemaining(realtimeRemaining));
       } else {
-        Serial.println("\n  ❌ FAILED!");
-        Serial.print("  ⏱️  Attempt duration: ");
-        Serial.print(txDuration);
-        Serial.println(" ms");
-        Serial.println("  ⚠️  Will retry on next cycle");
+        Log.println("Ready to send!");
       }
-      Serial.println("╚══════════════════════════════════════════════════════════╝\n");
-    }
-    
-    // Send ECG data periodically (Packet Type 0x02) - every 2 minutes when heart rate stable
-    if (currentTime - lastECGTxTime >= ECG_TX_INTERVAL) {
-      int bpm = ecgMonitor.getBPM();
-      if (bpm > 40 && bpm < 150) {  // Only send when heart rate in reasonable range
-        Serial.println("\n╔══════════════════════════════════════════════════════════╗");
-        Serial.println("║         📡 ECG DATA TRANSMISSION (Type 0x02)           ║");
-        Serial.println("║          Every 2.05 minutes (Optimized)                ║");
-        Serial.println("╚══════════════════════════════════════════════════════════╝");
-        
-        uint8_t payload[70];
-        uint8_t compressedECG[50];
-        uint8_t pqrst[14];
-        
-        int ecgLen = ecgMonitor.getCompressedECG(compressedECG, 50);
-        int pqrstLen = ecgMonitor.getPQRSTData(pqrst);
-        
-        int len = PayloadBuilder::buildECGPayload(
-          payload,
-          compressedECG,
-          ecgLen,
-          pqrst,
-          pqrstLen
-        );
-        
-        // Display packet contents
-        Serial.println("\n📦 PACKET CONTENTS:");
-        Serial.println("  ┌─────────────────────────────────────────┐");
-        Serial.print("  │ Packet Type:       0x");
-        Serial.print(payload[0], HEX);
-        Serial.println(" (ECG Data)          │");
-        Serial.print("  │ Packet Size:       ");
-        Serial.print(len);
-        Serial.println(" bytes                   │");
-        Serial.print("  │ Current BPM:       ");
-        Serial.print(bpm);
-        Serial.println(" BPM                   │");
-        Serial.println("  ├─────────────────────────────────────────┤");
-        Serial.print("  │ Compressed ECG:    ");
-        Serial.print(ecgLen);
-        Serial.println(" bytes (25Hz)        │");
-        Serial.print("  │ PQRST Features:    ");
-        Serial.print(pqrstLen);
-        Serial.println(" bytes              │");
-        Serial.print("  │ Compression:       100Hz → 25Hz       │");
-        Serial.println();
-        Serial.print("  │ Encoding:          8-bit differential  │");
-        Serial.println();
-        Serial.println("  └─────────────────────────────────────────┘");
-        
-        // Display compressed ECG sample (first 10 bytes)
-        Serial.print("\n  📋 Compressed ECG (first 10 bytes): ");
-        for (int i = 0; i < min(10, ecgLen); i++) {
-          if (compressedECG[i] < 0x10) Serial.print("0");
-          Serial.print(compressedECG[i], HEX);
-          Serial.print(" ");
-        }
-        if (ecgLen > 10) Serial.print("...");
-        Serial.println();
-        
-        if (pqrstLen > 0) {
-          Serial.print("  📋 PQRST Features: ");
-          for (int i = 0; i < min(14, pqrstLen); i++) {
-            if (pqrst[i] < 0x10) Serial.print("0");
-            Serial.print(pqrst[i], HEX);
-            Serial.print(" ");
-          }
-          Serial.println();
-        }
-        
-        Serial.println("\n📡 TRANSMISSION STATUS:");
-        Serial.print("  → Sending via LoRa...");
-        
-        unsigned long txStart = millis();
-        bool success = loraComm.sendUplink(2, payload, len, false);
-        unsigned long txDuration = millis() - txStart;
-        
-        if (success) {
-          Serial.println("\n  ✅ SUCCESS!");
-          Serial.print("  ⏱️  Transmission time: ");
-          Serial.print(txDuration);
-          Serial.println(" ms");
-          Serial.print("  📊 Frame counter: ");
-          Serial.println(loraComm.getFrameCounter());
-          Serial.print("  📶 LoRa RSSI: ");
-          Serial.print(loraComm.getRSSI());
-          Serial.println(" dBm");
-          Serial.print("  📈 Data rate: ");
-          Serial.print((len * 8.0 / txDuration * 1000.0), 0);
-          Serial.println(" bps");
-          Serial.print("  🕒 Next transmission: ");
-          Serial.println(formatTimeRemaining(ECG_TX_INTERVAL));
-          lastECGTxTime = currentTime;
-        } else {
-          Serial.println("\n  ❌ FAILED!");
-          Serial.print("  ⏱️  Attempt duration: ");
-          Serial.print(txDuration);
-          Serial.println(" ms");
-          Serial.println("  ⚠️  Will retry on next cycle");
-        }
-        Serial.println("╚══════════════════════════════════════════════════════════╝\n");
+      Log.print("  ECG:              ");
+      if (ecgRemaining > 0) {
+        Log.println(formatTimeRemaining(ecgRemaining));
+      } else {
+        Log.println("Ready to send!");
       }
+      Log.printf("  History:          %lu records waiting\n", (unsigned long)historyLog.pending());
+      Log.println();
+      lastCountdownDisplay = currentTime;
     }
-  // LoRa transmission complete - continue monitoring
-  
-  // Wait before next reading
-  delay(READ_INTERVAL_MS);
+
+    printStatusReport(getTelemetry(), currentTime);
+  }
+
+  // Wait before next report (outside the profiled pass); a power mode
+  // change wakes the loop early to switch the CPU clock
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(powerManager.isQuiet() ? QUIET_REPORT_INTERVAL_MS : READ_INTERVAL_MS));
 }
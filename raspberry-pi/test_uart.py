@@ -9,9 +9,10 @@ This script helps test UART communication with Vision Master E213.
 import serial
 import time
 import sys
+import os
 
 UART_PORT = '/dev/ttyS0'
-UART_BAUDRATE = 115200
+UART_BAUDRATE = int(os.getenv('UART_BAUDRATE', '921600'))  # Must match the gateway
 
 def test_uart_loopback():
     """Test UART loopback (TX connected to RX)"""
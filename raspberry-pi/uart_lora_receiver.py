@@ -9,11 +9,36 @@ and forwards them to the Node.js backend server via HTTP POST.
 Hardware Setup:
 - Vision Master E213 connected to Raspberry Pi via UART
 - Default: /dev/ttyS0 (GPIO 14 TX, GPIO 15 RX)
-- Baud rate: 115200
+- Baud rate: 921600 (UART_BAUDRATE to override, must match the gateway)
 
-Packet Format from Vision Master E213:
+UART framing (shared/include/UartLink.h):
+- COBS([type][seq][payload][CRC16 LE]) 0x00
+- Type 0x01 LoRa packet: [RSSI int16 LE][SNR x4 int8][LoRa packet]
+- Type 0x02 time sync (to the gateway): [year LE 2B][month][day][hour][minute][second]
+  [Unix time us LE 8B]
+- Type 0x04 stored packet: [record ID LE 4B][floor ID LE 4B][age ms LE 4B]
+  [RSSI int16 LE][SNR x4 int8][gateway ID LE 4B][RX time us LE 8B][LoRa packet]
+- Type 0x05 ACK (to the gateway): [record ID LE 4B] - every record up to it
+  is in the backend; empty once a second as a keepalive
+
+The gateway keeps every packet until it is acknowledged
+(LoRa_Gateway/include/ForwardStore.h) and replays the backlog after an
+outage of this script or the backend, so records are only acknowledged
+after the backend accepted them. Replayed records carry their age, so
+the backend gets the time they were received. Stored packets read in one
+go are posted as one batch and acknowledged with one ACK.
+
+With several gateways, each one names itself and stamps every packet
+with its RX time on this Pi's clock (kept from the time sync, sent once a
+second). The backend keeps one copy of each (device ID, frame counter)
+heard within a few seconds by any gateway - the best-RSSI one.
+
+LoRa packet format from Vision Master E213:
 - [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)] [Data (n bytes)]
-- RSSI and SNR appended by Vision Master
+- Until the gateway has learned a wearable's device ID it forwards the
+  compact header: [0x81] [Short ID (2 bytes)] [Frame Counter (2 bytes)]
+  [Port (1 byte)] [Data]. The short ID is posted as short_id and the
+  backend resolves it against the devices it knows.
 
 Author: Health Monitor System
 Date: 2025
@@ -33,50 +58,247 @@ from datetime import datetime
 # Configuration
 # ============================================================================
 UART_PORT = '/dev/ttyS0'  # Change to /dev/ttyAMA0 if using Raspberry Pi 3/4
-UART_BAUDRATE = 115200
+UART_BAUDRATE = int(os.getenv('UART_BAUDRATE', '921600'))
 UART_TIMEOUT = 1
 
+# UART frame types (UartFrame::Type in shared/include/UartLink.h)
+FRAME_LORA_PACKET = 0x01
+FRAME_TIME_SYNC = 0x02
+FRAME_STORED_PACKET = 0x04
+FRAME_HOST_ACK = 0x05
+COMPACT_MARKER = 0x81            # First byte of a compact LoRa header
+AGE_UNKNOWN = 0xFFFFFFFF         # Stored before the gateway restarted
+STORED_HEAD_SIZE = 27            # Metadata ahead of the LoRa packet
+KEEPALIVE_INTERVAL = 1.0         # Seconds between empty ACKs
+BACKEND_RETRY_INTERVAL = 5.0     # Seconds before retrying a failed backend
+MAX_FRAME = 400  # Longer runs without a delimiter are noise
+
 # Backend server configuration (use environment variables)
 SERVER_IP = os.getenv('SERVER_IP', 'localhost')  # Default to localhost
 SERVER_PORT = os.getenv('SERVER_PORT', '5000')
 SERVER_URL = f'http://{SERVER_IP}:{SERVER_PORT}/api/sensor-data'
+REPLAY_BATCH_MAX = 64            # Stored packets per backend request (the gateway's replay window)
 
 # Global variables
 ser = None
 running = True
+http = requests.Session()  # Keeps the backend connection open between packets
 stats = {
     'packets_received': 0,
     'packets_sent': 0,
     'errors': 0,
     'last_packet_time': None,
-    'time_syncs_sent': 0
+    'time_syncs_sent': 0,
+    'frame_errors': 0,
+    'frames_lost': 0,
+    'duplicates': 0
 }
+tx_seq = 0
+
+# Store-and-forward state: every record ID up to forward_base is in the
+# backend, forward_delivered holds the ones beyond it
+forward_base = None
+forward_delivered = set()
+backend_retry_at = 0.0
+last_keepalive = 0.0
+
+# ============================================================================
+# UART Framing
+# ============================================================================
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE (same as UartFrame::crc16)"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+def cobs_encode(data):
+    """COBS-encode data (no delimiter)"""
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+    out[code_index] = code
+    return bytes(out)
+
+def cobs_decode(data):
+    """Decode one COBS frame (delimiter removed), None if malformed"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+def encode_frame(frame_type, payload):
+    """Build a delimited UART frame"""
+    global tx_seq
+    body = bytes([frame_type, tx_seq]) + bytes(payload)
+    tx_seq = (tx_seq + 1) & 0xFF
+    crc = crc16(body)
+    return cobs_encode(body + bytes([crc & 0xFF, crc >> 8])) + b'\x00'
+
+def decode_frame(encoded):
+    """
+    Decode a frame without its delimiter
+    Returns (type, seq, payload) or None if corrupt
+    """
+    frame = cobs_decode(encoded)
+    if frame is None or len(frame) < 4:
+        return None
+    if crc16(frame[:-2]) != (frame[-2] | (frame[-1] << 8)):
+        return None
+    return frame[0], frame[1], frame[2:-2]
 
 def send_time_sync():
-    """Send current time to Vision Master E213 (sent with every packet)"""
+    """Send current time to Vision Master E213 (once a second, with the keepalive)"""
     global ser, stats
     
     if not ser or not ser.is_open:
         return
     
     try:
-        now = datetime.now()
-        # Time sync format: [0xFF][0xFE][YY][YY][MM][DD][HH][MM][SS][0xFD]
-        time_packet = bytearray([
-            0xFF, 0xFE,
-            (now.year >> 8) & 0xFF, now.year & 0xFF,
+        now_us = time.time_ns() // 1000
+        now = datetime.fromtimestamp(now_us / 1000000.0)
+        # Time sync payload: [year LE 2B][month][day][hour][minute][second][Unix time us LE 8B]
+        # The gateway times its packets with the microseconds - taken as
+        # close to the write as possible
+        time_payload = bytes([
+            now.year & 0xFF, (now.year >> 8) & 0xFF,
             now.month, now.day,
-            now.hour, now.minute, now.second,
-            0xFD
-        ])
+            now.hour, now.minute, now.second
+        ]) + now_us.to_bytes(8, 'little')
         
-        ser.write(time_packet)
+        ser.write(encode_frame(FRAME_TIME_SYNC, time_payload))
         stats['time_syncs_sent'] += 1
-        print(f"⏰ Time sync sent: {now.strftime('%Y-%m-%d %H:%M:%S')}")
         
     except Exception as e:
         print(f"❌ Error sending time sync: {e}")
 
+def id_diff(a, b):
+    """a - b for 32-bit record IDs (signed, handles wrap-around)"""
+    d = (a - b) & 0xFFFFFFFF
+    return d - 0x100000000 if d & 0x80000000 else d
+
+def send_host_ack(record_id=None):
+    """Report delivered records (or just presence) to the gateway"""
+    if not ser or not ser.is_open:
+        return
+    payload = b'' if record_id is None else record_id.to_bytes(4, 'little')
+    try:
+        ser.write(encode_frame(FRAME_HOST_ACK, payload))
+    except Exception as e:
+        print(f"❌ Error sending ACK: {e}")
+
+def send_keepalive():
+    """Tell the gateway we are here, and the time, once a second"""
+    global last_keepalive
+    if time.time() - last_keepalive < KEEPALIVE_INTERVAL:
+        return
+    last_keepalive = time.time()
+    send_host_ack()
+    send_time_sync()
+
+def handle_stored_packets(payloads):
+    """
+    Deliver the stored packets (FRAME_STORED_PACKET) read in one go and
+    acknowledge them with a single ACK
+    During a backlog replay the gateway sends up to its replay window
+    back to back; they go to the backend in one batch request.
+    Records already delivered are only acknowledged again.
+    """
+    global forward_base, backend_retry_at
+    pending = []  # (record ID, JSON for the backend)
+    
+    for payload in payloads:
+        if len(payload) < STORED_HEAD_SIZE:
+            continue
+        
+        record_id = int.from_bytes(payload[0:4], 'little')
+        floor_id = int.from_bytes(payload[4:8], 'little')
+        age_ms = int.from_bytes(payload[8:12], 'little')
+        rssi = int.from_bytes(payload[12:14], 'little', signed=True)
+        snr = int.from_bytes(payload[14:15], 'little', signed=True) / 4.0
+        gateway_id = f"{int.from_bytes(payload[15:19], 'little'):08X}"
+        rx_time_us = int.from_bytes(payload[19:27], 'little')  # 0: not synced
+        
+        # Records below the floor are gone for good; a floor far from ours
+        # means the gateway started a new ID range
+        floor_base = (floor_id - 1) & 0xFFFFFFFF
+        if forward_base is None or abs(id_diff(floor_base, forward_base)) > 0x100000:
+            forward_base = floor_base
+            forward_delivered.clear()
+            pending = [r for r in pending if id_diff(r[0], forward_base) > 0]
+        elif id_diff(floor_base, forward_base) > 0:
+            forward_base = floor_base
+            forward_delivered.difference_update([i for i in forward_delivered if id_diff(i, forward_base) <= 0])
+        
+        if (id_diff(record_id, forward_base) <= 0 or record_id in forward_delivered
+                or any(r[0] == record_id for r in pending)):
+            stats['duplicates'] += 1
+            continue
+        if time.time() < backend_retry_at:
+            continue
+        
+        packet_info = parse_packet(payload[STORED_HEAD_SIZE:])
+        if not packet_info:
+            # Retrying would not help
+            forward_delivered.add(record_id)
+            continue
+        stats['packets_received'] += 1
+        
+        timestamp = datetime.now()
+        if rx_time_us:
+            timestamp = datetime.fromtimestamp(rx_time_us / 1000000.0)
+        elif age_ms != AGE_UNKNOWN:
+            timestamp = datetime.fromtimestamp(time.time() - age_ms / 1000.0)
+        pending.append((record_id, server_json(packet_info, rssi, snr, timestamp, gateway_id, rx_time_us)))
+    
+    if pending:
+        stats['last_packet_time'] = datetime.now().strftime('%Y-%m-%d %H:%M:%S')
+        stored = 0
+        for i in range(0, len(pending), REPLAY_BATCH_MAX):
+            batch = pending[i:i + REPLAY_BATCH_MAX]
+            results = send_batch_to_server([r[1] for r in batch])
+            if results is None:
+                # Backend down - the gateway keeps the records until it is back
+                backend_retry_at = time.time() + BACKEND_RETRY_INTERVAL
+                break
+            for (record_id, _), delivered in zip(batch, results):
+                if delivered:
+                    forward_delivered.add(record_id)
+                    stored += 1
+            if stored < i + len(batch):
+                backend_retry_at = time.time() + BACKEND_RETRY_INTERVAL
+                break
+        print(f"📦 {len(pending)} stored packet(s) replayed, {stored} in the backend")
+    
+    while (forward_base + 1) & 0xFFFFFFFF in forward_delivered:
+        forward_base = (forward_base + 1) & 0xFFFFFFFF
+        forward_delivered.discard(forward_base)
+    send_host_ack(forward_base)
+
 def signal_handler(sig, frame):
     """Handle Ctrl+C gracefully"""
     global running
@@ -95,7 +317,9 @@ def print_statistics():
     print("="*60)
     print(f"Packets Received: {stats['packets_received']}")
     print(f"Packets Sent to Server: {stats['packets_sent']}")
+    print(f"Duplicates Ignored: {stats['duplicates']}")
     print(f"Errors: {stats['errors']}")
+    print(f"UART Frames Corrupt / Lost: {stats['frame_errors']} / {stats['frames_lost']}")
     if stats['last_packet_time']:
         print(f"Last Packet: {stats['last_packet_time']}")
     print("="*60 + "\n")
@@ -106,9 +330,25 @@ def parse_packet(data):
     
     Packet format:
     [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)] [Payload (n bytes)]
+    or compact: [0x81] [Short ID (2 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)] [Payload]
     
     Returns dict with parsed data or None if invalid
     """
+    packet_type_names = {1: "Realtime", 2: "ECG", 3: "Fall Event", 5: "ECG (Rice)", 6: "Diagnostics", 7: "Fall Waveform", 10: "Vitals History"}
+    
+    if len(data) >= 6 and data[0] == COMPACT_MARKER:
+        port = data[5]
+        payload = data[6:]
+        return {
+            'device_id': None,
+            'short_id': int.from_bytes(data[1:3], 'little'),
+            'frame_counter': int.from_bytes(data[3:5], 'little'),
+            'packet_type': port,
+            'packet_type_name': packet_type_names.get(port, "Unknown"),
+            'payload': payload,
+            'payload_length': len(payload)
+        }
+    
     if len(data) < 13:  # Minimum packet size
         print(f"❌ Packet too short: {len(data)} bytes")
         return None
@@ -130,7 +370,6 @@ def parse_packet(data):
         port = data[12]
         payload = data[13:]
         
-        packet_type_names = {1: "Realtime", 2: "ECG", 3: "Fall Event"}
         packet_type_name = packet_type_names.get(port, "Unknown")
         
         return {
@@ -146,39 +385,94 @@ def parse_packet(data):
         print(f"   Raw data (first 20 bytes): {data[:20].hex()}")
         return None
 
-def send_to_server(packet_info, rssi=-100, snr=0):
+def server_json(packet_info, rssi=-100, snr=0, timestamp=None, gateway_id=None, rx_time_us=0):
     """
-    Send packet data to backend server via HTTP POST
+    Build the backend's JSON for one packet
     
     Args:
         packet_info: Parsed packet dictionary
         rssi: Received Signal Strength Indicator (dBm)
         snr: Signal-to-Noise Ratio (dB)
+        timestamp: Reception time (default now)
+        gateway_id: Gateway that received it (hex string)
+        rx_time_us: Gateway RX time, Unix microseconds (0 if unknown)
+    """
+    return {
+        'device_id': packet_info['device_id'],
+        'short_id': packet_info.get('short_id'),
+        'packet_type': packet_info['packet_type'],
+        'data': base64.b64encode(packet_info['payload']).decode('utf-8'),
+        'timestamp': (timestamp or datetime.now()).isoformat(),
+        'frame_counter': packet_info['frame_counter'],
+        'rssi': rssi,
+        'snr': snr,
+        'gateway_id': gateway_id,
+        'rx_time_us': rx_time_us or None
+    }
+
+def send_batch_to_server(packets):
+    """
+    Send several packets (server_json() each) in one HTTP POST
+    
+    Returns:
+        One bool per packet, True if it is done with (stored, or rejected
+        as invalid) - or None if the request failed
     """
     try:
-        # Encode payload as base64
-        payload_base64 = base64.b64encode(packet_info['payload']).decode('utf-8')
-        
-        # Create JSON payload matching the server's expected format
-        json_data = {
-            'device_id': packet_info['device_id'],
-            'packet_type': packet_info['packet_type'],
-            'data': payload_base64,
-            'timestamp': datetime.now().isoformat(),
-            'frame_counter': packet_info['frame_counter'],
-            'rssi': rssi
-        }
+        response = http.post(
+            SERVER_URL + '/batch',
+            json={'packets': packets},
+            headers={'Content-Type': 'application/json'},
+            timeout=5 + len(packets) // 4
+        )
+        if response.status_code != 200:
+            print(f"❌ Server error: HTTP {response.status_code}")
+            print(f"   Response: {response.text}")
+            stats['errors'] += 1
+            return None
         
+        codes = [r.get('code') for r in response.json().get('results', [])]
+        codes += [None] * (len(packets) - len(codes))
+        stats['packets_sent'] += codes.count(200)
+        stats['errors'] += len(codes) - codes.count(200)
+        # A packet the backend rejects as invalid would be rejected again
+        return [code in (200, 400) for code in codes]
+            
+    except requests.exceptions.Timeout:
+        print("❌ Server timeout")
+    except requests.exceptions.ConnectionError:
+        print("❌ Cannot connect to server")
+    except Exception as e:
+        print(f"❌ Error sending to server: {e}")
+    stats['errors'] += 1
+    return None
+
+def send_to_server(packet_info, rssi=-100, snr=0, timestamp=None, gateway_id=None, rx_time_us=0):
+    """
+    Send packet data to backend server via HTTP POST
+    (arguments as for server_json())
+    
+    Returns:
+        True if the server stored it
+    """
+    try:
         # Send POST request
-        response = requests.post(
+        response = http.post(
             SERVER_URL,
-            json=json_data,
+            json=server_json(packet_info, rssi, snr, timestamp, gateway_id, rx_time_us),
             headers={'Content-Type': 'application/json'},
             timeout=5
         )
         
         if response.status_code == 200:
-            print(f"   ✅ Sent to server (HTTP {response.status_code})")
+            try:
+                duplicate = response.json().get('status') == 'duplicate'
+            except ValueError:
+                duplicate = False
+            if duplicate:
+                print("   ⏭️  Already stored from another gateway")
+            else:
+                print(f"   ✅ Sent to server (HTTP {response.status_code})")
             stats['packets_sent'] += 1
             return True
         else:
@@ -200,13 +494,48 @@ def send_to_server(packet_info, rssi=-100, snr=0):
         stats['errors'] += 1
         return False
 
+def handle_lora_packet(data_bytes, rssi, snr, timestamp=None, gateway_id=None, rx_time_us=0):
+    """
+    Parse one LoRa packet and send it to the backend
+    
+    Returns:
+        True if the backend stored it (or it cannot be parsed - retrying
+        would not help)
+    """
+    packet_info = parse_packet(data_bytes)
+    if not packet_info:
+        return True
+    
+    stats['packets_received'] += 1
+    stats['last_packet_time'] = datetime.now().strftime('%Y-%m-%d %H:%M:%S')
+    
+    print(f"\n📦 Packet #{stats['packets_received']}")
+    print(f"   Device: {packet_info['device_id'] or 'short ID %04X' % packet_info['short_id']}")
+    print(f"   Type: {packet_info['packet_type_name']} (Port {packet_info['packet_type']})")
+    print(f"   Frame: {packet_info['frame_counter']}")
+    print(f"   RSSI: {rssi} dBm, SNR: {snr} dB" + (f", gateway {gateway_id}" if gateway_id else ""))
+    print(f"   Size: {packet_info['payload_length']} bytes")
+    if timestamp is not None:
+        print(f"   Received: {timestamp.strftime('%Y-%m-%d %H:%M:%S')}")
+    
+    # Show payload hex for debugging
+    if packet_info['packet_type'] == 3:
+        print(f"   🚨 FALL EVENT DETECTED!")
+        print(f"   Payload (hex): {packet_info['payload'].hex()}")
+    
+    # Add RSSI/SNR to packet info
+    packet_info['rssi'] = rssi
+    
+    # Send to server
+    return send_to_server(packet_info, rssi, snr, timestamp, gateway_id, rx_time_us)
+
 def read_lora_packets():
     """
     Main loop to read LoRa packets from UART
     
     Expected format from Vision Master E213:
-    - Line-based protocol with RSSI/SNR info
-    - Packet data in hexadecimal or binary format
+    - COBS frames with CRC16 and sequence numbers, delimited by 0x00
+    - A corrupt frame is dropped and reading resumes at the next delimiter
     """
     global ser, running
     
@@ -219,117 +548,59 @@ def read_lora_packets():
     print("="*60 + "\n")
     
     buffer = bytearray()
-    consecutive_failures = 0
-    MAX_CONSECUTIVE_FAILURES = 10
+    expected_seq = None
     
     while running:
         try:
-            # Check for incoming data
-            if ser and ser.is_open and ser.in_waiting > 0:
-                first_byte = ser.read(1)
+            send_keepalive()
+            
+            # Read whatever arrived; frames end at each 0x00
+            waiting = ser.in_waiting if ser and ser.is_open else 0
+            chunk = ser.read(waiting if waiting > 0 else 1) if ser and ser.is_open else b''
+            if not chunk:
+                continue
+            buffer += chunk
+            stored = []
+            
+            while True:
+                end = buffer.find(b'\x00')
+                if end < 0:
+                    if len(buffer) > MAX_FRAME:
+                        # No delimiter for too long - drop it and resync at the next 0x00
+                        buffer.clear()
+                        stats['frame_errors'] += 1
+                    break
                 
-                if first_byte == b'\xAA':
-                    # Start of LoRa packet frame
-                    # Format: [0xAA][LEN][RSSI][SNR][DATA...][0x55]
-                    
-                    # Read header bytes with short timeout
-                    header_data = ser.read(3) if ser.in_waiting >= 3 else b''
-                    
-                    # If not enough bytes yet, wait briefly
-                    if len(header_data) < 3:
-                        time.sleep(0.05)
-                        header_data += ser.read(3 - len(header_data))
-                    
-                    if len(header_data) == 3:
-                        length = header_data[0]
-                        rssi_encoded = header_data[1]
-                        snr_encoded = header_data[2]
-                        
-                        # Validate length (reasonable packet size)
-                        if length < 13 or length > 255:
-                            print(f"⚠️  Invalid packet length: {length}")
-                            consecutive_failures += 1
-                            continue
-                        
-                        # Wait for complete packet data + end marker
-                        bytes_needed = length + 1
-                        packet_data = b''
-                        timeout_counter = 0
-                        
-                        while len(packet_data) < bytes_needed and timeout_counter < 300:
-                            available = ser.in_waiting
-                            if available > 0:
-                                chunk = ser.read(min(available, bytes_needed - len(packet_data)))
-                                packet_data += chunk
-                            else:
-                                time.sleep(0.01)
-                                timeout_counter += 1
-                        
-                        if len(packet_data) == bytes_needed:
-                            # Split data and end marker
-                            data_bytes = packet_data[:-1]
-                            end_marker = packet_data[-1:]
-                            
-                            if end_marker == b'\x55' and len(data_bytes) == length:
-                                # Decode RSSI/SNR
-                                rssi = rssi_encoded - 150
-                                snr = snr_encoded - 20
-                                
-                                # Reset failure counter on success
-                                consecutive_failures = 0
-                                
-                                # Parse packet
-                                packet_info = parse_packet(data_bytes)
-                                if packet_info:
-                                    stats['packets_received'] += 1
-                                    stats['last_packet_time'] = datetime.now().strftime('%Y-%m-%d %H:%M:%S')
-                                    
-                                    print(f"\n📦 Packet #{stats['packets_received']}")
-                                    print(f"   Device: {packet_info['device_id']}")
-                                    print(f"   Type: {packet_info['packet_type_name']} (Port {packet_info['packet_type']})")
-                                    print(f"   Frame: {packet_info['frame_counter']}")
-                                    print(f"   RSSI: {rssi} dBm, SNR: {snr} dB")
-                                    print(f"   Size: {packet_info['payload_length']} bytes")
-                                    
-                                    # Show payload hex for debugging
-                                    if packet_info['packet_type'] == 3:
-                                        print(f"   🚨 FALL EVENT DETECTED!")
-                                        print(f"   Payload (hex): {packet_info['payload'].hex()}")
-                                    
-                                    # Add RSSI/SNR to packet info
-                                    packet_info['rssi'] = rssi
-                                    
-                                    # Send to server
-                                    send_to_server(packet_info)
-                                    
-                                    # Send time sync after each packet
-                                    send_time_sync()
-                            else:
-                                print(f"⚠️  Invalid packet frame (end={end_marker.hex() if end_marker else 'empty'})")
-                                consecutive_failures += 1
-                        else:
-                            print(f"⚠️  Timeout waiting for packet data (got {len(packet_data)}/{bytes_needed})")
-                            consecutive_failures += 1
-                    else:
-                        print(f"⚠️  Could not read header (got {len(header_data)}/3 bytes)")
-                        consecutive_failures += 1
-                        
-                elif first_byte == b'\x55':
-                    # Orphaned end marker - we're out of sync
-                    # This is normal on startup, ignore silently unless it persists
-                    pass
-                else:
-                    # Unknown byte - could be noise or we're mid-packet
-                    pass
+                encoded = bytes(buffer[:end])
+                del buffer[:end + 1]
+                if not encoded:
+                    continue
                 
-                # If too many failures, clear buffer to resync
-                if consecutive_failures >= MAX_CONSECUTIVE_FAILURES:
-                    print("⚠️  Too many packet failures, resynchronizing...")
-                    ser.reset_input_buffer()
-                    consecutive_failures = 0
-                    time.sleep(0.5)
+                frame = decode_frame(encoded)
+                if frame is None:
+                    stats['frame_errors'] += 1
+                    print(f"⚠️  Corrupt UART frame dropped ({len(encoded)} bytes)")
+                    continue
+                
+                frame_type, seq, payload = frame
+                if expected_seq is not None and seq != expected_seq:
+                    lost = (seq - expected_seq) & 0xFF
+                    stats['frames_lost'] += lost
+                    print(f"⚠️  {lost} UART frame(s) lost")
+                expected_seq = (seq + 1) & 0xFF
+                
+                if frame_type == FRAME_STORED_PACKET:
+                    stored.append(payload)
+                    continue
+                if frame_type != FRAME_LORA_PACKET or len(payload) < 3:
+                    continue
+                
+                rssi = int.from_bytes(payload[0:2], byteorder='little', signed=True)
+                snr = int.from_bytes(payload[2:3], byteorder='little', signed=True) / 4.0
+                handle_lora_packet(payload[3:], rssi, snr)
             
-            time.sleep(0.005)  # Reduced from 0.01 for faster response
+            if stored:
+                handle_stored_packets(stored)
             
         except serial.SerialException as e:
             print(f"❌ UART error: {e}")
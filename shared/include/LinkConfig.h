@@ -0,0 +1,127 @@
+#ifndef LINK_CONFIG_H
+#define LINK_CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * LinkConfig - Settings both ends of a link must agree on
+ *
+ * The wearable (esp), the gateway (LoRa_Gateway) and the badge (Indicator)
+ * each used to carry their own copy of these; a mismatch only showed up as
+ * packets that never arrived. They are defined once here and checked with
+ * static_assert, so a setting that cannot work on both ends fails the
+ * build of every firmware that includes it.
+ *
+ * Everything is constexpr and header-only: the radio task and the drivers
+ * see plain constants (C++11 constexpr - single-return functions).
+ */
+
+/**
+ * Heltec LoRa 32 V3 family (Wireless Stick V3, Vision Master E213 / E290):
+ * SX1262 wiring
+ */
+struct HeltecV3Board {
+  static constexpr int LORA_NSS = 8;
+  static constexpr int LORA_DIO1 = 14;
+  static constexpr int LORA_NRST = 12;
+  static constexpr int LORA_BUSY = 13;
+  static constexpr int LORA_MOSI = 10;
+  static constexpr int LORA_MISO = 11;
+  static constexpr int LORA_SCLK = 9;
+};
+
+/**
+ * LoRa air interface, packet ports and the ADR plan (Packet Type 0x09)
+ */
+struct RadioConfig {
+  static constexpr float FREQUENCY_MHZ = 923.0f;   // Hong Kong AS923
+  static constexpr float BANDWIDTH_KHZ = 125.0f;
+  static constexpr uint8_t SPREADING_FACTOR = 9;   // Default and slowest SF
+  static constexpr uint8_t CODING_RATE = 7;        // 4/7
+  static constexpr uint8_t SYNC_WORD = 0x12;       // Private network
+  static constexpr int8_t OUTPUT_POWER_DBM = 22;   // SX1262 maximum
+  static constexpr uint16_t PREAMBLE_LENGTH = 8;   // Symbols
+  static constexpr float DUTY_CYCLE = 0.01f;       // Per transmitter and rolling hour (Hong Kong AS923 SRD limit)
+
+  // Packet ports (payload byte 0 / compact header port)
+  static constexpr uint8_t COMPACT_MIN_PORT = 4;   // First type sent with the compact header
+  static constexpr uint8_t ADR_LISTEN_PORT = 4;    // Frames followed by an ADR window
+  static constexpr uint8_t ACK_PORT = 8;           // Gateway ACK (downlink)
+  static constexpr uint8_t ADR_PORT = 9;           // Gateway link setting (downlink)
+  static constexpr uint8_t HISTORY_PORT = 10;      // Vitals history page (confirmed)
+
+  // ADR: the gateway cycles CAD over ADR_SF_MIN..SPREADING_FACTOR, so a
+  // wearable preamble must outlast one cycle to be caught on any SF
+  static constexpr uint8_t ADR_SF_MIN = 7;
+  static constexpr int8_t ADR_POWER_MIN_DBM = 10;
+  static constexpr uint32_t ADR_PREAMBLE_MS = 28;
+  static constexpr uint8_t CAD_SYMBOLS = 2;        // RadioLib scanChannel() default
+  static constexpr uint32_t CAD_OVERHEAD_US = 2000;  // Standby, SF switch, IRQ per step
+
+  /**
+   * Symbol time at an SF (µs)
+   */
+  static constexpr uint32_t symbolUs(uint8_t sf) {
+    return (uint32_t)((1UL << sf) * 1000.0f / BANDWIDTH_KHZ);
+  }
+
+  /**
+   * Preamble symbols at an SF - at least ADR_PREAMBLE_MS long
+   */
+  static constexpr uint16_t preambleSymbols(uint8_t sf) {
+    return (ADR_PREAMBLE_MS * 1000 + symbolUs(sf) - 1) / symbolUs(sf) > PREAMBLE_LENGTH
+      ? (uint16_t)((ADR_PREAMBLE_MS * 1000 + symbolUs(sf) - 1) / symbolUs(sf))
+      : PREAMBLE_LENGTH;
+  }
+
+  /**
+   * One CAD pass over sf..SPREADING_FACTOR (µs)
+   */
+  static constexpr uint32_t cadCycleUs(uint8_t sf = ADR_SF_MIN) {
+    return sf > SPREADING_FACTOR ? 0
+      : CAD_SYMBOLS * symbolUs(sf) + CAD_OVERHEAD_US + cadCycleUs(sf + 1);
+  }
+};
+
+static_assert(RadioConfig::SPREADING_FACTOR >= 7 && RadioConfig::SPREADING_FACTOR <= 12,
+              "SX1262 LoRa SF must be 7-12 (SF5/6 need implicit headers)");
+static_assert(RadioConfig::CODING_RATE >= 5 && RadioConfig::CODING_RATE <= 8,
+              "LoRa coding rate is 4/5 to 4/8");
+static_assert(RadioConfig::OUTPUT_POWER_DBM >= -9 && RadioConfig::OUTPUT_POWER_DBM <= 22,
+              "SX1262 output power is -9 to 22 dBm");
+static_assert(RadioConfig::ADR_SF_MIN >= 7 && RadioConfig::ADR_SF_MIN <= RadioConfig::SPREADING_FACTOR,
+              "ADR_SF_MIN must lie between SF7 and the default SF");
+static_assert(RadioConfig::ADR_POWER_MIN_DBM <= RadioConfig::OUTPUT_POWER_DBM,
+              "ADR power floor above the default power");
+static_assert(RadioConfig::ADR_PREAMBLE_MS * 1000 >= RadioConfig::cadCycleUs(),
+              "ADR preamble shorter than the gateway's CAD cycle - packets on some SFs would be missed");
+static_assert(RadioConfig::ADR_LISTEN_PORT >= RadioConfig::COMPACT_MIN_PORT &&
+              RadioConfig::ACK_PORT >= RadioConfig::COMPACT_MIN_PORT &&
+              RadioConfig::ADR_PORT >= RadioConfig::COMPACT_MIN_PORT,
+              "Downlinks and ADR-window frames use the compact header");
+
+/**
+ * UART links (frame format in UartLink.h)
+ */
+struct UartConfig {
+  static constexpr uint32_t BADGE_BAUD = 921600;   // Wearable -> badge
+  static constexpr uint32_t PI_BAUD = 921600;      // Gateway <-> Raspberry Pi (UART_BAUDRATE there)
+
+  // The badge light-sleeps and loses the bytes that wake it: the wearable
+  // sends this many delimiters ahead of each frame (UartLink::setWakePreamble())
+  static constexpr size_t BADGE_WAKE_PREAMBLE = 160;
+  static constexpr uint32_t BADGE_WAKE_US = 1000;  // ESP32-S3 light-sleep wake-up, with margin
+
+  /**
+   * Time to send n bytes (8N1) at a baud rate (µs)
+   */
+  static constexpr uint32_t bytesUs(size_t n, uint32_t baud) {
+    return (uint32_t)((uint64_t)n * 10 * 1000000 / baud);
+  }
+};
+
+static_assert(UartConfig::bytesUs(UartConfig::BADGE_WAKE_PREAMBLE, UartConfig::BADGE_BAUD) >= UartConfig::BADGE_WAKE_US,
+              "Badge wake preamble shorter than the light-sleep wake-up - frames would be cut");
+
+#endif
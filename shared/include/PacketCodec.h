@@ -0,0 +1,588 @@
+#ifndef PACKET_CODEC_H
+#define PACKET_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "LinkConfig.h"
+
+/**
+ * PacketCodec - LoRa packet layouts shared by the wearable (esp), the
+ * gateway (LoRa_Gateway) and the badge (Indicator)
+ *
+ * Each end used to hard-code the byte offsets it reads. Here every layout
+ * is written down once: a struct per packet type holds its type byte,
+ * field offsets and size, and a View reads the fields straight from the
+ * received bytes (radio RX buffer, UART payload) without copying them.
+ * Writers fill a caller's buffer in place - on the wearable that is the
+ * LoRaComm queue slot the frame is sent from (LoRaComm::uplinkBuffer()).
+ *
+ * All multi-byte fields are little-endian. Payload byte 0 is the packet
+ * type and doubles as the layout version: fields are only ever appended,
+ * so a view checks for at least SIZE bytes and ignores the rest, and a
+ * change that would move a field takes a new type (as 0x05 did for ECG).
+ *
+ * Readers are constexpr (C++11 - single-return functions), so the layouts
+ * are checked with static_assert below and in each firmware.
+ */
+
+/**
+ * Little-endian field access
+ */
+struct ByteOrder {
+  static constexpr uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+  }
+
+  static constexpr int16_t getI16(const uint8_t* p) {
+    return (int16_t)getU16(p);
+  }
+
+  static constexpr uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  static float getF32(const uint8_t* p) {
+    uint32_t bits = getU32(p);
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+  }
+
+  static void putU16(uint8_t* p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+  }
+
+  static void putU32(uint8_t* p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+  }
+
+  static void putF32(uint8_t* p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    putU32(p, bits);
+  }
+};
+
+/**
+ * Temperature byte: -20°C to 80°C mapped onto 0-255 (unsigned, truncated)
+ */
+struct TempCode {
+  static constexpr float MIN_C = -20.0f;
+  static constexpr float SPAN_C = 100.0f;
+
+  static constexpr uint8_t encode(float celsius) {
+    return !(celsius > MIN_C) ? 0   // Also NaN
+      : celsius >= MIN_C + SPAN_C ? 255
+      : (uint8_t)((celsius - MIN_C) / SPAN_C * 255.0f);
+  }
+
+  static constexpr float decode(uint8_t encoded) {
+    return encoded / 255.0f * SPAN_C + MIN_C;
+  }
+};
+
+/**
+ * LoRa packet header
+ * Classic: [Device ID (10 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+ * Compact: [0x81] [Short ID (2 bytes)] [Frame Counter (2 bytes)] [Port (1 byte)]
+ * Types from RadioConfig::COMPACT_MIN_PORT up use the compact header.
+ */
+struct LoRaHeader {
+  static constexpr size_t DEVICE_ID_SIZE = 10;
+  static constexpr size_t CLASSIC_SIZE = DEVICE_ID_SIZE + 3;
+  static constexpr size_t COMPACT_SIZE = 6;
+  static constexpr size_t MAX_SIZE = CLASSIC_SIZE;
+  static constexpr uint8_t COMPACT_MARKER = 0x81;  // Never a valid first ID character
+
+  /**
+   * Header length used for a packet type
+   */
+  static constexpr size_t sizeFor(uint8_t port) {
+    return port >= RadioConfig::COMPACT_MIN_PORT ? COMPACT_SIZE : CLASSIC_SIZE;
+  }
+
+  /**
+   * 16-bit short device ID: 32-bit FNV-1a of the ID string folded in half
+   */
+  static uint16_t shortIdOf(const char* id) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < DEVICE_ID_SIZE && id[i] != '\0'; i++) {
+      hash ^= (uint8_t)id[i];
+      hash *= 16777619UL;
+    }
+    return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+  }
+
+  /**
+   * @return Header length (COMPACT_SIZE)
+   */
+  static size_t writeCompact(uint8_t* p, uint16_t shortId, uint16_t frameCounter, uint8_t port) {
+    p[0] = COMPACT_MARKER;
+    ByteOrder::putU16(p + 1, shortId);
+    ByteOrder::putU16(p + 3, frameCounter);
+    p[5] = port;
+    return COMPACT_SIZE;
+  }
+
+  /**
+   * @param deviceId Padded with zeros to DEVICE_ID_SIZE
+   * @return Header length (CLASSIC_SIZE)
+   */
+  static size_t writeClassic(uint8_t* p, const char* deviceId, uint16_t frameCounter, uint8_t port) {
+    memset(p, 0, DEVICE_ID_SIZE);
+    strncpy((char*)p, deviceId, DEVICE_ID_SIZE);
+    ByteOrder::putU16(p + DEVICE_ID_SIZE, frameCounter);
+    p[DEVICE_ID_SIZE + 2] = port;
+    return CLASSIC_SIZE;
+  }
+
+  /**
+   * Either header over received bytes
+   */
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool compact() const {
+      return n >= COMPACT_SIZE && p[0] == COMPACT_MARKER;
+    }
+
+    /**
+     * Header length, 0 if the packet is too short for its header
+     */
+    constexpr size_t size() const {
+      return compact() ? COMPACT_SIZE : n >= CLASSIC_SIZE ? CLASSIC_SIZE : 0;
+    }
+
+    constexpr bool valid() const {
+      return size() != 0;
+    }
+
+    constexpr uint16_t shortId() const {   // Compact only
+      return ByteOrder::getU16(p + 1);
+    }
+
+    constexpr const uint8_t* deviceId() const {   // Classic only, DEVICE_ID_SIZE bytes, not terminated
+      return p;
+    }
+
+    constexpr uint16_t frameCounter() const {
+      return ByteOrder::getU16(p + size() - 3);
+    }
+
+    constexpr uint8_t port() const {
+      return p[size() - 1];
+    }
+
+    constexpr const uint8_t* payload() const {
+      return p + size();
+    }
+
+    constexpr size_t payloadLength() const {
+      return n - size();
+    }
+  };
+};
+
+/**
+ * Realtime monitoring (Packet Type 0x01) - also the badge's UART payload
+ */
+struct RealtimePacket {
+  static constexpr uint8_t TYPE = 0x01;
+  static constexpr size_t HEART_RATE = 1;
+  static constexpr size_t BODY_TEMP = 2;     // TempCode
+  static constexpr size_t AMBIENT_TEMP = 3;  // TempCode
+  static constexpr size_t NOISE = 4;         // dB
+  static constexpr size_t FALL_STATE = 5;    // 0=Normal, 1=Warning, 2=Fall, 3=Dangerous, 4=Recovery
+  static constexpr size_t ALERT_FLAGS = 6;   // bit0=HR, bit1=temp, bit2=fall, bit3=noise
+  static constexpr size_t RSSI = 7;          // int16 placeholder
+  static constexpr size_t SNR = 9;           // int8 placeholder
+  static constexpr size_t SIZE = 10;
+
+  static constexpr uint8_t FLAG_HR = 0x01;
+  static constexpr uint8_t FLAG_TEMP = 0x02;
+  static constexpr uint8_t FLAG_FALL = 0x04;
+  static constexpr uint8_t FLAG_NOISE = 0x08;
+
+  /**
+   * @return Payload length (SIZE)
+   */
+  static size_t write(uint8_t* p, uint8_t heartRate, uint8_t bodyTemp, uint8_t ambientTemp,
+                      uint8_t noise, uint8_t fallState, uint8_t alertFlags) {
+    p[0] = TYPE;
+    p[HEART_RATE] = heartRate;
+    p[BODY_TEMP] = bodyTemp;
+    p[AMBIENT_TEMP] = ambientTemp;
+    p[NOISE] = noise;
+    p[FALL_STATE] = fallState;
+    p[ALERT_FLAGS] = alertFlags;
+    ByteOrder::putU16(p + RSSI, 0);  // Filled by the receiver, if at all
+    p[SNR] = 0;
+    return SIZE;
+  }
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= SIZE && p[0] == TYPE; }
+    constexpr uint8_t heartRate() const { return p[HEART_RATE]; }
+    constexpr uint8_t bodyTempCode() const { return p[BODY_TEMP]; }
+    constexpr uint8_t ambientTempCode() const { return p[AMBIENT_TEMP]; }
+    constexpr float bodyTemp() const { return TempCode::decode(p[BODY_TEMP]); }
+    constexpr float ambientTemp() const { return TempCode::decode(p[AMBIENT_TEMP]); }
+    constexpr uint8_t noise() const { return p[NOISE]; }
+    constexpr uint8_t fallState() const { return p[FALL_STATE]; }
+    constexpr uint8_t alertFlags() const { return p[ALERT_FLAGS]; }
+  };
+};
+
+/**
+ * Fall event (Packet Type 0x03), floats as IEEE-754 single
+ */
+struct FallEventPacket {
+  static constexpr uint8_t TYPE = 0x03;
+  static constexpr size_t TIMESTAMP = 1;     // uint32, ms since boot
+  static constexpr size_t JERK = 5;
+  static constexpr size_t SVM = 9;
+  static constexpr size_t ANGULAR_VELOCITY = 13;
+  static constexpr size_t PITCH = 17;
+  static constexpr size_t ROLL = 21;
+  static constexpr size_t IMPACT_COUNT = 25;
+  static constexpr size_t WARNING_COUNT = 26;
+  static constexpr size_t HEART_RATE = 27;
+  static constexpr size_t BODY_TEMP = 28;    // TempCode
+  static constexpr size_t ACCEL_X = 29;
+  static constexpr size_t ACCEL_Y = 33;
+  static constexpr size_t ACCEL_Z = 37;
+  static constexpr size_t MOVEMENT_VARIANCE = 41;
+  static constexpr size_t SIZE = 45;
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= SIZE && p[0] == TYPE; }
+    constexpr uint32_t timestamp() const { return ByteOrder::getU32(p + TIMESTAMP); }
+    constexpr uint8_t heartRate() const { return p[HEART_RATE]; }
+    constexpr float bodyTemp() const { return TempCode::decode(p[BODY_TEMP]); }
+    float svm() const { return ByteOrder::getF32(p + SVM); }
+  };
+};
+
+/**
+ * Realtime batch (Packet Type 0x04): the first reading in full, then per
+ * reading [dt s][change mask][changed fields] (see the wearable's
+ * PayloadBuilder::buildRealtimeBatchPayload). The vitals history page
+ * (0x0A) encodes its records the same way.
+ */
+struct RealtimeBatchPacket {
+  static constexpr uint8_t TYPE = 0x04;
+  static constexpr size_t COUNT = 1;
+  static constexpr size_t TIMESTAMP = 2;     // uint32, ms since boot, of the first reading
+  static constexpr size_t FIRST_READING = 6; // HR, body temp, ambient temp, noise, status
+  static constexpr size_t HEADER_SIZE = 11;
+  static constexpr uint8_t MAX_READINGS = 10;
+
+  static constexpr uint8_t DELTA_ESCAPE = 0x80;  // Absolute value follows
+  static constexpr uint8_t MASK_STATUS = 0x10;   // Bits 0-3: HR, body temp, ambient temp, noise
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= HEADER_SIZE && p[0] == TYPE; }
+    constexpr uint8_t count() const { return p[COUNT]; }
+    constexpr uint32_t timestamp() const { return ByteOrder::getU32(p + TIMESTAMP); }
+    constexpr const uint8_t* firstReading() const { return p + FIRST_READING; }
+    constexpr const uint8_t* deltas() const { return p + HEADER_SIZE; }
+    constexpr size_t deltasLength() const { return n - HEADER_SIZE; }
+  };
+};
+
+/**
+ * ECG window (Packet Type 0x02 8-bit delta at 25Hz, 0x05 Rice-coded at
+ * 50Hz): samples then the PQRST features of the last beat
+ */
+struct EcgPacket {
+  static constexpr uint8_t TYPE_DELTA = 0x02;
+  static constexpr uint8_t TYPE_RICE = 0x05;
+  static constexpr size_t SAMPLES = 1;
+  static constexpr size_t SAMPLES_SIZE = 50;
+  static constexpr size_t PQRST = SAMPLES + SAMPLES_SIZE;
+  static constexpr size_t SIZE = PQRST + 14;
+
+  // PQRST block, relative to PQRST: uint16 timestamp, int16 amplitudes,
+  // uint8 widths (AD8232::getPQRSTData() writes it)
+  static constexpr size_t PQRST_TIMESTAMP = 0;
+  static constexpr size_t PQRST_P_AMP = 2;
+  static constexpr size_t PQRST_Q_AMP = 4;
+  static constexpr size_t PQRST_R_AMP = 6;
+  static constexpr size_t PQRST_S_AMP = 8;
+  static constexpr size_t PQRST_T_AMP = 10;
+  static constexpr size_t PQRST_QRS_WIDTH = 12;
+  static constexpr size_t PQRST_QT_INTERVAL = 13;
+  static constexpr size_t PQRST_SIZE = 14;
+};
+
+/**
+ * Latency diagnostics (Packet Type 0x06): statistics window, then per
+ * profiled stage uint16 average, p99 and maximum duration (us) and
+ * deadline misses, all saturating at 65535
+ */
+struct DiagnosticsPacket {
+  static constexpr uint8_t TYPE = 0x06;
+  static constexpr size_t WINDOW = 1;        // uint32, s
+  static constexpr size_t STAGE_COUNT = 5;
+  static constexpr size_t HEADER_SIZE = 6;
+
+  // Stage block, relative to HEADER_SIZE + stage * STAGE_SIZE
+  static constexpr size_t STAGE_AVG = 0;
+  static constexpr size_t STAGE_P99 = 2;
+  static constexpr size_t STAGE_MAX = 4;
+  static constexpr size_t STAGE_MISSES = 6;
+  static constexpr size_t STAGE_SIZE = 8;
+
+  static constexpr size_t sizeFor(uint8_t stageCount) {
+    return HEADER_SIZE + (size_t)stageCount * STAGE_SIZE;
+  }
+
+  /**
+   * @return Payload length (sizeFor(stageCount)); the stages follow with writeStage()
+   */
+  static size_t writeHeader(uint8_t* p, uint32_t windowSeconds, uint8_t stageCount) {
+    p[0] = TYPE;
+    ByteOrder::putU32(p + WINDOW, windowSeconds);
+    p[STAGE_COUNT] = stageCount;
+    return sizeFor(stageCount);
+  }
+
+  static void writeStage(uint8_t* p, uint8_t stage, uint16_t avgUs, uint16_t p99Us,
+                         uint16_t maxUs, uint16_t misses) {
+    uint8_t* s = p + HEADER_SIZE + (size_t)stage * STAGE_SIZE;
+    ByteOrder::putU16(s + STAGE_AVG, avgUs);
+    ByteOrder::putU16(s + STAGE_P99, p99Us);
+    ByteOrder::putU16(s + STAGE_MAX, maxUs);
+    ByteOrder::putU16(s + STAGE_MISSES, misses);
+  }
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+    constexpr const uint8_t* stage(uint8_t i) const { return p + HEADER_SIZE + (size_t)i * STAGE_SIZE; }
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= HEADER_SIZE && p[0] == TYPE && n >= sizeFor(p[STAGE_COUNT]); }
+    constexpr uint32_t windowSeconds() const { return ByteOrder::getU32(p + WINDOW); }
+    constexpr uint8_t stageCount() const { return p[STAGE_COUNT]; }
+    constexpr uint16_t avgUs(uint8_t i) const { return ByteOrder::getU16(stage(i) + STAGE_AVG); }
+    constexpr uint16_t p99Us(uint8_t i) const { return ByteOrder::getU16(stage(i) + STAGE_P99); }
+    constexpr uint16_t maxUs(uint8_t i) const { return ByteOrder::getU16(stage(i) + STAGE_MAX); }
+    constexpr uint16_t misses(uint8_t i) const { return ByteOrder::getU16(stage(i) + STAGE_MISSES); }
+  };
+};
+
+/**
+ * Fall waveform fragment (Packet Type 0x07): one Rice-coded block of one
+ * IMU axis from a captured fall window; the fragments of a window share
+ * its ID and follow the 0x03 alert
+ */
+struct FallWaveformPacket {
+  static constexpr uint8_t TYPE = 0x07;
+  static constexpr size_t WINDOW_ID = 1;       // Increments per captured fall
+  static constexpr size_t FRAGMENT_INDEX = 2;
+  static constexpr size_t FRAGMENT_COUNT = 3;
+  static constexpr size_t CHANNEL = 4;         // 0-2 accel X/Y/Z, 3-5 gyro X/Y/Z
+  static constexpr size_t START = 5;           // uint16, first sample of the block
+  static constexpr size_t WINDOW_LENGTH = 7;   // uint16, samples per channel
+  static constexpr size_t TRIGGER_INDEX = 9;   // uint16, first sample after confirmation
+  static constexpr size_t SAMPLE_RATE = 11;    // Hz
+  static constexpr size_t KEYFRAME = 12;       // uint16, first sample (counts / 16 + 2048)
+  static constexpr size_t STEP = 14;           // Quantiser step (1 = lossless)
+  static constexpr size_t SAMPLE_COUNT = 15;   // Including the keyframe
+  static constexpr size_t CODE = 16;           // Rice-coded residuals, MSB first, zero padded
+  static constexpr size_t CODE_SIZE = 96;
+  static constexpr size_t SIZE = CODE + CODE_SIZE;
+
+  /**
+   * @return Payload length (SIZE)
+   */
+  static size_t write(uint8_t* p, uint8_t windowId, uint8_t fragmentIndex, uint8_t fragmentCount,
+                      uint8_t channel, uint16_t start, uint16_t windowLength, uint16_t triggerIndex,
+                      uint8_t sampleRateHz, uint16_t keyframe, uint8_t step, uint8_t sampleCount,
+                      const uint8_t* code) {
+    p[0] = TYPE;
+    p[WINDOW_ID] = windowId;
+    p[FRAGMENT_INDEX] = fragmentIndex;
+    p[FRAGMENT_COUNT] = fragmentCount;
+    p[CHANNEL] = channel;
+    ByteOrder::putU16(p + START, start);
+    ByteOrder::putU16(p + WINDOW_LENGTH, windowLength);
+    ByteOrder::putU16(p + TRIGGER_INDEX, triggerIndex);
+    p[SAMPLE_RATE] = sampleRateHz;
+    ByteOrder::putU16(p + KEYFRAME, keyframe);
+    p[STEP] = step;
+    p[SAMPLE_COUNT] = sampleCount;
+    memcpy(p + CODE, code, CODE_SIZE);
+    return SIZE;
+  }
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= SIZE && p[0] == TYPE; }
+    constexpr uint8_t windowId() const { return p[WINDOW_ID]; }
+    constexpr uint8_t fragmentIndex() const { return p[FRAGMENT_INDEX]; }
+    constexpr uint8_t fragmentCount() const { return p[FRAGMENT_COUNT]; }
+    constexpr uint8_t channel() const { return p[CHANNEL]; }
+    constexpr uint16_t start() const { return ByteOrder::getU16(p + START); }
+    constexpr uint16_t windowLength() const { return ByteOrder::getU16(p + WINDOW_LENGTH); }
+    constexpr uint16_t triggerIndex() const { return ByteOrder::getU16(p + TRIGGER_INDEX); }
+    constexpr uint8_t sampleRateHz() const { return p[SAMPLE_RATE]; }
+    constexpr uint16_t keyframe() const { return ByteOrder::getU16(p + KEYFRAME); }
+    constexpr uint8_t step() const { return p[STEP]; }
+    constexpr uint8_t sampleCount() const { return p[SAMPLE_COUNT]; }
+    constexpr const uint8_t* code() const { return p + CODE; }
+  };
+};
+
+/**
+ * Vitals history page (Packet Type 0x0A): consecutive HistoryLog records,
+ * oldest first, the first in full and the others coded as in the 0x04
+ * batch (RealtimeBatchPacket). EVENT_FLAG in a record's status marks a
+ * fall event record.
+ */
+struct HistoryPagePacket {
+  static constexpr uint8_t TYPE = 0x0A;
+  static constexpr size_t LOG_ID = 1;          // uint16, random per boot
+  static constexpr size_t FIRST_SEQUENCE = 3;  // uint32
+  static constexpr size_t FIRST_AGE = 7;       // uint32, s, when the page was built
+  static constexpr size_t COUNT = 11;
+  static constexpr size_t FIRST_RECORD = 12;   // HR, body temp, ambient temp, noise, status
+  static constexpr size_t HEADER_SIZE = 17;
+  static constexpr size_t RECORD_MAX_SIZE = 11;  // dt + mask + 4 escaped fields + status
+  static constexpr uint8_t MAX_RECORDS = 255;
+
+  static constexpr uint8_t EVENT_FLAG = 0x80;
+
+  /**
+   * Page header and first record, count 1; the further records follow at
+   * HEADER_SIZE and setCount() closes the page
+   * @return Bytes written (HEADER_SIZE)
+   */
+  static size_t writeHeader(uint8_t* p, uint16_t logId, uint32_t firstSequence, uint32_t firstAgeS,
+                            uint8_t heartRate, uint8_t bodyTemp, uint8_t ambientTemp,
+                            uint8_t noise, uint8_t status) {
+    p[0] = TYPE;
+    ByteOrder::putU16(p + LOG_ID, logId);
+    ByteOrder::putU32(p + FIRST_SEQUENCE, firstSequence);
+    ByteOrder::putU32(p + FIRST_AGE, firstAgeS);
+    p[COUNT] = 1;
+    p[FIRST_RECORD] = heartRate;
+    p[FIRST_RECORD + 1] = bodyTemp;
+    p[FIRST_RECORD + 2] = ambientTemp;
+    p[FIRST_RECORD + 3] = noise;
+    p[FIRST_RECORD + 4] = status;
+    return HEADER_SIZE;
+  }
+
+  static void setCount(uint8_t* p, uint8_t count) {
+    p[COUNT] = count;
+  }
+
+  class View {
+    const uint8_t* p;
+    size_t n;
+
+  public:
+    constexpr View(const uint8_t* data, size_t length) : p(data), n(length) {}
+
+    constexpr bool valid() const { return n >= HEADER_SIZE && p[0] == TYPE && p[COUNT] > 0; }
+    constexpr uint16_t logId() const { return ByteOrder::getU16(p + LOG_ID); }
+    constexpr uint32_t firstSequence() const { return ByteOrder::getU32(p + FIRST_SEQUENCE); }
+    constexpr uint32_t firstAge() const { return ByteOrder::getU32(p + FIRST_AGE); }
+    constexpr uint8_t count() const { return p[COUNT]; }
+    constexpr const uint8_t* firstRecord() const { return p + FIRST_RECORD; }
+    constexpr const uint8_t* deltas() const { return p + HEADER_SIZE; }
+    constexpr size_t deltasLength() const { return n - HEADER_SIZE; }
+  };
+};
+
+/**
+ * Gateway downlinks (compact header, port repeated as payload byte 0)
+ *   ACK (0x08): [0x08]
+ *   ADR (0x09): [0x09][SF][TX power dBm]
+ */
+struct DownlinkPacket {
+  static constexpr size_t ACK_SIZE = LoRaHeader::COMPACT_SIZE + 1;
+  static constexpr size_t ADR_SF = LoRaHeader::COMPACT_SIZE + 1;
+  static constexpr size_t ADR_POWER = LoRaHeader::COMPACT_SIZE + 2;
+  static constexpr size_t ADR_SIZE = LoRaHeader::COMPACT_SIZE + 3;
+
+  /**
+   * @return Packet length (ACK_SIZE)
+   */
+  static size_t writeAck(uint8_t* p, uint16_t shortId, uint16_t frameCounter) {
+    LoRaHeader::writeCompact(p, shortId, frameCounter, RadioConfig::ACK_PORT);
+    p[LoRaHeader::COMPACT_SIZE] = RadioConfig::ACK_PORT;
+    return ACK_SIZE;
+  }
+
+  /**
+   * @return Packet length (ADR_SIZE)
+   */
+  static size_t writeAdr(uint8_t* p, uint16_t shortId, uint16_t frameCounter, uint8_t sf, int8_t powerDbm) {
+    LoRaHeader::writeCompact(p, shortId, frameCounter, RadioConfig::ADR_PORT);
+    p[LoRaHeader::COMPACT_SIZE] = RadioConfig::ADR_PORT;
+    p[ADR_SF] = sf;
+    p[ADR_POWER] = (uint8_t)powerDbm;
+    return ADR_SIZE;
+  }
+};
+
+static_assert(TempCode::encode(36.5f) == 144 && TempCode::encode(-40.0f) == 0 && TempCode::encode(100.0f) == 255,
+              "Temperature code must stay (t + 20) / 100 * 255 - the backend decodes it");
+static_assert(TempCode::encode(TempCode::decode(144) + 0.01f) == 144,
+              "Temperature code does not round-trip");
+static_assert(RealtimePacket::SNR < RealtimePacket::SIZE && FallEventPacket::MOVEMENT_VARIANCE + 4 == FallEventPacket::SIZE,
+              "Field past the end of its packet");
+static_assert(EcgPacket::SIZE == 65 && EcgPacket::PQRST_QT_INTERVAL + 1 == EcgPacket::PQRST_SIZE,
+              "ECG layout changed - the backend reads PQRST at byte 51");
+static_assert(RealtimeBatchPacket::FIRST_READING + 5 == RealtimeBatchPacket::HEADER_SIZE,
+              "Batch header must end after the first reading");
+static_assert(FallWaveformPacket::SIZE == 112 && FallWaveformPacket::SAMPLE_COUNT + 1 == FallWaveformPacket::CODE,
+              "Waveform layout changed - the backend reads the Rice code at byte 16");
+static_assert(HistoryPagePacket::FIRST_RECORD + 5 == HistoryPagePacket::HEADER_SIZE &&
+              HistoryPagePacket::RECORD_MAX_SIZE == 2 + 4 * 2 + 1,
+              "History page header must end after the first record");
+static_assert(DiagnosticsPacket::sizeFor(7) == 62 && DiagnosticsPacket::STAGE_MISSES + 2 == DiagnosticsPacket::STAGE_SIZE,
+              "Diagnostics layout changed - the backend reads 8 bytes per stage");
+static_assert(LoRaHeader::sizeFor(RadioConfig::ACK_PORT) == LoRaHeader::COMPACT_SIZE &&
+              LoRaHeader::sizeFor(RealtimePacket::TYPE) == LoRaHeader::CLASSIC_SIZE,
+              "Header sizes disagree with RadioConfig::COMPACT_MIN_PORT");
+
+#endif
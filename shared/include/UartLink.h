@@ -0,0 +1,430 @@
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * UartLink - Framed serial link shared by every UART in the system
+ *
+ * The wearable -> badge link and the gateway <-> Raspberry Pi link carry
+ * the same frames:
+ *
+ *   COBS( [type][seq][payload...][CRC16 LE] ) 0x00
+ *
+ * COBS removes every zero byte from the frame, so 0x00 only ever appears
+ * as the delimiter: after corruption, lost bytes or joining mid-stream the
+ * receiver is back in sync at the next 0x00, without scanning for markers
+ * or timing out. The CRC is CRC-16/CCITT-FALSE over type, seq and payload.
+ * seq counts frames per sender (wrapping at 256) so the receiver can count
+ * frames lost on the wire. raspberry-pi/uart_lora_receiver.py implements
+ * the same format.
+ *
+ * UartFrame is the portable encoder / decoder. UartLink drives an ESP32
+ * UART through the ESP-IDF driver: the driver's ISR fills its RX ring
+ * buffer and posts to an event queue, receive() waits on the queue and
+ * decodes COBS straight from the bytes it reads, and the payload is handed
+ * out in place. send() encodes into one buffer and queues it on the
+ * driver's TX ring, so the caller never waits for the wire.
+ *
+ * A receiver that light-sleeps between frames loses the bytes that wake
+ * it. The sender can put a preamble of delimiters ahead of every frame
+ * (setWakePreamble()): the decoder skips empty frames, so the preamble
+ * costs nothing but air time and the frame behind it arrives intact.
+ */
+
+class UartFrame {
+public:
+  enum Type {
+    LORA_PACKET = 0x01,    // Gateway -> Pi: [RSSI int16 LE][SNR x4 int8][LoRa packet]
+    TIME_SYNC = 0x02,      // Pi -> gateway: [year LE 2B][month][day][hour][minute][second]
+                           //   [Unix time us LE 8B] (see HostClock.h)
+    REALTIME = 0x03,       // Wearable -> badge: realtime payload (Packet Type 0x01)
+    STORED_PACKET = 0x04,  // Gateway -> Pi: [record ID LE 4B][floor ID LE 4B][age ms LE 4B]
+                           //   [RSSI int16 LE][SNR x4 int8][gateway ID LE 4B]
+                           //   [RX time us LE 8B][LoRa packet] (see ForwardStore.h)
+    HOST_ACK = 0x05        // Pi -> gateway: [record ID LE 4B] delivered up to, or empty (keepalive)
+  };
+
+  enum Result {
+    NONE = 0,    // Byte consumed, frame not complete
+    FRAME = 1,   // Verified frame ready
+    ERROR = 2    // Frame dropped (CRC, truncated or oversized)
+  };
+
+  static const size_t MAX_PAYLOAD = 320;
+  static const size_t OVERHEAD = 4;  // type, seq, CRC
+  static const size_t MAX_ENCODED = MAX_PAYLOAD + OVERHEAD + (MAX_PAYLOAD + OVERHEAD) / 254 + 2;
+
+  /**
+   * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+   */
+  static uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < length; i++) {
+      crc ^= (uint16_t)data[i] << 8;
+      for (int b = 0; b < 8; b++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+  /**
+   * Encode one frame, delimiter included
+   * The payload is gathered from head and body so callers can prefix
+   * metadata without copying the packet first.
+   * @param out At least MAX_ENCODED bytes
+   * @return Encoded length (0 if the payload exceeds MAX_PAYLOAD)
+   */
+  static size_t encode(uint8_t type, uint8_t seq,
+                       const uint8_t* head, size_t headLength,
+                       const uint8_t* body, size_t bodyLength, uint8_t* out) {
+    if (headLength + bodyLength > MAX_PAYLOAD) return 0;
+
+    Writer w(out);
+    uint8_t prefix[2] = {type, seq};
+    uint16_t crc = crc16(prefix, 2);
+    crc = crc16(head, headLength, crc);
+    crc = crc16(body, bodyLength, crc);
+
+    w.put(type);
+    w.put(seq);
+    for (size_t i = 0; i < headLength; i++) w.put(head[i]);
+    for (size_t i = 0; i < bodyLength; i++) w.put(body[i]);
+    w.put(crc & 0xFF);
+    w.put(crc >> 8);
+    return w.finish();
+  }
+
+  /**
+   * Incremental decoder - feed() every received byte
+   */
+  class Decoder {
+  private:
+    uint8_t frame[MAX_PAYLOAD + OVERHEAD];
+    size_t length;
+    uint8_t code;       // Current COBS block code
+    uint8_t remaining;  // Data bytes left in the block
+    bool dropping;      // Oversized / malformed - skip to the delimiter
+    bool ready;         // frame holds the last verified frame
+
+    bool append(uint8_t b) {
+      if (length >= sizeof(frame)) return false;
+      frame[length++] = b;
+      return true;
+    }
+
+  public:
+    Decoder() {
+      reset();
+    }
+
+    void reset() {
+      length = 0;
+      code = 0xFF;
+      remaining = 0;
+      dropping = false;
+      ready = false;
+    }
+
+    Result feed(uint8_t b) {
+      if (ready) reset();
+      if (b == 0) {
+        bool complete = !dropping && remaining == 0 && length >= OVERHEAD;
+        bool empty = !dropping && length == 0 && code == 0xFF;
+        size_t n = length;
+        reset();
+        if (empty) return NONE;  // Back-to-back delimiters
+        if (!complete) return ERROR;
+        uint16_t crc = frame[n - 2] | (frame[n - 1] << 8);
+        if (crc16(frame, n - 2) != crc) return ERROR;
+        length = n;
+        ready = true;
+        return FRAME;
+      }
+
+      if (dropping) return NONE;
+      if (remaining == 0) {
+        // Code byte: blocks shorter than 254 bytes stood for a zero
+        if (code != 0xFF && !append(0)) dropping = true;
+        code = b;
+        remaining = b - 1;
+        return NONE;
+      }
+      if (!append(b)) dropping = true;
+      remaining--;
+      return NONE;
+    }
+
+    /**
+     * Fields of the frame FRAME was returned for (valid until the next feed())
+     */
+    uint8_t type() const {
+      return frame[0];
+    }
+
+    uint8_t seq() const {
+      return frame[1];
+    }
+
+    const uint8_t* payload() const {
+      return frame + 2;
+    }
+
+    size_t payloadLength() const {
+      return length >= OVERHEAD ? length - OVERHEAD : 0;
+    }
+  };
+
+private:
+  // Streaming COBS writer
+  struct Writer {
+    uint8_t* out;
+    size_t codeIndex;
+    size_t pos;
+    uint8_t code;
+
+    explicit Writer(uint8_t* o) : out(o), codeIndex(0), pos(1), code(1) {}
+
+    void put(uint8_t b) {
+      if (b == 0) {
+        out[codeIndex] = code;
+        codeIndex = pos++;
+        code = 1;
+        return;
+      }
+      out[pos++] = b;
+      if (++code == 0xFF) {
+        out[codeIndex] = code;
+        codeIndex = pos++;
+        code = 1;
+      }
+    }
+
+    size_t finish() {
+      out[codeIndex] = code;
+      out[pos++] = 0;
+      return pos;
+    }
+  };
+};
+
+#if defined(ESP_PLATFORM)
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+class UartLink {
+public:
+  static const int RX_BUFFER = 4096;   // Driver RX ring (about 45 ms at 921600 baud)
+  static const int TX_BUFFER = 2048;   // Driver TX ring
+  static const int EVENT_QUEUE = 20;
+  static const size_t CHUNK = 256;     // Bytes taken from the driver per read
+
+private:
+  uart_port_t port;
+  QueueHandle_t events;
+  bool started;
+
+  UartFrame::Decoder decoder;
+  uint8_t chunk[CHUNK];
+  size_t chunkLength;
+  size_t chunkPos;
+
+  uint8_t txFrame[UartFrame::MAX_ENCODED];
+  uint8_t txSeq;
+  size_t wakePreamble;                 // 0x00 bytes sent ahead of each frame
+
+  bool rxSynced;
+  uint8_t rxSeq;                       // Expected sequence number
+
+  // Statistics
+  uint32_t framesSent;
+  uint32_t framesReceived;
+  uint32_t framesLost;                 // Sequence gaps
+  uint32_t frameErrors;                // CRC / framing
+  uint32_t overruns;                   // Driver FIFO or ring overflow
+
+  void countSequence(uint8_t seq) {
+    if (rxSynced) framesLost += (uint8_t)(seq - rxSeq);
+    rxSynced = true;
+    rxSeq = seq + 1;
+  }
+
+public:
+  UartLink() {
+    port = UART_NUM_1;
+    events = nullptr;
+    started = false;
+    chunkLength = 0;
+    chunkPos = 0;
+    txSeq = 0;
+    wakePreamble = 0;
+    rxSynced = false;
+    rxSeq = 0;
+    framesSent = 0;
+    framesReceived = 0;
+    framesLost = 0;
+    frameErrors = 0;
+    overruns = 0;
+  }
+
+  /**
+   * Install the ESP-IDF UART driver (the port must not also be used
+   * through HardwareSerial)
+   * @return true if the driver started
+   */
+  bool begin(uart_port_t uartPort, int txPin, int rxPin, uint32_t baud) {
+    port = uartPort;
+
+    uart_config_t config = {};
+    config.baud_rate = (int)baud;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+
+    if (uart_driver_install(port, RX_BUFFER, TX_BUFFER, EVENT_QUEUE, &events, 0) != ESP_OK) return false;
+    if (uart_param_config(port, &config) != ESP_OK ||
+        uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+      uart_driver_delete(port);
+      return false;
+    }
+    uart_set_rx_timeout(port, 2);  // Post data after 2 idle character times
+    started = true;
+    return true;
+  }
+
+  /**
+   * Queue one frame for transmission
+   * @param head Optional payload prefix (nullptr, 0 for none)
+   * @return false if not started or the payload is too large
+   */
+  bool send(uint8_t type, const uint8_t* head, size_t headLength, const uint8_t* body, size_t bodyLength) {
+    if (!started) return false;
+    size_t length = UartFrame::encode(type, txSeq, head, headLength, body, bodyLength, txFrame);
+    if (length == 0) return false;
+    for (size_t sent = 0; sent < wakePreamble; sent += CHUNK) {
+      static const uint8_t zeros[CHUNK] = {};
+      size_t n = wakePreamble - sent < CHUNK ? wakePreamble - sent : CHUNK;
+      if (uart_write_bytes(port, zeros, n) != (int)n) return false;
+    }
+    if (uart_write_bytes(port, txFrame, length) != (int)length) return false;
+    txSeq++;
+    framesSent++;
+    return true;
+  }
+
+  bool send(uint8_t type, const uint8_t* payload, size_t length) {
+    return send(type, nullptr, 0, payload, length);
+  }
+
+  /**
+   * Next verified frame
+   * @param wait Ticks to wait for the first UART event
+   * @return true with the frame in frameType() / payload() (valid until
+   *         the next receive())
+   */
+  bool receive(TickType_t wait) {
+    if (!started) return false;
+
+    for (;;) {
+      while (chunkPos < chunkLength) {
+        UartFrame::Result r = decoder.feed(chunk[chunkPos++]);
+        if (r == UartFrame::FRAME) {
+          framesReceived++;
+          countSequence(decoder.seq());
+          return true;
+        }
+        if (r == UartFrame::ERROR) frameErrors++;
+      }
+
+      // Drain what the driver holds before waiting for the next event
+      size_t buffered = 0;
+      uart_get_buffered_data_len(port, &buffered);
+      if (buffered > 0) {
+        int n = uart_read_bytes(port, chunk, buffered < CHUNK ? buffered : CHUNK, 0);
+        chunkLength = n > 0 ? n : 0;
+        chunkPos = 0;
+        continue;
+      }
+
+      uart_event_t event;
+      if (xQueueReceive(events, &event, wait) != pdTRUE) return false;
+      wait = 0;
+      if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+        // Bytes are gone - drop everything and resync at the next delimiter
+        uart_flush_input(port);
+        xQueueReset(events);
+        decoder.reset();
+        chunkLength = 0;
+        chunkPos = 0;
+        overruns++;
+      }
+    }
+  }
+
+  /**
+   * Send this many delimiters ahead of every frame (0 = none), enough to
+   * cover the receiver's wake-up from light sleep
+   */
+  void setWakePreamble(size_t bytes) {
+    wakePreamble = bytes;
+  }
+
+  /**
+   * Whether received bytes wait to be decoded (receive(0) would do work)
+   */
+  bool rxPending() {
+    if (!started) return false;
+    if (chunkPos < chunkLength) return true;
+    size_t buffered = 0;
+    uart_get_buffered_data_len(port, &buffered);
+    return buffered > 0 || uxQueueMessagesWaiting(events) > 0;
+  }
+
+  /**
+   * Wait until queued frames have left the TX FIFO (before light sleep,
+   * which stops the UART clock)
+   */
+  void flush(TickType_t wait) {
+    if (started) uart_wait_tx_done(port, wait);
+  }
+
+  uint8_t frameType() const {
+    return decoder.type();
+  }
+
+  const uint8_t* payload() const {
+    return decoder.payload();
+  }
+
+  size_t payloadLength() const {
+    return decoder.payloadLength();
+  }
+
+  uint32_t getFramesSent() const {
+    return framesSent;
+  }
+
+  uint32_t getFramesReceived() const {
+    return framesReceived;
+  }
+
+  uint32_t getFramesLost() const {
+    return framesLost;
+  }
+
+  uint32_t getFrameErrors() const {
+    return frameErrors;
+  }
+
+  uint32_t getOverruns() const {
+    return overruns;
+  }
+};
+#endif
+
+#endif